@@ -94,33 +94,12 @@ static const uint8_t adv7611_init_2[] = {
     HDMI_I2C_ADDR,      0x6c, 0xa2  // disable manual HPA
 };
 
-static void adv7611_send_init_seq(const uint8_t *seq, int entries) {
-    uint8_t addr;
-    uint8_t buf[2];
-    int result;
-    for (int i = 0; i < entries; i++) {
-        addr = seq[i*3];
-        buf[0] = seq[i*3 + 1];
-        buf[1] = seq[i*3 + 2];
-        result = pal_i2c_write_payload(ADV7611_I2C, addr, buf, 2);
-        if (result != 0) {
-            syslog_printf("Failed writing data to ADV7611\n");
-        }
-    }
-}
+#define INIT_WRITES ((sizeof(adv7611_init_0) + sizeof(adv7611_init_1) + \
+        sizeof(adv7611_init_2)) / 3)
 
-static void adv7611_load_edid(uint8_t *edid) {
-    uint8_t buf[2];
-    int result;
-    for (int i = 0; i < 128; i++) {
-        buf[0] = i;
-        buf[1] = edid[i];
-        result = pal_i2c_write_payload(ADV7611_I2C, EDID_I2C_ADDR, buf, 2);
-        if (result != 0) {
-            syslog_printf("Failed writing data to ADV7611\n");
-        }
-    }
-}
+// Compiled init sequence, the EDID is sent in place as one more transfer
+static pal_i2c_xfer_t init_xfers[INIT_WRITES + 1];
+static uint8_t init_data[INIT_WRITES];
 
 uint8_t adv7611_read_reg(uint8_t addr, uint8_t reg) {
     uint8_t val;
@@ -142,13 +121,18 @@ void adv7611_early_init(void) {
 }
 
 void adv7611_init(void) {
-    adv7611_send_init_seq(adv7611_init_0, sizeof(adv7611_init_0) / 3);
-    adv7611_send_init_seq(adv7611_init_1, sizeof(adv7611_init_1) / 3);
-
-    uint8_t *edid = edid_get_raw();
-    adv7611_load_edid(edid);
-
-    adv7611_send_init_seq(adv7611_init_2, sizeof(adv7611_init_2) / 3);
+    i2c_seq_t seq;
+    i2c_seq_report_t report;
+    i2c_seq_init(&seq, init_xfers, sizeof(init_xfers) / sizeof(init_xfers[0]),
+            init_data, sizeof(init_data));
+    i2c_seq_add_table(&seq, adv7611_init_0, sizeof(adv7611_init_0) / 3);
+    i2c_seq_add_table(&seq, adv7611_init_1, sizeof(adv7611_init_1) / 3);
+    i2c_seq_add_block(&seq, EDID_I2C_ADDR, 0x00, edid_get_raw(), 128);
+    i2c_seq_add_table(&seq, adv7611_init_2, sizeof(adv7611_init_2) / 3);
+    if (i2c_seq_run(&seq, ADV7611_I2C, &report) != 0) {
+        syslog_printf("Failed writing data to ADV7611\n");
+    }
+    i2c_seq_print_report("ADV7611 init", &report);
 
     syslog_printf("ADV7611 initialization done\n");
 }
@@ -157,6 +141,5 @@ void adv7611_powerdown(void) {
     uint8_t buf[2];
     buf[0] = 0x0c;
     buf[1] = 0x62; // Power down
-    int result;
-    result = pal_i2c_write_payload(ADV7611_I2C, ADV7611_I2C_ADDR, buf, 2);
+    pal_i2c_write_payload(ADV7611_I2C, ADV7611_I2C_ADDR, buf, 2);
 }
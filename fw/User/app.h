@@ -26,7 +26,9 @@
 #include "shell.h"
 #include "syslog.h"
 #include "usbapp.h"
+#include "usbbulk.h"
 #include "crc16.h"
+#include "lzb.h"
 #include "ptn3460.h"
 #include "config.h"
 #include "edid.h"
@@ -40,6 +42,10 @@
 #include "spiflash.h"
 #include "power.h"
 #include "caster.h"
+#include "damage.h"
+#include "region.h"
+#include "boot.h"
+#include "i2c_seq.h"
 #include "button.h"
 #include "ui.h"
 #include "fonts.h"
@@ -48,8 +54,10 @@
 //#define UNUSED(expr) do { (void)(expr); } while (0)
 
 #define HOUSEKEEPING_TASK_PRIORITY      (tskIDLE_PRIORITY + 1)
+#define USB_BULK_TASK_PRIORITY          (tskIDLE_PRIORITY + 2)
 #define STARTUP_TASK_LOW_PRIORITY       (tskIDLE_PRIORITY + 1)
 #define UI_TASK_PRIORITY                (tskIDLE_PRIORITY + 3)
+#define CASTER_TASK_PRIORITY            (tskIDLE_PRIORITY + 4)
 #define USB_DEVICE_TASK_PRIORITY        (tskIDLE_PRIORITY + 4)
 #define USB_PD_TASK_PRIORITY            (tskIDLE_PRIORITY + 4)
 #define STARTUP_TASK_HIGH_PRIORITY      (tskIDLE_PRIORITY + 5)
@@ -59,8 +67,11 @@
 
 #define STARTUP_TASK_STACK_SIZE         (configMINIMAL_STACK_SIZE + 1024)
 #define USB_DEVICE_TASK_STACK_SIZE      (configMINIMAL_STACK_SIZE + 128)
+#define USB_BULK_TASK_STACK_SIZE        (configMINIMAL_STACK_SIZE + 128)
 #define USB_PD_TASK_STACK_SIZE          (configMINIMAL_STACK_SIZE + 128)
 #define HOUSEKEEPING_TASK_STACK_SIZE    (configMINIMAL_STACK_SIZE)
 #define UI_TASK_STACK_SIZE              (configMINIMAL_STACK_SIZE + 256)
+#define CASTER_TASK_STACK_SIZE          (configMINIMAL_STACK_SIZE + 128)
 #define KEY_SCAN_TASK_STACK_SIZE        (configMINIMAL_STACK_SIZE)
 #define POWER_MON_TASK_STACK_SIZE       (configMINIMAL_STACK_SIZE + 256)
+#define BOOT_WORKER_STACK_SIZE          (configMINIMAL_STACK_SIZE + 512)
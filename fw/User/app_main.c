@@ -36,8 +36,10 @@ TaskHandle_t housekeeping_task_handle;
 TaskHandle_t startup_task_handle;
 TaskHandle_t idle_task_handle;
 TaskHandle_t usb_device_task_handle;
+TaskHandle_t usb_bulk_task_handle;
 TaskHandle_t usb_pd_task_handle;
 TaskHandle_t ui_task_handle;
+TaskHandle_t caster_task_handle;
 TaskHandle_t key_scan_task_handle;
 TaskHandle_t power_mon_task_handle;
 
@@ -55,13 +57,7 @@ static portTASK_FUNCTION(housekeeping_task, pvParameters) {
     }
 }
 
-static portTASK_FUNCTION(startup_task, pvParameters) {
-    // Power up sequence continues here
-    syslog_printf("System starting");
-    syslog_printf("Serial number: %08x", board_get_uid());
-
-    board_late_init();
-    pal_i2c_init();
+static bool boot_flash(void) {
     spif_init();
     spif_id_t id;
     spif_read_jedec_id(&id);
@@ -69,34 +65,110 @@ static portTASK_FUNCTION(startup_task, pvParameters) {
     syslog_printf("SPI Flash Type: %02x\n", id.type);
     syslog_printf("SPI Flash Capacity: %02x\n", id.capacity);
     spiffs_init();
-//    spif_erase_sector(0);
-//    uint8_t buf[8] = {0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, 0x80};
-//    spif_write(0, 8, buf);
-//    memset(buf, 0, 8);
-//    spif_read(0, 8, buf);
-//    syslog_printf("RD: %02x %02x %02x %02x %02x %02x %02x %02x", buf[0], buf[1],
-//        buf[2], buf[3], buf[4], buf[5], buf[6], buf[7]);
+    return true;
+}
+
+static bool boot_config(void) {
     config_init();
     config_load();
+    waveform_init(WAVEFORM_FILE);
     edid_init();
+    return true;
+}
+
+static bool boot_fpga(void) {
+    // Doesn't need the video input, the ui task only checks it came up
+    fpga_init("fpga.bit");
+    return true;
+}
+
+static bool boot_power(void) {
+    power_set_vcom(config.vcom);
+    power_set_vgh(config.vgh);
+    return true;
+}
+
+static bool boot_dp_reset(void) {
     adv7611_early_init(); // Must be before PTN3460 to release RST and I2C bus
     ptn3460_early_init(); // Let PTN3460 starts internal bootup process
+    return true;
+}
+
+static bool boot_dp_wait(void) {
+    return ptn3460_wait_ready();
+}
+
+static bool boot_adv7611(void) {
     adv7611_init();
+    return true;
+}
+
+static bool boot_ptn3460(void) {
     ptn3460_init();
-    power_set_vcom(config.vcom); // Move out from here
-    power_set_vgh(config.vgh);
+    return true;
+}
+
+// Enough to cover the FPGA, the DP bridge wait and the I2C bus at once
+#define BOOT_WORKERS    3
+
+// Indices into boot_steps, for the dependency masks
+enum {
+    BOOT_FLASH,
+    BOOT_CONFIG,
+    BOOT_FPGA,
+    BOOT_DP_RESET,
+    BOOT_DP_WAIT,
+    BOOT_ADV7611,
+    BOOT_PTN3460,
+    BOOT_POWER,
+    BOOT_STEP_COUNT
+};
+
+// Longest chains first, boot_run() picks ready steps in this order
+static const boot_step_t boot_steps[BOOT_STEP_COUNT] = {
+    [BOOT_FLASH] = {"flash", boot_flash, 0, BOOT_RES_QSPI},
+    [BOOT_CONFIG] = {"config", boot_config, BOOT_STEP(BOOT_FLASH),
+            BOOT_RES_QSPI},
+    [BOOT_FPGA] = {"fpga", boot_fpga, BOOT_STEP(BOOT_CONFIG),
+            BOOT_RES_QSPI | BOOT_RES_FPGA_SPI},
+    [BOOT_DP_RESET] = {"dp_reset", boot_dp_reset, 0, BOOT_RES_I2C},
+    [BOOT_DP_WAIT] = {"dp_wait", boot_dp_wait, BOOT_STEP(BOOT_DP_RESET), 0},
+    [BOOT_ADV7611] = {"adv7611", boot_adv7611,
+            BOOT_STEP(BOOT_DP_RESET) | BOOT_STEP(BOOT_CONFIG), BOOT_RES_I2C},
+    [BOOT_PTN3460] = {"ptn3460", boot_ptn3460,
+            BOOT_STEP(BOOT_DP_WAIT) | BOOT_STEP(BOOT_CONFIG), BOOT_RES_I2C},
+    [BOOT_POWER] = {"power", boot_power, BOOT_STEP(BOOT_CONFIG),
+            BOOT_RES_DAC},
+};
+
+static portTASK_FUNCTION(startup_task, pvParameters) {
+    // Power up sequence continues here
+    syslog_printf("System starting");
+    syslog_printf("Serial number: %08x", board_get_uid());
+
+    board_late_init();
+    pal_i2c_init();
+    boot_run(boot_steps, BOOT_STEP_COUNT, BOOT_WORKERS);
+    boot_print_timeline();
     ui_init();
+    caster_queue_init();
+    region_init();
+    usbbulk_init();
 
     idle_task_handle = xTaskGetIdleTaskHandle();
 
     xTaskCreate(housekeeping_task, "HousekeepingTask", HOUSEKEEPING_TASK_STACK_SIZE,
         NULL, HOUSEKEEPING_TASK_PRIORITY, &housekeeping_task_handle);
+    xTaskCreate(usbbulk_task, "USBBulkTask", USB_BULK_TASK_STACK_SIZE,
+        NULL, USB_BULK_TASK_PRIORITY, &usb_bulk_task_handle);
     xTaskCreate(usb_device_task, "USBDeviceTask", USB_DEVICE_TASK_STACK_SIZE,
         NULL, USB_DEVICE_TASK_PRIORITY, &usb_device_task_handle);
     xTaskCreate(usb_pd_task, "USBPDTask", USB_PD_TASK_STACK_SIZE,
         NULL, USB_PD_TASK_PRIORITY, &usb_pd_task_handle);
     xTaskCreate(ui_task, "UITask", UI_TASK_STACK_SIZE,
         NULL, UI_TASK_PRIORITY, &ui_task_handle);
+    xTaskCreate(caster_task, "CasterTask", CASTER_TASK_STACK_SIZE,
+        NULL, CASTER_TASK_PRIORITY, &caster_task_handle);
     xTaskCreate(key_scan_task, "KeyScanTask", KEY_SCAN_TASK_STACK_SIZE,
         NULL, KEY_SCAN_TASK_PRIORITY, &key_scan_task_handle);
     xTaskCreate(power_monitor_task, "PowerMonTask", POWER_MON_TASK_STACK_SIZE,
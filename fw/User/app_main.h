@@ -26,8 +26,10 @@ extern TaskHandle_t housekeeping_task_handle;
 extern TaskHandle_t startup_task_handle;
 extern TaskHandle_t idle_task_handle;
 extern TaskHandle_t usb_device_task_handle;
+extern TaskHandle_t usb_bulk_task_handle;
 extern TaskHandle_t usb_pd_task_handle;
 extern TaskHandle_t ui_task_handle;
+extern TaskHandle_t caster_task_handle;
 extern TaskHandle_t key_scan_task_handle;
 extern TaskHandle_t power_mon_task_handle;
 
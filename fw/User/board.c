@@ -97,6 +97,9 @@ void HAL_GPIO_EXTI_Callback(uint16_t GPIO_Pin) {
     if (GPIO_Pin == GPIO_PIN_15) {
         usbpd_isr();
     }
+    else if (GPIO_Pin == GPIO_PIN_11) {
+        ui_fpga_done_isr();
+    }
 }
 
 // TODO: Use semaphore?
@@ -0,0 +1,242 @@
+//
+// Grimoire
+// Copyright 2025 Wenting Zhang
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#include "platform.h"
+#include "board.h"
+#include "app.h"
+
+int boot_sched_init(boot_sched_t *sched, const boot_step_t *steps, int count) {
+    memset(sched, 0, sizeof(boot_sched_t));
+    if ((count < 0) || (count > BOOT_MAX_STEPS))
+        return -1;
+    sched->steps = steps;
+    sched->count = count;
+    // Walk the graph once with zero durations, anything left over is either
+    // waiting on a missing step or part of a cycle
+    uint32_t reachable = 0;
+    bool progress = true;
+    while (progress) {
+        progress = false;
+        for (int i = 0; i < count; i++) {
+            if (!(reachable & BOOT_STEP(i)) &&
+                    ((steps[i].deps & ~reachable) == 0)) {
+                reachable |= BOOT_STEP(i);
+                progress = true;
+            }
+        }
+    }
+    uint32_t all = (count == 32) ? 0xffffffffu : (BOOT_STEP(count) - 1);
+    return (reachable == all) ? 0 : -1;
+}
+
+int boot_sched_next(boot_sched_t *sched) {
+    for (int i = 0; i < sched->count; i++) {
+        const boot_step_t *step = &sched->steps[i];
+        if (sched->started & BOOT_STEP(i))
+            continue;
+        if ((step->deps & ~sched->done) != 0)
+            continue;
+        if (step->resources & sched->busy)
+            continue;
+        return i;
+    }
+    return -1;
+}
+
+void boot_sched_start(boot_sched_t *sched, int step, uint32_t now,
+        int worker) {
+    sched->started |= BOOT_STEP(step);
+    sched->busy |= sched->steps[step].resources;
+    sched->records[step].start = now;
+    sched->records[step].worker = worker;
+}
+
+void boot_sched_finish(boot_sched_t *sched, int step, uint32_t now, bool ok) {
+    sched->done |= BOOT_STEP(step);
+    sched->busy &= ~sched->steps[step].resources;
+    sched->records[step].end = now;
+    if (ok)
+        return;
+    sched->failed |= BOOT_STEP(step);
+    // Skip whatever depends on it, directly or not, so nothing waits on it
+    bool progress = true;
+    while (progress) {
+        progress = false;
+        for (int i = 0; i < sched->count; i++) {
+            if (sched->started & BOOT_STEP(i))
+                continue;
+            if (!(sched->steps[i].deps & (sched->failed | sched->skipped)))
+                continue;
+            sched->started |= BOOT_STEP(i);
+            sched->done |= BOOT_STEP(i);
+            sched->skipped |= BOOT_STEP(i);
+            sched->records[i].start = now;
+            sched->records[i].end = now;
+            progress = true;
+        }
+    }
+}
+
+bool boot_sched_complete(boot_sched_t *sched) {
+    uint32_t all = (sched->count == 32) ? 0xffffffffu :
+            (BOOT_STEP(sched->count) - 1);
+    return sched->done == all;
+}
+
+uint32_t boot_sched_simulate(boot_sched_t *sched, const uint32_t *durations,
+        int workers) {
+    int running[BOOT_MAX_WORKERS];
+    uint32_t now = 0;
+    if (workers > BOOT_MAX_WORKERS)
+        workers = BOOT_MAX_WORKERS;
+    for (int w = 0; w < workers; w++)
+        running[w] = -1;
+    while (!boot_sched_complete(sched)) {
+        // Hand out work to every idle worker
+        for (int w = 0; w < workers; w++) {
+            if (running[w] != -1)
+                continue;
+            int step = boot_sched_next(sched);
+            if (step == -1)
+                break;
+            boot_sched_start(sched, step, now, w);
+            running[w] = step;
+        }
+        // Advance to the next step to finish
+        int next_w = -1;
+        uint32_t next_end = 0;
+        for (int w = 0; w < workers; w++) {
+            if (running[w] == -1)
+                continue;
+            uint32_t end = sched->records[running[w]].start +
+                    durations[running[w]];
+            if ((next_w == -1) || (end < next_end)) {
+                next_w = w;
+                next_end = end;
+            }
+        }
+        if (next_w == -1)
+            break; // Stuck, boot_sched_init() should have caught it
+        now = next_end;
+        boot_sched_finish(sched, running[next_w], now, true);
+        running[next_w] = -1;
+    }
+    return now;
+}
+
+static boot_sched_t boot_sched;
+static SemaphoreHandle_t boot_lock;
+static SemaphoreHandle_t boot_wake;
+static SemaphoreHandle_t boot_exit;
+static TickType_t boot_start;
+static int boot_workers;
+
+static void boot_worker(int worker) {
+    xSemaphoreTake(boot_lock, portMAX_DELAY);
+    while (!boot_sched_complete(&boot_sched)) {
+        int step = boot_sched_next(&boot_sched);
+        if (step == -1) {
+            // Wait for another worker to finish something
+            xSemaphoreGive(boot_lock);
+            xSemaphoreTake(boot_wake, portMAX_DELAY);
+            xSemaphoreTake(boot_lock, portMAX_DELAY);
+            continue;
+        }
+        boot_sched_start(&boot_sched, step, xTaskGetTickCount() - boot_start,
+                worker);
+        xSemaphoreGive(boot_lock);
+
+        bool ok = boot_sched.steps[step].run();
+
+        xSemaphoreTake(boot_lock, portMAX_DELAY);
+        boot_sched_finish(&boot_sched, step, xTaskGetTickCount() - boot_start,
+                ok);
+        for (int i = 0; i < boot_workers; i++)
+            xSemaphoreGive(boot_wake);
+    }
+    xSemaphoreGive(boot_lock);
+    // Wake up the others so they see it's complete
+    for (int i = 0; i < boot_workers; i++)
+        xSemaphoreGive(boot_wake);
+}
+
+static portTASK_FUNCTION(boot_worker_task, pvParameters) {
+    boot_worker((int)(intptr_t)pvParameters);
+    xSemaphoreGive(boot_exit);
+    vTaskDelete(NULL);
+}
+
+void boot_run(const boot_step_t *steps, int count, int workers) {
+    boot_start = xTaskGetTickCount();
+    if (boot_sched_init(&boot_sched, steps, count) != 0) {
+        syslog_printf("Invalid boot dependencies, running steps in order");
+        for (int i = 0; i < count; i++) {
+            if (!steps[i].run())
+                syslog_printf("Boot step %s failed", steps[i].name);
+        }
+        return;
+    }
+
+    if (workers < 1)
+        workers = 1;
+    if (workers > BOOT_MAX_WORKERS)
+        workers = BOOT_MAX_WORKERS;
+    boot_workers = workers;
+    boot_lock = xSemaphoreCreateMutex();
+    boot_wake = xSemaphoreCreateCounting(BOOT_MAX_WORKERS * BOOT_MAX_STEPS, 0);
+    boot_exit = xSemaphoreCreateCounting(BOOT_MAX_WORKERS, 0);
+    // Extra workers run at the priority of the caller
+    UBaseType_t priority = uxTaskPriorityGet(NULL);
+    for (int i = 1; i < workers; i++) {
+        xTaskCreate(boot_worker_task, "BootWorker", BOOT_WORKER_STACK_SIZE,
+                (void *)(intptr_t)i, priority, NULL);
+    }
+    boot_worker(0);
+    // Don't free anything before the other workers are out
+    for (int i = 1; i < workers; i++)
+        xSemaphoreTake(boot_exit, portMAX_DELAY);
+    vSemaphoreDelete(boot_lock);
+    vSemaphoreDelete(boot_wake);
+    vSemaphoreDelete(boot_exit);
+}
+
+void boot_print_timeline(void) {
+    uint32_t total = 0;
+    for (int i = 0; i < boot_sched.count; i++) {
+        boot_record_t *rec = &boot_sched.records[i];
+        if (boot_sched.skipped & BOOT_STEP(i)) {
+            syslog_printf("Boot %-12s skipped, a dependency failed",
+                    boot_sched.steps[i].name);
+            continue;
+        }
+        syslog_printf("Boot %-12s %5d - %5d ms (%d ms) on worker %d%s",
+                boot_sched.steps[i].name,
+                rec->start * (1000 / configTICK_RATE_HZ),
+                rec->end * (1000 / configTICK_RATE_HZ),
+                (rec->end - rec->start) * (1000 / configTICK_RATE_HZ),
+                rec->worker,
+                (boot_sched.failed & BOOT_STEP(i)) ? ", failed" : "");
+        if (rec->end > total)
+            total = rec->end;
+    }
+    syslog_printf("Boot took %d ms", total * (1000 / configTICK_RATE_HZ));
+}
@@ -0,0 +1,84 @@
+//
+// Grimoire
+// Copyright 2025 Wenting Zhang
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#pragma once
+
+// Boot steps run by a few worker tasks as soon as the steps they depend on
+// are done. Steps holding the same resource never run at the same time. A
+// step that fails skips everything depending on it, the rest still runs. The
+// scheduling part (boot_sched_*) has no RTOS calls so it can run on the host.
+#define BOOT_MAX_STEPS      16
+#define BOOT_MAX_WORKERS    4
+
+#define BOOT_STEP(n)        (1u << (n))
+
+// Resources shared between boot steps
+#define BOOT_RES_QSPI       (1u << 0)   // SPIFFS and the SPI flash
+#define BOOT_RES_FPGA_SPI   (1u << 1)
+#define BOOT_RES_I2C        (1u << 2)
+#define BOOT_RES_DAC        (1u << 3)   // DAC1, VCOM and VGH setpoints
+
+typedef struct {
+    const char *name;
+    bool (*run)(void);      // Returns false if the step failed
+    uint32_t deps;          // BOOT_STEP() mask of steps to finish first
+    uint32_t resources;     // BOOT_RES_* held while running
+} boot_step_t;
+
+typedef struct {
+    uint32_t start;         // Ticks since the scheduler started
+    uint32_t end;
+    uint8_t worker;
+} boot_record_t;
+
+typedef struct {
+    const boot_step_t *steps;
+    int count;
+    uint32_t started;       // Steps started, including finished ones
+    uint32_t done;          // Including failed and skipped ones
+    uint32_t failed;
+    uint32_t skipped;       // Never run, a dependency failed
+    uint32_t busy;          // Resources currently held
+    boot_record_t records[BOOT_MAX_STEPS];
+} boot_sched_t;
+
+// Returns -1 if the steps can't all be run, because of a dependency on a
+// missing step or a cycle
+int boot_sched_init(boot_sched_t *sched, const boot_step_t *steps, int count);
+// Returns a step that could start now, or -1. Steps are picked in array
+// order, so put the long ones first.
+int boot_sched_next(boot_sched_t *sched);
+void boot_sched_start(boot_sched_t *sched, int step, uint32_t now,
+        int worker);
+// Marks the step done, or failed along with the steps depending on it
+void boot_sched_finish(boot_sched_t *sched, int step, uint32_t now, bool ok);
+bool boot_sched_complete(boot_sched_t *sched);
+// Runs the schedule with the given step durations instead of calling the
+// steps, none of them fail. Returns the total time.
+uint32_t boot_sched_simulate(boot_sched_t *sched, const uint32_t *durations,
+        int workers);
+
+// Runs all steps on the calling task and workers - 1 extra tasks, returns
+// once all of them are done or skipped. Falls back to running the steps in
+// order if boot_sched_init() rejects them.
+void boot_run(const boot_step_t *steps, int count, int workers);
+void boot_print_timeline(void);
@@ -24,9 +24,22 @@
 #include "board.h"
 #include "app.h"
 
-static size_t last_update;
-static size_t last_update_duration;
+// Ops written to the FPGA but not retired yet, the FPGA holds at most two
+// (one active, one queued) and retires them in order
+#define CASTER_INFLIGHT_MAX 2
+
 static uint8_t waveform_frames;
+static QueueHandle_t caster_queue;
+static damage_rect_t inflight[CASTER_INFLIGHT_MAX];
+static int inflight_count;
+static caster_queue_stats_t queue_stats;
+static bool coalesce = true;
+static TickType_t last_retire;
+static TickType_t last_issue;
+static TickType_t blocked_since;    // Head of the pending list waiting on the FPGA
+static bool blocked;
+static int deferred_entry = -1;
+static caster_space_cb_t space_cb;  // Called once the command queue has room
 
 static uint8_t get_update_frames(void) {
     // Should be worst case time to clear/ update a frame
@@ -35,81 +48,102 @@ static uint8_t get_update_frames(void) {
     return 16;
 }
 
-static void wait(void) {
-    // Reading is not implemented in the simulator
-}
-
 void caster_init(void) {
     waveform_frames = 38; // Need to sync with the RTL code
-    fpga_write_reg8(CSR_CFG_V_FP, config.tcon_vfp);
-    fpga_write_reg8(CSR_CFG_V_SYNC, config.tcon_vsync);
-    fpga_write_reg8(CSR_CFG_V_BP, config.tcon_vbp);
-    fpga_write_reg16(CSR_CFG_V_ACT, config.tcon_vact);
-    fpga_write_reg8(CSR_CFG_H_FP, config.tcon_hfp);
-    fpga_write_reg8(CSR_CFG_H_SYNC, config.tcon_hsync);
-    fpga_write_reg8(CSR_CFG_H_BP, config.tcon_hbp);
-    fpga_write_reg16(CSR_CFG_H_ACT, config.tcon_hact);
+    // Back to the LUT built into the bitstream, caster_task reloads the set
+    waveform_set_current(-1);
     uint32_t frame_bytes = config.tcon_hact * 4 * config.tcon_vact * 2;
-    fpga_write_reg8(CSR_CFG_FBYTES_B0, frame_bytes & 0xff);
-    fpga_write_reg8(CSR_CFG_FBYTES_B1, (frame_bytes >> 8) & 0xff);
-    fpga_write_reg8(CSR_CFG_FBYTES_B2, (frame_bytes >> 16) & 0xff);
-    fpga_write_reg8(CSR_CFG_MINDRV, 2);
-    fpga_write_reg8(CSR_LUT_FRAME, 38);
-    fpga_write_reg16(CSR_OSD_LEFT, 0);
-    fpga_write_reg16(CSR_OSD_RIGHT, 256/4);
-    fpga_write_reg16(CSR_OSD_TOP, 0);
-    fpga_write_reg16(CSR_OSD_BOTTOM, 128);
-    fpga_write_reg8(CSR_OSD_EN, 0);
-    fpga_write_reg8(CSR_CFG_MIRROR, config.mirror);
-    fpga_write_reg8(CSR_ENABLE, 1); // Enable refresh
-}
-
-static uint8_t is_busy() {
-    uint8_t status = fpga_write_reg8(CSR_STATUS, 0x00);
-    return !!(status & STATUS_OP_QUEUE);
+    fpga_batch_t batch;
+    // Written in address order so consecutive registers share one CS
+    fpga_lock();
+    fpga_batch_begin(&batch);
+    fpga_batch_reg8(&batch, CSR_CFG_V_FP, config.tcon_vfp);
+    fpga_batch_reg8(&batch, CSR_CFG_V_SYNC, config.tcon_vsync);
+    fpga_batch_reg8(&batch, CSR_CFG_V_BP, config.tcon_vbp);
+    fpga_batch_reg16(&batch, CSR_CFG_V_ACT, config.tcon_vact);
+    fpga_batch_reg8(&batch, CSR_CFG_H_FP, config.tcon_hfp);
+    fpga_batch_reg8(&batch, CSR_CFG_H_SYNC, config.tcon_hsync);
+    fpga_batch_reg8(&batch, CSR_CFG_H_BP, config.tcon_hbp);
+    fpga_batch_reg16(&batch, CSR_CFG_H_ACT, config.tcon_hact);
+    fpga_batch_reg8(&batch, CSR_CFG_FBYTES_B2, (frame_bytes >> 16) & 0xff);
+    fpga_batch_reg8(&batch, CSR_CFG_FBYTES_B1, (frame_bytes >> 8) & 0xff);
+    fpga_batch_reg8(&batch, CSR_CFG_FBYTES_B0, frame_bytes & 0xff);
+    fpga_batch_reg8(&batch, CSR_CFG_MINDRV, 2);
+    fpga_batch_reg8(&batch, CSR_OSD_EN, 0);
+    fpga_batch_reg16(&batch, CSR_OSD_LEFT, 0);
+    fpga_batch_reg16(&batch, CSR_OSD_RIGHT, 256/4);
+    fpga_batch_reg16(&batch, CSR_OSD_TOP, 0);
+    fpga_batch_reg16(&batch, CSR_OSD_BOTTOM, 128);
+    fpga_batch_reg8(&batch, CSR_CFG_MIRROR, config.mirror);
+    fpga_batch_reg8(&batch, CSR_LUT_FRAME, 38);
+    fpga_batch_reg8(&batch, CSR_ENABLE, 1); // Enable refresh, must be last
+    fpga_batch_commit(&batch);
+    fpga_unlock();
 }
 
 uint8_t caster_load_waveform(uint8_t *waveform, uint8_t frames) {
-    fpga_write_reg8(CSR_LUT_FRAME, 0); // Reset value before loading
-    fpga_write_reg16(CSR_LUT_ADDR, 0);
+    if ((frames == 0) || (frames > WAVEFORM_MAX_FRAMES))
+        return 1;
+    fpga_batch_t batch;
+    // The LUT address must not move between setting it and the upload
+    fpga_lock();
+    fpga_batch_begin(&batch);
+    fpga_batch_reg8(&batch, CSR_LUT_FRAME, 0); // Reset value before loading
+    fpga_batch_reg16(&batch, CSR_LUT_ADDR, 0);
+    fpga_batch_commit(&batch);
     fpga_write_bulk(CSR_LUT_WR, waveform, WAVEFORM_SIZE);
+    // Only play back as many frames as the LUT has
+    fpga_write_reg8(CSR_LUT_FRAME, frames);
+    fpga_unlock();
     waveform_frames = frames;
     return 0;
 }
 
+static void caster_set_op_area(fpga_batch_t *batch, uint16_t x0, uint16_t y0,
+        uint16_t x1, uint16_t y1) {
+    fpga_batch_reg16(batch, CSR_OP_LEFT, x0);
+    fpga_batch_reg16(batch, CSR_OP_RIGHT, x1);
+    fpga_batch_reg16(batch, CSR_OP_TOP, y0);
+    fpga_batch_reg16(batch, CSR_OP_BOTTOM, y1);
+}
+
 uint8_t caster_redraw(uint16_t x0, uint16_t y0, uint16_t x1, uint16_t y1) {
-    //if (is_busy()) return 1;
-    fpga_write_reg16(CSR_OP_LEFT, x0);
-    fpga_write_reg16(CSR_OP_TOP, y0);
-    fpga_write_reg16(CSR_OP_RIGHT, x1);
-    fpga_write_reg16(CSR_OP_BOTTOM, y1);
-    fpga_write_reg8(CSR_OP_LENGTH, get_update_frames());
-    fpga_write_reg8(CSR_OP_CMD, OP_EXT_REDRAW);
+    fpga_batch_t batch;
+    fpga_lock();
+    fpga_batch_begin(&batch);
+    caster_set_op_area(&batch, x0, y0, x1, y1);
+    // OP_PARAM is skipped, redraw doesn't use it
+    fpga_batch_reg8(&batch, CSR_OP_LENGTH, get_update_frames());
+    fpga_batch_reg8(&batch, CSR_OP_CMD, OP_EXT_REDRAW);
+    fpga_batch_commit(&batch);
+    fpga_unlock();
     return 0;
 }
 
 uint8_t caster_setmode(uint16_t x0, uint16_t y0, uint16_t x1, uint16_t y1,
         update_mode_t mode) {
-    //if (is_busy()) return 1;
-    fpga_write_reg16(CSR_OP_LEFT, x0);
-    fpga_write_reg16(CSR_OP_TOP, y0);
-    fpga_write_reg16(CSR_OP_RIGHT, x1);
-    fpga_write_reg16(CSR_OP_BOTTOM, y1);
-    fpga_write_reg8(CSR_OP_LENGTH, get_update_frames());
-    fpga_write_reg8(CSR_OP_PARAM, (uint8_t)mode);
-    fpga_write_reg8(CSR_OP_CMD, OP_EXT_SETMODE);
+    fpga_batch_t batch;
+    fpga_lock();
+    fpga_batch_begin(&batch);
+    caster_set_op_area(&batch, x0, y0, x1, y1);
+    fpga_batch_reg8(&batch, CSR_OP_PARAM, (uint8_t)mode);
+    fpga_batch_reg8(&batch, CSR_OP_LENGTH, get_update_frames());
+    fpga_batch_reg8(&batch, CSR_OP_CMD, OP_EXT_SETMODE);
+    fpga_batch_commit(&batch);
+    fpga_unlock();
     return 0;
 }
 
 uint8_t caster_setinput(uint8_t input_src) {
-//    if (is_busy()) return 1;
 //    fpga_write_reg8(CSR_CFG_IN_SRC, input_src);
     return 0;
 }
 
 uint8_t caster_osd_send_buf(uint8_t *buf) {
+    fpga_lock();
     fpga_write_reg16(CSR_OSD_ADDR, 0);
     fpga_write_bulk(CSR_OSD_WR, buf, 4096);
+    fpga_unlock();
     return 0;
 }
 
@@ -117,3 +151,247 @@ uint8_t caster_osd_set_enable(bool en) {
     fpga_write_reg8(CSR_OSD_EN, en);
     return 0;
 }
+
+/*** Command queue ***/
+// All region ops go through caster_task, which only writes an op to the FPGA
+// when its op queue has room, instead of having it silently dropped. Ops are
+// held for at least CASTER_COALESCE_MS, and for as long as the FPGA is busy,
+// so overlapping or adjacent ones can be merged into a single FPGA op.
+
+void caster_queue_init(void) {
+    caster_queue = xQueueCreate(CASTER_QUEUE_LENGTH, sizeof(caster_op_t));
+    inflight_count = 0;
+    blocked = false;
+    space_cb = NULL;
+    memset(&queue_stats, 0, sizeof(queue_stats));
+}
+
+// Returns 0 if the op is queued, 1 if the queue stayed full for wait ticks
+uint8_t caster_submit(const caster_op_t *op, TickType_t wait) {
+    if (xQueueSend(caster_queue, op, wait) != pdTRUE) {
+        queue_stats.rejected++;
+        return 1;
+    }
+    queue_stats.submitted++;
+    uint32_t depth = uxQueueMessagesWaiting(caster_queue);
+    if (depth > queue_stats.max_depth)
+        queue_stats.max_depth = depth;
+    return 0;
+}
+
+// Same as caster_submit, but blocks until the FPGA retires the op
+uint8_t caster_submit_wait(const caster_op_t *op, TickType_t wait) {
+    caster_op_t req = *op;
+    req.notify = xTaskGetCurrentTaskHandle();
+    xTaskNotifyWait(CASTER_NOTIFY_DONE | CASTER_NOTIFY_ERROR, 0, NULL, 0);
+    if (caster_submit(&req, wait))
+        return 1;
+    uint32_t bits = 0;
+    while (!(bits & (CASTER_NOTIFY_DONE | CASTER_NOTIFY_ERROR))) {
+        uint32_t value;
+        xTaskNotifyWait(0, CASTER_NOTIFY_DONE | CASTER_NOTIFY_ERROR, &value,
+                portMAX_DELAY);
+        bits |= value;
+    }
+    return (bits & CASTER_NOTIFY_ERROR) ? 1 : 0;
+}
+
+uint8_t caster_queue_redraw(uint16_t x0, uint16_t y0, uint16_t x1, uint16_t y1,
+        TickType_t wait) {
+    caster_op_t op = {
+        .cmd = OP_EXT_REDRAW,
+        .x0 = x0, .y0 = y0, .x1 = x1, .y1 = y1
+    };
+    return caster_submit(&op, wait);
+}
+
+uint8_t caster_queue_setmode(uint16_t x0, uint16_t y0, uint16_t x1, uint16_t y1,
+        update_mode_t mode, TickType_t wait) {
+    caster_op_t op = {
+        .cmd = OP_EXT_SETMODE,
+        .param = (uint8_t)mode,
+        .x0 = x0, .y0 = y0, .x1 = x1, .y1 = y1
+    };
+    return caster_submit(&op, wait);
+}
+
+uint32_t caster_queue_space(void) {
+    return uxQueueSpacesAvailable(caster_queue);
+}
+
+static caster_space_cb_t take_space_cb(void) {
+    taskENTER_CRITICAL();
+    caster_space_cb_t cb = space_cb;
+    space_cb = NULL;
+    taskEXIT_CRITICAL();
+    return cb;
+}
+
+// For submitters that can't block: cb is called once from caster_task when
+// the command queue has CASTER_SPACE_NOTIFY free slots. Returns false,
+// without calling cb, if it already has.
+bool caster_queue_notify_space(caster_space_cb_t cb) {
+    taskENTER_CRITICAL();
+    space_cb = cb;
+    taskEXIT_CRITICAL();
+    // caster_task may have emptied the queue before seeing cb
+    if ((caster_queue_space() >= CASTER_SPACE_NOTIFY) && take_space_cb())
+        return false;
+    return true;
+}
+
+void caster_queue_get_stats(caster_queue_stats_t *stats) {
+    *stats = queue_stats;
+}
+
+static void notify_rect(const damage_rect_t *rect, uint32_t bits) {
+    for (int i = 0; i < rect->notify_count; i++) {
+        if (rect->notify[i])
+            xTaskNotify(rect->notify[i], bits, eSetBits);
+    }
+}
+
+// Retire in-flight ops based on how many the FPGA still holds. If the FPGA
+// got restarted in the meantime, everything in flight is considered done.
+static uint8_t update_inflight(void) {
+    uint8_t status = fpga_write_reg8(CSR_STATUS, 0x00);
+    int held = !!(status & (1 << STATUS_OP_BUSY)) +
+            !!(status & (1 << STATUS_OP_QUEUE));
+    while (inflight_count > held) {
+        notify_rect(&inflight[0], CASTER_NOTIFY_DONE);
+        queue_stats.completed += inflight[0].ops;
+        last_retire = xTaskGetTickCount();
+        inflight_count--;
+        memmove(&inflight[0], &inflight[1],
+                sizeof(damage_rect_t) * inflight_count);
+    }
+    return status;
+}
+
+static void issue_op(const caster_op_t *op) {
+    if (op->cmd == OP_EXT_SETMODE)
+        caster_setmode(op->x0, op->y0, op->x1, op->y1, (update_mode_t)op->param);
+    else
+        caster_redraw(op->x0, op->y0, op->x1, op->y1);
+    queue_stats.issued++;
+}
+
+void caster_queue_set_coalesce(bool enable) {
+    coalesce = enable;
+}
+
+// Loads the LUT for the current temperature range. Pixels driven by a LUT
+// while it's rewritten would play a mix of the old and the new one, so the
+// swap waits until no op is in flight and the last one had time to finish
+// playing its LUT. Pixels in the auto LUT modes start on input changes
+// without an op, those could still see the swap.
+static void update_waveform(bool idle) {
+    int entry = waveform_select(waveform_get_temperature());
+    if ((entry < 0) || (entry == waveform_get_current()))
+        return;
+    TickType_t lut_ticks = pdMS_TO_TICKS(waveform_frames * 1000 /
+            FRAME_RATE_HZ);
+    if (!idle || (xTaskGetTickCount() - last_retire < lut_ticks)) {
+        if (deferred_entry != entry)
+            waveform_add_upload(0, true);
+        deferred_entry = entry;
+        return;
+    }
+    deferred_entry = -1;
+    const uint8_t *lut = waveform_get_lut(entry);
+    if (!lut) {
+        // Keep the LUT in use instead of retrying on every poll
+        syslog_printf("Failed to read waveform LUT %d", entry);
+        waveform_set_current(entry);
+        return;
+    }
+    TickType_t start = xTaskGetTickCount();
+    caster_load_waveform((uint8_t *)lut, waveform_get_entry(entry)->frames);
+    waveform_add_upload(xTaskGetTickCount() - start, false);
+    waveform_set_current(entry);
+}
+
+// Last time the FPGA was seen doing something: an op retired, an op was
+// written, or the head op started waiting for room
+static TickType_t last_progress(void) {
+    TickType_t t = last_retire;
+    if ((int32_t)(last_issue - t) > 0)
+        t = last_issue;
+    if ((int32_t)(blocked_since - t) > 0)
+        t = blocked_since;
+    return t;
+}
+
+static void add_pending(damage_list_t *pending, const caster_op_t *op) {
+    int count = pending->count;
+    damage_add(pending, op, xTaskGetTickCount(), coalesce);
+    if (pending->count == count)
+        queue_stats.coalesced++;
+}
+
+portTASK_FUNCTION(caster_task, pvParameters) {
+    static damage_list_t pending;
+    caster_op_t op;
+    damage_rect_t rect;
+
+    damage_init(&pending);
+    while (1) {
+        // Poll every tick while ops are pending, otherwise sleep on the queue,
+        // waking up now and then to follow the temperature
+        TickType_t wait = (pending.count || inflight_count) ? 1 :
+                waveform_loaded() ? pdMS_TO_TICKS(CASTER_WAVEFORM_POLL_MS) :
+                portMAX_DELAY;
+        if (pending.count == DAMAGE_MAX_RECTS) {
+            vTaskDelay(1);
+        }
+        else if (xQueueReceive(caster_queue, &op, wait) == pdTRUE) {
+            add_pending(&pending, &op);
+            // Take whatever else is already waiting before touching the SPI
+            while ((pending.count < DAMAGE_MAX_RECTS) &&
+                    (xQueueReceive(caster_queue, &op, 0) == pdTRUE))
+                add_pending(&pending, &op);
+            if (space_cb && (caster_queue_space() >= CASTER_SPACE_NOTIFY)) {
+                caster_space_cb_t cb = take_space_cb();
+                if (cb)
+                    cb();
+            }
+        }
+        uint8_t status = update_inflight();
+        update_waveform((pending.count == 0) && (inflight_count == 0));
+        if (pending.count == 0) {
+            blocked = false;
+            continue;
+        }
+        TickType_t now = xTaskGetTickCount();
+        TickType_t age = now - pending.rects[0].time;
+        if (coalesce && (age < pdMS_TO_TICKS(CASTER_COALESCE_MS)))
+            continue;
+        if (!(status & (1 << STATUS_OP_QUEUE)) &&
+                (inflight_count < CASTER_INFLIGHT_MAX)) {
+            damage_pop(&pending, &rect);
+            issue_op(&rect.op);
+            inflight[inflight_count++] = rect;
+            last_issue = now;
+            blocked = false;
+            continue;
+        }
+        if (!blocked) {
+            blocked = true;
+            blocked_since = now;
+        }
+        // Ops wait behind each other for as long as the FPGA keeps retiring
+        // them, it's only stuck if nothing moved for the whole timeout
+        if (now - last_progress() >= pdMS_TO_TICKS(CASTER_OP_TIMEOUT_MS)) {
+            // FPGA not running, don't block everyone else forever
+            syslog_printf("Caster op queue stuck, status %02x", status);
+            damage_pop(&pending, &rect);
+            notify_rect(&rect, CASTER_NOTIFY_ERROR);
+            queue_stats.timeout += rect.ops;
+            // Nothing retired for that long either, these won't be
+            for (int i = 0; i < inflight_count; i++)
+                notify_rect(&inflight[i], CASTER_NOTIFY_ERROR);
+            inflight_count = 0;
+            blocked = false;
+        }
+    }
+}
@@ -22,6 +22,8 @@
 //
 #pragma once
 
+#include "waveform.h"
+
 // Register map
 #define CSR_LUT_FRAME       0
 #define CSR_LUT_ADDR_HI     1
@@ -94,8 +96,6 @@
 #define STATUS_OP_QUEUE     3
 #define CTRL_ENABLE         0
 
-#define WAVEFORM_SIZE       (4*1024)
-
 #define FRAME_RATE_HZ       (60)
 
 typedef enum {
@@ -109,6 +109,42 @@ typedef enum {
     UM_AUTO_LUT_ERROR_DIFFUSION = 7
 } update_mode_t;
 
+// Region op submitted through the command queue
+typedef struct {
+    uint8_t cmd;            // OP_EXT_*
+    uint8_t param;          // Update mode for OP_EXT_SETMODE
+    uint16_t x0;
+    uint16_t y0;
+    uint16_t x1;
+    uint16_t y1;
+    TaskHandle_t notify;    // Task notified on completion, could be NULL
+} caster_op_t;
+
+typedef struct {
+    uint32_t submitted;     // Accepted into the command queue
+    uint32_t rejected;      // Command queue full until timeout
+    uint32_t coalesced;     // Merged into another op
+    uint32_t issued;        // FPGA ops written, after merging
+    uint32_t completed;     // Retired by the FPGA
+    uint32_t timeout;       // FPGA queue never freed up, op discarded
+    uint32_t max_depth;     // Command queue high watermark
+} caster_queue_stats_t;
+
+#define CASTER_QUEUE_LENGTH     16
+// Room in the command queue before a caster_queue_notify_space() callback
+#define CASTER_SPACE_NOTIFY     (CASTER_QUEUE_LENGTH / 2)
+// How long an op waits for the FPGA op queue before it's discarded
+#define CASTER_OP_TIMEOUT_MS    1000
+// Minimum time an op is held for merging with ops coming after it
+#define CASTER_COALESCE_MS      2
+// How often an idle caster_task checks whether the LUT has to be swapped
+#define CASTER_WAVEFORM_POLL_MS 100
+// Notification bits sent to caster_op_t.notify
+#define CASTER_NOTIFY_DONE      (1 << 0)
+#define CASTER_NOTIFY_ERROR     (1 << 1)
+
+typedef void (*caster_space_cb_t)(void);
+
 void caster_init(void);
 uint8_t caster_load_waveform(uint8_t *waveform, uint8_t frames);
 uint8_t caster_redraw(uint16_t x0, uint16_t y0, uint16_t x1, uint16_t y1);
@@ -116,3 +152,15 @@ uint8_t caster_setmode(uint16_t x0, uint16_t y0, uint16_t x1, uint16_t y1,
     update_mode_t mode);
 uint8_t caster_osd_send_buf(uint8_t *buf);
 uint8_t caster_osd_set_enable(bool en);
+void caster_queue_init(void);
+uint8_t caster_submit(const caster_op_t *op, TickType_t wait);
+uint8_t caster_submit_wait(const caster_op_t *op, TickType_t wait);
+uint8_t caster_queue_redraw(uint16_t x0, uint16_t y0, uint16_t x1, uint16_t y1,
+    TickType_t wait);
+uint8_t caster_queue_setmode(uint16_t x0, uint16_t y0, uint16_t x1, uint16_t y1,
+    update_mode_t mode, TickType_t wait);
+uint32_t caster_queue_space(void);
+bool caster_queue_notify_space(caster_space_cb_t cb);
+void caster_queue_get_stats(caster_queue_stats_t *stats);
+void caster_queue_set_coalesce(bool enable);
+portTASK_FUNCTION(caster_task, pvParameters);
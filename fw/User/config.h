@@ -22,6 +22,8 @@
 //
 #pragma once
 
+#include <stdint.h>
+
 typedef struct {
     uint32_t pclk_hz; // pixel clock
     uint8_t hfp;
@@ -50,8 +52,20 @@ typedef struct {
     uint8_t mirror;
 } config_t;
 
+typedef struct {
+    const char *name;
+    config_t config;
+} config_preset_t;
+
+// Preset used by config_init(), until a saved configuration is loaded
+#define CONFIG_DEFAULT_PRESET   "1600x1200@75"
+
 extern config_t config;
+extern const config_preset_t config_presets[];
+extern const int config_preset_count;
 
+const config_preset_t *config_find_preset(const char *name);
+void config_apply_preset(const config_preset_t *preset);
 void config_init(void);
 void config_load(void);
 void config_save(void);
@@ -0,0 +1,159 @@
+//
+// Grimoire
+// Copyright 2025 Wenting Zhang
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include "config.h"
+
+// Timings of the panels the board has been used with. The TCON fields follow
+// the input timing: tcon_hact = hact / 4, HFP + HSYNC + HBP = hblk / 4 and
+// tcon_vfp = vblk - vfp - tcon_vsync - tcon_vbp. utils/timing_calc checks a
+// preset or a new set of values against the pixel rate and memory limits.
+const config_preset_t config_presets[] = {
+    {
+        .name = "1600x1200@60",
+        .config = {
+            .pclk_hz = 162000000,
+            .hact = 1600,
+            .vact = 1200,
+            .hblk = 560,
+            .hfp = 64,
+            .hsync = 192,
+            .vblk = 50,
+            .vfp = 1,
+            .vsync = 3,
+            .tcon_vfp = 45,
+            .tcon_vsync = 1,
+            .tcon_vbp = 2,
+            .tcon_vact = 1200,
+            .tcon_hfp = 120,
+            .tcon_hsync = 10,
+            .tcon_hbp = 10,
+            .tcon_hact = 400,
+        }
+    },
+    {
+        .name = "1600x1200@75",
+        .config = {
+            .pclk_hz = 156618000,
+            .hact = 1600,
+            .vact = 1200,
+            .hblk = 80,
+            .hfp = 8,
+            .hsync = 32,
+            .vblk = 43,
+            .vfp = 29,
+            .vsync = 8,
+            .tcon_vfp = 11,
+            .tcon_vsync = 1,
+            .tcon_vbp = 2,
+            .tcon_vact = 1200,
+            .tcon_hfp = 16,
+            .tcon_hsync = 2,
+            .tcon_hbp = 2,
+            .tcon_hact = 400,
+        }
+    },
+    {
+        .name = "1448x1072@75",
+        .config = {
+            .pclk_hz = 127320000,
+            .hact = 1448,
+            .vact = 1072,
+            .hblk = 80,
+            .hfp = 8,
+            .hsync = 32,
+            .vblk = 39,
+            .vfp = 25,
+            .vsync = 8,
+            .tcon_vfp = 11,
+            .tcon_vsync = 1,
+            .tcon_vbp = 2,
+            .tcon_vact = 1072,
+            .tcon_hfp = 17,
+            .tcon_hsync = 2,
+            .tcon_hbp = 1,
+            .tcon_hact = 362,
+        }
+    },
+    {
+        .name = "1040x1040@60",
+        .config = {
+            .pclk_hz = 72509000,
+            .hact = 1040,
+            .vact = 1040,
+            .hblk = 80,
+            .hfp = 8,
+            .hsync = 32,
+            .vblk = 39,
+            .vfp = 25,
+            .vsync = 8,
+            .tcon_vfp = 11,
+            .tcon_vsync = 1,
+            .tcon_vbp = 2,
+            .tcon_vact = 1040,
+            .tcon_hfp = 17,
+            .tcon_hsync = 2,
+            .tcon_hbp = 1,
+            .tcon_hact = 260,
+            .vcom = -2.45f,
+            .vgh = 22.0f,
+            .mirror = 0,
+        }
+    },
+    {
+        .name = "2232x1680@40",
+        .config = {
+            .pclk_hz = 158873000,
+            .hact = 2240,
+            .vact = 1680,
+            .hblk = 80,
+            .hfp = 8,
+            .hsync = 32,
+            .vblk = 32,
+            .vfp = 18,
+            .vsync = 8,
+            .tcon_vfp = 12,
+            .tcon_vsync = 1,
+            .tcon_vbp = 1,
+            .tcon_vact = 1680,
+            .tcon_hfp = 16,
+            .tcon_hsync = 2,
+            .tcon_hbp = 2,
+            .tcon_hact = 560,
+            .vcom = -0.8f,
+            .vgh = 22.0f,
+            .mirror = 1,
+        }
+    },
+};
+
+const int config_preset_count = sizeof(config_presets) / sizeof(config_preset_t);
+
+const config_preset_t *config_find_preset(const char *name) {
+    for (int i = 0; i < config_preset_count; i++) {
+        if (strcmp(config_presets[i].name, name) == 0)
+            return &config_presets[i];
+    }
+    return NULL;
+}
@@ -51,10 +51,13 @@ static const uint16_t crc16tab[256]= {
     0x6e17,0x7e36,0x4e55,0x5e74,0x2e93,0x3eb2,0x0ed1,0x1ef0
 };
 
-uint16_t crc16(const char *buf, int len) {
+uint16_t crc16_update(uint16_t crc, const char *buf, int len) {
     int counter;
-    uint16_t crc = 0;
     for (counter = 0; counter < len; counter++)
             crc = (crc<<8) ^ crc16tab[((crc>>8) ^ *buf++)&0x00FF];
     return crc;
 }
+
+uint16_t crc16(const char *buf, int len) {
+    return crc16_update(0, buf, len);
+}
@@ -7,6 +7,7 @@ extern "C" {
 #endif /* __cplusplus  */
 
 uint16_t crc16(const char *buf, int len);
+uint16_t crc16_update(uint16_t crc, const char *buf, int len);
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,180 @@
+//
+// Grimoire
+// Copyright 2025 Wenting Zhang
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#include "platform.h"
+#include "board.h"
+#include "app.h"
+
+// Coordinates are half open, x1 and y1 are not part of the region
+
+static uint16_t min16(uint16_t a, uint16_t b) {
+    return (a < b) ? a : b;
+}
+
+static uint16_t max16(uint16_t a, uint16_t b) {
+    return (a > b) ? a : b;
+}
+
+static uint32_t area(const caster_op_t *a) {
+    return (uint32_t)(a->x1 - a->x0) * (a->y1 - a->y0);
+}
+
+static bool overlaps(const caster_op_t *a, const caster_op_t *b) {
+    return (a->x0 < b->x1) && (b->x0 < a->x1) &&
+            (a->y0 < b->y1) && (b->y0 < a->y1);
+}
+
+static bool touches(const caster_op_t *a, const caster_op_t *b) {
+    return (a->x0 <= b->x1) && (b->x0 <= a->x1) &&
+            (a->y0 <= b->y1) && (b->y0 <= a->y1);
+}
+
+static bool same_kind(const caster_op_t *a, const caster_op_t *b) {
+    return (a->cmd == b->cmd) && (a->param == b->param);
+}
+
+static void bound(caster_op_t *dst, const caster_op_t *a,
+        const caster_op_t *b) {
+    *dst = *a;
+    dst->x0 = min16(a->x0, b->x0);
+    dst->y0 = min16(a->y0, b->y0);
+    dst->x1 = max16(a->x1, b->x1);
+    dst->y1 = max16(a->y1, b->y1);
+}
+
+static uint32_t intersection(const caster_op_t *a, const caster_op_t *b) {
+    if (!overlaps(a, b))
+        return 0;
+    return (uint32_t)(min16(a->x1, b->x1) - max16(a->x0, b->x0)) *
+            (min16(a->y1, b->y1) - max16(a->y0, b->y0));
+}
+
+// Check if op, which comes after the pending rect at index pos, could be
+// merged into it. Everything in between that touches the merged region and
+// does something else would get reordered, so that's not allowed.
+static bool can_merge(damage_list_t *list, int pos, const caster_op_t *op,
+        int op_pos, caster_op_t *merged) {
+    damage_rect_t *rect = &list->rects[pos];
+    if (!same_kind(&rect->op, op) || !touches(&rect->op, op))
+        return false;
+    bound(merged, &rect->op, op);
+    uint32_t covered = area(&rect->op) + area(op) -
+            intersection(&rect->op, op);
+    uint32_t total = area(merged);
+    if (op->cmd == OP_EXT_SETMODE) {
+        // Must not change the mode outside of the requested regions
+        if (total != covered)
+            return false;
+    }
+    else if ((total - covered) * 100 > covered * DAMAGE_MAX_WASTE) {
+        return false;
+    }
+    for (int i = pos + 1; i < op_pos; i++) {
+        if (!same_kind(&list->rects[i].op, op) &&
+                overlaps(&list->rects[i].op, merged))
+            return false;
+    }
+    return true;
+}
+
+static bool add_notify(damage_rect_t *rect, const TaskHandle_t *notify,
+        int count) {
+    TaskHandle_t result[DAMAGE_MAX_NOTIFY];
+    int result_count = rect->notify_count;
+    memcpy(result, rect->notify, sizeof(TaskHandle_t) * result_count);
+    for (int i = 0; i < count; i++) {
+        bool found = false;
+        for (int j = 0; j < result_count; j++)
+            found |= (result[j] == notify[i]);
+        if (found)
+            continue;
+        if (result_count == DAMAGE_MAX_NOTIFY)
+            return false;
+        result[result_count++] = notify[i];
+    }
+    memcpy(rect->notify, result, sizeof(TaskHandle_t) * result_count);
+    rect->notify_count = result_count;
+    return true;
+}
+
+static void remove_rect(damage_list_t *list, int pos) {
+    list->count--;
+    memmove(&list->rects[pos], &list->rects[pos + 1],
+            sizeof(damage_rect_t) * (list->count - pos));
+}
+
+// Merging grows a rect, which may now be mergeable with later ones
+static void merge_following(damage_list_t *list, int pos) {
+    for (int i = pos + 1; i < list->count; i++) {
+        damage_rect_t *rect = &list->rects[i];
+        caster_op_t merged;
+        if (!can_merge(list, pos, &rect->op, i, &merged))
+            continue;
+        if (!add_notify(&list->rects[pos], rect->notify, rect->notify_count))
+            continue;
+        list->rects[pos].op = merged;
+        list->rects[pos].ops += rect->ops;
+        remove_rect(list, i);
+        i = pos; // Start over, the rect grew again
+    }
+}
+
+void damage_init(damage_list_t *list) {
+    list->count = 0;
+}
+
+// Returns false if the op could neither be merged nor fit into the list
+bool damage_add(damage_list_t *list, const caster_op_t *op, uint32_t time,
+        bool merge) {
+    int notify_count = op->notify ? 1 : 0;
+    // Newest first, it's the most likely one to be next to this op
+    for (int i = merge ? (list->count - 1) : -1; i >= 0; i--) {
+        caster_op_t merged;
+        if (!can_merge(list, i, op, list->count, &merged))
+            continue;
+        if (!add_notify(&list->rects[i], &op->notify, notify_count))
+            continue;
+        list->rects[i].op = merged;
+        list->rects[i].ops++;
+        merge_following(list, i);
+        return true;
+    }
+    if (list->count == DAMAGE_MAX_RECTS)
+        return false;
+    damage_rect_t *rect = &list->rects[list->count++];
+    rect->op = *op;
+    rect->op.notify = NULL;
+    rect->notify[0] = op->notify;
+    rect->notify_count = notify_count;
+    rect->ops = 1;
+    rect->time = time;
+    return true;
+}
+
+// Take the oldest pending rect
+bool damage_pop(damage_list_t *list, damage_rect_t *rect) {
+    if (list->count == 0)
+        return false;
+    *rect = list->rects[0];
+    remove_rect(list, 0);
+    return true;
+}
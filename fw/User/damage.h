@@ -0,0 +1,49 @@
+//
+// Grimoire
+// Copyright 2025 Wenting Zhang
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#pragma once
+
+// Pending region ops waiting to be sent to the FPGA. Ops of the same kind
+// that overlap or touch are merged into one, as long as that doesn't change
+// the order against other pending ops on the same pixels.
+#define DAMAGE_MAX_RECTS    8
+#define DAMAGE_MAX_NOTIFY   4
+// Extra area a merged redraw may cover, in percent of the merged rects
+#define DAMAGE_MAX_WASTE    25
+
+typedef struct {
+    caster_op_t op;         // Merged region, op.notify is not used
+    TaskHandle_t notify[DAMAGE_MAX_NOTIFY];
+    uint8_t notify_count;
+    uint16_t ops;           // Number of ops merged into this one
+    uint32_t time;          // Time the first op arrived
+} damage_rect_t;
+
+typedef struct {
+    damage_rect_t rects[DAMAGE_MAX_RECTS];
+    int count;
+} damage_list_t;
+
+void damage_init(damage_list_t *list);
+bool damage_add(damage_list_t *list, const caster_op_t *op, uint32_t time,
+        bool merge);
+bool damage_pop(damage_list_t *list, damage_rect_t *rect);
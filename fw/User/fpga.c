@@ -25,96 +25,304 @@
 #include "app.h"
 //#include "bitstream.h"
 
-static int fpga_done = 0;
+// Held around every chip select, and by callers across register sequences
+// that have to reach the FPGA together. Recursive, so they can still use the
+// functions below. Also guards the shadow.
+static SemaphoreHandle_t fpga_bus_lock;
 
-static void delay_loop(uint32_t t) {
-    volatile uint32_t x = t;
-    while (x--);
+// Last value written to each CSR, only trusted while the valid bit is set
+static uint8_t shadow[CSR_STATUS];
+static uint8_t shadow_valid[CSR_STATUS / 8];
+static fpga_shadow_stats_t shadow_stats;
+
+// Writes to these have effects beyond setting the register and are never
+// dropped: the LUT and OSD data ports, their address registers which rewind
+// the write pointer, and the op command which submits the op.
+static bool shadow_cacheable(uint8_t addr) {
+    switch (addr) {
+    case CSR_LUT_ADDR_HI:
+    case CSR_LUT_ADDR_LO:
+    case CSR_LUT_WR:
+    case CSR_OP_CMD:
+    case CSR_OSD_ADDR_HI:
+    case CSR_OSD_ADDR_LO:
+    case CSR_OSD_WR:
+        return false;
+    default:
+        return addr < CSR_STATUS;
+    }
+}
+
+static bool shadow_known(uint8_t addr) {
+    return shadow_cacheable(addr) &&
+            (shadow_valid[addr / 8] & (1 << (addr % 8)));
+}
+
+static bool shadow_match(uint8_t addr, uint8_t val) {
+    return shadow_known(addr) && (shadow[addr] == val);
+}
+
+static void shadow_update(uint8_t addr, uint8_t val) {
+    if (!shadow_cacheable(addr))
+        return;
+    shadow[addr] = val;
+    shadow_valid[addr / 8] |= 1 << (addr % 8);
+}
+
+void fpga_lock(void) {
+    // Created on first use, by the boot step loading the bitstream. The tasks
+    // that share the bus are only started after boot.
+    if (!fpga_bus_lock)
+        fpga_bus_lock = xSemaphoreCreateRecursiveMutex();
+    xSemaphoreTakeRecursive(fpga_bus_lock, portMAX_DELAY);
+}
+
+void fpga_unlock(void) {
+    xSemaphoreGiveRecursive(fpga_bus_lock);
+}
+
+void fpga_shadow_invalidate(void) {
+    fpga_lock();
+    memset(shadow_valid, 0, sizeof(shadow_valid));
+    shadow_stats.invalidates++;
+    fpga_unlock();
+}
+
+void fpga_shadow_get_stats(fpga_shadow_stats_t *stats) {
+    *stats = shadow_stats;
+}
+
+void fpga_shadow_reset_stats(void) {
+    memset(&shadow_stats, 0, sizeof(shadow_stats));
 }
 
 uint8_t fpga_write_reg8(uint8_t addr, uint8_t val) {
     uint8_t txbuf[2] = {addr, val};
     uint8_t rxbuf[2];
+    fpga_lock();
     gpio_put(FPGA_CS, 0);
     spi_send_recv(FPGA_SPI, txbuf, rxbuf, 2);
     gpio_put(FPGA_CS, 1);
+    shadow_update(addr, val);
+    fpga_unlock();
     return rxbuf[1];
 }
 
 void fpga_write_reg16(uint8_t addr, uint16_t val) {
     uint8_t txbuf[3] = {addr, val >> 8, val & 0xff};
+    fpga_lock();
     gpio_put(FPGA_CS, 0);
     spi_send(FPGA_SPI, txbuf, 3);
     gpio_put(FPGA_CS, 1);
+    shadow_update(addr, val >> 8);
+    shadow_update(addr + 1, val & 0xff);
+    fpga_unlock();
 }
 
 void fpga_write_bulk(uint8_t addr, uint8_t *buf, int length) {
     uint8_t txbuf[1] = {addr};
+    fpga_lock();
     gpio_put(FPGA_CS, 0);
     spi_send(FPGA_SPI, txbuf, 1);
     spi_send(FPGA_SPI, buf, length);
     gpio_put(FPGA_CS, 1);
+    // Ports don't auto increment, everything goes to the same address
+    if ((addr != CSR_LUT_WR) && (addr != CSR_OSD_WR)) {
+        for (int i = 0; i < length; i++)
+            shadow_update(addr + i, buf[i]);
+    }
+    fpga_unlock();
+}
+
+void fpga_batch_begin(fpga_batch_t *batch) {
+    batch->segs = 0;
+    batch->len = 0;
+}
+
+static void batch_append(fpga_batch_t *batch, uint8_t addr, uint8_t val) {
+    // Data ports don't auto increment, anything after them needs a new CS
+    bool port = (batch->segs != 0) &&
+            ((batch->next_addr - 1 == CSR_LUT_WR) ||
+            (batch->next_addr - 1 == CSR_OSD_WR));
+    bool append = (batch->segs != 0) && (addr == batch->next_addr) && !port;
+    int needed = append ? 1 : 2;
+    if ((batch->len + needed > FPGA_BATCH_SIZE) ||
+            (!append && (batch->segs == FPGA_BATCH_MAX_SEGS))) {
+        // Out of space, send what we have so far to keep the order
+        fpga_batch_commit(batch);
+        append = false;
+    }
+    if (!append) {
+        batch->buf[batch->len++] = addr;
+        batch->seg_len[batch->segs++] = 1;
+    }
+    batch->buf[batch->len++] = val;
+    batch->seg_len[batch->segs - 1]++;
+    batch->next_addr = addr + 1;
+}
+
+void fpga_batch_reg8(fpga_batch_t *batch, uint8_t addr, uint8_t val) {
+    fpga_lock();
+    if (!shadow_cacheable(addr)) {
+        shadow_stats.uncached++;
+    }
+    else if (shadow_match(addr, val)) {
+        shadow_stats.hits++;
+        fpga_unlock();
+        return;
+    }
+    else {
+        shadow_stats.misses++;
+    }
+    // If only a few registers were dropped since the end of the current
+    // segment, resending them is cheaper than another address byte and CS
+    int gap = addr - batch->next_addr;
+    if ((batch->segs != 0) && (gap > 0) && (gap <= FPGA_SHADOW_GAP)) {
+        bool known = true;
+        for (int i = batch->next_addr; i < addr; i++)
+            known = known && shadow_known(i);
+        if (known) {
+            for (int i = batch->next_addr; i < addr; i++)
+                batch_append(batch, i, shadow[i]);
+            shadow_stats.fills += gap;
+        }
+    }
+    batch_append(batch, addr, val);
+    shadow_update(addr, val);
+    fpga_unlock();
+}
+
+void fpga_batch_reg16(fpga_batch_t *batch, uint8_t addr, uint16_t val) {
+    fpga_batch_reg8(batch, addr, val >> 8);
+    fpga_batch_reg8(batch, addr + 1, val & 0xff);
+}
+
+void fpga_batch_commit(fpga_batch_t *batch) {
+    uint8_t *seg = batch->buf;
+    fpga_lock();
+    for (int i = 0; i < batch->segs; i++) {
+        gpio_put(FPGA_CS, 0);
+        if (batch->seg_len[i] > 4) {
+            spi_send_dma(FPGA_SPI, seg, batch->seg_len[i]);
+            spi_wait_dma_complete(FPGA_SPI);
+        }
+        else {
+            // Not worth setting up DMA for a single register
+            spi_send(FPGA_SPI, seg, batch->seg_len[i]);
+        }
+        gpio_put(FPGA_CS, 1);
+        seg += batch->seg_len[i];
+    }
+    fpga_unlock();
+    fpga_batch_begin(batch);
+}
+
+typedef struct {
+    spiffs_file f;
+    uint32_t remaining;     // Bytes left to send to the FPGA
+    bool compressed;
+    uint8_t *cbuf;          // Compressed block, only used if compressed
+} bitstream_src_t;
+
+// Read the next block of the bitstream into buf, decompressing it if needed.
+// Returns the number of bytes to send, 0 at the end or on error.
+static int fpga_read_block(bitstream_src_t *src, uint8_t *buf) {
+    if (src->remaining == 0)
+        return 0;
+    int len = (src->remaining > LZB_BLOCK_SIZE) ? LZB_BLOCK_SIZE : src->remaining;
+    if (!src->compressed) {
+        if (SPIFFS_read(&spiffs_fs, src->f, buf, len) != len)
+            return 0;
+    }
+    else {
+        uint16_t clen;
+        if (SPIFFS_read(&spiffs_fs, src->f, &clen, 2) != 2)
+            return 0;
+        bool stored = clen & LZB_BLOCK_STORED;
+        clen &= ~LZB_BLOCK_STORED;
+        if (clen > LZB_BLOCK_SIZE)
+            return 0;
+        if (stored) {
+            if ((clen != len) || (SPIFFS_read(&spiffs_fs, src->f, buf, len) != len))
+                return 0;
+        }
+        else {
+            if (SPIFFS_read(&spiffs_fs, src->f, src->cbuf, clen) != clen)
+                return 0;
+            if (lzb_decompress(src->cbuf, clen, buf, len) != len)
+                return 0;
+        }
+    }
+    src->remaining -= len;
+    return len;
 }
 
 static void fpga_load_bitstream(const char *fn) {
 
     TickType_t start = xTaskGetTickCount();
 
-    SPIFFS_clearerr(&spiffs_fs);
     spiffs_file f = SPIFFS_open(&spiffs_fs, fn, SPIFFS_O_RDONLY, 0);
-    if (SPIFFS_errno(&spiffs_fs) != 0)
+    if (f < 0)
         return;
 
     spiffs_stat s;
     SPIFFS_fstat(&spiffs_fs, f, &s);
-    uint32_t size = s.size;
-
-    const int block_size = 4096;
-    uint8_t *buf0 = pvPortMalloc(block_size);
-    uint8_t *buf1 = pvPortMalloc(block_size);
-    uint8_t *rdbuf = buf0;
-    uint8_t *wrbuf = buf1;
-    int readbuf = 0;
 
-    gpio_put(FPGA_CS, 0);
-    for (int i = 0; i < size / block_size; i++) {
-        // Start writing if available
-        if (i != 0)
-            spi_send_dma(FPGA_SPI, wrbuf, block_size);
-        SPIFFS_read(&spiffs_fs, f, rdbuf, block_size);
-        // Check DMA finish
-        if (i != 0)
-            spi_wait_dma_complete(FPGA_SPI);
-        // Swap buffer
-        readbuf = !readbuf;
-        rdbuf = readbuf ? buf1 : buf0;
-        wrbuf = readbuf ? buf0 : buf1;
+    // Compressed bitstreams are recognized by the header, anything else is
+    // sent as is
+    bitstream_src_t src = {.f = f, .remaining = s.size, .compressed = false};
+    lzb_header_t hdr;
+    if ((SPIFFS_read(&spiffs_fs, f, &hdr, sizeof(hdr)) == sizeof(hdr)) &&
+            (hdr.magic == LZB_MAGIC) && (hdr.block_size == LZB_BLOCK_SIZE)) {
+        src.remaining = hdr.size;
+        src.compressed = true;
+    }
+    else {
+        SPIFFS_lseek(&spiffs_fs, f, 0, SPIFFS_SEEK_SET);
     }
 
-    // Writing last read block
-    spi_send_dma(FPGA_SPI, wrbuf, block_size);
+    uint8_t *buf0 = pvPortMalloc(LZB_BLOCK_SIZE);
+    uint8_t *buf1 = pvPortMalloc(LZB_BLOCK_SIZE);
+    if (src.compressed)
+        src.cbuf = pvPortMalloc(LZB_BLOCK_SIZE);
+    if (!buf0 || !buf1 || (src.compressed && !src.cbuf)) {
+        // CS is still high, the FPGA keeps waiting for a bitstream
+        syslog_printf("No memory for loading the bitstream");
+        SPIFFS_close(&spiffs_fs, f);
+        goto out;
+    }
+    uint8_t *wrbuf = buf0;
+    uint8_t *rdbuf = buf1;
+    uint32_t total = src.remaining;
 
-    int remaining = size % block_size;
-    if (remaining != 0) {
-        SPIFFS_read(&spiffs_fs, f, rdbuf, remaining);
-    	
-        // Check DMA finish
+    // Send one block while the next one is read and decompressed
+    gpio_put(FPGA_CS, 0);
+    int len = fpga_read_block(&src, wrbuf);
+    while (len > 0) {
+        spi_send_dma(FPGA_SPI, wrbuf, len);
+        int next = fpga_read_block(&src, rdbuf);
         spi_wait_dma_complete(FPGA_SPI);
-        // No need to swap buffer, just send out the last block
-        spi_send_dma(FPGA_SPI, rdbuf, block_size);
+        uint8_t *tmp = wrbuf;
+        wrbuf = rdbuf;
+        rdbuf = tmp;
+        len = next;
     }
     gpio_put(FPGA_CS, 1);
     SPIFFS_close(&spiffs_fs, f);
 
-    // Check DMA finish
-    spi_wait_dma_complete(FPGA_SPI);
-
-    vPortFree(buf0);
-    vPortFree(buf1);
+    if (src.remaining != 0)
+        syslog_printf("Bitstream truncated or corrupted, %d bytes missing",
+                src.remaining);
 
     TickType_t end = xTaskGetTickCount();
 
-    syslog_printf("Bitstream loading took %d ms", (end - start) * (1000 / configTICK_RATE_HZ));
+    syslog_printf("Bitstream loading took %d ms (%d bytes%s)",
+            (end - start) * (1000 / configTICK_RATE_HZ), total,
+            src.compressed ? ", compressed" : "");
+out:
+    vPortFree(buf0);
+    vPortFree(buf1);
+    vPortFree(src.cbuf);
 }
 
 
@@ -140,6 +348,9 @@ static void fpga_wait_done(bool timeout) {
 }
 
 void fpga_reset(void) {
+    // Reconfiguration brings all CSRs back to their reset values
+    memset(shadow_valid, 0, sizeof(shadow_valid));
+    shadow_stats.invalidates++;
     // FPGA Reset
     gpio_put(FPGA_PROG, 0);
     sleep_ms(2);
@@ -148,6 +359,10 @@ void fpga_reset(void) {
 }
 
 void fpga_init(const char *fn) {
+    // Nothing else may touch the bus while the FPGA is reconfigured, the
+    // bitstream is sent in a single chip select
+    fpga_lock();
+
     // Initialize FPGA pins
     gpio_put(FPGA_CS, 1);
 
@@ -163,6 +378,7 @@ void fpga_init(const char *fn) {
 
     // Switch to lower frequency
     board_switch_spi_freq(FPGA_SPI, 6000000);
+    fpga_unlock();
 }
 
 void fpga_suspend(void) {
@@ -22,10 +22,48 @@
 //
 #pragma once
 
+// Register writes to consecutive addresses are merged into one chip select,
+// relying on the address auto increment of the CSR interface.
+#define FPGA_BATCH_SIZE     64
+#define FPGA_BATCH_MAX_SEGS 8
+
+typedef struct {
+    uint8_t buf[FPGA_BATCH_SIZE];
+    uint8_t seg_len[FPGA_BATCH_MAX_SEGS]; // Including the address byte
+    uint8_t segs;
+    uint8_t len;
+    uint8_t next_addr;
+} fpga_batch_t;
+
+// Batched writes are checked against a copy of the last value written to each
+// CSR and dropped if nothing changed. A gap of up to this many registers with
+// known values is filled in from the shadow instead of starting a new CS.
+#define FPGA_SHADOW_GAP     2
+
+typedef struct {
+    uint32_t hits;          // Writes dropped, register already had the value
+    uint32_t misses;        // Writes sent to the FPGA
+    uint32_t uncached;      // Writes to ports and registers with side effects
+    uint32_t fills;         // Unchanged registers sent to bridge a gap
+    uint32_t invalidates;   // Shadow dropped on FPGA reset
+} fpga_shadow_stats_t;
+
 void fpga_init(const char *fn);
+// fpga_reset() doesn't take the bus lock, it's also used from fatal()
 void fpga_reset(void);
+// Serializes FPGA SPI access between tasks. Every function here takes it, a
+// caller only needs it to keep a sequence of writes together.
+void fpga_lock(void);
+void fpga_unlock(void);
 void fpga_suspend(void);
 void fpga_resume(void);
 uint8_t fpga_write_reg8(uint8_t addr, uint8_t val);
 void fpga_write_reg16(uint8_t addr, uint16_t val);
 void fpga_write_bulk(uint8_t addr, uint8_t *buf, int length);
+void fpga_batch_begin(fpga_batch_t *batch);
+void fpga_batch_reg8(fpga_batch_t *batch, uint8_t addr, uint8_t val);
+void fpga_batch_reg16(fpga_batch_t *batch, uint8_t addr, uint16_t val);
+void fpga_batch_commit(fpga_batch_t *batch);
+void fpga_shadow_invalidate(void);
+void fpga_shadow_get_stats(fpga_shadow_stats_t *stats);
+void fpga_shadow_reset_stats(void);
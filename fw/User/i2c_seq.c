@@ -0,0 +1,132 @@
+//
+// Grimoire
+// Copyright 2025 Wenting Zhang
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#include "platform.h"
+#include "board.h"
+#include "app.h"
+
+// START + address + ACK, then 9 bits per byte, then STOP
+#define XFER_BITS(len)      (10 + 9 * (len) + 1)
+
+void i2c_seq_init(i2c_seq_t *seq, pal_i2c_xfer_t *xfers, size_t max_xfers,
+        uint8_t *data, size_t max_data) {
+    memset(seq, 0, sizeof(i2c_seq_t));
+    seq->xfers = xfers;
+    seq->max_xfers = max_xfers;
+    seq->data = data;
+    seq->max_data = max_data;
+}
+
+static pal_i2c_xfer_t *new_xfer(i2c_seq_t *seq, uint8_t addr, uint8_t reg) {
+    if (seq->count == seq->max_xfers) {
+        seq->overflow = true;
+        return NULL;
+    }
+    pal_i2c_xfer_t *xfer = &seq->xfers[seq->count++];
+    memset(xfer, 0, sizeof(pal_i2c_xfer_t));
+    xfer->addr = addr;
+    xfer->flags = PAL_I2C_XFER_REG;
+    xfer->reg = reg;
+    return xfer;
+}
+
+static int add_write(i2c_seq_t *seq, uint8_t addr, uint8_t reg, uint8_t val) {
+    if (seq->used == seq->max_data) {
+        seq->overflow = true;
+        return -1;
+    }
+    pal_i2c_xfer_t *last = seq->count ? &seq->xfers[seq->count - 1] : NULL;
+    if (!seq->open || (last->addr != addr) ||
+            ((size_t)last->reg + last->tx_len != reg)) {
+        last = new_xfer(seq, addr, reg);
+        if (!last)
+            return -1;
+        last->tx = &seq->data[seq->used];
+        seq->open = true;
+    }
+    seq->data[seq->used++] = val;
+    last->tx_len++;
+    seq->writes++;
+    return 0;
+}
+
+int i2c_seq_add_table(i2c_seq_t *seq, const uint8_t *table, size_t entries) {
+    for (size_t i = 0; i < entries; i++) {
+        if (add_write(seq, table[i * 3], table[i * 3 + 1], table[i * 3 + 2]))
+            return -1;
+    }
+    return 0;
+}
+
+int i2c_seq_add_block(i2c_seq_t *seq, uint8_t addr, uint8_t reg,
+        const uint8_t *buf, size_t len) {
+    pal_i2c_xfer_t *xfer = new_xfer(seq, addr, reg);
+    if (!xfer)
+        return -1;
+    xfer->tx = buf;
+    xfer->tx_len = len;
+    seq->writes += len;
+    seq->open = false;
+    return 0;
+}
+
+void i2c_seq_get_report(const i2c_seq_t *seq, i2c_seq_report_t *report) {
+    uint32_t bits = 0;
+    for (size_t i = 0; i < seq->count; i++)
+        bits += XFER_BITS(1 + seq->xfers[i].tx_len);
+    report->writes = seq->writes;
+    report->xfers = seq->count;
+    report->bus_us = (uint64_t)bits * 1000000 / I2C_SEQ_BUS_HZ;
+    report->single_us = (uint64_t)seq->writes * XFER_BITS(2) * 1000000 /
+            I2C_SEQ_BUS_HZ;
+    report->elapsed_ms = 0;
+}
+
+int i2c_seq_run(i2c_seq_t *seq, pal_i2c_t *i2c, i2c_seq_report_t *report) {
+    if (seq->overflow) {
+        syslog_printf("I2C sequence doesn't fit\n");
+        return -1;
+    }
+    TickType_t start = xTaskGetTickCount();
+    int result = pal_i2c_transfer(i2c, seq->xfers, seq->count,
+            PAL_I2C_PRIO_HIGH);
+    TickType_t elapsed = xTaskGetTickCount() - start;
+    if (result != 0) {
+        for (size_t i = 0; i < seq->count; i++) {
+            if (seq->xfers[i].result != 0)
+                syslog_printf("I2C write to %02x:%02x failed\n",
+                        seq->xfers[i].addr, seq->xfers[i].reg);
+        }
+    }
+    if (report) {
+        i2c_seq_get_report(seq, report);
+        report->elapsed_ms = elapsed * portTICK_PERIOD_MS;
+    }
+    return result;
+}
+
+void i2c_seq_print_report(const char *name, const i2c_seq_report_t *report) {
+    syslog_printf("%s: %d writes in %d transfers, bus %.1f ms "
+            "(%.1f ms unmerged), took %d ms\n", name, (int)report->writes,
+            (int)report->xfers, report->bus_us / 1000.0f,
+            report->single_us / 1000.0f, (int)report->elapsed_ms);
+}
@@ -0,0 +1,64 @@
+//
+// Grimoire
+// Copyright 2025 Wenting Zhang
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#pragma once
+
+#include "pal_i2c.h"
+
+// Register write sequences, compiled into as few I2C transactions as
+// possible. Tables are {device address, register, value} triples. Adjacent
+// entries for the same device with consecutive registers are merged into
+// one auto increment burst, table order is kept otherwise. The compiled
+// sequence goes out as a single pal_i2c_transfer() batch.
+
+// Bus clock assumed by the estimates in the report
+#define I2C_SEQ_BUS_HZ      (100000)
+
+typedef struct {
+    pal_i2c_xfer_t *xfers;
+    size_t max_xfers;
+    uint8_t *data;          // Values of merged table entries
+    size_t max_data;
+    size_t count;           // Transactions compiled
+    size_t used;            // Bytes of data used
+    uint32_t writes;        // Register writes added
+    bool open;              // Table entries may extend the last transaction
+    bool overflow;
+} i2c_seq_t;
+
+typedef struct {
+    uint32_t writes;        // Register writes
+    uint32_t xfers;         // Transactions after merging
+    uint32_t bus_us;        // Estimated bus time
+    uint32_t single_us;     // Estimated bus time, one transaction per write
+    uint32_t elapsed_ms;    // Measured by i2c_seq_run()
+} i2c_seq_report_t;
+
+void i2c_seq_init(i2c_seq_t *seq, pal_i2c_xfer_t *xfers, size_t max_xfers,
+        uint8_t *data, size_t max_data);
+int i2c_seq_add_table(i2c_seq_t *seq, const uint8_t *table, size_t entries);
+// buf is sent in place, it has to stay valid until the sequence has run
+int i2c_seq_add_block(i2c_seq_t *seq, uint8_t addr, uint8_t reg,
+        const uint8_t *buf, size_t len);
+void i2c_seq_get_report(const i2c_seq_t *seq, i2c_seq_report_t *report);
+int i2c_seq_run(i2c_seq_t *seq, pal_i2c_t *i2c, i2c_seq_report_t *report);
+void i2c_seq_print_report(const char *name, const i2c_seq_report_t *report);
@@ -0,0 +1,88 @@
+//
+// Grimoire
+// Copyright 2025 Wenting Zhang
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#include <stdint.h>
+#include <string.h>
+#include "lzb.h"
+
+static int read_length(const uint8_t **src, const uint8_t *end, int len) {
+    if (len != 15)
+        return len;
+    uint8_t b;
+    do {
+        if (*src >= end)
+            return -1;
+        b = *(*src)++;
+        len += b;
+    } while (b == 255);
+    return len;
+}
+
+int lzb_decompress(const uint8_t *src, int src_len, uint8_t *dst, int dst_len) {
+    const uint8_t *end = src + src_len;
+    uint8_t *op = dst;
+    uint8_t *op_end = dst + dst_len;
+
+    while (src < end) {
+        uint8_t token = *src++;
+
+        int lit = read_length(&src, end, token >> 4);
+        if ((lit < 0) || (lit > end - src) || (lit > op_end - op))
+            return -1;
+        memcpy(op, src, lit);
+        src += lit;
+        op += lit;
+
+        // Last sequence only has literals
+        if (src == end)
+            break;
+
+        if (end - src < 2)
+            return -1;
+        int offset = src[0] | (src[1] << 8);
+        src += 2;
+        int match = read_length(&src, end, token & 0xf);
+        if (match < 0)
+            return -1;
+        match += LZB_MIN_MATCH;
+        if ((offset == 0) || (offset > op - dst) || (match > op_end - op))
+            return -1;
+
+        uint8_t *ref = op - offset;
+        if (offset == 1) {
+            // Runs of the same byte, mostly zeros in the bitstream
+            memset(op, *ref, match);
+            op += match;
+        }
+        else if (offset >= match) {
+            memcpy(op, ref, match);
+            op += match;
+        }
+        else {
+            // Overlapping copy repeats the pattern
+            while (match--)
+                *op++ = *ref++;
+        }
+    }
+
+    return op - dst;
+}
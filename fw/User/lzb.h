@@ -0,0 +1,51 @@
+//
+// Grimoire
+// Copyright 2025 Wenting Zhang
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#pragma once
+
+#include <stdint.h>
+
+// Block compressed file format used for the FPGA bitstream. The file starts
+// with a lzb_header_t, followed by blocks that each decompress to block_size
+// bytes (the last one could be shorter). Every block is a little endian u16
+// length followed by that many bytes of data. If bit 15 of the length is set
+// the data is stored as is, otherwise it's LZ4 style sequences:
+//   token: literal length << 4 | (match length - 4)
+//   extra literal length bytes if the nibble is 15, each adds up to 255
+//   literals
+//   u16 match offset, little endian, not present in the last sequence
+//   extra match length bytes if the nibble is 15
+// Matches never reach outside of the block, so blocks decompress on their own.
+#define LZB_MAGIC           0x315a4c47  // "GLZ1"
+#define LZB_BLOCK_SIZE      4096
+#define LZB_BLOCK_STORED    0x8000
+#define LZB_MIN_MATCH       4
+
+typedef struct {
+    uint32_t magic;
+    uint32_t size;          // Decompressed size
+    uint32_t block_size;
+} lzb_header_t;
+
+// Returns the number of bytes written to dst, or -1 if src is corrupted or
+// doesn't fit in dst
+int lzb_decompress(const uint8_t *src, int src_len, uint8_t *dst, int dst_len);
@@ -21,24 +21,323 @@
 // SOFTWARE.
 //
 #include "platform.h"
-#include "pal_i2c.h"
+#include "board.h"
+#include "app.h"
 
 // Ugly
 #define I2C1_SCL        GPIOB, GPIO_PIN_6
 #define I2C1_SDA        GPIOB, GPIO_PIN_7
 
+// Longest NBYTES the peripheral takes, longer phases use RELOAD
+#define MAX_CHUNK       255
+
+typedef struct {
+    pal_i2c_xfer_t *head;
+    pal_i2c_xfer_t *tail;
+    uint32_t depth;
+    SemaphoreHandle_t lock;     // One blocking caller per queue at a time
+    SemaphoreHandle_t done;     // Given when its last transfer completes
+} xfer_queue_t;
+
 struct pal_i2c_t {
-    SemaphoreHandle_t lock;
+    SemaphoreHandle_t lock;     // Held across pal_i2c_ll_* sessions
     I2C_TypeDef *port;
+    xfer_queue_t queue[PAL_I2C_PRIO_COUNT];
+    pal_i2c_xfer_t *cur;        // Transfer on the bus, NULL when idle
+    bool read;                  // cur is in its read phase
+    bool error;                 // cur got a NACK
+    size_t pos;                 // Bytes moved in the current phase
+    bool exclusive;             // LL session, don't start transfers
+    bool idle_wait;             // LL session waiting for cur to finish
+    SemaphoreHandle_t idle;
+    pal_i2c_stats_t stats;
 };
 
 struct pal_i2c_t pi2c1;
 
-extern I2C_HandleTypeDef hi2c1;
-
 void pal_i2c_init(void) {
     pi2c1.port = I2C1;
     pi2c1.lock = xSemaphoreCreateMutex();
+    pi2c1.idle = xSemaphoreCreateBinary();
+    for (int i = 0; i < PAL_I2C_PRIO_COUNT; i++) {
+        pi2c1.queue[i].lock = xSemaphoreCreateMutex();
+        pi2c1.queue[i].done = xSemaphoreCreateBinary();
+    }
+}
+
+static void irq_enable(I2C_TypeDef *port) {
+    LL_I2C_EnableIT_TX(port);
+    LL_I2C_EnableIT_RX(port);
+    LL_I2C_EnableIT_TC(port);
+    LL_I2C_EnableIT_STOP(port);
+    LL_I2C_EnableIT_NACK(port);
+    LL_I2C_EnableIT_ERR(port);
+}
+
+static void irq_disable(I2C_TypeDef *port) {
+    LL_I2C_DisableIT_TX(port);
+    LL_I2C_DisableIT_RX(port);
+    LL_I2C_DisableIT_TC(port);
+    LL_I2C_DisableIT_STOP(port);
+    LL_I2C_DisableIT_NACK(port);
+    LL_I2C_DisableIT_ERR(port);
+}
+
+// Clearing PE resets the state machine and releases the bus
+static void port_reset(I2C_TypeDef *port) {
+    irq_disable(port);
+    LL_I2C_Disable(port);
+    while (LL_I2C_IsEnabled(port));
+    LL_I2C_Enable(port);
+}
+
+static size_t phase_len(pal_i2c_t *i2c) {
+    pal_i2c_xfer_t *xfer = i2c->cur;
+    if (i2c->read)
+        return xfer->rx_len;
+    return xfer->tx_len + ((xfer->flags & PAL_I2C_XFER_REG) ? 1 : 0);
+}
+
+static uint8_t tx_byte(pal_i2c_xfer_t *xfer, size_t pos) {
+    if (xfer->flags & PAL_I2C_XFER_REG) {
+        if (pos == 0)
+            return xfer->reg;
+        pos--;
+    }
+    return (pos < xfer->tx_len) ? xfer->tx[pos] : 0xff;
+}
+
+static void phase_start(pal_i2c_t *i2c, bool read, uint32_t request) {
+    i2c->read = read;
+    i2c->pos = 0;
+    size_t len = phase_len(i2c);
+    LL_I2C_HandleTransfer(i2c->port, i2c->cur->addr << 1,
+        LL_I2C_ADDRSLAVE_7BIT, (len > MAX_CHUNK) ? MAX_CHUNK : len,
+        (len > MAX_CHUNK) ? LL_I2C_MODE_RELOAD : LL_I2C_MODE_SOFTEND,
+        request);
+}
+
+// Start the next queued transfer if the bus is free. Runs in the interrupt
+// or in a critical section.
+static void engine_kick(pal_i2c_t *i2c) {
+    if (i2c->cur)
+        return;
+    if (!i2c->exclusive) {
+        for (int i = 0; i < PAL_I2C_PRIO_COUNT; i++) {
+            xfer_queue_t *queue = &i2c->queue[i];
+            pal_i2c_xfer_t *xfer = queue->head;
+            if (!xfer)
+                continue;
+            queue->head = xfer->next;
+            if (!queue->head)
+                queue->tail = NULL;
+            queue->depth--;
+            i2c->cur = xfer;
+            i2c->error = false;
+            irq_enable(i2c->port);
+            if ((xfer->flags & PAL_I2C_XFER_REG) || xfer->tx_len ||
+                    !xfer->rx_len)
+                phase_start(i2c, false, LL_I2C_GENERATE_START_WRITE);
+            else
+                phase_start(i2c, true, LL_I2C_GENERATE_START_READ);
+            return;
+        }
+    }
+    irq_disable(i2c->port);
+    if (i2c->idle_wait) {
+        i2c->idle_wait = false;
+        xSemaphoreGiveFromISR(i2c->idle, NULL);
+    }
+}
+
+static void xfer_finish(pal_i2c_t *i2c, int result) {
+    pal_i2c_xfer_t *xfer = i2c->cur;
+    i2c->cur = NULL;
+    i2c->stats.xfers++;
+    if (result != 0)
+        i2c->stats.failed++;
+    xfer->result = result;
+    if (xfer->done)
+        xfer->done(xfer);
+    engine_kick(i2c);
+}
+
+static void enqueue(pal_i2c_t *i2c, pal_i2c_xfer_t *xfer, pal_i2c_prio_t prio) {
+    xfer_queue_t *queue = &i2c->queue[prio];
+    xfer->result = PAL_I2C_PENDING;
+    xfer->next = NULL;
+    if (queue->tail)
+        queue->tail->next = xfer;
+    else
+        queue->head = xfer;
+    queue->tail = xfer;
+    queue->depth++;
+    uint32_t depth = 0;
+    for (int i = 0; i < PAL_I2C_PRIO_COUNT; i++)
+        depth += i2c->queue[i].depth;
+    if (depth > i2c->stats.max_queued)
+        i2c->stats.max_queued = depth;
+}
+
+// Drop a transfer that is still pending, in a critical section
+static void cancel(pal_i2c_t *i2c, pal_i2c_xfer_t *xfer, pal_i2c_prio_t prio) {
+    if (xfer->result != PAL_I2C_PENDING)
+        return;
+    if (i2c->cur == xfer) {
+        port_reset(i2c->port);
+        xfer_finish(i2c, -1);
+        return;
+    }
+    xfer_queue_t *queue = &i2c->queue[prio];
+    pal_i2c_xfer_t **link = &queue->head;
+    pal_i2c_xfer_t *prev = NULL;
+    while (*link && (*link != xfer)) {
+        prev = *link;
+        link = &(*link)->next;
+    }
+    if (!*link)
+        return;
+    *link = xfer->next;
+    if (queue->tail == xfer)
+        queue->tail = prev;
+    queue->depth--;
+    xfer->result = -1;
+    i2c->stats.failed++;
+}
+
+void pal_i2c_ev_isr(pal_i2c_t *i2c) {
+    I2C_TypeDef *port = i2c->port;
+    pal_i2c_xfer_t *xfer = i2c->cur;
+    i2c->stats.irqs++;
+    if (!xfer) {
+        irq_disable(port);
+        return;
+    }
+    uint32_t isr = LL_I2C_ReadReg(port, ISR);
+    if (isr & I2C_ISR_NACKF) {
+        // The peripheral sends STOP by itself, finish on STOPF
+        LL_I2C_ClearFlag_NACK(port);
+        i2c->error = true;
+    }
+    else if (isr & I2C_ISR_TXIS) {
+        LL_I2C_TransmitData8(port, tx_byte(xfer, i2c->pos++));
+        i2c->stats.bytes++;
+    }
+    else if (isr & I2C_ISR_RXNE) {
+        uint8_t val = LL_I2C_ReceiveData8(port);
+        if (i2c->pos < xfer->rx_len)
+            xfer->rx[i2c->pos] = val;
+        i2c->pos++;
+        i2c->stats.bytes++;
+    }
+    if (isr & I2C_ISR_TCR) {
+        size_t left = phase_len(i2c) - i2c->pos;
+        if (left <= MAX_CHUNK)
+            LL_I2C_DisableReloadMode(port);
+        LL_I2C_SetTransferSize(port, (left > MAX_CHUNK) ? MAX_CHUNK : left);
+    }
+    if (isr & I2C_ISR_TC) {
+        if (!i2c->read && xfer->rx_len)
+            phase_start(i2c, true, LL_I2C_GENERATE_RESTART_7BIT_READ);
+        else
+            LL_I2C_GenerateStopCondition(port);
+    }
+    if (isr & I2C_ISR_STOPF) {
+        LL_I2C_ClearFlag_STOP(port);
+        xfer_finish(i2c, i2c->error ? -1 : 0);
+    }
+}
+
+void pal_i2c_er_isr(pal_i2c_t *i2c) {
+    I2C_TypeDef *port = i2c->port;
+    i2c->stats.irqs++;
+    LL_I2C_ClearFlag_BERR(port);
+    LL_I2C_ClearFlag_ARLO(port);
+    LL_I2C_ClearFlag_OVR(port);
+    port_reset(port);
+    if (i2c->cur)
+        xfer_finish(i2c, -1);
+    else
+        engine_kick(i2c);
+}
+
+void pal_i2c_submit(pal_i2c_t *i2c, pal_i2c_xfer_t *xfer, pal_i2c_prio_t prio) {
+    taskENTER_CRITICAL();
+    enqueue(i2c, xfer, prio);
+    engine_kick(i2c);
+    taskEXIT_CRITICAL();
+}
+
+static void transfer_done(pal_i2c_xfer_t *xfer) {
+    BaseType_t woken = pdFALSE;
+    xSemaphoreGiveFromISR(((xfer_queue_t *)xfer->ctx)->done, &woken);
+    portYIELD_FROM_ISR(woken);
+}
+
+// Queue the transfers back to back and block until the last one is done.
+// done and ctx of the transfers are overwritten. Returns -1 if any failed.
+int pal_i2c_transfer(pal_i2c_t *i2c, pal_i2c_xfer_t *xfers, size_t count,
+        pal_i2c_prio_t prio) {
+    xfer_queue_t *queue = &i2c->queue[prio];
+    if (count == 0)
+        return 0;
+    xSemaphoreTake(queue->lock, portMAX_DELAY);
+    size_t bytes = 0;
+    for (size_t i = 0; i < count; i++) {
+        xfers[i].done = NULL;
+        bytes += xfers[i].tx_len + xfers[i].rx_len + 1;
+    }
+    xfers[count - 1].done = transfer_done;
+    xfers[count - 1].ctx = queue;
+    taskENTER_CRITICAL();
+    for (size_t i = 0; i < count; i++)
+        enqueue(i2c, &xfers[i], prio);
+    engine_kick(i2c);
+    taskEXIT_CRITICAL();
+    // A byte takes 90us at 100kHz, allow 125us. Lower priority transfers
+    // wait for the higher queue to drain as well.
+    TickType_t timeout = pdMS_TO_TICKS((PAL_I2C_TIMEOUT_MS * count +
+            bytes / 8) * (prio + 1));
+    if (xSemaphoreTake(queue->done, timeout) == pdTRUE) {
+        i2c->stats.wakeups++;
+    }
+    else {
+        taskENTER_CRITICAL();
+        for (size_t i = 0; i < count; i++)
+            cancel(i2c, &xfers[i], prio);
+        taskEXIT_CRITICAL();
+        // The last transfer may have finished right before it's cancelled
+        xSemaphoreTake(queue->done, 0);
+        i2c->stats.timeouts++;
+        syslog_printf("I2C timeout\n");
+    }
+    int result = 0;
+    for (size_t i = 0; i < count; i++) {
+        if (xfers[i].result != 0)
+            result = -1;
+    }
+    xSemaphoreGive(queue->lock);
+    return result;
+}
+
+void pal_i2c_get_stats(pal_i2c_t *i2c, pal_i2c_stats_t *stats) {
+    taskENTER_CRITICAL();
+    *stats = i2c->stats;
+    taskEXIT_CRITICAL();
+}
+
+static int xfer_one(pal_i2c_t *i2c, uint8_t addr, const uint8_t *reg,
+        const uint8_t *tx, size_t tx_len, uint8_t *rx, size_t rx_len) {
+    pal_i2c_xfer_t xfer = {
+        .addr = addr,
+        .flags = reg ? PAL_I2C_XFER_REG : 0,
+        .reg = reg ? *reg : 0,
+        .tx = tx,
+        .tx_len = tx_len,
+        .rx = rx,
+        .rx_len = rx_len
+    };
+    return pal_i2c_transfer(i2c, &xfer, 1, PAL_I2C_PRIO_HIGH);
 }
 
 bool pal_i2c_ll_start(pal_i2c_t *i2c, uint32_t request, uint8_t slave_addr, uint8_t transfer_size) {
@@ -115,136 +414,68 @@ void pal_i2c_ll_stop(pal_i2c_t *i2c) {
     while(LL_I2C_IsActiveFlag_BUSY(port));
 }
 
+// The LL functions poll the peripheral directly. Hold off the queues for
+// the whole session and wait for the transfer on the bus to finish.
 void pal_i2c_ll_lock(pal_i2c_t *i2c) {
     xSemaphoreTake(i2c->lock, portMAX_DELAY);
+    taskENTER_CRITICAL();
+    i2c->exclusive = true;
+    bool busy = (i2c->cur != NULL);
+    i2c->idle_wait = busy;
+    taskEXIT_CRITICAL();
+    if (busy && (xSemaphoreTake(i2c->idle,
+            pdMS_TO_TICKS(PAL_I2C_TIMEOUT_MS)) != pdTRUE)) {
+        taskENTER_CRITICAL();
+        i2c->idle_wait = false;
+        if (i2c->cur) {
+            port_reset(i2c->port);
+            xfer_finish(i2c, -1);
+        }
+        taskEXIT_CRITICAL();
+        // Finished right before the reset
+        xSemaphoreTake(i2c->idle, 0);
+        i2c->stats.timeouts++;
+    }
 }
 
 void pal_i2c_ll_unlock(pal_i2c_t *i2c) {
+    taskENTER_CRITICAL();
+    i2c->exclusive = false;
+    engine_kick(i2c);
+    taskEXIT_CRITICAL();
     xSemaphoreGive(i2c->lock);
 }
 
 int pal_i2c_write_byte(pal_i2c_t *i2c, uint8_t addr, uint8_t val) {
-    int result = -1;
-    xSemaphoreTake(i2c->lock, portMAX_DELAY);
-    if (!pal_i2c_ll_start(i2c, REQ_WRITE, addr << 1, 1))
-        goto i2c_stop_point;
-    if (!pal_i2c_ll_send(i2c, val))
-        goto i2c_stop_point;
-    result = 0;
-i2c_stop_point:
-    pal_i2c_ll_stop(i2c);
-    xSemaphoreGive(i2c->lock);
-    return result;
+    return xfer_one(i2c, addr, NULL, &val, 1, NULL, 0);
 }
 
 int pal_i2c_write_reg(pal_i2c_t *i2c, uint8_t addr, uint8_t reg, uint8_t val) {
-    int result = -1;
-    xSemaphoreTake(i2c->lock, portMAX_DELAY);
-    if (!pal_i2c_ll_start(i2c, REQ_WRITE, addr << 1, 2))
-        goto i2c_stop_point;
-    if (!pal_i2c_ll_send(i2c, reg))
-        goto i2c_stop_point;
-    if (!pal_i2c_ll_send(i2c, val))
-        goto i2c_stop_point;
-    result = 0;
-i2c_stop_point:
-    pal_i2c_ll_stop(i2c);
-    xSemaphoreGive(i2c->lock);
-    return result;
+    return xfer_one(i2c, addr, &reg, &val, 1, NULL, 0);
 }
 
 int pal_i2c_write_longreg(pal_i2c_t *i2c, uint8_t addr, uint8_t reg, uint8_t *payload, size_t len) {
-    int result = -1;
-    xSemaphoreTake(i2c->lock, portMAX_DELAY);
-    if (!pal_i2c_ll_start(i2c, REQ_WRITE, addr << 1, 1 + len))
-        goto i2c_stop_point;
-    if (!pal_i2c_ll_send(i2c, reg))
-        goto i2c_stop_point;
-    for (int i = 0; i < len; i++) {
-        if (!pal_i2c_ll_send(i2c, payload[i]))
-            goto i2c_stop_point;
-    }
-    result = 0;
-i2c_stop_point:
-    pal_i2c_ll_stop(i2c);
-    xSemaphoreGive(i2c->lock);
-    return result;
+    return xfer_one(i2c, addr, &reg, payload, len, NULL, 0);
 }
 
 int pal_i2c_write_payload(pal_i2c_t *i2c, uint8_t addr, uint8_t *payload, size_t len) {
-    int result = -1;
-    xSemaphoreTake(i2c->lock, portMAX_DELAY);
-    if (!pal_i2c_ll_start(i2c, REQ_WRITE, addr << 1, len))
-        goto i2c_stop_point;
-    for (int i = 0; i < len; i++) {
-        if (!pal_i2c_ll_send(i2c, payload[i]))
-            goto i2c_stop_point;
-    }
-    result = 0;
-i2c_stop_point:
-    pal_i2c_ll_stop(i2c);
-    xSemaphoreGive(i2c->lock);
-    return result;
+    return xfer_one(i2c, addr, NULL, payload, len, NULL, 0);
 }
 
 int pal_i2c_read_reg(pal_i2c_t *i2c, uint8_t addr, uint8_t reg, uint8_t *val) {
-    int result = -1;
-    xSemaphoreTake(i2c->lock, portMAX_DELAY);
-    if (!pal_i2c_ll_start(i2c, REQ_WRITE, addr << 1, 1))
-        goto i2c_stop_point;
-    if (!pal_i2c_ll_send(i2c, reg))
-        goto i2c_stop_point;
-    if (!pal_i2c_ll_start(i2c, REQ_RESTART_READ, addr << 1, 1))
-        goto i2c_stop_point;
-    if (!pal_i2c_ll_recv(i2c, val))
-        goto i2c_stop_point;
-    result = 0;
-i2c_stop_point:
-    pal_i2c_ll_stop(i2c);
-    xSemaphoreGive(i2c->lock);
-    return result;
+    return xfer_one(i2c, addr, &reg, NULL, 0, val, 1);
 }
 
 int pal_i2c_read_payload(pal_i2c_t *i2c, uint8_t addr, uint8_t *tx_payload, size_t tx_len, uint8_t *rx_payload, size_t rx_len) {
-    int result = -1;
-    xSemaphoreTake(i2c->lock, portMAX_DELAY);
-    if (!pal_i2c_ll_start(i2c, REQ_WRITE, addr << 1, tx_len))
-        goto i2c_stop_point;
-    for (int i = 0; i < tx_len; i++) {
-        if (!pal_i2c_ll_send(i2c, tx_payload[i]))
-            goto i2c_stop_point;
-    }
-    if (!pal_i2c_ll_start(i2c, REQ_RESTART_READ, addr << 1, rx_len))
-        goto i2c_stop_point;
-    for (int i = 0; i < rx_len; i++) {
-        if (!pal_i2c_ll_recv(i2c, &rx_payload[i]))
-            goto i2c_stop_point;
-    }
-    result = 0;
-i2c_stop_point:
-    pal_i2c_ll_stop(i2c);
-    xSemaphoreGive(i2c->lock);
-    return result;
+    return xfer_one(i2c, addr, NULL, tx_payload, tx_len, rx_payload, rx_len);
 }
 
 int pal_i2c_read_byte(pal_i2c_t *i2c, uint8_t addr, uint8_t *val) {
-    int result = -1;
-    xSemaphoreTake(i2c->lock, portMAX_DELAY);
-    if (!pal_i2c_ll_start(i2c, REQ_READ, addr << 1, 1))
-        goto i2c_stop_point;
-    if (!pal_i2c_ll_recv(i2c, val))
-        goto i2c_stop_point;
-    result = 0;
-i2c_stop_point:
-    pal_i2c_ll_stop(i2c);
-    xSemaphoreGive(i2c->lock);
-    return result;
+    return xfer_one(i2c, addr, NULL, NULL, 0, val, 1);
 }
 
 bool pal_i2c_ping(pal_i2c_t *i2c, uint8_t addr) {
-    bool result = true;
-    I2C_TypeDef* port = i2c->port;
-    xSemaphoreTake(i2c->lock, portMAX_DELAY);
+    pal_i2c_ll_lock(i2c);
 
     // Switch to GPIO emulated I2C
     HAL_GPIO_WritePin(I2C1_SDA, 1);
@@ -301,6 +532,6 @@ bool pal_i2c_ping(pal_i2c_t *i2c, uint8_t addr) {
     GPIO_InitStruct.Alternate = LL_GPIO_AF_4;
     LL_GPIO_Init(GPIOB, &GPIO_InitStruct);
 
-    xSemaphoreGive(i2c->lock);
+    pal_i2c_ll_unlock(i2c);
     return !ack;
 }
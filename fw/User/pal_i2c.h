@@ -27,7 +27,55 @@ typedef struct pal_i2c_t pal_i2c_t;
 
 extern pal_i2c_t pi2c1;
 
+// Asynchronous transfers. A transfer writes reg (with PAL_I2C_XFER_REG) and
+// tx, then reads rx after a repeated START, then STOPs. Either phase may be
+// empty. Transfers are queued per priority and run back to back from the
+// I2C interrupt, high priority first. done() is called from the interrupt
+// once result is set, and may be NULL.
+#define PAL_I2C_XFER_REG        (1 << 0)
+#define PAL_I2C_PENDING         (1)
+// Per transfer timeout for the blocking calls
+#define PAL_I2C_TIMEOUT_MS      (20)
+
+typedef enum {
+    PAL_I2C_PRIO_HIGH = 0,  // Interactive accesses, the blocking calls below
+    PAL_I2C_PRIO_LOW,       // Background polling, runs when HIGH is empty
+    PAL_I2C_PRIO_COUNT
+} pal_i2c_prio_t;
+
+typedef struct pal_i2c_xfer pal_i2c_xfer_t;
+
+struct pal_i2c_xfer {
+    uint8_t addr;
+    uint8_t flags;
+    uint8_t reg;
+    const uint8_t *tx;
+    size_t tx_len;
+    uint8_t *rx;
+    size_t rx_len;
+    void (*done)(pal_i2c_xfer_t *xfer);
+    void *ctx;
+    volatile int result;    // PAL_I2C_PENDING, then 0 or -1
+    pal_i2c_xfer_t *next;   // Used by the queue
+};
+
+typedef struct {
+    uint32_t xfers;         // Completed transfers
+    uint32_t failed;        // NACK, bus error or timeout
+    uint32_t timeouts;
+    uint32_t bytes;
+    uint32_t irqs;
+    uint32_t wakeups;       // pal_i2c_transfer() callers woken when done
+    uint32_t max_queued;    // Queue depth high watermark
+} pal_i2c_stats_t;
+
 void pal_i2c_init(void);
+void pal_i2c_submit(pal_i2c_t *i2c, pal_i2c_xfer_t *xfer, pal_i2c_prio_t prio);
+int pal_i2c_transfer(pal_i2c_t *i2c, pal_i2c_xfer_t *xfers, size_t count,
+        pal_i2c_prio_t prio);
+void pal_i2c_get_stats(pal_i2c_t *i2c, pal_i2c_stats_t *stats);
+void pal_i2c_ev_isr(pal_i2c_t *i2c);
+void pal_i2c_er_isr(pal_i2c_t *i2c);
 int pal_i2c_write_byte(pal_i2c_t *i2c, uint8_t addr, uint8_t val);
 int pal_i2c_write_reg(pal_i2c_t *i2c, uint8_t addr, uint8_t reg, uint8_t val);
 int pal_i2c_write_longreg(pal_i2c_t *i2c, uint8_t addr, uint8_t reg, uint8_t *payload, size_t len);
@@ -39,3 +39,4 @@
 #include "task.h"
 #include "queue.h"
 #include "stream_buffer.h"
+#include "timers.h"
@@ -256,10 +256,32 @@ portTASK_FUNCTION(power_monitor_task, pvParameters) {
         INA3221_2_I2C_ADDR, 0x02,
         INA3221_2_I2C_ADDR, 0x04,
     };
+    // All 16 readings go out as one batch on the low priority queue, so
+    // the task sleeps through the whole round and other I2C users only
+    // ever wait for a single register read
+    static pal_i2c_xfer_t ina_xfers[16];
+    static uint8_t ina_buf[16][2];
+    for (int i = 0; i < 8; i++) {
+        ina_xfers[i * 2].addr = ina_shunt_regs[i * 2];
+        ina_xfers[i * 2].reg = ina_shunt_regs[i * 2 + 1];
+        ina_xfers[i * 2 + 1].addr = ina_bus_regs[i * 2];
+        ina_xfers[i * 2 + 1].reg = ina_bus_regs[i * 2 + 1];
+    }
+    for (int i = 0; i < 16; i++) {
+        ina_xfers[i].flags = PAL_I2C_XFER_REG;
+        ina_xfers[i].rx = ina_buf[i];
+        ina_xfers[i].rx_len = 2;
+    }
     while (1) {
+        if (pal_i2c_transfer(INA3221_I2C, ina_xfers, 16, PAL_I2C_PRIO_LOW) != 0) {
+            syslog_printf("Failed reading data from INA3221\n");
+        }
         for (int i = 0; i < 8; i++) {
-            currents[i] = convert_shunt_current(ina_read(ina_shunt_regs[i * 2], ina_shunt_regs[i * 2 + 1]));
-            voltages[i] = convert_bus_voltage(ina_read(ina_bus_regs[i * 2], ina_bus_regs[i * 2 + 1]));
+            // Keep the last good value of a failed read
+            if (ina_xfers[i * 2].result == 0)
+                currents[i] = convert_shunt_current(((uint16_t)ina_buf[i * 2][0] << 8) | ina_buf[i * 2][1]);
+            if (ina_xfers[i * 2 + 1].result == 0)
+                voltages[i] = convert_bus_voltage(((uint16_t)ina_buf[i * 2 + 1][0] << 8) | ina_buf[i * 2 + 1][1]);
         }
         if (adc_conv_done == true) {
             // Update numbers
@@ -56,17 +56,25 @@ void ptn3460_early_init(void) {
     gpio_put(DP_PDN, 1);
 }
 
-void ptn3460_init(void) {
+// Waits for the PTN3460 internal boot after ptn3460_early_init(). No I2C
+// access, so the boot sequence runs other steps meanwhile. Returns false if
+// HPD doesn't come up within PTN3460_READY_TIMEOUT_MS.
+bool ptn3460_wait_ready(void) {
     // wait for HPD to become high
     int ticks = 0;
     while (gpio_get(DP_HPD) != true) {
         ticks ++;
-        if (ticks > 500) {
+        if (ticks == PTN3460_READY_TIMEOUT_MS) {
             syslog_printf("PTN3460 boot timeout\n");
+            return false;
         }
         sleep_ms(1);
     }
     syslog_printf("PTN3460 up after %d ms\n", ticks);
+    return true;
+}
+
+void ptn3460_init(void) {
     // Enable EDID emulation
     ptn3460_select_edid_emulation(0);
     ptn3460_load_edid(edid_get_raw());
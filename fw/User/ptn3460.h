@@ -22,6 +22,10 @@
 //
 #pragma once
 
+// HPD normally comes up in 100 to 500 ms
+#define PTN3460_READY_TIMEOUT_MS    1000
+
 void ptn3460_early_init(void);
+bool ptn3460_wait_ready(void);
 void ptn3460_init(void);
 void ptn3460_set_aux_polarity(int reverse);
@@ -0,0 +1,429 @@
+//
+// Grimoire
+// Copyright 2025 Wenting Zhang
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#include "platform.h"
+#include "board.h"
+#include "app.h"
+
+// Coordinates are half open, x1 and y1 are not part of the region
+
+typedef struct {
+    uint16_t x0;
+    uint16_t x1;
+    uint16_t y0;            // Band the rect started in
+    uint8_t mode;
+    bool matched;
+} open_rect_t;
+
+static region_table_t table;
+static region_stats_t stats;
+static bool dirty;          // Ops were dropped, the FPGA mode map is off
+static caster_op_t ops[REGION_MAX_OPS];
+static SemaphoreHandle_t region_lock;   // table
+static SemaphoreHandle_t send_lock;     // Everything else
+
+// Scratch for region_diff() and region_ops()
+static uint16_t xs[REGION_MAX_EDGES];
+static uint16_t ys[REGION_MAX_EDGES];
+static open_rect_t open_rects[REGION_MAX_EDGES];
+static open_rect_t spans[REGION_MAX_EDGES];
+static caster_op_t painted[REGION_MAX + 1];
+
+static void add_edge(uint16_t *edges, int *count, uint16_t v, uint16_t lo,
+        uint16_t hi) {
+    if ((v <= lo) || (v >= hi))
+        return; // Area bounds are added separately
+    int i = *count;
+    while ((i > 0) && (edges[i - 1] > v)) {
+        edges[i] = edges[i - 1];
+        i--;
+    }
+    if ((i > 0) && (edges[i - 1] == v)) {
+        // Already there, undo the shift
+        memmove(&edges[i], &edges[i + 1], sizeof(uint16_t) * (*count - i));
+        return;
+    }
+    edges[i] = v;
+    (*count)++;
+}
+
+static void add_table_edges(const region_table_t *t, const caster_op_t *area,
+        int *nx, int *ny) {
+    for (int i = 0; i < t->count; i++) {
+        const region_t *r = &t->regions[i];
+        add_edge(xs, nx, r->x0, area->x0, area->x1);
+        add_edge(xs, nx, r->x1, area->x0, area->x1);
+        add_edge(ys, ny, r->y0, area->y0, area->y1);
+        add_edge(ys, ny, r->y1, area->y0, area->y1);
+    }
+}
+
+uint8_t region_mode_at(const region_table_t *t, uint16_t x, uint16_t y) {
+    for (int i = t->count - 1; i >= 0; i--) {
+        const region_t *r = &t->regions[i];
+        if ((x >= r->x0) && (x < r->x1) && (y >= r->y0) && (y < r->y1))
+            return r->mode;
+    }
+    return t->background;
+}
+
+static bool emit(caster_op_t *ops, int *count, int max_ops,
+        const open_rect_t *rect, uint16_t y1) {
+    if (*count == max_ops)
+        return false;
+    caster_op_t *op = &ops[(*count)++];
+    memset(op, 0, sizeof(caster_op_t));
+    op->cmd = OP_EXT_SETMODE;
+    op->param = rect->mode;
+    op->x0 = rect->x0;
+    op->x1 = rect->x1;
+    op->y0 = rect->y0;
+    op->y1 = y1;
+    return true;
+}
+
+int region_diff(const region_table_t *from, const region_table_t *to,
+        const caster_op_t *area, caster_op_t *ops, int max_ops) {
+    if ((area->x0 >= area->x1) || (area->y0 >= area->y1))
+        return 0;
+    // Every region edge inside the area is a grid line, so each cell is
+    // either fully inside or fully outside of any region
+    int nx = 1, ny = 1;
+    xs[0] = area->x0;
+    ys[0] = area->y0;
+    add_table_edges(from, area, &nx, &ny);
+    add_table_edges(to, area, &nx, &ny);
+    xs[nx++] = area->x1;
+    ys[ny++] = area->y1;
+
+    int count = 0;
+    int open_count = 0;
+    for (int j = 0; j < ny - 1; j++) {
+        // Changed cells of this band, runs of the same mode joined
+        int span_count = 0;
+        for (int i = 0; i < nx - 1; i++) {
+            uint8_t mode = region_mode_at(to, xs[i], ys[j]);
+            // Nothing to go back to where the background isn't known
+            if ((mode == REGION_MODE_UNKNOWN) ||
+                    (region_mode_at(from, xs[i], ys[j]) == mode))
+                continue;
+            if ((span_count != 0) && (spans[span_count - 1].x1 == xs[i]) &&
+                    (spans[span_count - 1].mode == mode)) {
+                spans[span_count - 1].x1 = xs[i + 1];
+                continue;
+            }
+            open_rect_t *span = &spans[span_count++];
+            span->x0 = xs[i];
+            span->x1 = xs[i + 1];
+            span->y0 = ys[j];
+            span->mode = mode;
+        }
+        // Spans identical to one of the band above extend it downwards
+        for (int k = 0; k < open_count; k++)
+            open_rects[k].matched = false;
+        for (int s = 0; s < span_count; s++) {
+            spans[s].matched = false;
+            for (int k = 0; k < open_count; k++) {
+                if ((open_rects[k].x0 == spans[s].x0) &&
+                        (open_rects[k].x1 == spans[s].x1) &&
+                        (open_rects[k].mode == spans[s].mode)) {
+                    open_rects[k].matched = true;
+                    spans[s].matched = true;
+                    break;
+                }
+            }
+        }
+        int kept = 0;
+        for (int k = 0; k < open_count; k++) {
+            if (open_rects[k].matched)
+                open_rects[kept++] = open_rects[k];
+            else if (!emit(ops, &count, max_ops, &open_rects[k], ys[j]))
+                return -1;
+        }
+        open_count = kept;
+        for (int s = 0; s < span_count; s++) {
+            if (!spans[s].matched)
+                open_rects[open_count++] = spans[s];
+        }
+    }
+    for (int k = 0; k < open_count; k++) {
+        if (!emit(ops, &count, max_ops, &open_rects[k], area->y1))
+            return -1;
+    }
+    return count;
+}
+
+static void screen_area(caster_op_t *area) {
+    memset(area, 0, sizeof(caster_op_t));
+    area->cmd = OP_EXT_SETMODE;
+    area->x1 = config.hact;
+    area->y1 = config.vact;
+}
+
+// Ops that don't overlap can't be reordered in a way that matters, so
+// painting the area bottom to top is just as correct as the diff. At most
+// REGION_MAX + 1 ops.
+int region_paint(const region_table_t *t, const caster_op_t *area,
+        caster_op_t *ops) {
+    int count = 0;
+    caster_op_t op = *area;
+    op.param = t->background;
+    if (t->background != REGION_MODE_UNKNOWN)
+        ops[count++] = op;
+    for (int i = 0; i < t->count; i++) {
+        const region_t *r = &t->regions[i];
+        op.x0 = (r->x0 > area->x0) ? r->x0 : area->x0;
+        op.y0 = (r->y0 > area->y0) ? r->y0 : area->y0;
+        op.x1 = (r->x1 < area->x1) ? r->x1 : area->x1;
+        op.y1 = (r->y1 < area->y1) ? r->y1 : area->y1;
+        if ((op.x0 >= op.x1) || (op.y0 >= op.y1))
+            continue;
+        op.param = r->mode;
+        ops[count++] = op;
+    }
+    return count;
+}
+
+// The diff splits a window moved diagonally into the L shapes it left and
+// entered, painting over the area both cover is one op per region in it.
+// Ties go to the diff, it touches fewer pixels.
+int region_ops(const region_table_t *from, const region_table_t *to,
+        const caster_op_t *area, caster_op_t *ops, bool *repaint) {
+    int paint_count = region_paint(to, area, painted);
+    int count = region_diff(from, to, area, ops, paint_count);
+    *repaint = (count < 0);
+    if (count < 0) {
+        memcpy(ops, painted, sizeof(caster_op_t) * paint_count);
+        count = paint_count;
+    }
+    return count;
+}
+
+// Build the ops turning the current table into next within area, then make
+// next current. If earlier ops didn't make it to the FPGA, the whole table
+// is painted instead, or left to region_refresh() for callers that can't
+// wait. Called with both locks held, returns the op count or -1 if left.
+static int apply(const region_table_t *next, const caster_op_t *area,
+        TickType_t wait) {
+    stats.changes++;
+    int count;
+    if (dirty && !wait) {
+        table = *next;
+        return -1;
+    }
+    if (dirty) {
+        caster_op_t screen;
+        screen_area(&screen);
+        count = region_paint(next, &screen, ops);
+    }
+    else {
+        bool repaint;
+        count = region_ops(&table, next, area, ops, &repaint);
+        if (repaint)
+            stats.repaints++;
+    }
+    table = *next;
+    dirty = false;
+    return count;
+}
+
+// Only send_lock held, so the table can be read meanwhile. Stops at the first
+// op the caster queue doesn't take instead of waiting for each of the rest,
+// the mode map is then sent again in full.
+static uint8_t send(int count, TickType_t wait) {
+    for (int i = 0; i < count; i++) {
+        const caster_op_t *op = &ops[i];
+        if (caster_queue_setmode(op->x0, op->y0, op->x1, op->y1,
+                (update_mode_t)op->param, wait)) {
+            stats.failed += count - i;
+            dirty = true;
+            return REGION_DROPPED;
+        }
+        stats.ops++;
+        stats.pixels += (uint32_t)(op->x1 - op->x0) * (op->y1 - op->y0);
+    }
+    return REGION_OK;
+}
+
+// Changes are made with both locks held and sent with only send_lock, which
+// keeps the ops of successive changes in order. Callers that may wait for
+// queue space also wait for the change before theirs to be sent.
+static bool begin(TickType_t wait) {
+    if (xSemaphoreTake(send_lock, wait ? portMAX_DELAY : 0) != pdTRUE)
+        return false;
+    xSemaphoreTake(region_lock, portMAX_DELAY);
+    return true;
+}
+
+static uint8_t finish(int count, TickType_t wait) {
+    xSemaphoreGive(region_lock);
+    uint8_t result = (count < 0) ? REGION_DROPPED : send(count, wait);
+    xSemaphoreGive(send_lock);
+    return result;
+}
+
+static int find(const region_table_t *t, uint8_t id) {
+    for (int i = 0; i < t->count; i++) {
+        if (t->regions[i].id == id)
+            return i;
+    }
+    return -1;
+}
+
+// Bounding box of a and b, covers everything that may change when a region
+// moves from a to b
+static void bound(caster_op_t *area, const region_t *a, const region_t *b) {
+    memset(area, 0, sizeof(caster_op_t));
+    area->cmd = OP_EXT_SETMODE;
+    area->x0 = (a->x0 < b->x0) ? a->x0 : b->x0;
+    area->y0 = (a->y0 < b->y0) ? a->y0 : b->y0;
+    area->x1 = (a->x1 > b->x1) ? a->x1 : b->x1;
+    area->y1 = (a->y1 > b->y1) ? a->y1 : b->y1;
+}
+
+static void remove_at(region_table_t *t, int pos) {
+    t->count--;
+    memmove(&t->regions[pos], &t->regions[pos + 1],
+            sizeof(region_t) * (t->count - pos));
+}
+
+void region_init(void) {
+    region_lock = xSemaphoreCreateMutex();
+    send_lock = xSemaphoreCreateMutex();
+    memset(&table, 0, sizeof(table));
+    memset(&stats, 0, sizeof(stats));
+    dirty = false;
+    // Whatever the FPGA starts with, until the first region_set_background()
+    table.background = REGION_MODE_UNKNOWN;
+}
+
+// Add a region on top of the others, or move it and change its mode if the
+// id is already in use, keeping its place in the stack. An empty rectangle
+// removes it. Returns REGION_OK on success.
+uint8_t region_set(uint8_t id, uint16_t x0, uint16_t y0, uint16_t x1,
+        uint16_t y1, update_mode_t mode, TickType_t wait) {
+    if ((x0 >= x1) || (y0 >= y1))
+        return region_remove(id, wait);
+    if (id >= REGION_ID_MAX)
+        return REGION_FAIL;
+    region_t r = {.id = id, .mode = mode, .x0 = x0, .y0 = y0, .x1 = x1,
+            .y1 = y1};
+    if (!begin(wait))
+        return REGION_BUSY;
+    region_table_t next = table;
+    int pos = find(&next, id);
+    caster_op_t area;
+    if (pos >= 0) {
+        bound(&area, &next.regions[pos], &r);
+        next.regions[pos] = r;
+    }
+    else if (next.count < REGION_MAX) {
+        bound(&area, &r, &r);
+        next.regions[next.count++] = r;
+    }
+    else {
+        finish(0, wait);
+        return REGION_FAIL;
+    }
+    return finish(apply(&next, &area, wait), wait);
+}
+
+uint8_t region_remove(uint8_t id, TickType_t wait) {
+    if (!begin(wait))
+        return REGION_BUSY;
+    region_table_t next = table;
+    int pos = find(&next, id);
+    if (pos < 0) {
+        finish(0, wait);
+        return REGION_FAIL;
+    }
+    caster_op_t area;
+    bound(&area, &next.regions[pos], &next.regions[pos]);
+    remove_at(&next, pos);
+    return finish(apply(&next, &area, wait), wait);
+}
+
+// Move a region to the top of the stack
+uint8_t region_raise(uint8_t id, TickType_t wait) {
+    if (!begin(wait))
+        return REGION_BUSY;
+    region_table_t next = table;
+    int pos = find(&next, id);
+    if (pos < 0) {
+        finish(0, wait);
+        return REGION_FAIL;
+    }
+    region_t r = next.regions[pos];
+    remove_at(&next, pos);
+    next.regions[next.count++] = r;
+    caster_op_t area;
+    bound(&area, &r, &r);
+    return finish(apply(&next, &area, wait), wait);
+}
+
+uint8_t region_set_background(update_mode_t mode, TickType_t wait) {
+    if (!begin(wait))
+        return REGION_BUSY;
+    region_table_t next = table;
+    next.background = mode;
+    caster_op_t area;
+    screen_area(&area);
+    return finish(apply(&next, &area, wait), wait);
+}
+
+// Remove all regions, only the background mode is left
+uint8_t region_clear(TickType_t wait) {
+    if (!begin(wait))
+        return REGION_BUSY;
+    region_table_t next = table;
+    next.count = 0;
+    caster_op_t area;
+    screen_area(&area);
+    return finish(apply(&next, &area, wait), wait);
+}
+
+// Program the whole table again, after the FPGA lost its mode map or ops
+// were dropped
+uint8_t region_refresh(TickType_t wait) {
+    if (!begin(wait))
+        return REGION_BUSY;
+    caster_op_t area;
+    screen_area(&area);
+    int count = region_paint(&table, &area, ops);
+    dirty = false;
+    return finish(count, wait);
+}
+
+// Set when ops were dropped, until a refresh or the next change goes through
+bool region_dirty(void) {
+    return dirty;
+}
+
+void region_get_table(region_table_t *t) {
+    xSemaphoreTake(region_lock, portMAX_DELAY);
+    *t = table;
+    xSemaphoreGive(region_lock);
+}
+
+void region_get_stats(region_stats_t *s) {
+    *s = stats;
+}
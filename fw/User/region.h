@@ -0,0 +1,104 @@
+//
+// Grimoire
+// Copyright 2025 Wenting Zhang
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#pragma once
+
+// Update mode map made of rectangular regions, for example one per
+// application window. Regions are stacked, the topmost one containing a pixel
+// sets its mode, pixels not covered by any use the background mode.
+//
+// Every change is applied by comparing the effective modes before and after
+// on a grid made from the region edges. Only cells whose mode changed are
+// sent, merged into non-overlapping setmode ops, unless painting the changed
+// area over region by region takes fewer. Moving or changing one window
+// costs about as many ops as there are windows around it, over a fraction of
+// the screen, instead of reprogramming all of it.
+#define REGION_MAX          16
+#define REGION_ID_MAX       16      // Ids are 0 to REGION_ID_MAX - 1
+// Max ops of one change, a repaint takes up to REGION_MAX + 1
+#define REGION_MAX_OPS      32
+// Grid lines per axis, both tables plus the changed area
+#define REGION_MAX_EDGES    (REGION_MAX * 4 + 2)
+// Max time an op waits for space in the caster command queue, for callers
+// that can block. Once one doesn't get in, the rest of the change is dropped
+// and the whole mode map is sent again later.
+#define REGION_OP_WAIT_MS   100
+// Results of the region_*() calls changing the table
+#define REGION_OK           0
+#define REGION_FAIL         1   // Unknown id or table full, nothing changed
+#define REGION_BUSY         2   // Another change in progress, nothing changed
+#define REGION_DROPPED      3   // Table changed, the ops are sent by the next
+                                // region_refresh()
+// Background mode before it is first set, the FPGA mode map is not touched
+// there
+#define REGION_MODE_UNKNOWN 0xff
+
+typedef struct {
+    uint8_t id;
+    uint8_t mode;           // update_mode_t
+    uint16_t x0;
+    uint16_t y0;
+    uint16_t x1;
+    uint16_t y1;
+} region_t;
+
+typedef struct {
+    region_t regions[REGION_MAX];   // Bottom to top
+    uint8_t count;
+    uint8_t background;     // update_mode_t or REGION_MODE_UNKNOWN
+} region_table_t;
+
+typedef struct {
+    uint32_t changes;       // Calls that modified the table
+    uint32_t ops;           // Setmode ops submitted
+    uint64_t pixels;        // Area covered by those ops
+    uint32_t repaints;      // Changes where painting over took fewer ops
+    uint32_t failed;        // Ops dropped because the caster queue was full
+} region_stats_t;
+
+// Ops that turn the mode map of table from into that of table to within
+// area. Returns the op count, or -1 if more than max_ops would be needed.
+// Not reentrant.
+int region_diff(const region_table_t *from, const region_table_t *to,
+        const caster_op_t *area, caster_op_t *ops, int max_ops);
+// Area painted bottom to top, ops needs room for REGION_MAX + 1
+int region_paint(const region_table_t *table, const caster_op_t *area,
+        caster_op_t *ops);
+// Whichever of the two takes fewer ops, ops needs room for REGION_MAX_OPS.
+// Not reentrant.
+int region_ops(const region_table_t *from, const region_table_t *to,
+        const caster_op_t *area, caster_op_t *ops, bool *repaint);
+uint8_t region_mode_at(const region_table_t *table, uint16_t x, uint16_t y);
+
+// wait is per op, like the caster_queue_*() calls. With 0 nothing blocks,
+// not even on a change made by another task.
+void region_init(void);
+uint8_t region_set(uint8_t id, uint16_t x0, uint16_t y0, uint16_t x1,
+        uint16_t y1, update_mode_t mode, TickType_t wait);
+uint8_t region_remove(uint8_t id, TickType_t wait);
+uint8_t region_raise(uint8_t id, TickType_t wait);
+uint8_t region_set_background(update_mode_t mode, TickType_t wait);
+uint8_t region_clear(TickType_t wait);
+uint8_t region_refresh(TickType_t wait);
+bool region_dirty(void);
+void region_get_table(region_table_t *table);
+void region_get_stats(region_stats_t *stats);
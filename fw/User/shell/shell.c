@@ -79,6 +79,10 @@ SHELL_FUNC( shell_rm );
 SHELL_FUNC( shell_setvolt );
 SHELL_FUNC( shell_setcfg );
 SHELL_FUNC( shell_sensor );
+SHELL_FUNC( shell_caster );
+SHELL_FUNC( shell_ui );
+SHELL_FUNC( shell_fpga );
+SHELL_FUNC( shell_region );
 
 SHELL_HELP( help );
 SHELL_HELP( ver );
@@ -95,6 +99,10 @@ SHELL_HELP( rm );
 SHELL_HELP( setvolt );
 SHELL_HELP( setcfg );
 SHELL_HELP( sensor );
+SHELL_HELP( caster );
+SHELL_HELP( ui );
+SHELL_HELP( fpga );
+SHELL_HELP( region );
 
 //static const SHELL_COMMAND shell_commands[] =
 const SHELL_COMMAND shell_commands[] =
@@ -114,6 +122,10 @@ const SHELL_COMMAND shell_commands[] =
   { "setvolt", shell_setvolt },
   { "setcfg", shell_setcfg },
   { "sensor", shell_sensor },
+  { "caster", shell_caster },
+  { "ui", shell_ui },
+  { "fpga", shell_fpga },
+  { "region", shell_region },
   { "exit", NULL },
   { NULL, NULL }
 };
@@ -135,6 +147,10 @@ static const SHELL_HELP_DATA shell_help_data[] =
   SHELL_INFO( setvolt ),
   SHELL_INFO( setcfg ),
   SHELL_INFO( sensor ),
+  SHELL_INFO( caster ),
+  SHELL_INFO( ui ),
+  SHELL_INFO( fpga ),
+  SHELL_INFO( region ),
   { NULL, NULL, NULL }
 };
 
@@ -317,7 +333,7 @@ const SHELL_COMMAND* shellh_execute_command( shell_context_t *ctx, char* cmd, in
 
   // Transform ' ' characters inside a '' or "" quoted string in
   // a 'special' char.
-  for( i = 0, inside_quotes = 0, quote_char = '\0'; i < strlen( cmd ); i ++ )
+  for( i = 0, inside_quotes = 0, quote_char = '\0'; i < ( int )strlen( cmd ); i ++ )
     if( ( cmd[ i ] == '\'' ) || ( cmd[ i ] == '"' ) )
     {
       if( !inside_quotes )
@@ -397,7 +413,7 @@ const SHELL_COMMAND* shellh_execute_command( shell_context_t *ctx, char* cmd, in
   {
     p = argv[ i ];
     // Put back spaces if needed
-    for( inside_quotes = 0; inside_quotes < strlen( argv[ i ] ); inside_quotes ++ )
+    for( inside_quotes = 0; inside_quotes < ( int )strlen( argv[ i ] ); inside_quotes ++ )
     {
       if( p[ inside_quotes ] == SHELL_ALT_SPACE )
         argv[ i ][ inside_quotes ] = ' ';
@@ -132,8 +132,10 @@ void shell_stacks(shell_context_t *ctx, int argc, char **argv ) {
     shell_print_task_stack(ctx, startup_task_handle);
     shell_print_task_stack(ctx, housekeeping_task_handle);
     shell_print_task_stack(ctx, usb_device_task_handle);
+    shell_print_task_stack(ctx, usb_bulk_task_handle);
     shell_print_task_stack(ctx, usb_pd_task_handle);
     shell_print_task_stack(ctx, ui_task_handle);
+    shell_print_task_stack(ctx, caster_task_handle);
     shell_print_task_stack(ctx, key_scan_task_handle);
     shell_print_task_stack(ctx, power_mon_task_handle);
 }
@@ -608,7 +610,8 @@ void shell_setvolt(shell_context_t *ctx, int argc, char **argv) {
 }
 
 
-const char shell_help_setcfg[] = "<set|get|save> [key] [value]\n";
+const char shell_help_setcfg[] = "<set|get|save|preset> [key] [value]\n"
+        "preset without a name lists the panel timing presets\n";
 const char shell_help_summary_setcfg[] = "Sets configuration. Remember to use save to save it to the flash.";
 
 typedef struct {
@@ -681,6 +684,21 @@ void shell_setcfg(shell_context_t *ctx, int argc, char **argv) {
         return;
     }
 
+    if (strcmp(argv[1], "preset") == 0) {
+        if (argc < 3) {
+            for (int i = 0; i < config_preset_count; i++)
+                printf("%s\n", config_presets[i].name);
+            return;
+        }
+        const config_preset_t *preset = config_find_preset(argv[2]);
+        if (preset == NULL) {
+            printf("Unknown preset %s\n", argv[2]);
+            return;
+        }
+        config_apply_preset(preset);
+        return;
+    }
+
     cfg_var_t *var = NULL;
     if (argc >= 3) {
         for (int i = 0; i < num_vars; i++) {
@@ -759,3 +777,184 @@ void shell_sensor(shell_context_t *ctx, int argc, char **argv) {
     p_cur_sum += p_cur; p_avg_sum += p_avg; p_max_sum += p_max;
     printf("EPD HV:    %5.1f mW  %5.1f mW  %5.1f mW\n", p_cur_sum, p_avg_sum, p_max_sum);
 }
+
+/***********************************************************************
+ * CMD: caster
+ **********************************************************************/
+const char shell_help_caster[] = "<stat|coalesce|temp|redraw|setmode> [on|off] [degC] [x0 y0 x1 y1] [mode]\n"
+  "temp sets the panel temperature used to pick the waveform LUT\n";
+const char shell_help_summary_caster[] = "Submit region ops to the EPDC, or show command queue stats";
+
+void shell_caster(shell_context_t *ctx, int argc, char **argv) {
+    if ((argc >= 2) && (strcmp(argv[1], "stat") == 0)) {
+        caster_queue_stats_t stats;
+        caster_queue_get_stats(&stats);
+        printf("Submitted: %u\n", (unsigned)stats.submitted);
+        printf("Rejected:  %u\n", (unsigned)stats.rejected);
+        printf("Coalesced: %u\n", (unsigned)stats.coalesced);
+        printf("Issued:    %u\n", (unsigned)stats.issued);
+        printf("Completed: %u\n", (unsigned)stats.completed);
+        printf("Timeout:   %u\n", (unsigned)stats.timeout);
+        printf("Max depth: %u / %u\n", (unsigned)stats.max_depth,
+                CASTER_QUEUE_LENGTH);
+        if (!waveform_loaded())
+            return;
+        waveform_stats_t wstats;
+        waveform_get_stats(&wstats);
+        const waveform_set_entry_t *e = waveform_get_entry(
+                waveform_get_current());
+        if (e)
+            printf("Waveform:  %d to %d degC, %u frames\n", e->temp_min,
+                    e->temp_max, e->frames);
+        printf("LUT swaps: %u, %u deferred, %u ms upload max\n",
+                (unsigned)wstats.swaps, (unsigned)wstats.deferred,
+                (unsigned)wstats.max_upload_ms);
+        printf("LUT cache: %u hits, %u misses, %u ms flash\n",
+                (unsigned)wstats.cache_hits, (unsigned)wstats.cache_misses,
+                (unsigned)wstats.flash_ms);
+        return;
+    }
+    if ((argc >= 2) && (strcmp(argv[1], "temp") == 0)) {
+        if (argc >= 3)
+            waveform_set_temperature(strtol(argv[2], NULL, 0));
+        else
+            printf("%d degC\n", waveform_get_temperature());
+        return;
+    }
+    if ((argc >= 3) && (strcmp(argv[1], "coalesce") == 0)) {
+        caster_queue_set_coalesce(strcmp(argv[2], "on") == 0);
+        return;
+    }
+    if (argc < 6) {
+        printf("Usage: %s %s", argv[0], shell_help_caster);
+        return;
+    }
+    caster_op_t op = {
+        .x0 = strtol(argv[2], NULL, 0),
+        .y0 = strtol(argv[3], NULL, 0),
+        .x1 = strtol(argv[4], NULL, 0),
+        .y1 = strtol(argv[5], NULL, 0)
+    };
+    if (strcmp(argv[1], "redraw") == 0) {
+        op.cmd = OP_EXT_REDRAW;
+    }
+    else if ((strcmp(argv[1], "setmode") == 0) && (argc >= 7)) {
+        op.cmd = OP_EXT_SETMODE;
+        op.param = strtol(argv[6], NULL, 0);
+    }
+    else {
+        printf("Usage: %s %s", argv[0], shell_help_caster);
+        return;
+    }
+    TickType_t start = xTaskGetTickCount();
+    if (caster_submit_wait(&op, pdMS_TO_TICKS(1000)))
+        printf("Failed\n");
+    else
+        printf("Done in %u ms\n", (unsigned)(xTaskGetTickCount() - start));
+}
+
+/***********************************************************************
+ * CMD: ui
+ **********************************************************************/
+const char shell_help_ui[] = "[health <ms>]\n"
+  "  Show ui task event stats, or set the health check period (0 to stop)\n";
+const char shell_help_summary_ui[] = "Show ui task stats or set the health check period";
+
+void shell_ui(shell_context_t *ctx, int argc, char **argv) {
+    if ((argc >= 3) && (strcmp(argv[1], "health") == 0)) {
+        ui_set_health_period(strtol(argv[2], NULL, 0));
+        return;
+    }
+    ui_stats_t stats;
+    ui_get_stats(&stats);
+    printf("Buttons:       %u (max latency %u ms)\n", (unsigned)stats.buttons,
+            (unsigned)(stats.max_button_latency * portTICK_PERIOD_MS));
+    printf("Health checks: %u\n", (unsigned)stats.health_checks);
+    printf("I2C reads:     %u\n", (unsigned)stats.i2c_reads);
+    printf("FPGA restarts: %u\n", (unsigned)stats.fpga_restarts);
+    printf("Dropped:       %u\n", (unsigned)stats.dropped);
+}
+
+/***********************************************************************
+ * CMD: fpga
+ **********************************************************************/
+const char shell_help_fpga[] = "[clear]\n"
+  "  Show FPGA CSR shadow hit/miss counters, or clear them\n";
+const char shell_help_summary_fpga[] = "Show FPGA CSR shadow stats";
+
+void shell_fpga(shell_context_t *ctx, int argc, char **argv) {
+    if ((argc >= 2) && (strcmp(argv[1], "clear") == 0)) {
+        fpga_shadow_reset_stats();
+        return;
+    }
+    fpga_shadow_stats_t stats;
+    fpga_shadow_get_stats(&stats);
+    uint32_t cached = stats.hits + stats.misses;
+    printf("Hits:        %u (%u%%)\n", (unsigned)stats.hits,
+            cached ? (unsigned)(stats.hits * 100ull / cached) : 0);
+    printf("Misses:      %u\n", (unsigned)stats.misses);
+    printf("Uncached:    %u\n", (unsigned)stats.uncached);
+    printf("Gap fills:   %u\n", (unsigned)stats.fills);
+    printf("Invalidates: %u\n", (unsigned)stats.invalidates);
+}
+
+/***********************************************************************
+ * CMD: region
+ **********************************************************************/
+const char shell_help_region[] = "[set <id> <x0> <y0> <x1> <y1> <mode>|rm <id>|raise <id>|bg <mode>|clear|refresh]\n"
+  "  Show the update mode regions, bottom to top, or change them\n";
+const char shell_help_summary_region[] = "Show or change per region update modes";
+
+void shell_region(shell_context_t *ctx, int argc, char **argv) {
+    TickType_t wait = pdMS_TO_TICKS(REGION_OP_WAIT_MS);
+    uint8_t result = 0;
+    if ((argc >= 8) && (strcmp(argv[1], "set") == 0)) {
+        result = region_set(strtol(argv[2], NULL, 0), strtol(argv[3], NULL, 0),
+                strtol(argv[4], NULL, 0), strtol(argv[5], NULL, 0),
+                strtol(argv[6], NULL, 0), strtol(argv[7], NULL, 0), wait);
+    }
+    else if ((argc >= 3) && (strcmp(argv[1], "rm") == 0)) {
+        result = region_remove(strtol(argv[2], NULL, 0), wait);
+    }
+    else if ((argc >= 3) && (strcmp(argv[1], "raise") == 0)) {
+        result = region_raise(strtol(argv[2], NULL, 0), wait);
+    }
+    else if ((argc >= 3) && (strcmp(argv[1], "bg") == 0)) {
+        result = region_set_background(strtol(argv[2], NULL, 0), wait);
+    }
+    else if ((argc >= 2) && (strcmp(argv[1], "clear") == 0)) {
+        result = region_clear(wait);
+    }
+    else if ((argc >= 2) && (strcmp(argv[1], "refresh") == 0)) {
+        result = region_refresh(wait);
+    }
+    else if (argc >= 2) {
+        printf("Usage: %s %s", argv[0], shell_help_region);
+        return;
+    }
+    else {
+        region_table_t table;
+        region_stats_t stats;
+        region_get_table(&table);
+        region_get_stats(&stats);
+        for (int i = 0; i < table.count; i++) {
+            region_t *r = &table.regions[i];
+            printf("%2d: %4d %4d %4d %4d mode %d\n", r->id, r->x0, r->y0,
+                    r->x1, r->y1, r->mode);
+        }
+        if (table.background == REGION_MODE_UNKNOWN)
+            printf("Background: not set\n");
+        else
+            printf("Background: mode %d\n", table.background);
+        printf("Changes:   %u\n", (unsigned)stats.changes);
+        printf("Ops:       %u (%u pixels)\n", (unsigned)stats.ops,
+                (unsigned)stats.pixels);
+        printf("Repaints:  %u\n", (unsigned)stats.repaints);
+        printf("Failed:    %u\n", (unsigned)stats.failed);
+        return;
+    }
+    if (result == REGION_DROPPED)
+        printf("Caster queue full, sent again on the next refresh\n");
+    else if (result)
+        printf("Failed\n");
+}
@@ -32,11 +32,11 @@ int shell_vprintf(shell_context_t *ctx, const char *fmt, va_list ap)
 {
     va_list va;
     char *str;
-    va = ap;
+    va_copy(va, ap);
     int len = vsnprintf(NULL, 0, fmt, va);
-    va = ap;
+    va_end(va);
     str = SHELL_MALLOC(len + 1);
-    vsnprintf(str, len + 1, fmt, va);
+    vsnprintf(str, len + 1, fmt, ap);
     term_putstr(&ctx->t, str, len);
     SHELL_FREE(str);
     return(len);
@@ -489,6 +489,8 @@ int spif_read_jedec_id(spif_id_t *id) {
 // spiffs abstraction layer
 static spiffs_config spiffs_cfg;
 spiffs spiffs_fs;
+// Taken by SPIFFS_LOCK() in every API call. The errno in spiffs_fs is shared
+// by all tasks, so check the return values rather than SPIFFS_errno().
 SemaphoreHandle_t spiffs_lock;
 static uint8_t fs_work_buf[256 * 2];
 static uint8_t fs_fds[32 * 4];
@@ -25,7 +25,12 @@
 #include "app.h"
 #include "ui.h"
 
-static QueueHandle_t btn_queue;
+static QueueHandle_t ui_queue;
+static TimerHandle_t health_timer;
+static ui_stats_t ui_stats;
+// Set while the FPGA is expected to be configured, a falling DONE pin
+// means it lost its configuration
+static volatile bool fpga_running = false;
 
 typedef enum {
     BTN1_SHORT_PRESSED,
@@ -56,8 +61,49 @@ static int mode_max = sizeof(modes) / sizeof(modes[0]);
 #define OSD_HEIGHT  128
 static uint8_t osd_fb[OSD_WIDTH * OSD_HEIGHT / 8];
 
+static void health_timer_cb(TimerHandle_t timer) {
+    ui_post_event(UI_EV_HEALTH, 0);
+}
+
 void ui_init(void) {
-    btn_queue = xQueueCreate(8, sizeof(btn_event_t));
+    ui_queue = xQueueCreate(UI_QUEUE_LENGTH, sizeof(ui_event_t));
+    health_timer = xTimerCreate("UIHealth", pdMS_TO_TICKS(UI_HEALTH_PERIOD_MS),
+            pdTRUE, NULL, health_timer_cb);
+}
+
+void ui_post_event(ui_event_type_t type, uint8_t param) {
+    ui_event_t event = {
+        .type = type,
+        .param = param,
+        .time = xTaskGetTickCount()
+    };
+    // Never block, health checks and key presses are dropped if the ui task
+    // is that far behind
+    if (xQueueSend(ui_queue, &event, 0) != pdTRUE)
+        ui_stats.dropped++;
+}
+
+void ui_fpga_done_isr(void) {
+    BaseType_t context_switch = pdFALSE;
+    if (!fpga_running || !ui_queue)
+        return;
+    ui_event_t event = {
+        .type = UI_EV_FPGA_LOST,
+        .time = xTaskGetTickCountFromISR()
+    };
+    xQueueSendFromISR(ui_queue, &event, &context_switch);
+    portYIELD_FROM_ISR(context_switch);
+}
+
+void ui_set_health_period(uint32_t ms) {
+    if (ms == 0)
+        xTimerStop(health_timer, portMAX_DELAY);
+    else
+        xTimerChangePeriod(health_timer, pdMS_TO_TICKS(ms), portMAX_DELAY);
+}
+
+void ui_get_stats(ui_stats_t *stats) {
+    *stats = ui_stats;
 }
 
 static void osd_set_pixel(int x, int y, bool p) {
@@ -121,10 +167,9 @@ static void osd_clear(uint8_t c) {
 }
 
 static font_t *load_font(const char *fn) {
-    SPIFFS_clearerr(&spiffs_fs);
     spiffs_file f = SPIFFS_open(&spiffs_fs, fn, SPIFFS_O_RDONLY, 0);
-    if (SPIFFS_errno(&spiffs_fs) != 0)
-        return;
+    if (f < 0)
+        return NULL;
     
     spiffs_stat s;
     SPIFFS_fstat(&spiffs_fs, f, &s);
@@ -144,6 +189,7 @@ static font_t *load_font(const char *fn) {
 
 static bool is_tmds_active(void) {
     uint8_t val;
+    ui_stats.i2c_reads++;
     val = adv7611_read_reg(HDMI_I2C_ADDR, 0x04);
     return !!(val & 0x2);
 }
@@ -152,25 +198,28 @@ static bool is_dp_active(void) {
     return dp_ready;
 }
 
+static bool wait_fpga_up(void) {
+    int timeout = 10; // 1 sec
+    while (timeout) {
+        // Wait for PLL to lock
+        vTaskDelay(pdMS_TO_TICKS(100));
+        uint8_t result = fpga_write_reg8(CSR_ID0, 0x00);
+        if (result == 0x35)
+            return true;
+        timeout--;
+        if (timeout == 0) {
+            syslog_printf("FPGA failed to start up (%02x), retrying...", result);
+        }
+    }
+    return false;
+}
+
 static void restart_fpga(void) {
     bool fpga_up = false;
     int retry = 3;
     while (!fpga_up) {
         fpga_init("fpga.bit");
-        int timeout = 10; // 1 sec
-        while (timeout) {
-            // Wait for PLL to lock
-            vTaskDelay(pdMS_TO_TICKS(100));
-            uint8_t result = fpga_write_reg8(CSR_ID0, 0x00);
-            if (result == 0x35) {
-                fpga_up = true;
-                break;
-            }
-            timeout--;
-            if (timeout == 0) {
-                syslog_printf("FPGA failed to start up (%02x), retrying...", result);
-            }
-        }
+        fpga_up = wait_fpga_up();
         if (!fpga_up) {
             retry--;
             if (retry == 0) {
@@ -180,17 +229,81 @@ static void restart_fpga(void) {
     }
 }
 
+// Earliest of the pending timeouts, portMAX_DELAY if there is none
+static TickType_t ticks_until(TickType_t deadline, TickType_t wait) {
+    if (deadline == 0)
+        return wait;
+    int32_t left = (int32_t)deadline - (int32_t)xTaskGetTickCount();
+    if (left <= 0)
+        return 0;
+    return ((TickType_t)left < wait) ? (TickType_t)left : wait;
+}
+
+static void start_fpga(bool reload) {
+    if (reload) {
+        power_off_epd();
+        fpga_running = false;
+        restart_fpga();
+        ui_stats.fpga_restarts++;
+    }
+    else if (!wait_fpga_up()) {
+        // Bitstream is loaded during boot, only reload it if that didn't work
+        restart_fpga();
+    }
+    power_on_epd();
+    caster_init(); // Start refresh
+    fpga_running = true;
+    // Mode map starts over with the FPGA, regions set before are kept
+    region_refresh(pdMS_TO_TICKS(REGION_OP_WAIT_MS));
+}
+
+static void check_health(bool tmds_mode) {
+    ui_stats.health_checks++;
+    // Check FPGA lost sync
+    if (fpga_write_reg8(CSR_ID0, 0x00) != 0x35) {
+        syslog_printf("Lost access to FPGA, attempt to restart...");
+        start_fpga(true);
+        syslog_printf("FPGA restarted");
+    }
+
+    if (!tmds_mode)
+        return; // DP link loss is reported by the PD task
+
+    // Detect loss of signal
+    if (!is_tmds_active()) {
+        // Stop and restart when TMDS is detected
+        power_off_epd();
+        NVIC_SystemReset();
+    }
+
+    // Detect signal mode
+    // TODO: This should be implemented in FPGA
+    uint16_t x, y;
+    ui_stats.i2c_reads += 4;
+    x = (uint16_t)(adv7611_read_reg(HDMI_I2C_ADDR, 0x07) & 0x1f) << 8;
+    x |= adv7611_read_reg(HDMI_I2C_ADDR, 0x08);
+
+    y = (uint16_t)(adv7611_read_reg(HDMI_I2C_ADDR, 0x09) & 0x1f) << 8;
+    y |= adv7611_read_reg(HDMI_I2C_ADDR, 0x0a);
+
+    if ((x != config.hact) || (y != config.vact)) {
+        fatal("Incorrect input resolution, detected %d x %d.", x, y);
+    }
+}
+
 portTASK_FUNCTION(ui_task, pvParameters) {
     TickType_t osd_timeout = 0;
     bool setmode = false;
     TickType_t autoclear_timeout = 0;
     bool autoclear = false;
+    ui_event_t event;
 
     // Load font into memory
     font_t *font_24x40 = load_font("font_24x40.bin");
     font_t *font_32x53 = load_font("font_32x53.bin");
 
-    // First wait link establish
+    // First wait link establish. TMDS has no interrupt, DP is reported by
+    // the PD task as soon as it's up.
     bool tmds_mode = false;
     while (1) {
         // Check is DP on
@@ -204,23 +317,17 @@ portTASK_FUNCTION(ui_task, pvParameters) {
             tmds_mode = false;
             break;
         }
-        vTaskDelay(pdMS_TO_TICKS(100)); // Wait before next iteration
+        // Anything else that comes in before the link is up is dropped
+        xQueueReceive(ui_queue, &event, pdMS_TO_TICKS(100));
     }
-    restart_fpga();
-    power_on_epd();
-    caster_init(); // Start refresh
+    start_fpga(false);
     syslog_printf("FPGA started with status %02x", fpga_write_reg8(CSR_STATUS, 0x00));
+    xTimerStart(health_timer, portMAX_DELAY);
 
     while (1) {
-        // Check FPGA lost sync
-        if (fpga_write_reg8(CSR_ID0, 0x00) != 0x35) {
-            syslog_printf("Lost access to FPGA, attempt to restart...");
-            power_off_epd();
-            restart_fpga();
-            power_on_epd();
-            caster_init();
-            syslog_printf("FPGA restarted");
-        }
+        TickType_t wait = ticks_until(osd_timeout, portMAX_DELAY);
+        wait = ticks_until(autoclear_timeout, wait);
+        BaseType_t result = xQueueReceive(ui_queue, &event, wait);
 
         // Check OSD timeout
         if ((osd_timeout != 0) && (((int32_t)xTaskGetTickCount() - (int32_t)osd_timeout) >= 0)) {
@@ -230,7 +337,7 @@ portTASK_FUNCTION(ui_task, pvParameters) {
 
         // Update auto clear
         if ((autoclear_timeout != 0) && (((int32_t)xTaskGetTickCount() - (int32_t)autoclear_timeout) >= 0)) {
-            caster_redraw(0,0,2400,1800);
+            caster_queue_redraw(0,0,2400,1800,portMAX_DELAY);
             autoclear_timeout = 0; // Pending reset
         }
 
@@ -242,33 +349,40 @@ portTASK_FUNCTION(ui_task, pvParameters) {
             autoclear_timeout = 0;
         }
 
-        // Detect loss of signal
-        if (tmds_mode && (!is_tmds_active())) {
-            // Stop and restart when TMDS is detected
-            power_off_epd();
-            NVIC_SystemReset();
-        }
-
-        // Detect signal mode
-        // TODO: This should be implemented in FPGA
-        if (tmds_mode) {
-            uint16_t x, y;
-            x = (uint16_t)(adv7611_read_reg(HDMI_I2C_ADDR, 0x07) & 0x1f) << 8;
-            x |= adv7611_read_reg(HDMI_I2C_ADDR, 0x08);
-
-            y = (uint16_t)(adv7611_read_reg(HDMI_I2C_ADDR, 0x09) & 0x1f) << 8;
-            y |= adv7611_read_reg(HDMI_I2C_ADDR, 0x0a);
+        if (result != pdTRUE)
+            continue;
 
-            if ((x != config.hact) || (y != config.vact)) {
-                fatal("Incorrect input resolution, detected %d x %d.", x, y);
-            }
+        switch (event.type) {
+        case UI_EV_HEALTH:
+            check_health(tmds_mode);
+            // Mode map ops the caster queue couldn't take earlier
+            if (region_dirty())
+                region_refresh(pdMS_TO_TICKS(REGION_OP_WAIT_MS));
+            continue;
+        case UI_EV_FPGA_LOST:
+            if (!fpga_running || (gpio_get(FPGA_DONE) == 1))
+                continue; // Stale, or a glitch
+            syslog_printf("FPGA lost configuration, attempt to restart...");
+            start_fpga(true);
+            syslog_printf("FPGA restarted");
+            continue;
+        case UI_EV_LINK:
+            // Only logged, the panel keeps the last image until DP is back
+            if (!tmds_mode)
+                syslog_printf("DP link %s", event.param ? "up" : "lost");
+            continue;
+        case UI_EV_BUTTON:
+            break;
+        default:
+            continue;
         }
 
         // Key press logic
-        btn_event_t btn_event;
-        BaseType_t result = xQueueReceive(btn_queue, &btn_event, pdMS_TO_TICKS(200));
-        if (result != pdTRUE)
-            continue;
+        uint32_t latency = xTaskGetTickCount() - event.time;
+        ui_stats.buttons++;
+        if (latency > ui_stats.max_button_latency)
+            ui_stats.max_button_latency = latency;
+        btn_event_t btn_event = event.param;
         if (btn_event == BTN1_SHORT_PRESSED) {
             // First key short press
             mode--;
@@ -282,7 +396,7 @@ portTASK_FUNCTION(ui_task, pvParameters) {
         }
         else if ((btn_event == BTN1_LONG_PRESSED) || (btn_event == BTN2_LONG_PRESSED) || (btn_event == BTN3_SHORT_PRESSED)) {
             // Clear screen
-            caster_redraw(0,0,2400,1800);
+            caster_queue_redraw(0,0,2400,1800,portMAX_DELAY);
         }
         else if (btn_event == BTN3_LONG_PRESSED) {
             // Toggle auto clearing
@@ -293,9 +407,13 @@ portTASK_FUNCTION(ui_task, pvParameters) {
             osd_draw_string(font_24x40, 10, 60, autoclear ? "ON" : "OFF", 4, false);
             caster_osd_send_buf(osd_fb);
             caster_osd_set_enable(true);
+            if (autoclear && (autoclear_timeout == 0))
+                autoclear_timeout = xTaskGetTickCount() + pdMS_TO_TICKS(60000);
         }
         if (setmode) {
-            caster_setmode(0, 0, config.hact, config.vact, modes[mode].id);
+            // Windows with their own mode keep it
+            region_set_background(modes[mode].id,
+                    pdMS_TO_TICKS(REGION_OP_WAIT_MS));
             osd_timeout = xTaskGetTickCount() + pdMS_TO_TICKS(2000);
             osd_clear(0xff);
             osd_draw_string(font_24x40, 10, 10, "Mode:", 5, false);
@@ -310,31 +428,24 @@ portTASK_FUNCTION(ui_task, pvParameters) {
 portTASK_FUNCTION(key_scan_task, pvParameters) {
     while (1) {
         uint32_t scan = button_scan();
-        btn_event_t event;
         // No wait, if the ui task doesn't take it, the key press is lost
         if ((scan & BTN_MASK) == BTN_SHORT_PRESSED) {
-            event = BTN1_SHORT_PRESSED;
-            xQueueSend(btn_queue, &event, 0);
+            ui_post_event(UI_EV_BUTTON, BTN1_SHORT_PRESSED);
         }
         else if ((scan & BTN_MASK) == BTN_LONG_PRESSED) {
-            event = BTN1_LONG_PRESSED;
-            xQueueSend(btn_queue, &event, 0);
+            ui_post_event(UI_EV_BUTTON, BTN1_LONG_PRESSED);
         }
         if (((scan >> BTN_SHIFT) & BTN_MASK) == BTN_SHORT_PRESSED) {
-            event = BTN2_SHORT_PRESSED;
-            xQueueSend(btn_queue, &event, 0);
+            ui_post_event(UI_EV_BUTTON, BTN2_SHORT_PRESSED);
         }
         else if (((scan >> BTN_SHIFT) & BTN_MASK) == BTN_LONG_PRESSED) {
-            event = BTN2_LONG_PRESSED;
-            xQueueSend(btn_queue, &event, 0);
+            ui_post_event(UI_EV_BUTTON, BTN2_LONG_PRESSED);
         }
         if (((scan >> (BTN_SHIFT * 2)) & BTN_MASK) == BTN_SHORT_PRESSED) {
-            event = BTN3_SHORT_PRESSED;
-            xQueueSend(btn_queue, &event, 0);
+            ui_post_event(UI_EV_BUTTON, BTN3_SHORT_PRESSED);
         }
         else if (((scan >> (BTN_SHIFT * 2)) & BTN_MASK) == BTN_LONG_PRESSED) {
-            event = BTN3_LONG_PRESSED;
-            xQueueSend(btn_queue, &event, 0);
+            ui_post_event(UI_EV_BUTTON, BTN3_LONG_PRESSED);
         }
         vTaskDelay(pdMS_TO_TICKS(10));
     }
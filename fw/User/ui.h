@@ -22,6 +22,37 @@
 //
 #pragma once
 
+// Health checks (FPGA ID, TMDS status and input resolution) run at this
+// period, everything else wakes the ui task through ui_post_event()
+#define UI_HEALTH_PERIOD_MS     500
+#define UI_QUEUE_LENGTH         16
+
+typedef enum {
+    UI_EV_BUTTON,       // param is the button event
+    UI_EV_HEALTH,       // Health check timer
+    UI_EV_LINK,         // DP link up (param 1) or lost (param 0)
+    UI_EV_FPGA_LOST,    // FPGA DONE went low
+} ui_event_type_t;
+
+typedef struct {
+    uint8_t type;
+    uint8_t param;
+    TickType_t time;    // When it was posted
+} ui_event_t;
+
+typedef struct {
+    uint32_t buttons;
+    uint32_t health_checks;
+    uint32_t i2c_reads;         // ADV7611 status reads on pi2c1
+    uint32_t fpga_restarts;
+    uint32_t dropped;           // Events lost to a full queue
+    uint32_t max_button_latency; // Ticks from key scan to handling
+} ui_stats_t;
+
 void ui_init(void);
+void ui_post_event(ui_event_type_t type, uint8_t param);
+void ui_fpga_done_isr(void);
+void ui_set_health_period(uint32_t ms);
+void ui_get_stats(ui_stats_t *stats);
 portTASK_FUNCTION(ui_task, pvParameters);
 portTASK_FUNCTION(key_scan_task, pvParameters);
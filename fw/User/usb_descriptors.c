@@ -28,7 +28,7 @@
 #include "board.h"
 
 #define USB_VID   0x0483
-#define USB_PID   0x5750 // Composite HID CDC
+#define USB_PID   0x5750 // Composite HID CDC Vendor
 #define USB_BCD   0x0200
 
 //--------------------------------------------------------------------+
@@ -49,7 +49,9 @@ tusb_desc_device_t const desc_device =
 
     .idVendor           = USB_VID,
     .idProduct          = USB_PID,
-    .bcdDevice          = 0x0100,
+    // Bumped with the vendor bulk interface, so hosts don't reuse the
+    // cached configuration
+    .bcdDevice          = 0x0101,
 
     .iManufacturer      = 0x01,
     .iProduct           = 0x02,
@@ -91,15 +93,18 @@ enum
   ITF_NUM_HID = 0,
   ITF_NUM_CDC,
   ITF_NUM_CDC_DATA,
+  ITF_NUM_BULK,
   ITF_NUM_TOTAL
 };
 
-#define CONFIG_TOTAL_LEN    (TUD_CONFIG_DESC_LEN + TUD_HID_INOUT_DESC_LEN + TUD_CDC_DESC_LEN)
+#define CONFIG_TOTAL_LEN    (TUD_CONFIG_DESC_LEN + TUD_HID_INOUT_DESC_LEN + TUD_CDC_DESC_LEN + TUD_VENDOR_DESC_LEN)
 
 #define EPNUM_HID         0x01
 #define EPNUM_CDC_NOTIF   0x83
 #define EPNUM_CDC_OUT     0x02
 #define EPNUM_CDC_IN      0x82
+#define EPNUM_BULK_OUT    0x04
+#define EPNUM_BULK_IN     0x84
 
 uint8_t const desc_fs_configuration[] =
 {
@@ -111,6 +116,9 @@ uint8_t const desc_fs_configuration[] =
 
   // Interface number, string index, EP notification address and size, EP data address (out, in) and size.
   TUD_CDC_DESCRIPTOR(ITF_NUM_CDC, 5, EPNUM_CDC_NOTIF, 8, EPNUM_CDC_OUT, EPNUM_CDC_IN, 64),
+
+  // Interface number, string index, EP Out & IN address, EP size. Handled by usbbulk.c
+  TUD_VENDOR_DESCRIPTOR(ITF_NUM_BULK, 6, EPNUM_BULK_OUT, EPNUM_BULK_IN, TUD_OPT_HIGH_SPEED ? 512 : 64),
 };
 
 // Invoked when received GET CONFIGURATION DESCRIPTOR
@@ -144,6 +152,7 @@ char const *string_desc_arr[] =
   NULL,                          // 3: Serials will use unique ID if possible
   "Control",                     // 4: HID Interface
   "Debug",                       // 5: CDC Interface
+  "Bulk",                        // 6: Vendor Interface
 };
 
 static uint16_t _desc_str[32 + 1];
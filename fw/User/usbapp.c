@@ -23,6 +23,7 @@
 #include "platform.h"
 #include "app.h"
 #include "tusb.h"
+#include "device/usbd_pvt.h"
 
 void usbapp_term_out(char data, void *usr) {
 	tud_cdc_write_char(data);
@@ -72,6 +73,185 @@ uint16_t tud_hid_get_report_cb(uint8_t instance, uint8_t report_id, hid_report_t
 
 #define RX_BLK_SIZE (64*1024)
 
+// Protocol v2 state, only used from the USB task
+static uint16_t v2_next_seq;
+static uint16_t v2_unacked;
+static uint8_t v2_status = USBRET_SUCCESS;
+static uint8_t v2_failed;
+static uint16_t v2_first_failed;
+static bool v2_ack_pending;
+static bool v2_resend;
+static bool v2_gap;
+
+static void v2_space_ready(void *param);
+
+static void v2_space_cb(void) {
+    usbd_defer_func(v2_space_ready, NULL, false);
+}
+
+static void v2_send_ack(void) {
+    // The host stops sending while the queue is full, it gets another ack
+    // once there is room
+    uint32_t space = caster_queue_space();
+    if ((space == 0) && !caster_queue_notify_space(v2_space_cb))
+        space = caster_queue_space();
+    uint8_t txbuf[CFG_TUD_HID_EP_BUFSIZE] = {0};
+    txbuf[0] = USBV2_MAGIC;
+    txbuf[1] = USBV2_TYPE_ACK;
+    txbuf[2] = v2_next_seq & 0xff;
+    txbuf[3] = (v2_next_seq >> 8) & 0xff;
+    txbuf[4] = v2_status;
+    txbuf[5] = v2_failed;
+    txbuf[6] = v2_first_failed & 0xff;
+    txbuf[7] = (v2_first_failed >> 8) & 0xff;
+    txbuf[8] = space;
+    txbuf[9] = v2_resend;
+    uint16_t chksum = crc16((char *)txbuf, USBV2_CRC_OFFSET);
+    txbuf[USBV2_CRC_OFFSET] = chksum & 0xff;
+    txbuf[USBV2_CRC_OFFSET + 1] = (chksum >> 8) & 0xff;
+    // If the previous report is still on its way, retry once it's done
+    v2_ack_pending = !tud_hid_report(0, txbuf, CFG_TUD_HID_EP_BUFSIZE);
+    if (v2_ack_pending)
+        return;
+    v2_unacked = 0;
+    v2_status = USBRET_SUCCESS;
+    v2_failed = 0;
+    v2_resend = false;
+}
+
+// Room in the caster queue again, runs in the USB task
+static void v2_space_ready(void *param) {
+    (void) param;
+    if (v2_gap)
+        v2_resend = true;
+    v2_send_ack();
+}
+
+void tud_hid_report_complete_cb(uint8_t instance, uint8_t const* report, uint16_t len) {
+    (void) instance;
+    (void) report;
+    (void) len;
+    if (v2_ack_pending)
+        v2_send_ack();
+}
+
+// Returns 0 on success, 1 on failure or if cmd is not a region command
+// Runs in the USB task, so nothing waits: REGION_BUSY and REGION_DROPPED
+// are up to the caller
+static uint8_t usbapp_region_cmd(uint8_t cmd, uint8_t param, uint16_t x0,
+        uint16_t y0, uint16_t x1, uint16_t y1) {
+    switch (cmd) {
+    case USBCMD_REGION_SET:
+        return region_set(USB_REGION_ID(param), x0, y0, x1, y1,
+                (update_mode_t)USB_REGION_MODE(param), 0);
+    case USBCMD_REGION_RAISE:
+        return region_raise(USB_REGION_ID(param), 0);
+    case USBCMD_REGION_CLEAR:
+        return region_clear(0);
+    default:
+        return REGION_FAIL;
+    }
+}
+
+static void v2_fail(uint16_t seq, uint8_t status) {
+    if (v2_failed == 0) {
+        v2_status = status;
+        v2_first_failed = seq;
+    }
+    if (v2_failed < 0xff)
+        v2_failed++;
+}
+
+// Stop at a command the caster queue has no room for, the host sends it
+// again after the ack with queue space that follows
+static void v2_queue_full(void) {
+    v2_gap = true;
+    v2_resend = true;
+    v2_send_ack();
+}
+
+static void v2_process(uint8_t const* buffer, uint16_t bufsize) {
+    uint8_t count = buffer[1];
+    uint16_t seq = (buffer[3] << 8) | buffer[2];
+    uint8_t flags = buffer[4];
+    uint16_t chksum = (buffer[USBV2_CRC_OFFSET + 1] << 8) | buffer[USBV2_CRC_OFFSET];
+
+    if ((bufsize < CFG_TUD_HID_EP_BUFSIZE) ||
+            (crc16((char *)buffer, USBV2_CRC_OFFSET) != chksum)) {
+        // Nothing in the report can be trusted, ask for everything since
+        // the last command processed
+        v2_resend = true;
+        v2_send_ack();
+        return;
+    }
+    if (count > USBV2_MAX_CMDS)
+        count = USBV2_MAX_CMDS;
+    if (flags & USBV2_FLAG_RESET) {
+        v2_next_seq = seq;
+        v2_unacked = 0;
+        v2_failed = 0;
+        v2_status = USBRET_SUCCESS;
+        v2_gap = false;
+    }
+    for (int i = 0; i < count; i++) {
+        uint16_t cmd_seq = seq + i;
+        // Skip anything already processed, the host is resending
+        if ((int16_t)(cmd_seq - v2_next_seq) < 0)
+            continue;
+        // A report went missing, drop the rest until the host goes back.
+        // Only ask once, the following reports have the same gap.
+        if (cmd_seq != v2_next_seq) {
+            if (!v2_gap) {
+                v2_gap = true;
+                v2_resend = true;
+                v2_send_ack();
+            }
+            return;
+        }
+        v2_gap = false;
+        uint8_t const *p = buffer + USBV2_HDR_SIZE + i * USBV2_CMD_SIZE;
+        uint16_t x0 = (p[3] << 8) | p[2];
+        uint16_t y0 = (p[5] << 8) | p[4];
+        uint16_t x1 = (p[7] << 8) | p[6];
+        uint16_t y1 = (p[9] << 8) | p[8];
+        // Don't wait for queue space, a few waits in one report would add
+        // up to the host's timeout
+        uint8_t retval;
+        bool busy;
+        if (p[0] == USBCMD_REDRAW) {
+            retval = caster_queue_redraw(x0, y0, x1, y1, 0);
+            busy = retval;
+        }
+        else if (p[0] == USBCMD_SETMODE) {
+            retval = caster_queue_setmode(x0, y0, x1, y1, (update_mode_t)p[1],
+                    0);
+            busy = retval;
+        }
+        else {
+            retval = usbapp_region_cmd(p[0], p[1], x0, y0, x1, y1);
+            busy = (retval == REGION_BUSY);
+        }
+        if (busy) {
+            v2_queue_full();
+            return;
+        }
+        if (retval && (retval != REGION_DROPPED))
+            v2_fail(cmd_seq, USBRET_GENERALFAIL);
+        v2_next_seq = cmd_seq + 1;
+        v2_unacked++;
+        // The region table has the change, the ops that didn't fit are
+        // sent by the next region_refresh(). Hold the host off while the
+        // queue is full, same as for a redraw.
+        if ((retval == REGION_DROPPED) && (caster_queue_space() == 0)) {
+            v2_queue_full();
+            return;
+        }
+    }
+    if ((flags & USBV2_FLAG_ACK) || (v2_unacked >= USBV2_ACK_INTERVAL) ||
+            (v2_failed != 0))
+        v2_send_ack();
+}
+
 // Invoked when received SET_REPORT control request or
 // received data on OUT endpoint ( Report ID = 0, Type = 0 )
 void tud_hid_set_report_cb(uint8_t instance, uint8_t report_id, hid_report_type_t report_type, uint8_t const* buffer, uint16_t bufsize)
@@ -88,24 +268,26 @@ void tud_hid_set_report_cb(uint8_t instance, uint8_t report_id, hid_report_type_
     uint16_t y0 = (buffer[6] << 8) | buffer[5];
     uint16_t x1 = (buffer[8] << 8) | buffer[7];
     uint16_t y1 = (buffer[10] << 8) | buffer[9];
-    uint16_t id = (buffer[12] << 8) | buffer[11];
     uint16_t chksum = (buffer[14] << 8) | buffer[13];
 
     static bool is_recv = false;
     static uint16_t recv_name_cnt;
     static uint32_t recv_data_cnt;
     static uint32_t recv_buf_cnt;
-    static uint32_t recv_chksum_expected;
-    static uint32_t recv_chksum;
     static spiffs_file recv_f;
     static uint8_t *recv_buf;
 
     uint8_t retval = 1;
-    uint16_t exp_chksum;
+    uint16_t exp_chksum = 0;
     bool ret = true;
 
+    if (!is_recv && (cmd == USBV2_MAGIC)) {
+        v2_process(buffer, bufsize);
+        return;
+    }
+
     if (!is_recv) {
-        exp_chksum = crc16(buffer, 13);
+        exp_chksum = crc16((char *)buffer, 13);
         if (chksum != exp_chksum) {
             retval = USBRET_CHKSUMFAIL;
             goto returnval;
@@ -125,10 +307,21 @@ void tud_hid_set_report_cb(uint8_t instance, uint8_t report_id, hid_report_type_
             // TODO
             break;
         case USBCMD_REDRAW:
-            retval = caster_redraw(x0, y0, x1, y1);
+            // No waiting in the USB task, a full queue is the only failure
+            // and the host sends the command again
+            retval = caster_queue_redraw(x0, y0, x1, y1, 0);
             break;
         case USBCMD_SETMODE:
-            retval = caster_setmode(x0, y0, x1, y1, (update_mode_t)param);
+            retval = caster_queue_setmode(x0, y0, x1, y1, (update_mode_t)param,
+                    0);
+            break;
+        case USBCMD_REGION_SET:
+        case USBCMD_REGION_RAISE:
+        case USBCMD_REGION_CLEAR:
+            retval = usbapp_region_cmd(cmd, param, x0, y0, x1, y1);
+            // Taken, the ops follow with the next region_refresh()
+            if (retval == REGION_DROPPED)
+                retval = 0;
             break;
         case USBCMD_USBBOOT:
             //iap_usbboot();
@@ -136,11 +329,16 @@ void tud_hid_set_report_cb(uint8_t instance, uint8_t report_id, hid_report_type_
         case USBCMD_NUKE:
             //iap_nuke();
             break;
+        case USBCMD_RECV_BULK:
+            // Same fields as RECV, but name and data follow on the bulk
+            // endpoint. x1 is the CRC16 of the data.
+            retval = usbbulk_recv_start(param,
+                    ((uint32_t)y0 << 16) | (uint32_t)x0, x1);
+            break;
         case USBCMD_RECV:
             is_recv = true;
             recv_name_cnt = param;
             recv_data_cnt = ((uint32_t)y0 << 16) | (uint32_t)x0;
-            recv_chksum_expected = ((uint32_t)y1 << 16) | (uint32_t)x1;
             recv_buf_cnt = 0;
             recv_buf = pvPortMalloc(RX_BLK_SIZE);
             retval = 0;
@@ -152,7 +350,7 @@ void tud_hid_set_report_cb(uint8_t instance, uint8_t report_id, hid_report_type_
         //exp_chksum = crc16(buffer, 16);
         if (recv_name_cnt > 0) {
             // Buffer should be a null terminated string
-            recv_f = SPIFFS_open(&spiffs_fs, buffer, SPIFFS_O_CREAT | SPIFFS_O_TRUNC | SPIFFS_O_WRONLY, 0);
+            recv_f = SPIFFS_open(&spiffs_fs, (const char *)buffer, SPIFFS_O_CREAT | SPIFFS_O_TRUNC | SPIFFS_O_WRONLY, 0);
             recv_name_cnt = 0;
             ret = true;
             syslog_printf("Start receiving file %s, %d bytes\n", buffer, recv_data_cnt);
@@ -31,11 +31,56 @@
 #define USBCMD_NUKE         0x06
 #define USBCMD_USBBOOT      0x07
 #define USBCMD_RECV         0x08
+#define USBCMD_RECV_BULK    0x09
+#define USBCMD_REGION_SET   0x0a
+#define USBCMD_REGION_RAISE 0x0b
+#define USBCMD_REGION_CLEAR 0x0c
+
+// Region commands carry the region id in the low nibble of the mode byte (v2)
+// or param (v1), and the update mode in the high nibble. REGION_SET adds or
+// moves a region (see region.h), an empty rectangle removes it. REGION_RAISE
+// only uses the id, REGION_CLEAR nothing.
+#define USB_REGION_ID(p)    ((p) & 0x0f)
+#define USB_REGION_MODE(p)  (((p) >> 4) & 0x0f)
 
 #define USBRET_GENERALFAIL  0x00
 #define USBRET_CHKSUMFAIL   0x01
 #define USBRET_SUCCESS      0x55
 
+// Protocol v2, multiple region commands per report. Byte 0 is always
+// USBV2_MAGIC, which is not a valid v1 command, so both can be mixed.
+//
+// Host to device:
+// [0] magic, [1] command count, [2:3] sequence number of the first command,
+// [4] flags, then count * 10 bytes of commands:
+//     [0] USBCMD_REDRAW, USBCMD_SETMODE or USBCMD_REGION_*, [1] mode,
+//     [2:9] x0, y0, x1, y1
+// [62:63] CRC16 of bytes 0 to 61. All fields are little endian.
+//
+// Device to host, only when requested with USBV2_FLAG_ACK, when
+// USBV2_ACK_INTERVAL commands have been received since the last ack, or on
+// errors:
+// [0] magic, [1] USBV2_TYPE_ACK, [2:3] sequence number expected next, all
+// commands before have been processed, [4] USBRET_SUCCESS or the first
+// error, [5] number of failed commands, [6:7] sequence number of the first
+// failed command, [8] free space in the command queue, [9] non-zero if a
+// report was corrupted or lost, or the command queue was full, the host
+// should send everything again starting from the expected sequence number.
+// With [8] zero it should hold off for a bit first. [62:63] CRC16.
+//
+// The host may have up to USBV2_WINDOW commands outstanding without an ack.
+// Reports with a sequence number ahead of the expected one are dropped.
+#define USBV2_MAGIC         0x82
+#define USBV2_TYPE_ACK      0x01
+#define USBV2_FLAG_ACK      0x01
+#define USBV2_FLAG_RESET    0x02    // New session, take the sequence as is
+#define USBV2_HDR_SIZE      5
+#define USBV2_CMD_SIZE      10
+#define USBV2_MAX_CMDS      5
+#define USBV2_CRC_OFFSET    62
+#define USBV2_WINDOW        32
+#define USBV2_ACK_INTERVAL  (USBV2_WINDOW / 2)
+
 void usbapp_term_out(char data, void *usr);
 int usbapp_term_in(int mode, void *usr);
 portTASK_FUNCTION(usb_device_task, pvParameters);
@@ -0,0 +1,265 @@
+//
+// Grimoire
+// Copyright 2025 Wenting Zhang
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+// USB data is received straight into two heap buffers by the endpoint
+// transfer, no copy in between. While one buffer is being written to the
+// flash by usbbulk_task, the other one is filled by USB. If both are busy
+// the OUT endpoint is left unarmed, and the host gets NAKed until the flash
+// catches up.
+//
+#include "platform.h"
+#include "app.h"
+#include "tusb.h"
+#include "device/usbd_pvt.h"
+
+typedef enum {
+    BULK_IDLE,
+    BULK_NAME,
+    BULK_DATA,
+    BULK_FLUSH
+} bulk_state_t;
+
+typedef enum {
+    MSG_OPEN,
+    MSG_WRITE,
+    MSG_CLOSE
+} bulk_msg_type_t;
+
+typedef struct {
+    bulk_msg_type_t type;
+    uint8_t buf;
+    uint32_t len;       // Bytes to write, or bytes missing for MSG_CLOSE
+} bulk_msg_t;
+
+// USB task side
+static uint8_t ep_out;
+static uint8_t ep_in;
+static bulk_state_t state = BULK_IDLE;
+static uint8_t *bufs[2];
+static bool buf_busy[2];
+static uint8_t fill_buf;
+static bool arm_pending;
+static uint32_t remaining;
+static uint16_t name_len;
+static char name[SPIFFS_OBJ_NAME_LEN];
+static CFG_TUSB_MEM_ALIGN uint8_t status_buf[4];
+// Writer task side
+static QueueHandle_t msg_queue;
+static spiffs_file file = -1;
+static uint16_t crc;
+static uint16_t crc_expected;
+static uint32_t size;
+static bool failed;
+static TickType_t start_time;
+
+static void arm_out(void) {
+    uint32_t len = (remaining > USBBULK_BLK_SIZE) ? USBBULK_BLK_SIZE : remaining;
+    buf_busy[fill_buf] = true;
+    arm_pending = false;
+    usbd_edpt_xfer(BOARD_TUD_RHPORT, ep_out, bufs[fill_buf], len);
+}
+
+static void buffer_done(void *param) {
+    uint8_t buf = (uint8_t)(uintptr_t)param;
+    buf_busy[buf] = false;
+    if (arm_pending && (state == BULK_DATA))
+        arm_out();
+}
+
+static void finish(void *param) {
+    uint8_t retval = (uint8_t)(uintptr_t)param;
+    vPortFree(bufs[0]);
+    vPortFree(bufs[1]);
+    bufs[0] = bufs[1] = NULL;
+    state = BULK_IDLE;
+    status_buf[0] = retval;
+    status_buf[1] = 0;
+    status_buf[2] = crc & 0xff;
+    status_buf[3] = (crc >> 8) & 0xff;
+    if (ep_in)
+        usbd_edpt_xfer(BOARD_TUD_RHPORT, ep_in, status_buf, sizeof(status_buf));
+}
+
+// Called from the HID command handler, in the USB task
+uint8_t usbbulk_recv_start(uint16_t nlen, uint32_t fsize, uint16_t chksum) {
+    if ((state != BULK_IDLE) || (ep_out == 0) || (nlen == 0) ||
+            (nlen >= SPIFFS_OBJ_NAME_LEN))
+        return 1;
+    bufs[0] = pvPortMalloc(USBBULK_BLK_SIZE);
+    bufs[1] = pvPortMalloc(USBBULK_BLK_SIZE);
+    if (!bufs[0] || !bufs[1]) {
+        vPortFree(bufs[0]);
+        vPortFree(bufs[1]);
+        bufs[0] = bufs[1] = NULL;
+        return 1;
+    }
+    buf_busy[0] = buf_busy[1] = false;
+    name_len = nlen;
+    remaining = fsize;
+    size = fsize;
+    crc_expected = chksum;
+    state = BULK_NAME;
+    usbd_edpt_xfer(BOARD_TUD_RHPORT, ep_out, bufs[0], name_len);
+    return 0;
+}
+
+static void bulk_init(void) {
+    state = BULK_IDLE;
+}
+
+static void bulk_reset(uint8_t rhport) {
+    (void)rhport;
+    ep_out = ep_in = 0;
+    if (state == BULK_DATA) {
+        // Host went away mid transfer, let the writer clean up
+        bulk_msg_t msg = {.type = MSG_CLOSE, .len = remaining};
+        state = BULK_FLUSH;
+        xQueueSend(msg_queue, &msg, portMAX_DELAY);
+    }
+    else if (state == BULK_NAME) {
+        vPortFree(bufs[0]);
+        vPortFree(bufs[1]);
+        bufs[0] = bufs[1] = NULL;
+        state = BULK_IDLE;
+    }
+}
+
+static uint16_t bulk_open(uint8_t rhport, tusb_desc_interface_t const *desc,
+        uint16_t max_len) {
+    uint16_t len = sizeof(tusb_desc_interface_t) +
+            2 * sizeof(tusb_desc_endpoint_t);
+    if ((desc->bInterfaceClass != TUSB_CLASS_VENDOR_SPECIFIC) ||
+            (max_len < len))
+        return 0;
+    uint8_t const *p_desc = tu_desc_next(desc);
+    if (!usbd_open_edpt_pair(rhport, p_desc, 2, TUSB_XFER_BULK, &ep_out, &ep_in))
+        return 0;
+    return len;
+}
+
+static bool bulk_control_xfer_cb(uint8_t rhport, uint8_t stage,
+        tusb_control_request_t const *request) {
+    return false; // No vendor requests
+}
+
+static bool bulk_xfer_cb(uint8_t rhport, uint8_t ep_addr, xfer_result_t result,
+        uint32_t xferred_bytes) {
+    bulk_msg_t msg;
+    if ((ep_addr != ep_out) || (state == BULK_IDLE) || (state == BULK_FLUSH))
+        return true;
+    if (state == BULK_NAME) {
+        memcpy(name, bufs[0], name_len);
+        name[name_len] = '\0';
+        msg.type = MSG_OPEN;
+        xQueueSend(msg_queue, &msg, portMAX_DELAY);
+        state = BULK_DATA;
+        fill_buf = 0;
+        buf_busy[0] = false;
+        if (remaining > 0) {
+            arm_out();
+            return true;
+        }
+    }
+    else {
+        msg.type = MSG_WRITE;
+        msg.buf = fill_buf;
+        msg.len = xferred_bytes;
+        xQueueSend(msg_queue, &msg, portMAX_DELAY);
+        remaining -= (xferred_bytes > remaining) ? remaining : xferred_bytes;
+        fill_buf = !fill_buf;
+        if ((result == XFER_RESULT_SUCCESS) && (remaining > 0) &&
+                (xferred_bytes != 0)) {
+            if (buf_busy[fill_buf])
+                arm_pending = true; // Re-armed once the writer returns it
+            else
+                arm_out();
+            return true;
+        }
+    }
+    // Done, or a short transfer if the host gave up
+    msg.type = MSG_CLOSE;
+    msg.len = remaining;
+    state = BULK_FLUSH;
+    xQueueSend(msg_queue, &msg, portMAX_DELAY);
+    return true;
+}
+
+static usbd_class_driver_t const bulk_driver = {
+    .init = bulk_init,
+    .reset = bulk_reset,
+    .open = bulk_open,
+    .control_xfer_cb = bulk_control_xfer_cb,
+    .xfer_cb = bulk_xfer_cb,
+    .sof = NULL
+};
+
+usbd_class_driver_t const *usbd_app_driver_get_cb(uint8_t *driver_count) {
+    *driver_count = 1;
+    return &bulk_driver;
+}
+
+void usbbulk_init(void) {
+    msg_queue = xQueueCreate(4, sizeof(bulk_msg_t));
+}
+
+portTASK_FUNCTION(usbbulk_task, pvParameters) {
+    bulk_msg_t msg;
+
+    while (1) {
+        xQueueReceive(msg_queue, &msg, portMAX_DELAY);
+        switch (msg.type) {
+        case MSG_OPEN:
+            failed = false;
+            crc = 0;
+            start_time = xTaskGetTickCount();
+            file = SPIFFS_open(&spiffs_fs, name,
+                    SPIFFS_O_CREAT | SPIFFS_O_TRUNC | SPIFFS_O_WRONLY, 0);
+            if (file < 0)
+                failed = true;
+            syslog_printf("Start receiving file %s, %d bytes\n", name, (int)size);
+            break;
+        case MSG_WRITE:
+            if (!failed) {
+                crc = crc16_update(crc, (char *)bufs[msg.buf], msg.len);
+                if (SPIFFS_write(&spiffs_fs, file, bufs[msg.buf], msg.len) !=
+                        (int32_t)msg.len)
+                    failed = true;
+            }
+            usbd_defer_func(buffer_done, (void *)(uintptr_t)msg.buf, false);
+            break;
+        case MSG_CLOSE: {
+            if (file >= 0)
+                SPIFFS_close(&spiffs_fs, file);
+            file = -1;
+            uint8_t retval = USBRET_SUCCESS;
+            if (failed || (msg.len != 0))
+                retval = USBRET_GENERALFAIL;
+            else if (crc != crc_expected)
+                retval = USBRET_CHKSUMFAIL;
+            uint32_t ms = (xTaskGetTickCount() - start_time) * portTICK_PERIOD_MS;
+            syslog_printf("File received in %d ms, status %02x\n", (int)ms, retval);
+            usbd_defer_func(finish, (void *)(uintptr_t)retval, false);
+            break;
+        }
+        }
+    }
+}
@@ -65,6 +65,13 @@ portTASK_FUNCTION(usb_pd_task, pvParameters) {
                 pd_send_hpd(0, hpd_high);
                 hpd_sent = true;
                 dp_ready = true;
+                ui_post_event(UI_EV_LINK, 1);
+            }
+            else if (!dp_enabled && hpd_sent) {
+                // Alt mode exited
+                hpd_sent = false;
+                dp_ready = false;
+                ui_post_event(UI_EV_LINK, 0);
             }
 //            vTaskDelay(pdMS_TO_TICKS(5));
             //xSemaphoreTake(isr_sem, 0); // Clear semaphore
@@ -0,0 +1,196 @@
+//
+// Grimoire
+// Copyright 2025 Wenting Zhang
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#include "platform.h"
+#include "board.h"
+#include "app.h"
+
+static waveform_set_header_t header;
+static waveform_set_entry_t entries[WAVEFORM_MAX_TEMPS];
+static char file_name[32];
+static bool loaded;
+static volatile int temperature = WAVEFORM_TEMP_UNKNOWN;
+static int current = -1;    // Entry whose LUT is in the FPGA
+
+static uint8_t cache[WAVEFORM_CACHE_SLOTS][WAVEFORM_SIZE];
+static int cache_lut[WAVEFORM_CACHE_SLOTS];     // -1 if the slot is free
+static uint32_t cache_used[WAVEFORM_CACHE_SLOTS];
+static uint32_t cache_clock;
+static waveform_stats_t stats;
+
+static size_t lut_offset(int lut) {
+    return sizeof(waveform_set_header_t) +
+            header.temps * sizeof(waveform_set_entry_t) +
+            (size_t)lut * WAVEFORM_SIZE;
+}
+
+// Returns 0 if the set is usable, otherwise the LUT built into the bitstream
+// stays in use
+int waveform_init(const char *fn) {
+    loaded = false;
+    current = -1;
+    for (int i = 0; i < WAVEFORM_CACHE_SLOTS; i++)
+        cache_lut[i] = -1;
+    memset(&stats, 0, sizeof(stats));
+
+    spiffs_file f = SPIFFS_open(&spiffs_fs, fn, SPIFFS_O_RDONLY, 0);
+    if (f < 0)
+        return -1;
+    spiffs_stat s;
+    SPIFFS_fstat(&spiffs_fs, f, &s);
+    int result = -1;
+    if ((SPIFFS_read(&spiffs_fs, f, &header, sizeof(header)) !=
+            sizeof(header)) || (header.magic != WAVEFORM_SET_MAGIC) ||
+            (header.temps == 0) || (header.temps > WAVEFORM_MAX_TEMPS) ||
+            (header.luts == 0) || (lut_offset(header.luts) > s.size)) {
+        syslog_printf("Invalid waveform set %s", fn);
+        goto out;
+    }
+    size_t size = header.temps * sizeof(waveform_set_entry_t);
+    if (SPIFFS_read(&spiffs_fs, f, entries, size) != (int32_t)size)
+        goto out;
+    for (int i = 0; i < header.temps; i++) {
+        if ((entries[i].lut >= header.luts) || (entries[i].frames == 0) ||
+                (entries[i].frames > WAVEFORM_MAX_FRAMES)) {
+            syslog_printf("Invalid waveform set entry %d", i);
+            goto out;
+        }
+    }
+    strncpy(file_name, fn, sizeof(file_name) - 1);
+    loaded = true;
+    result = 0;
+    header.name[sizeof(header.name) - 1] = '\0';
+    syslog_printf("Waveform %s, %d temperature ranges, %d LUTs",
+            header.name, header.temps, header.luts);
+out:
+    SPIFFS_close(&spiffs_fs, f);
+    return result;
+}
+
+bool waveform_loaded(void) {
+    return loaded;
+}
+
+// Could be called from any task, in degC
+void waveform_set_temperature(int temp) {
+    temperature = temp;
+}
+
+int waveform_get_temperature(void) {
+    return temperature;
+}
+
+// Entry to use at the given temperature, -1 if there is no set
+int waveform_select(int temp) {
+    if (!loaded)
+        return -1;
+    if (temp == WAVEFORM_TEMP_UNKNOWN)
+        temp = WAVEFORM_DEFAULT_TEMP;
+    if (current >= 0) {
+        const waveform_set_entry_t *e = &entries[current];
+        if ((temp >= e->temp_min - WAVEFORM_HYSTERESIS) &&
+                (temp < e->temp_max + WAVEFORM_HYSTERESIS))
+            return current;
+    }
+    // Range containing the temperature, or the closest one if it's outside
+    // of all of them
+    int best = 0;
+    int best_dist = INT32_MAX;
+    for (int i = 0; i < header.temps; i++) {
+        int dist = 0;
+        if (temp < entries[i].temp_min)
+            dist = entries[i].temp_min - temp;
+        else if (temp >= entries[i].temp_max)
+            dist = temp - entries[i].temp_max + 1;
+        if (dist < best_dist) {
+            best = i;
+            best_dist = dist;
+        }
+    }
+    return best;
+}
+
+const waveform_set_entry_t *waveform_get_entry(int entry) {
+    if (!loaded || (entry < 0) || (entry >= header.temps))
+        return NULL;
+    return &entries[entry];
+}
+
+// LUT of an entry, read from the flash if it's not cached. Returns NULL if
+// the read failed.
+const uint8_t *waveform_get_lut(int entry) {
+    const waveform_set_entry_t *e = waveform_get_entry(entry);
+    if (!e)
+        return NULL;
+    int slot = 0;
+    for (int i = 0; i < WAVEFORM_CACHE_SLOTS; i++) {
+        if (cache_lut[i] == e->lut) {
+            stats.cache_hits++;
+            cache_used[i] = ++cache_clock;
+            return cache[i];
+        }
+        // Free slot, or else the least recently used
+        if ((cache_lut[slot] >= 0) && ((cache_lut[i] < 0) ||
+                (cache_used[i] < cache_used[slot])))
+            slot = i;
+    }
+    stats.cache_misses++;
+    TickType_t start = xTaskGetTickCount();
+    cache_lut[slot] = -1;
+    spiffs_file f = SPIFFS_open(&spiffs_fs, file_name, SPIFFS_O_RDONLY, 0);
+    if (f < 0)
+        return NULL;
+    int32_t len = -1;
+    if (SPIFFS_lseek(&spiffs_fs, f, lut_offset(e->lut), SPIFFS_SEEK_SET) >= 0)
+        len = SPIFFS_read(&spiffs_fs, f, cache[slot], WAVEFORM_SIZE);
+    SPIFFS_close(&spiffs_fs, f);
+    stats.flash_ms += xTaskGetTickCount() - start;
+    if (len != WAVEFORM_SIZE)
+        return NULL;
+    cache_lut[slot] = e->lut;
+    cache_used[slot] = ++cache_clock;
+    return cache[slot];
+}
+
+int waveform_get_current(void) {
+    return current;
+}
+
+// -1 when the FPGA LUT is not from the set, such as after caster_init()
+void waveform_set_current(int entry) {
+    current = entry;
+}
+
+void waveform_add_upload(uint32_t ms, bool deferred) {
+    if (deferred) {
+        stats.deferred++;
+        return;
+    }
+    stats.swaps++;
+    stats.upload_ms += ms;
+    if (ms > stats.max_upload_ms)
+        stats.max_upload_ms = ms;
+}
+
+void waveform_get_stats(waveform_stats_t *s) {
+    *s = stats;
+}
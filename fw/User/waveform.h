@@ -0,0 +1,100 @@
+//
+// Grimoire
+// Copyright 2025 Wenting Zhang
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Caster LUT, uploaded as is with caster_load_waveform(). Every frame holds
+// the voltage for all 16x16 src/dst transitions, 2 bits each: the byte at
+// frame * 64 + src * 4 + dst / 4, bits (dst % 4) * 2 and up.
+#define WAVEFORM_SIZE       (4*1024)
+#define WAVEFORM_FRAME_SIZE (64)
+#define WAVEFORM_MAX_FRAMES (WAVEFORM_SIZE / WAVEFORM_FRAME_SIZE)
+
+#define WAVEFORM_GND        0
+#define WAVEFORM_NEG        1   // To black
+#define WAVEFORM_POS        2   // To white
+
+#define WAVEFORM_LUT_INDEX(frame, src, dst) \
+    ((frame) * WAVEFORM_FRAME_SIZE + (src) * 4 + (dst) / 4)
+#define WAVEFORM_LUT_SHIFT(dst) (((dst) % 4) * 2)
+
+// Waveform set file, one mode compiled for a number of temperature ranges by
+// caster_wvfm_asm. The file starts with a waveform_set_header_t, followed by
+// `temps` waveform_set_entry_t sorted by temperature, then `luts` LUTs of
+// WAVEFORM_SIZE bytes each. Temperature ranges sharing the same table in the
+// source waveform share the LUT as well. All fields are little endian.
+#define WAVEFORM_SET_MAGIC  0x31465747  // "GWF1"
+
+typedef struct {
+    uint32_t magic;
+    uint8_t temps;
+    uint8_t luts;
+    uint8_t mode;           // Mode ID in the source waveform
+    uint8_t reserved;
+    char name[24];          // Mode name, NUL terminated
+} waveform_set_header_t;
+
+typedef struct {
+    int8_t temp_min;        // degC, inclusive
+    int8_t temp_max;        // degC, exclusive
+    uint8_t frames;         // Value for caster_load_waveform()
+    uint8_t lut;            // LUT index in the file
+} waveform_set_entry_t;
+
+// Temperature compensation: the set in WAVEFORM_FILE is loaded at boot, and
+// caster_task swaps the LUT in the FPGA whenever the reported temperature
+// moves into another range. Recently used LUTs stay in RAM so swapping back
+// and forth doesn't read the flash every time.
+#define WAVEFORM_FILE           "waveform.gwf"
+#define WAVEFORM_MAX_TEMPS      32
+#define WAVEFORM_CACHE_SLOTS    4
+// The current range is kept until the temperature is this far outside of it,
+// so a reading hovering around a boundary doesn't swap on every change
+#define WAVEFORM_HYSTERESIS     2
+// Assumed until a temperature gets reported
+#define WAVEFORM_DEFAULT_TEMP   25
+#define WAVEFORM_TEMP_UNKNOWN   (-128)
+
+typedef struct {
+    uint32_t swaps;         // LUTs loaded into the FPGA
+    uint32_t deferred;      // Swaps postponed by updates in progress
+    uint32_t cache_hits;
+    uint32_t cache_misses;
+    uint32_t flash_ms;      // Total time reading LUTs from the flash
+    uint32_t upload_ms;     // Total time writing LUTs to the FPGA
+    uint32_t max_upload_ms;
+} waveform_stats_t;
+
+int waveform_init(const char *fn);
+bool waveform_loaded(void);
+void waveform_set_temperature(int temp);
+int waveform_get_temperature(void);
+int waveform_select(int temp);
+const waveform_set_entry_t *waveform_get_entry(int entry);
+const uint8_t *waveform_get_lut(int entry);
+int waveform_get_current(void);
+void waveform_set_current(int entry);
+void waveform_add_upload(uint32_t ms, bool deferred);
+void waveform_get_stats(waveform_stats_t *stats);
@@ -0,0 +1,756 @@
+//
+// Caster pixel pipeline simulator
+// Copyright 2025 Wenting Zhang
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+// The firmware (caster.c, fpga.c, config.c) is compiled unmodified against
+// the host port in ../fw_host. All CSR writes it issues go through the SPI
+// mock into the CSR model, and this file implements the EPDC pixel pipeline
+// on top of the resulting register state:
+//
+// Stage 1: fetch input pixel and 16-bit pixel state
+// Stage 2: dither 8-bit input to 1-bit and 4-bit (../libdither)
+// Stage 3: waveform lookup for the LUT modes
+// Stage 4: decide new state and voltage
+// Stage 5: write back state, count voltage
+//
+// Pixel state layout used by the model:
+// [15:12] level at the start of the current transition (settled level if idle)
+// [11:8]  destination level
+// [7:2]   frame counter
+// [1:0]   phase: idle, fast drive, LUT playback, full refresh
+//
+// The update mode of each pixel is kept outside of the state word, as set by
+// OP_EXT_SETMODE. Timing is modelled at 4 pixels per EPDC clock over the full
+// TCON frame including blanking.
+//
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <time.h>
+#include <getopt.h>
+#include "platform.h"
+#include "board.h"
+#include "app.h"
+#include "host_hal.h"
+#include "fpga_model.h"
+#include "host_spiffs.h"
+#include "dither.h"
+
+#define PH_IDLE         0
+#define PH_FAST         1
+#define PH_LUT          2
+#define PH_REFRESH      3
+
+#define V_GND           0
+#define V_NEG           1 // To black
+#define V_POS           2 // To white
+
+#define ST_SRC(s)       ((s) >> 12)
+#define ST_DST(s)       (((s) >> 8) & 0xf)
+#define ST_CNT(s)       (((s) >> 2) & 0x3f)
+#define ST_PH(s)        ((s) & 0x3)
+#define ST_MAKE(src, dst, cnt, ph) \
+        (uint16_t)(((src) << 12) | ((dst) << 8) | ((cnt) << 2) | (ph))
+
+#define HIST_MAX        256
+#define NOT_PENDING     0xffffffffu
+#define PIPELINE_STAGES 5
+#define PIXELS_PER_CLK  4
+
+// Published limits from the README
+#define LIMIT_DITHER_MPS    133.0
+#define LIMIT_NODITHER_MPS  280.0
+#define DDR3_800_X16_MPS    360.0
+#define STATE_BYTES_PER_PX  4.5
+
+typedef enum {
+    SCN_FLIP,
+    SCN_TYPING,
+    SCN_SCROLL,
+    SCN_FILES
+} scenario_t;
+
+typedef struct {
+    fpga_model_t fpga;
+    int w;
+    int h;
+    // Per pixel planes
+    uint16_t *state;
+    uint8_t *mode;
+    uint8_t *redraw;
+    uint8_t *input;
+    uint8_t *in1;
+    uint8_t *in4;
+    uint8_t *last_target;
+    uint32_t *pending_since;
+    uint8_t *settle_map;
+    bool dither_dirty;
+    // Drive parameters
+    uint32_t drive_frames;
+    uint32_t lut_frames_fallback;
+    // Statistics
+    uint64_t hist[HIST_MAX + 1];
+    uint64_t settled;
+    uint64_t retargeted;
+    uint64_t early_cancels;
+    uint64_t frames_driving;
+    uint64_t voltage_count[3];
+    uint64_t frames;
+    bool warned_lut_frame;
+    // Waveform set swaps
+    uint32_t lut_swaps;
+    uint64_t lut_swap_disturbed;
+    uint64_t lut_swap_max;
+    uint64_t lut_swap_ns;
+} sim_t;
+
+static int clampi(int x, int lo, int hi) {
+    return (x < lo) ? lo : (x > hi) ? hi : x;
+}
+
+static bool mode_is_lut(uint8_t mode) {
+    return (mode == UM_MANUAL_LUT_NO_DITHER) ||
+            (mode == UM_MANUAL_LUT_ERROR_DIFFUSION) ||
+            (mode == UM_AUTO_LUT_NO_DITHER) ||
+            (mode == UM_AUTO_LUT_ERROR_DIFFUSION);
+}
+
+static bool mode_is_auto(uint8_t mode) {
+    return (mode == UM_AUTO_LUT_NO_DITHER) ||
+            (mode == UM_AUTO_LUT_ERROR_DIFFUSION);
+}
+
+static bool mode_uses_dither(uint8_t mode) {
+    return (mode != UM_MANUAL_LUT_NO_DITHER) &&
+            (mode != UM_FAST_MONO_NO_DITHER) &&
+            (mode != UM_AUTO_LUT_NO_DITHER) &&
+            (mode != UM_FAST_GREY);
+}
+
+// Stage 2, recomputed only when the input or the mode map changes, the
+// result is the same as dithering every frame
+static void stage2_dither(sim_t *sim) {
+    dither_stage2(sim->input, sim->mode, sim->in1, sim->in4, sim->w, sim->h,
+            sim->w);
+    sim->dither_dirty = false;
+}
+
+static uint8_t pixel_target(sim_t *sim, int i) {
+    uint8_t mode = sim->mode[i];
+    if ((mode == UM_FAST_MONO_NO_DITHER) || (mode == UM_FAST_MONO_BAYER) ||
+            (mode == UM_FAST_MONO_BLUE_NOISE))
+        return sim->in1[i] ? 15 : 0;
+    if (mode == UM_FAST_GREY)
+        return (uint8_t)(((sim->in4[i] + 2) / 5) * 5);
+    return sim->in4[i];
+}
+
+// Stage 3, 2 bits per transition, 64 bytes per frame
+static uint8_t stage3_lookup(sim_t *sim, uint8_t frame, uint8_t src,
+        uint8_t dst) {
+    uint32_t idx = WAVEFORM_LUT_INDEX(frame, src, dst);
+    return (sim->fpga.lut[idx] >> WAVEFORM_LUT_SHIFT(dst)) & 0x3;
+}
+
+static uint32_t fast_drive_frames(sim_t *sim, int src, int dst) {
+    uint32_t delta = abs(dst - src);
+    uint32_t frames = (delta * sim->drive_frames + 14) / 15;
+    uint32_t mindrv = sim->fpga.regs[CSR_CFG_MINDRV];
+    return (frames < mindrv) ? mindrv : frames;
+}
+
+static uint32_t lut_frames(sim_t *sim) {
+    uint32_t frames = sim->fpga.regs[CSR_LUT_FRAME];
+    if (frames == 0) {
+        if (!sim->warned_lut_frame) {
+            fprintf(stderr, "Warning: CSR_LUT_FRAME is 0 while a LUT mode is "
+                    "active, assuming %d frames\n", sim->lut_frames_fallback);
+            sim->warned_lut_frame = true;
+        }
+        frames = sim->lut_frames_fallback;
+    }
+    return (frames > WAVEFORM_MAX_FRAMES) ? WAVEFORM_MAX_FRAMES : frames;
+}
+
+// Stage 4, returns the new state and the voltage for this frame
+static uint16_t stage4_decide(sim_t *sim, uint16_t st, uint8_t mode,
+        uint8_t target, bool redraw, uint8_t *voltage) {
+    int src = ST_SRC(st);
+    int dst = ST_DST(st);
+    int cnt = ST_CNT(st);
+    int ph = ST_PH(st);
+    bool lut = mode_is_lut(mode);
+    bool auto_lut = mode_is_auto(mode);
+    // Auto LUT modes first move to the nearest binary level quickly
+    uint8_t fast_target = auto_lut ? ((target >= 8) ? 15 : 0) : target;
+
+    *voltage = V_GND;
+
+    if (redraw && (ph != PH_LUT)) {
+        if (lut) {
+            ph = PH_LUT;
+            dst = target;
+        }
+        else {
+            ph = PH_REFRESH;
+            dst = fast_target;
+        }
+        cnt = 0;
+    }
+    else if ((ph == PH_IDLE) && (src != target) && (!lut || auto_lut)) {
+        if (auto_lut && (src == fast_target)) {
+            ph = PH_LUT;
+            dst = target;
+        }
+        else {
+            ph = PH_FAST;
+            dst = fast_target;
+        }
+        cnt = 0;
+    }
+    else if ((ph == PH_FAST) && (dst != fast_target)) {
+        // Early cancellation: restart from the level reached so far, with
+        // the counter set by the newly calculated driving time
+        int sign = (dst > src) ? 1 : -1;
+        int reached = src + sign * (int)((cnt * 15 + sim->drive_frames / 2) /
+                sim->drive_frames);
+        src = clampi(reached, 0, 15);
+        dst = fast_target;
+        cnt = 0;
+        sim->early_cancels++;
+    }
+    else if ((ph == PH_LUT) && auto_lut && ((target >= 8) != (dst >= 8))) {
+        // Input crossed the binary threshold during LUT playback, abandon it
+        src = dst;
+        dst = fast_target;
+        ph = PH_FAST;
+        cnt = 0;
+        sim->early_cancels++;
+    }
+
+    switch (ph) {
+    case PH_FAST:
+        *voltage = (dst > src) ? V_POS : V_NEG;
+        if ((uint32_t)++cnt >= fast_drive_frames(sim, src, dst)) {
+            src = dst;
+            cnt = 0;
+            ph = PH_IDLE;
+        }
+        break;
+    case PH_LUT:
+        *voltage = stage3_lookup(sim, cnt, src, dst);
+        if (*voltage == 3)
+            *voltage = V_GND;
+        if ((uint32_t)++cnt >= lut_frames(sim)) {
+            src = dst;
+            cnt = 0;
+            ph = PH_IDLE;
+        }
+        break;
+    case PH_REFRESH:
+        // Full drive to the rail, then fast drive to the destination
+        *voltage = (dst >= 8) ? V_POS : V_NEG;
+        if ((uint32_t)++cnt >= sim->drive_frames) {
+            src = (dst >= 8) ? 15 : 0;
+            cnt = 0;
+            ph = (src == dst) ? PH_IDLE : PH_FAST;
+        }
+        break;
+    default:
+        break;
+    }
+    return ST_MAKE(src, dst, cnt, ph);
+}
+
+static void pipeline_frame(void *ctx, fpga_model_t *model) {
+    sim_t *sim = ctx;
+    uint32_t now = (uint32_t)model->frame;
+    bool driving = false;
+
+    if (!model->regs[CSR_ENABLE])
+        return;
+    if (sim->dither_dirty)
+        stage2_dither(sim);
+
+    for (int i = 0; i < sim->w * sim->h; i++) {
+        // Stage 1
+        uint16_t st = sim->state[i];
+        uint8_t mode = sim->mode[i];
+        // Stage 2
+        uint8_t target = pixel_target(sim, i);
+        // Stage 3 and 4
+        uint8_t voltage;
+        bool redraw = sim->redraw[i];
+        sim->redraw[i] = 0;
+        if (target != sim->last_target[i]) {
+            if (sim->pending_since[i] != NOT_PENDING)
+                sim->retargeted++;
+            sim->pending_since[i] = now;
+            sim->last_target[i] = target;
+        }
+        else if (redraw && (sim->pending_since[i] == NOT_PENDING)) {
+            sim->pending_since[i] = now;
+        }
+        st = stage4_decide(sim, st, mode, target, redraw, &voltage);
+        // Stage 5
+        sim->state[i] = st;
+        sim->voltage_count[voltage]++;
+        if (voltage != V_GND)
+            driving = true;
+        if ((sim->pending_since[i] != NOT_PENDING) &&
+                (ST_PH(st) == PH_IDLE) && (ST_SRC(st) == target)) {
+            uint32_t frames = now + 1 - sim->pending_since[i];
+            sim->hist[(frames > HIST_MAX) ? HIST_MAX : frames]++;
+            sim->settle_map[i] = (frames > 255) ? 255 : frames;
+            sim->settled++;
+            sim->pending_since[i] = NOT_PENDING;
+        }
+    }
+    if (driving)
+        sim->frames_driving++;
+    sim->frames++;
+}
+
+static void apply_op(void *ctx, fpga_model_t *model, const fpga_op_t *op) {
+    sim_t *sim = ctx;
+    int x0 = clampi(op->left, 0, sim->w);
+    int x1 = clampi(op->right, 0, sim->w);
+    int y0 = clampi(op->top, 0, sim->h);
+    int y1 = clampi(op->bottom, 0, sim->h);
+    for (int y = y0; y < y1; y++) {
+        for (int x = x0; x < x1; x++) {
+            int i = y * sim->w + x;
+            if (op->cmd == OP_EXT_SETMODE)
+                sim->mode[i] = op->param & 0x7;
+            else if (op->cmd == OP_EXT_REDRAW)
+                sim->redraw[i] = 1;
+        }
+    }
+    if (op->cmd == OP_EXT_SETMODE)
+        sim->dither_dirty = true;
+}
+
+// Synthetic waveform standing in for the one built into the bitstream:
+// 4 frames of activation, clear to black, then drive up to the destination.
+static void default_waveform(uint8_t *lut, int frames) {
+    memset(lut, 0, WAVEFORM_SIZE);
+    for (int src = 0; src < 16; src++) {
+        for (int dst = 0; dst < 16; dst++) {
+            if (src == dst)
+                continue;
+            int f = 0;
+            uint8_t seq[WAVEFORM_MAX_FRAMES] = {0};
+            for (int i = 0; i < 4; i++)
+                seq[f++] = (i & 1) ? V_NEG : V_POS;
+            for (int i = 0; i < (src * 12 + 14) / 15; i++)
+                seq[f++] = V_NEG;
+            for (int i = 0; i < (dst * 12 + 14) / 15; i++)
+                seq[f++] = V_POS;
+            for (int i = 0; (i < f) && (i < frames); i++) {
+                lut[WAVEFORM_LUT_INDEX(i, src, dst)] |=
+                        seq[i] << WAVEFORM_LUT_SHIFT(dst);
+            }
+        }
+    }
+}
+
+// Swaps the LUT as soon as the temperature moves to another range, the way
+// caster_task would if no op was in flight. Pixels still playing the old LUT
+// at that point continue with the new one, those are the ones that could show
+// a glitch.
+static void update_waveform(sim_t *sim, int temp) {
+    waveform_set_temperature(temp);
+    int entry = waveform_select(temp);
+    if ((entry < 0) || (entry == waveform_get_current()))
+        return;
+    const uint8_t *lut = waveform_get_lut(entry);
+    if (!lut)
+        return;
+    uint64_t disturbed = 0;
+    for (int i = 0; i < sim->w * sim->h; i++)
+        if (ST_PH(sim->state[i]) == PH_LUT)
+            disturbed++;
+    host_spi_stats_t before, after;
+    host_spi_get_stats(&before);
+    caster_load_waveform((uint8_t *)lut, waveform_get_entry(entry)->frames);
+    host_spi_get_stats(&after);
+    waveform_set_current(entry);
+    sim->lut_swaps++;
+    sim->lut_swap_ns += after.modeled_ns - before.modeled_ns;
+    sim->lut_swap_disturbed += disturbed;
+    if (disturbed > sim->lut_swap_max)
+        sim->lut_swap_max = disturbed;
+}
+
+static int load_pgm(const char *fn, uint8_t *buf, int w, int h) {
+    FILE *fp = fopen(fn, "rb");
+    if (!fp) {
+        fprintf(stderr, "Failed to open %s\n", fn);
+        return -1;
+    }
+    int pw, ph, maxval;
+    if (fscanf(fp, "P5 %d %d %d", &pw, &ph, &maxval) != 3 || maxval != 255) {
+        fprintf(stderr, "%s is not an 8-bit binary PGM\n", fn);
+        fclose(fp);
+        return -1;
+    }
+    fgetc(fp);
+    // Crop or pad with white to the panel size
+    memset(buf, 0xff, w * h);
+    uint8_t *line = malloc(pw);
+    for (int y = 0; y < ph; y++) {
+        if (fread(line, 1, pw, fp) != (size_t)pw)
+            break;
+        if (y < h)
+            memcpy(buf + y * w, line, (pw < w) ? pw : w);
+    }
+    free(line);
+    fclose(fp);
+    return 0;
+}
+
+static void save_pgm(const char *fn, const uint8_t *buf, int w, int h) {
+    FILE *fp = fopen(fn, "wb");
+    if (!fp) {
+        fprintf(stderr, "Failed to open %s for writing\n", fn);
+        return;
+    }
+    fprintf(fp, "P5 %d %d 255\n", w, h);
+    fwrite(buf, 1, w * h, fp);
+    fclose(fp);
+}
+
+static void fill_rect(uint8_t *buf, int w, int h, int x0, int y0, int x1,
+        int y1, uint8_t val) {
+    x0 = clampi(x0, 0, w);
+    x1 = clampi(x1, 0, w);
+    y0 = clampi(y0, 0, h);
+    y1 = clampi(y1, 0, h);
+    for (int y = y0; y < y1; y++)
+        memset(buf + y * w + x0, val, x1 - x0);
+}
+
+// Generate input image number n for a synthetic scenario
+static void scenario_frame(scenario_t scn, int n, uint8_t *buf, int w, int h) {
+    switch (scn) {
+    case SCN_FLIP:
+        for (int y = 0; y < h; y++)
+            for (int x = 0; x < w; x++)
+                buf[y * w + x] = (n & 1) ? (255 - x * 255 / w) : (x * 255 / w);
+        break;
+    case SCN_TYPING: {
+        // 12x24 glyph cells, every 5th keystroke is a backspace
+        const int cw = 12, ch = 24, cols = w / cw;
+        memset(buf, 0xff, w * h);
+        int chars = 0;
+        for (int k = 0; k <= n; k++)
+            chars += ((k % 5) == 4) ? -1 : 1;
+        for (int c = 0; c < chars; c++) {
+            int cx = (c % cols) * cw, cy = (c / cols) * ch;
+            fill_rect(buf, w, h, cx + 2, cy + 4, cx + cw - 2, cy + ch - 4,
+                    (c * 37) % 96);
+        }
+        break;
+    }
+    case SCN_SCROLL:
+        // Lines of text-like blocks moving up 8 pixels per step
+        for (int y = 0; y < h; y++) {
+            int ly = y + n * 8;
+            bool text_row = ((ly % 24) >= 4) && ((ly % 24) < 20);
+            for (int x = 0; x < w; x++) {
+                bool ink = text_row && (((x / 12 + ly / 24 * 7) % 9) != 0) &&
+                        ((x % 12) >= 2) && ((x % 12) < 10);
+                buf[y * w + x] = ink ? 0x20 : 0xf0;
+            }
+        }
+        break;
+    default:
+        break;
+    }
+}
+
+static void print_usage(const char *name) {
+    fprintf(stderr, "Usage: %s [options] [input.pgm ...]\n", name);
+    fprintf(stderr, "  -m mode       Update mode set with caster_setmode (default 3)\n");
+    fprintf(stderr, "  -s scenario   flip, typing or scroll when no PGM is given (default typing)\n");
+    fprintf(stderr, "  -n frames     Number of EPDC frames to simulate (default 120)\n");
+    fprintf(stderr, "  -p period     EPDC frames each input image is shown (default 4)\n");
+    fprintf(stderr, "  -u steps      Number of input images to present (default 16)\n");
+    fprintf(stderr, "  -d frames     Full drive time of the fast modes (default 10)\n");
+    fprintf(stderr, "  -w file       Raw 4KB LUT loaded with caster_load_waveform\n");
+    fprintf(stderr, "  -f frames     Frame count for -w (default 38)\n");
+    fprintf(stderr, "  -W file       Waveform set from caster_wvfm_asm, picked by temperature\n");
+    fprintf(stderr, "  -T from:to    Temperature ramp over the run for -W, degC (default 25)\n");
+    fprintf(stderr, "  -c hz         EPDC clock (default pixel clock / 4)\n");
+    fprintf(stderr, "  -r            Issue caster_redraw for changed areas (manual LUT modes)\n");
+    fprintf(stderr, "  -o file.pgm   Write per pixel frames-to-settle map\n");
+}
+
+int main(int argc, char *argv[]) {
+    static sim_t sim;
+    int mode = UM_FAST_MONO_BAYER;
+    scenario_t scn = SCN_TYPING;
+    uint32_t frames = 120;
+    uint32_t period = 4;
+    uint32_t steps = 16;
+    const char *lut_fn = NULL;
+    const char *map_fn = NULL;
+    int lut_frame_count = 38;
+    const char *set_fn = NULL;
+    int temp_from = WAVEFORM_DEFAULT_TEMP;
+    int temp_to = WAVEFORM_DEFAULT_TEMP;
+    uint32_t clk_hz = 0;
+    bool auto_redraw = false;
+    int opt;
+
+    sim.drive_frames = 10;
+    while ((opt = getopt(argc, argv, "m:s:n:p:u:d:w:f:W:T:c:ro:h")) != -1) {
+        switch (opt) {
+        case 'm': mode = atoi(optarg) & 0x7; break;
+        case 's':
+            if (strcmp(optarg, "flip") == 0) scn = SCN_FLIP;
+            else if (strcmp(optarg, "typing") == 0) scn = SCN_TYPING;
+            else if (strcmp(optarg, "scroll") == 0) scn = SCN_SCROLL;
+            else { print_usage(argv[0]); return 1; }
+            break;
+        case 'n': frames = atoi(optarg); break;
+        case 'p': period = atoi(optarg); break;
+        case 'u': steps = atoi(optarg); break;
+        case 'd': sim.drive_frames = atoi(optarg); break;
+        case 'w': lut_fn = optarg; break;
+        case 'f': lut_frame_count = atoi(optarg); break;
+        case 'W': set_fn = optarg; break;
+        case 'T':
+            if (sscanf(optarg, "%d:%d", &temp_from, &temp_to) < 2)
+                temp_to = temp_from;
+            break;
+        case 'c': clk_hz = atoi(optarg); break;
+        case 'r': auto_redraw = true; break;
+        case 'o': map_fn = optarg; break;
+        default: print_usage(argv[0]); return 1;
+        }
+    }
+    if ((period == 0) || (sim.drive_frames == 0) ||
+            (lut_frame_count > WAVEFORM_MAX_FRAMES)) {
+        print_usage(argv[0]);
+        return 1;
+    }
+    int nfiles = argc - optind;
+    if (nfiles > 0) {
+        scn = SCN_FILES;
+        steps = nfiles;
+    }
+
+    host_init();
+    config_init();
+    if (clk_hz == 0)
+        clk_hz = config.pclk_hz / PIXELS_PER_CLK;
+    dither_init();
+    fpga_model_init(&sim.fpga, clk_hz);
+    default_waveform(sim.fpga.lut, 38);
+    sim.lut_frames_fallback = lut_frame_count;
+
+    // Same sequence as ui_task
+    caster_init();
+
+    sim.w = fpga_model_h_active(&sim.fpga);
+    sim.h = fpga_model_v_active(&sim.fpga);
+    size_t px = (size_t)sim.w * sim.h;
+    sim.state = calloc(px, sizeof(uint16_t));
+    sim.mode = calloc(px, 1);
+    sim.redraw = calloc(px, 1);
+    sim.input = malloc(px);
+    sim.in1 = calloc(px, 1);
+    sim.in4 = calloc(px, 1);
+    sim.last_target = malloc(px);
+    sim.pending_since = malloc(px * sizeof(uint32_t));
+    sim.settle_map = calloc(px, 1);
+    uint8_t *prev_input = malloc(px);
+    // Panel starts fully white and settled
+    memset(sim.input, 0xff, px);
+    for (size_t i = 0; i < px; i++) {
+        sim.state[i] = ST_MAKE(15, 15, 0, PH_IDLE);
+        sim.last_target[i] = 15;
+        sim.pending_since[i] = NOT_PENDING;
+    }
+    sim.dither_dirty = true;
+    fpga_model_set_callbacks(&sim.fpga, &sim, apply_op, pipeline_frame);
+
+    if (lut_fn) {
+        uint8_t *wf = calloc(WAVEFORM_SIZE, 1);
+        FILE *fp = fopen(lut_fn, "rb");
+        if (!fp) {
+            fprintf(stderr, "Failed to open %s\n", lut_fn);
+            return 1;
+        }
+        if (fread(wf, 1, WAVEFORM_SIZE, fp) != WAVEFORM_SIZE)
+            fprintf(stderr, "Warning: %s is shorter than 4KB\n", lut_fn);
+        fclose(fp);
+        caster_load_waveform(wf, lut_frame_count);
+        free(wf);
+    }
+    if (set_fn) {
+        spiffs_init();
+        if ((host_spiffs_import(set_fn, WAVEFORM_FILE) < 0) ||
+                (waveform_init(WAVEFORM_FILE) != 0)) {
+            fprintf(stderr, "Failed to load waveform set %s\n", set_fn);
+            return 1;
+        }
+        update_waveform(&sim, temp_from);
+        sim.lut_swaps = 0;
+        sim.lut_swap_ns = 0;
+    }
+    caster_setmode(0, 0, config.hact, config.vact, (update_mode_t)mode);
+    // Let the mode op retire before any content arrives, otherwise the first
+    // redraw would find the op queue occupied
+    while (fpga_model_status(&sim.fpga) &
+            ((1 << STATUS_OP_BUSY) | (1 << STATUS_OP_QUEUE)))
+        fpga_model_step(&sim.fpga, 1);
+    sim.frames = 0;
+    sim.frames_driving = 0;
+
+    printf("Panel: %d x %d, mode %d, EPDC clock %.3f MHz\n", sim.w, sim.h,
+            mode, clk_hz / 1e6);
+    printf("TCON: %u x %u clocks per frame, %.2f Hz\n",
+            fpga_model_h_total(&sim.fpga), fpga_model_v_total(&sim.fpga),
+            1e9 / fpga_model_frame_ns(&sim.fpga));
+
+    clock_t t0 = clock();
+    uint32_t step = 0;
+    for (uint32_t f = 0; f < frames; f++) {
+        if ((f % period == 0) && (step < steps)) {
+            memcpy(prev_input, sim.input, px);
+            if (scn == SCN_FILES) {
+                if (load_pgm(argv[optind + step], sim.input, sim.w, sim.h))
+                    return 1;
+            }
+            else {
+                scenario_frame(scn, step, sim.input, sim.w, sim.h);
+            }
+            step++;
+            sim.dither_dirty = true;
+            if (auto_redraw) {
+                // Bounding box of the change, like a host damage tracker
+                int x0 = sim.w, y0 = sim.h, x1 = 0, y1 = 0;
+                for (int y = 0; y < sim.h; y++) {
+                    for (int x = 0; x < sim.w; x++) {
+                        if (sim.input[y * sim.w + x] != prev_input[y * sim.w + x]) {
+                            if (x < x0) x0 = x;
+                            if (x >= x1) x1 = x + 1;
+                            if (y < y0) y0 = y;
+                            if (y >= y1) y1 = y + 1;
+                        }
+                    }
+                }
+                if (x1 > x0)
+                    caster_redraw(x0, y0, x1, y1);
+            }
+        }
+        if (set_fn)
+            update_waveform(&sim, temp_from + (int)((int64_t)(temp_to -
+                    temp_from) * f / frames));
+        fpga_model_step(&sim.fpga, 1);
+    }
+    double elapsed = (double)(clock() - t0) / CLOCKS_PER_SEC;
+
+    // Frames to settle
+    uint64_t pending = 0;
+    for (size_t i = 0; i < px; i++) {
+        if (sim.pending_since[i] != NOT_PENDING) {
+            pending++;
+            sim.settle_map[i] = 255;
+        }
+    }
+    printf("\nFrames to settle (%llu pixel updates settled, %llu still pending):\n",
+            (unsigned long long)sim.settled, (unsigned long long)pending);
+    if (sim.settled) {
+        uint64_t sum = 0, acc = 0;
+        int p50 = -1, p90 = -1, p99 = -1, max = 0;
+        for (int i = 0; i <= HIST_MAX; i++) {
+            sum += sim.hist[i] * i;
+            acc += sim.hist[i];
+            if (sim.hist[i])
+                max = i;
+            if ((p50 < 0) && (acc * 100 >= sim.settled * 50)) p50 = i;
+            if ((p90 < 0) && (acc * 100 >= sim.settled * 90)) p90 = i;
+            if ((p99 < 0) && (acc * 100 >= sim.settled * 99)) p99 = i;
+        }
+        double frame_ms = fpga_model_frame_ns(&sim.fpga) / 1e6;
+        printf("  mean %.2f, p50 %d, p90 %d, p99 %d, max %d%s frames\n",
+                (double)sum / sim.settled, p50, p90, p99, max,
+                (max == HIST_MAX) ? "+" : "");
+        printf("  mean %.1f ms, p99 %.1f ms\n", (double)sum / sim.settled *
+                frame_ms, p99 * frame_ms);
+        for (int i = 0; i <= HIST_MAX; i++) {
+            if (sim.hist[i])
+                printf("  %3d%s: %llu\n", i, (i == HIST_MAX) ? "+" : " ",
+                        (unsigned long long)sim.hist[i]);
+        }
+    }
+    printf("  retargeted before settling: %llu, early cancellations: %llu\n",
+            (unsigned long long)sim.retargeted,
+            (unsigned long long)sim.early_cancels);
+    printf("  frames with any pixel driven: %llu of %llu\n",
+            (unsigned long long)sim.frames_driving,
+            (unsigned long long)sim.frames);
+
+    // Throughput
+    double frame_rate = 1e9 / fpga_model_frame_ns(&sim.fpga);
+    double active_mps = (double)px * frame_rate / 1e6;
+    double peak_mps = clk_hz * (double)PIXELS_PER_CLK / 1e6;
+    double limit = mode_uses_dither(mode) ? LIMIT_DITHER_MPS : LIMIT_NODITHER_MPS;
+    printf("\nThroughput:\n");
+    printf("  pipeline: %d stages, %d pixels per clock, peak %.1f MP/s\n",
+            PIPELINE_STAGES, PIXELS_PER_CLK, peak_mps);
+    printf("  active pixel rate %.1f MP/s (%.0f%% of %.0f MP/s processing limit)\n",
+            active_mps, active_mps / limit * 100, limit);
+    printf("  state DDR traffic %.1f MB/s (%.0f%% of DDR3-800 x16)\n",
+            active_mps * STATE_BYTES_PER_PX,
+            active_mps / DDR3_800_X16_MPS * 100);
+    printf("  simulator: %.1f MP/s (%.2f s for %llu frames)\n",
+            (double)px * sim.frames / elapsed / 1e6, elapsed,
+            (unsigned long long)sim.frames);
+
+    printf("\nFPGA ops: %u submitted, %u dropped, %u completed, %u CSR writes\n",
+            sim.fpga.stats.ops_submitted, sim.fpga.stats.ops_dropped,
+            sim.fpga.stats.ops_completed, sim.fpga.stats.csr_writes);
+    host_spi_stats_t spi;
+    host_spi_get_stats(&spi);
+    printf("SPI: %u chip selects, %llu bytes\n", spi.cs_cycles,
+            (unsigned long long)spi.bytes);
+    if (set_fn) {
+        waveform_stats_t wstats;
+        waveform_get_stats(&wstats);
+        printf("LUT swaps: %u from %d to %d degC, %.2f ms SPI each, "
+                "%u flash reads\n", sim.lut_swaps, temp_from, temp_to,
+                sim.lut_swaps ? sim.lut_swap_ns / 1e6 / sim.lut_swaps : 0.0,
+                wstats.cache_misses);
+        printf("  pixels playing a LUT at a swap: %llu total, %llu max\n",
+                (unsigned long long)sim.lut_swap_disturbed,
+                (unsigned long long)sim.lut_swap_max);
+    }
+
+    if (map_fn)
+        save_pgm(map_fn, sim.settle_map, sim.w, sim.h);
+    return 0;
+}
@@ -0,0 +1,433 @@
+//
+// Caster waveform assembler
+// Copyright 2025 Wenting Zhang
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+//
+// Compiles one mode of an .iwf waveform (as written by wbf_wvfm_dump or
+// mxc_wvfm_dump) into the 4KB LUT layout uploaded by caster_load_waveform(),
+// once per temperature range. Trailing frames that leave every transition at
+// GND are dropped, so the LUT plays back no longer than it needs to.
+//
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <stdbool.h>
+#include <libgen.h>
+#include <unistd.h>
+#include "ini.h"
+#include "wbf.h"
+#include "waveform.h"
+
+#define MAX_MODES       (32)
+#define MAX_TEMPS       (32)
+#define MAX_TABLES      (MAX_MODES * MAX_TEMPS)
+// Upper bound of the last range when the descriptor doesn't have one
+#define DEFAULT_TUPBOUND (50)
+
+typedef struct {
+    int version;            // 1: mxc_wvfm_dump, 2: wbf_wvfm_dump
+    char *prefix;
+    int bpp;
+    int modes;
+    int temps;
+    int tables;
+    bool binary;            // FORMAT = LUT, tables are .lut instead of .csv
+    char *mode_names[MAX_MODES];
+    int temp_ranges[MAX_TEMPS + 1];
+    // Version 1 has a table for every mode and temp, version 2 shares them
+    int frame_counts[MAX_TABLES];
+    // Version 2, set when the table isn't PREFIX_TBx.csv (or .lut), relative
+    // to the descriptor
+    char *table_files[MAX_TABLES];
+    int mode_tables[MAX_MODES][MAX_TEMPS];
+} iwf_t;
+
+typedef struct {
+    int temp;               // Index in the source waveform
+    int table;
+    int frames;             // Frames in the source table
+    waveform_set_entry_t entry;
+} set_temp_t;
+
+// Number after a single letter prefix and before the given suffix, such as
+// T3RANGE or TB12FC, -1 if the name doesn't match
+static int parse_index(const char *name, const char *prefix,
+        const char *suffix) {
+    size_t plen = strlen(prefix);
+    size_t slen = strlen(suffix);
+    size_t len = strlen(name);
+    if ((len <= plen + slen) || (strncmp(name, prefix, plen) != 0) ||
+            (strcmp(name + len - slen, suffix) != 0))
+        return -1;
+    int id = 0;
+    for (size_t i = plen; i < len - slen; i++) {
+        if ((name[i] < '0') || (name[i] > '9'))
+            return -1;
+        id = id * 10 + (name[i] - '0');
+    }
+    return id;
+}
+
+static int iwf_handler(void *user, const char *section, const char *name,
+        const char *value) {
+    iwf_t *iwf = user;
+    int id;
+
+    if (strcmp(section, "WAVEFORM") == 0) {
+        if (strcmp(name, "VERSION") == 0)
+            iwf->version = atoi(value);
+        else if (strcmp(name, "PREFIX") == 0)
+            iwf->prefix = strdup(value);
+        else if (strcmp(name, "BPP") == 0)
+            iwf->bpp = atoi(value);
+        else if (strcmp(name, "MODES") == 0)
+            iwf->modes = atoi(value);
+        else if (strcmp(name, "TEMPS") == 0)
+            iwf->temps = atoi(value);
+        else if (strcmp(name, "TABLES") == 0)
+            iwf->tables = atoi(value);
+        else if (strcmp(name, "FORMAT") == 0) {
+            if (strcasecmp(value, "LUT") == 0)
+                iwf->binary = true;
+            else if (strcasecmp(value, "CSV") != 0)
+                return 0;
+        }
+        else if (strcmp(name, "TUPBOUND") == 0)
+            iwf->temp_ranges[MAX_TEMPS] = atoi(value);
+        else if ((id = parse_index(name, "T", "RANGE")) >= 0) {
+            if (id >= MAX_TEMPS)
+                return 0;
+            iwf->temp_ranges[id] = atoi(value);
+        }
+        else if ((id = parse_index(name, "TB", "FC")) >= 0) {
+            if (id >= MAX_TABLES)
+                return 0;
+            iwf->frame_counts[id] = atoi(value);
+        }
+        else if ((id = parse_index(name, "TB", "FILE")) >= 0) {
+            if (id >= MAX_TABLES)
+                return 0;
+            iwf->table_files[id] = strdup(value);
+        }
+        // Other fields (NAME) are not needed
+    }
+    else if (strncmp(section, "MODE", 4) == 0) {
+        int mode = atoi(section + 4);
+        if ((mode < 0) || (mode >= MAX_MODES))
+            return 0;
+        if (strcmp(name, "NAME") == 0) {
+            iwf->mode_names[mode] = strdup(value);
+        }
+        else if ((id = parse_index(name, "T", "TABLE")) >= 0) {
+            if (id >= MAX_TEMPS)
+                return 0;
+            iwf->mode_tables[mode][id] = atoi(value);
+        }
+        else if ((id = parse_index(name, "T", "FC")) >= 0) {
+            // Version 1, table ID is implied by the mode and temp
+            if (id >= MAX_TEMPS)
+                return 0;
+            iwf->mode_tables[mode][id] = mode * MAX_TEMPS + id;
+            iwf->frame_counts[mode * MAX_TEMPS + id] = atoi(value);
+        }
+    }
+    else {
+        fprintf(stderr, "Unknown section %s\n", section);
+        return 0;
+    }
+    return 1;
+}
+
+static void parse_range(const char *str, int *begin, int *end) {
+    const char *delim = strchr(str, ':');
+    *begin = atoi(str);
+    *end = delim ? atoi(delim + 1) : *begin;
+}
+
+// Loads a table into lut[frame][dst][src], one voltage per byte. Entries not
+// in the file are left at GND.
+static int load_table(const char *fn, int frames, int bpp, uint8_t *lut) {
+    int states = (bpp == 5) ? 32 : 16;
+    wbf_lut_t table;
+    int res = wbf_lut_load_table(fn, &table, states, frames, WAVEFORM_GND);
+    if (res != WBF_OK) {
+        fprintf(stderr, "Failed to load %s: %s\n", fn, wbf_strerror(res));
+        return -1;
+    }
+    if ((table.states != states) || table.uni || (table.frames != frames)) {
+        fprintf(stderr, "%s doesn't match the descriptor\n", fn);
+        wbf_lut_free(&table);
+        return -1;
+    }
+    // 5bpp waveforms are reduced to 16 levels by taking the even ones, same
+    // as waveform_5bpp_to_4bpp
+    int shift = (bpp == 5) ? 1 : 0;
+    for (int i = 0; i < frames; i++) {
+        const uint8_t *frame = &table.values[i * states * states];
+        for (int src = 0; src < 16; src++) {
+            for (int dst = 0; dst < 16; dst++) {
+                uint8_t val = frame[(src << shift) * states + (dst << shift)];
+                // 3 keeps the pixel floating, same as GND for the Caster
+                if (val > WAVEFORM_POS)
+                    val = WAVEFORM_GND;
+                lut[i * 256 + dst * 16 + src] = val;
+            }
+        }
+    }
+    wbf_lut_free(&table);
+    return 0;
+}
+
+// Packs into the Caster layout, returns the number of frames after trimming
+// the trailing frames that are GND for every transition
+static int pack_lut(const uint8_t *lut, int frames, uint8_t *packed) {
+    int used = 0;
+    memset(packed, 0, frames * WAVEFORM_FRAME_SIZE);
+    for (int f = 0; f < frames; f++) {
+        for (int src = 0; src < 16; src++) {
+            for (int dst = 0; dst < 16; dst++) {
+                uint8_t val = lut[f * 256 + dst * 16 + src];
+                packed[WAVEFORM_LUT_INDEX(f, src, dst)] |=
+                        val << WAVEFORM_LUT_SHIFT(dst);
+                if (val != WAVEFORM_GND)
+                    used = f + 1;
+            }
+        }
+    }
+    return used;
+}
+
+// Reads the packed LUT back the same way the Caster does
+static bool verify_lut(const uint8_t *lut, int frames, const uint8_t *packed,
+        int used) {
+    for (int f = 0; f < frames; f++) {
+        for (int src = 0; src < 16; src++) {
+            for (int dst = 0; dst < 16; dst++) {
+                uint8_t val = (f < used) ? ((packed[WAVEFORM_LUT_INDEX(f, src,
+                        dst)] >> WAVEFORM_LUT_SHIFT(dst)) & 0x3) : WAVEFORM_GND;
+                if (val != lut[f * 256 + dst * 16 + src])
+                    return false;
+            }
+        }
+    }
+    return true;
+}
+
+static int find_mode(const iwf_t *iwf, const char *name) {
+    for (int i = 0; i < iwf->modes; i++)
+        if (iwf->mode_names[i] && (strcasecmp(iwf->mode_names[i], name) == 0))
+            return i;
+    char *end;
+    long id = strtol(name, &end, 10);
+    if ((*end != '\0') || (id < 0) || (id >= iwf->modes))
+        return -1;
+    return id;
+}
+
+static int write_file(const char *fn, const void *buf, size_t size) {
+    FILE *fp = fopen(fn, "wb");
+    if (!fp) {
+        fprintf(stderr, "Failed to open %s\n", fn);
+        return -1;
+    }
+    int res = (fwrite(buf, 1, size, fp) == size) ? 0 : -1;
+    fclose(fp);
+    return res;
+}
+
+static void print_usage(const char *name) {
+    fprintf(stderr, "Usage: %s [options] -m mode input.iwf\n", name);
+    fprintf(stderr, "  -m mode       Mode ID or name (such as GC16)\n");
+    fprintf(stderr, "  -t min:max    Only temperature ranges overlapping min to max degC\n");
+    fprintf(stderr, "  -o file       Waveform set file, all temperature ranges\n");
+    fprintf(stderr, "  -b prefix     Also write each LUT as prefix_T<n>.bin, for caster_sim -w\n");
+    fprintf(stderr, "  -k            Keep trailing GND frames\n");
+}
+
+int main(int argc, char *argv[]) {
+    static iwf_t iwf;
+    const char *mode_name = NULL;
+    const char *set_fn = NULL;
+    const char *bin_prefix = NULL;
+    int temp_min = -128;
+    int temp_max = 127;
+    bool trim = true;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "m:t:o:b:k")) != -1) {
+        switch (opt) {
+        case 'm': mode_name = optarg; break;
+        case 't': parse_range(optarg, &temp_min, &temp_max); break;
+        case 'o': set_fn = optarg; break;
+        case 'b': bin_prefix = optarg; break;
+        case 'k': trim = false; break;
+        default: print_usage(argv[0]); return 1;
+        }
+    }
+    if (!mode_name || (optind != argc - 1)) {
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    char *input_fn = argv[optind];
+    iwf.temp_ranges[MAX_TEMPS] = DEFAULT_TUPBOUND;
+    iwf.bpp = 4;
+    if (ini_parse(input_fn, iwf_handler, &iwf) != 0) {
+        fprintf(stderr, "Failed to load waveform descriptor %s\n", input_fn);
+        return 1;
+    }
+    if (((iwf.version != 1) && (iwf.version != 2)) || !iwf.prefix ||
+            (iwf.modes <= 0) || (iwf.modes > MAX_MODES) ||
+            (iwf.temps <= 0) || (iwf.temps > MAX_TEMPS)) {
+        fprintf(stderr, "%s is not a valid waveform descriptor\n", input_fn);
+        return 1;
+    }
+    if ((iwf.bpp != 4) && (iwf.bpp != 5)) {
+        fprintf(stderr, "%d bpp waveforms are not supported\n", iwf.bpp);
+        return 1;
+    }
+    iwf.temp_ranges[iwf.temps] = iwf.temp_ranges[MAX_TEMPS];
+    int mode = find_mode(&iwf, mode_name);
+    if (mode < 0) {
+        fprintf(stderr, "Mode %s not found\n", mode_name);
+        return 1;
+    }
+
+    char *dir = dirname(strdup(input_fn));
+    size_t max_file = 0;
+    for (int i = 0; i < MAX_TABLES; i++)
+        if (iwf.table_files[i] && (strlen(iwf.table_files[i]) > max_file))
+            max_file = strlen(iwf.table_files[i]);
+    char *fn = malloc(strlen(dir) + strlen(iwf.prefix) + max_file + 32);
+    static set_temp_t temps[MAX_TEMPS];
+    static uint8_t luts[MAX_TEMPS][WAVEFORM_SIZE];
+    int ntemps = 0;
+    int nluts = 0;
+    int skipped = 0;
+    int total_src = 0;
+    int total_used = 0;
+
+    printf("Mode %d (%s), %d bpp\n", mode,
+            iwf.mode_names[mode] ? iwf.mode_names[mode] : "unnamed", iwf.bpp);
+    printf("  %-12s %5s %7s %7s\n", "degC", "table", "frames", "trimmed");
+    for (int t = 0; t < iwf.temps; t++) {
+        int lo = iwf.temp_ranges[t];
+        int hi = iwf.temp_ranges[t + 1];
+        if ((hi <= temp_min) || (lo > temp_max))
+            continue;
+        int table = iwf.mode_tables[mode][t];
+        int frames = iwf.frame_counts[table];
+        const char *ext = iwf.binary ? "lut" : "csv";
+        if (iwf.version == 1)
+            sprintf(fn, "%s/%s_M%d_T%d.%s", dir, iwf.prefix, mode, t, ext);
+        else if (iwf.table_files[table])
+            sprintf(fn, "%s/%s", dir, iwf.table_files[table]);
+        else
+            sprintf(fn, "%s/%s_TB%d.%s", dir, iwf.prefix, table, ext);
+        if (frames <= 0) {
+            fprintf(stderr, "No frame count for %s\n", fn);
+            return 1;
+        }
+        uint8_t *lut = malloc(frames * 256);
+        uint8_t *packed = malloc(frames * WAVEFORM_FRAME_SIZE);
+        if (load_table(fn, frames, iwf.bpp, lut) != 0)
+            return 1;
+        int used = pack_lut(lut, frames, packed);
+        if (!trim)
+            used = frames;
+        if (!verify_lut(lut, frames, packed, used)) {
+            fprintf(stderr, "LUT readback mismatch for %s\n", fn);
+            return 1;
+        }
+        printf("  %4d to %4d %5d %7d %7d", lo, hi, table, frames, used);
+        if ((used == 0) || (used > WAVEFORM_MAX_FRAMES)) {
+            // Nothing to drive, or longer than the Caster could hold
+            printf("  skipped, %s\n", used ? "too long" : "empty");
+            skipped++;
+            free(lut);
+            free(packed);
+            continue;
+        }
+        printf("\n");
+        total_src += frames;
+        total_used += used;
+
+        set_temp_t *st = &temps[ntemps++];
+        st->temp = t;
+        st->table = table;
+        st->frames = frames;
+        st->entry.temp_min = lo;
+        st->entry.temp_max = hi;
+        st->entry.frames = used;
+        // Ranges using the same table share the LUT
+        int id = nluts;
+        for (int i = 0; i < ntemps - 1; i++)
+            if (temps[i].table == table)
+                id = temps[i].entry.lut;
+        st->entry.lut = id;
+        if (id == nluts) {
+            memset(luts[id], 0, WAVEFORM_SIZE);
+            memcpy(luts[id], packed, used * WAVEFORM_FRAME_SIZE);
+            nluts++;
+        }
+        if (bin_prefix) {
+            char *bin_fn = malloc(strlen(bin_prefix) + 16);
+            sprintf(bin_fn, "%s_T%d.bin", bin_prefix, t);
+            if (write_file(bin_fn, luts[id], WAVEFORM_SIZE) != 0)
+                return 1;
+            free(bin_fn);
+        }
+        free(lut);
+        free(packed);
+    }
+    if (ntemps == 0) {
+        fprintf(stderr, "No temperature range to compile\n");
+        return 1;
+    }
+    printf("%d temperature ranges, %d LUTs, %d skipped, %d of %d frames "
+            "kept\n", ntemps, nluts, skipped, total_used, total_src);
+
+    if (set_fn) {
+        size_t size = sizeof(waveform_set_header_t) +
+                ntemps * sizeof(waveform_set_entry_t) + nluts * WAVEFORM_SIZE;
+        uint8_t *buf = calloc(size, 1);
+        waveform_set_header_t *hdr = (waveform_set_header_t *)buf;
+        hdr->magic = WAVEFORM_SET_MAGIC;
+        hdr->temps = ntemps;
+        hdr->luts = nluts;
+        hdr->mode = mode;
+        if (iwf.mode_names[mode])
+            strncpy(hdr->name, iwf.mode_names[mode], sizeof(hdr->name) - 1);
+        waveform_set_entry_t *entries = (waveform_set_entry_t *)(hdr + 1);
+        for (int i = 0; i < ntemps; i++)
+            entries[i] = temps[i].entry;
+        memcpy(entries + ntemps, luts, nluts * WAVEFORM_SIZE);
+        if (write_file(set_fn, buf, size) != 0)
+            return 1;
+        printf("Wrote %s, %zu bytes\n", set_fn, size);
+        free(buf);
+    }
+
+    free(fn);
+    return 0;
+}
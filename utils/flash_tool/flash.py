@@ -1,5 +1,7 @@
 # Install python3 hidapi package https://pypi.org/project/hidapi/
+# pyusb (https://pypi.org/project/pyusb/) is optional, used for faster uploads
 import hid
+import os
 import struct
 from datetime import datetime
 import subprocess
@@ -14,6 +16,7 @@ USBCMD_SETMODE =        0x05
 USBCMD_NUKE =           0x06
 USBCMD_USBBOOT =        0x07
 USBCMD_RECV =           0x08
+USBCMD_RECV_BULK =      0x09
 
 USBRET_GENERALFAIL =    0x00
 USBRET_CHKSUMFAIL =     0x01
@@ -22,6 +25,11 @@ USBRET_SUCCESS =        0x55
 PACKET_SIZE =           64
 PKT_DATA_SIZE =         PACKET_SIZE - 1
 
+USB_VID =               0x0483
+USB_PID =               0x5750
+BULK_CHUNK_SIZE =       64 * 1024
+BULK_TIMEOUT_MS =       10000
+
 def crc16(data: bytes):
     '''
     CRC-16 (CCITT) implemented with a precomputed lookup table
@@ -52,11 +60,8 @@ def crc16(data: bytes):
     return crc
 
 def open_dev():
-    vid = 0x0483
-    pid = 0x5750
-
     h = hid.device()
-    h.open(vid, pid)
+    h.open(USB_VID, USB_PID)
 
     print("Manufacturer: %s" % h.get_manufacturer_string())
     print("Product: %s" % h.get_product_string())
@@ -65,7 +70,7 @@ def open_dev():
     return h
 
 def send_cmd(h, cmd, param, x0, y0, x1, y1, pid):
-    byteseq = struct.pack('<bhhhhhh', cmd, param, x0, y0, x1, y1, pid)
+    byteseq = struct.pack('<BHHHHHH', cmd, param, x0, y0, x1, y1, pid)
     chksum = struct.pack('<H', crc16(byteseq))
     byteout = b'\0' + byteseq + chksum + bytearray(48)
     h.write(byteout)
@@ -89,11 +94,55 @@ def send_buffer(h, bin):
     totaltime = (datetime.now() - start_time).total_seconds()
     print(f'\nDone ({totaltime} seconds, {len(bin)/totaltime/1000:.1f}KB/s)')
 
+def open_bulk():
+    # Returns (OUT, IN) endpoints of the vendor bulk interface, or None if
+    # pyusb is not available or the firmware doesn't have the interface
+    try:
+        import usb.core
+        import usb.util
+    except ImportError:
+        return None
+    dev = usb.core.find(idVendor=USB_VID, idProduct=USB_PID)
+    if dev is None:
+        return None
+    intf = usb.util.find_descriptor(dev.get_active_configuration(),
+        bInterfaceClass=0xff)
+    if intf is None:
+        return None
+    ep_out = usb.util.find_descriptor(intf, custom_match=lambda e:
+        usb.util.endpoint_direction(e.bEndpointAddress) == usb.util.ENDPOINT_OUT)
+    ep_in = usb.util.find_descriptor(intf, custom_match=lambda e:
+        usb.util.endpoint_direction(e.bEndpointAddress) == usb.util.ENDPOINT_IN)
+    return (ep_out, ep_in)
+
+def send_file_bulk(h, bulk, bin, target_fn):
+    ep_out, ep_in = bulk
+    fsize = len(bin)
+    name = bytearray(target_fn, 'ascii')
+    send_cmd(h, USBCMD_RECV_BULK, len(name), fsize % 65536, fsize // 65536,
+        crc16(bin), 0, 0)
+    ep_out.write(name, BULK_TIMEOUT_MS)
+    start_time = datetime.now()
+    for i in range(0, fsize, BULK_CHUNK_SIZE):
+        print(f'\rSending {i // 1024} of {fsize // 1024} KB', end = '')
+        ep_out.write(bin[i:i+BULK_CHUNK_SIZE], BULK_TIMEOUT_MS)
+    # Chunks are a multiple of the packet size, the device counts bytes
+    status = ep_in.read(PACKET_SIZE, BULK_TIMEOUT_MS)
+    if (status[0] != USBRET_SUCCESS):
+        raise Exception("Send data failed!")
+    totaltime = (datetime.now() - start_time).total_seconds()
+    print(f'\nDone ({totaltime} seconds, {fsize/totaltime/1000:.1f}KB/s)')
+
 def send_file(h, fn, target_fn):
     fp = open(fn, 'rb')
     bin = fp.read()
     fp.close()
     fsize = len(bin)
+    bulk = open_bulk()
+    if bulk is not None:
+        send_file_bulk(h, bulk, bin, target_fn)
+        return
+    print("Bulk interface not available, falling back to HID")
     send_cmd(h, USBCMD_RECV, 1, fsize % 65536, fsize // 65536, 0, 0, 0)
     send_buffer(h, bytearray(target_fn, 'ascii'))
     send_buffer(h, bin)
@@ -103,7 +152,12 @@ def send_files():
     while not success:
         try:
             h = open_dev()
-            send_file(h, 'fpga.bit', 'fpga.bit')
+            # Compressed bitstream from utils/lzb_compress is stored under
+            # the same name, the firmware recognizes it by its header
+            if os.path.exists('fpga.lzb'):
+                send_file(h, 'fpga.lzb', 'fpga.bit')
+            else:
+                send_file(h, 'fpga.bit', 'fpga.bit')
             send_file(h, 'font_24x40.bin', 'font_24x40.bin')
             success = True
         except OSError:
@@ -0,0 +1,64 @@
+//
+// Glider firmware benchmarks
+// Copyright 2025 Wenting Zhang
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+// Shared helpers for the firmware benchmarks.
+//
+#pragma once
+
+#include "platform.h"
+#include "board.h"
+#include "app.h"
+#include "host_hal.h"
+#include "fpga_model.h"
+
+#ifndef MIN
+#define MIN(a, b) (((a) < (b)) ? (a) : (b))
+#endif
+#ifndef MAX
+#define MAX(a, b) (((a) > (b)) ? (a) : (b))
+#endif
+
+// Every benchmark is a subcommand of fw_bench
+typedef struct {
+    const char *name;
+    const char *help;
+    int (*run)(int argc, char **argv);
+} bench_t;
+
+int bench_csr(int argc, char **argv);
+int bench_queue(int argc, char **argv);
+int bench_coalesce(int argc, char **argv);
+int bench_upload(int argc, char **argv);
+int bench_bitstream(int argc, char **argv);
+int bench_boot(int argc, char **argv);
+int bench_i2c(int argc, char **argv);
+int bench_i2cseq(int argc, char **argv);
+int bench_region(int argc, char **argv);
+int bench_waveform(int argc, char **argv);
+
+// Reset the CSR model and the SPI counters
+void bench_reset_fpga(fpga_model_t *model);
+void bench_print_spi(const char *name, const host_spi_stats_t *stats,
+        uint32_t calls);
+
+// pal_i2c on the I2C1 model, with the interrupt handlers hooked up
+void bench_i2c_setup(void);
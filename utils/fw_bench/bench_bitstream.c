@@ -0,0 +1,179 @@
+//
+// Glider firmware benchmarks
+// Copyright 2025 Wenting Zhang
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+// FPGA bitstream load time from SPIFFS, raw against compressed with
+// lzb_compress. fpga_init() runs unmodified, a configuration port model on
+// the FPGA chip select checks the received stream and raises DONE once all
+// of it arrived. Flash and SPI time come from the host models, the
+// decompression time is estimated from the per byte cost below.
+//
+#include "bench.h"
+#include "host_spiffs.h"
+#include "lzb_compress.h"
+
+// Roughly the Spartan-6 LX16 bitstream size, and its frame length
+#define BITSTREAM_SIZE      (464 * 1024)
+#define FRAME_BYTES         (130)
+// LZ4 style decode on the M7 at 480 MHz, running from AXI SRAM
+#define DECOMPRESS_NS_PER_BYTE  (10)
+
+typedef struct {
+    const uint8_t *expected;
+    uint32_t size;
+    uint32_t received;
+    uint32_t mismatch;
+} config_port_t;
+
+static void port_select(void *ctx, bool selected) {
+}
+
+static void port_xfer(void *ctx, const uint8_t *tx, uint8_t *rx, size_t len) {
+    config_port_t *port = ctx;
+    for (size_t i = 0; i < len; i++) {
+        if ((port->received >= port->size) ||
+                (tx[i] != port->expected[port->received]))
+            port->mismatch++;
+        port->received++;
+    }
+    if (rx)
+        memset(rx, 0, len);
+    host_gpio_set_input(FPGA_DONE,
+            (port->received == port->size) && (port->mismatch == 0));
+}
+
+// Mostly empty configuration frames with a few set bytes each, like a design
+// using a small part of the device. density is the percentage of non zero
+// bytes.
+static void make_bitstream(uint8_t *buf, uint32_t size, int density) {
+    uint32_t seed = 1;
+    memset(buf, 0, size);
+    for (uint32_t i = 0; i < size; i++) {
+        seed = seed * 1103515245 + 12345;
+        if ((int)((seed >> 16) % 100) < density) {
+            seed = seed * 1103515245 + 12345;
+            buf[i] = seed >> 16;
+        }
+    }
+    // Sync word and a repeated frame header, as BitGen output has
+    for (uint32_t i = 0; i + 4 <= size; i += FRAME_BYTES)
+        memcpy(buf + i, "\xaa\x99\x55\x66", 4);
+}
+
+static uint32_t compress(const uint8_t *src, uint32_t size, uint8_t *dst) {
+    lzb_header_t hdr = {
+        .magic = LZB_MAGIC,
+        .size = size,
+        .block_size = LZB_BLOCK_SIZE
+    };
+    memcpy(dst, &hdr, sizeof(hdr));
+    uint32_t out = sizeof(hdr);
+    for (uint32_t pos = 0; pos < size; pos += LZB_BLOCK_SIZE)
+        out += lzb_compress_block(src + pos, MIN((uint32_t)LZB_BLOCK_SIZE, size - pos),
+                dst + out, 3);
+    return out;
+}
+
+static int load(const char *name, const uint8_t *file, uint32_t file_size,
+        const uint8_t *raw, uint32_t size, bool compressed) {
+    host_spiffs_format();
+    if (host_spiffs_write_file("fpga.bit", file, file_size) != (int)file_size) {
+        fprintf(stderr, "Failed to write the bitstream to SPIFFS\n");
+        return -1;
+    }
+    config_port_t port = {.expected = raw, .size = size};
+    host_spi_dev_t dev = {
+        .ctx = &port,
+        .select = port_select,
+        .xfer = port_xfer
+    };
+    host_spi_attach(FPGA_SPI, FPGA_CS, &dev);
+    host_gpio_set_input(FPGA_DONE, false);
+    board_switch_spi_freq(FPGA_SPI, 24000000);
+    host_flash_reset_stats();
+    host_spi_reset_stats();
+
+    fpga_init("fpga.bit");
+
+    host_flash_stats_t flash;
+    host_spi_stats_t spi;
+    host_flash_get_stats(&flash);
+    host_spi_get_stats(&spi);
+    uint64_t decompress_ns = compressed ?
+            (uint64_t)size * DECOMPRESS_NS_PER_BYTE : 0;
+    // Reading and decompressing the next block overlaps with the DMA of
+    // the current one
+    uint64_t pipelined = MAX(flash.modeled_ns + decompress_ns, spi.modeled_ns);
+    printf("  %-12s %7u %8.1f %8.1f %8.1f %8.1f %8.1f  %s\n", name, file_size,
+            flash.modeled_ns / 1e6, decompress_ns / 1e6, spi.modeled_ns / 1e6,
+            (flash.modeled_ns + decompress_ns + spi.modeled_ns) / 1e6,
+            pipelined / 1e6,
+            ((port.received == size) && (port.mismatch == 0)) ? "ok" :
+            "MISMATCH");
+    return port.mismatch ? -1 : 0;
+}
+
+int bench_bitstream(int argc, char **argv) {
+    int density = 8;
+    uint32_t size = BITSTREAM_SIZE;
+    if (argc > 1)
+        density = atoi(argv[1]);
+    if (argc > 2)
+        size = atoi(argv[2]);
+    if ((density < 0) || (density > 100) || (size == 0)) {
+        fprintf(stderr, "Usage: bitstream [density %%] [bytes]\n");
+        return 1;
+    }
+    uint8_t *raw = malloc(size);
+    make_bitstream(raw, size, density);
+    uint8_t *packed = malloc(sizeof(lzb_header_t) +
+            (size / LZB_BLOCK_SIZE + 1) * LZB_BOUND(LZB_BLOCK_SIZE));
+    uint32_t packed_size = compress(raw, size, packed);
+
+    // Host decode speed, for reference against the estimate above
+    uint8_t *check = malloc(LZB_BLOCK_SIZE);
+    uint64_t start = host_time_us();
+    for (int rep = 0; rep < 20; rep++) {
+        uint32_t pos = sizeof(lzb_header_t);
+        while (pos < packed_size) {
+            int clen = (packed[pos] | (packed[pos + 1] << 8));
+            if (!(clen & LZB_BLOCK_STORED))
+                lzb_decompress(packed + pos + 2, clen, check, LZB_BLOCK_SIZE);
+            pos += 2 + (clen & ~LZB_BLOCK_STORED);
+        }
+    }
+    uint64_t host_us = host_time_us() - start;
+
+    spiffs_init();
+    printf("%u byte bitstream, %d%% non zero, compressed to %u bytes (%.1f%%)\n",
+            size, density, packed_size, packed_size * 100.0 / size);
+    printf("Host decode %.0f MB/s, SPI at %u Hz\n",
+            host_us ? size * 20.0 / host_us : 0.0, 24000000);
+    printf("  %-12s %7s %8s %8s %8s %8s %8s\n", "", "bytes", "flash",
+            "decomp", "spi", "serial", "pipelined");
+    int res = load("raw", raw, size, raw, size, false);
+    res |= load("compressed", packed, packed_size, raw, size, true);
+    printf("  (times in ms)\n");
+    free(raw);
+    free(packed);
+    free(check);
+    return res ? 1 : 0;
+}
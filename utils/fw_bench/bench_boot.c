@@ -0,0 +1,142 @@
+//
+// Glider firmware benchmarks
+// Copyright 2025 Wenting Zhang
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+// Boot sequence length with the dependency scheduler in boot.c, against the
+// previous fully serial startup. The step graph mirrors boot_steps in
+// app_main.c, step durations are estimates from the logs of a board and the
+// bitstream benchmark. The schedule is computed with boot_sched_simulate(),
+// then boot_run() runs it for real on host tasks that sleep instead. An HPD
+// time of PTN3460_READY_TIMEOUT_MS or more fails dp_wait in boot_run().
+//
+#include "bench.h"
+
+enum {
+    BOOT_FLASH,
+    BOOT_CONFIG,
+    BOOT_FPGA,
+    BOOT_DP_RESET,
+    BOOT_DP_WAIT,
+    BOOT_ADV7611,
+    BOOT_PTN3460,
+    BOOT_POWER,
+    BOOT_STEP_COUNT
+};
+
+// Milliseconds
+static uint32_t durations[BOOT_STEP_COUNT] = {
+    [BOOT_FLASH] = 4,       // JEDEC ID and SPIFFS mount
+    [BOOT_CONFIG] = 2,
+    [BOOT_FPGA] = 190,      // PROG pulse plus raw bitstream over SPI
+    [BOOT_DP_RESET] = 20,   // ADV7611 reset pulses
+    [BOOT_DP_WAIT] = 120,   // PTN3460 HPD, up to 500
+    [BOOT_ADV7611] = 45,    // Init tables and EDID at 100kHz I2C
+    [BOOT_PTN3460] = 16,    // EDID and a few registers
+    [BOOT_POWER] = 0,
+};
+
+static bool run_step(int step) {
+    vTaskDelay(pdMS_TO_TICKS(durations[step]));
+    return true;
+}
+
+static bool step_flash(void) { return run_step(BOOT_FLASH); }
+static bool step_config(void) { return run_step(BOOT_CONFIG); }
+static bool step_fpga(void) { return run_step(BOOT_FPGA); }
+static bool step_dp_reset(void) { return run_step(BOOT_DP_RESET); }
+static bool step_adv7611(void) { return run_step(BOOT_ADV7611); }
+static bool step_ptn3460(void) { return run_step(BOOT_PTN3460); }
+static bool step_power(void) { return run_step(BOOT_POWER); }
+
+static bool hpd_timeout;
+
+// Gives up like ptn3460_wait_ready() if HPD takes too long
+static bool step_dp_wait(void) {
+    run_step(BOOT_DP_WAIT);
+    return !hpd_timeout;
+}
+
+static const boot_step_t steps[BOOT_STEP_COUNT] = {
+    [BOOT_FLASH] = {"flash", step_flash, 0, BOOT_RES_QSPI},
+    [BOOT_CONFIG] = {"config", step_config, BOOT_STEP(BOOT_FLASH),
+            BOOT_RES_QSPI},
+    [BOOT_FPGA] = {"fpga", step_fpga, BOOT_STEP(BOOT_CONFIG),
+            BOOT_RES_QSPI | BOOT_RES_FPGA_SPI},
+    [BOOT_DP_RESET] = {"dp_reset", step_dp_reset, 0, BOOT_RES_I2C},
+    [BOOT_DP_WAIT] = {"dp_wait", step_dp_wait, BOOT_STEP(BOOT_DP_RESET), 0},
+    [BOOT_ADV7611] = {"adv7611", step_adv7611,
+            BOOT_STEP(BOOT_DP_RESET) | BOOT_STEP(BOOT_CONFIG), BOOT_RES_I2C},
+    [BOOT_PTN3460] = {"ptn3460", step_ptn3460,
+            BOOT_STEP(BOOT_DP_WAIT) | BOOT_STEP(BOOT_CONFIG), BOOT_RES_I2C},
+    [BOOT_POWER] = {"power", step_power, BOOT_STEP(BOOT_CONFIG),
+            BOOT_RES_DAC},
+};
+
+static void print_timeline(boot_sched_t *sched) {
+    for (int i = 0; i < sched->count; i++) {
+        boot_record_t *rec = &sched->records[i];
+        printf("    %-10s %4u - %4u ms  worker %d\n", sched->steps[i].name,
+                rec->start, rec->end, rec->worker);
+    }
+}
+
+int bench_boot(int argc, char **argv) {
+    if (argc > 1)
+        durations[BOOT_DP_WAIT] = atoi(argv[1]);
+    if (argc > 2)
+        durations[BOOT_FPGA] = atoi(argv[2]);
+    if (durations[BOOT_DP_WAIT] >= PTN3460_READY_TIMEOUT_MS) {
+        hpd_timeout = true;
+        durations[BOOT_DP_WAIT] = PTN3460_READY_TIMEOUT_MS;
+    }
+
+    boot_sched_t sched;
+    if (boot_sched_init(&sched, steps, BOOT_STEP_COUNT) != 0) {
+        fprintf(stderr, "Invalid boot step graph\n");
+        return 1;
+    }
+    uint32_t serial = 0;
+    for (int i = 0; i < BOOT_STEP_COUNT; i++)
+        serial += durations[i];
+    printf("Boot to FPGA ready, PTN3460 HPD %s %u ms, bitstream %u ms\n",
+            hpd_timeout ? "timeout at" : "after", durations[BOOT_DP_WAIT],
+            durations[BOOT_FPGA]);
+    printf("  %-26s %5u ms\n", "serial", serial);
+    for (int workers = 1; workers <= 3; workers++) {
+        boot_sched_init(&sched, steps, BOOT_STEP_COUNT);
+        uint32_t total = boot_sched_simulate(&sched, durations, workers);
+        char label[32];
+        snprintf(label, sizeof(label), "scheduled, %d worker%s", workers,
+                (workers > 1) ? "s" : "");
+        printf("  %-26s %5u ms\n", label, total);
+        if (workers == 3)
+            print_timeline(&sched);
+    }
+
+    // Same schedule with real tasks, the host tick is 1ms
+    fflush(stdout);
+    uint64_t start = host_time_us();
+    boot_run(steps, BOOT_STEP_COUNT, 3);
+    printf("  %-26s %5.0f ms\n", "boot_run, 3 workers",
+            (host_time_us() - start) / 1000.0);
+    boot_print_timeline();
+    return 0;
+}
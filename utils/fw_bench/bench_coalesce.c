@@ -0,0 +1,202 @@
+//
+// Glider firmware benchmarks
+// Copyright 2025 Wenting Zhang
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+// Synthetic typing and scrolling traces played in real time through the
+// caster command queue, with damage coalescing on and off. Reports how many
+// FPGA ops are saved and the latency from submission to the FPGA starting
+// the op that covers it.
+//
+#include "bench.h"
+
+#define MAX_TRACE_OPS   256
+
+typedef struct {
+    uint32_t frame;     // When the host sends it, in EPDC frames
+    caster_op_t op;
+    uint64_t submit_us;
+    uint64_t start_us;
+    bool started;
+} trace_op_t;
+
+typedef struct {
+    trace_op_t ops[MAX_TRACE_OPS];
+    int count;
+    pthread_mutex_t lock;
+} trace_t;
+
+static fpga_model_t model;
+static trace_t trace;
+
+static void trace_add(uint32_t frame, uint16_t x0, uint16_t y0, uint16_t x1,
+        uint16_t y1) {
+    if (trace.count == MAX_TRACE_OPS)
+        return;
+    trace_op_t *t = &trace.ops[trace.count++];
+    memset(t, 0, sizeof(trace_op_t));
+    t->frame = frame;
+    t->op.cmd = OP_EXT_REDRAW;
+    t->op.x0 = x0;
+    t->op.y0 = y0;
+    t->op.x1 = x1;
+    t->op.y1 = y1;
+}
+
+// A key press every 6 frames: the glyph, the old cursor and the new cursor
+static void gen_typing(uint32_t keys) {
+    trace.count = 0;
+    for (uint32_t i = 0; i < keys; i++) {
+        uint16_t x = 40 + (i % 60) * 16;
+        uint16_t y = 100 + (i / 60) * 32;
+        uint32_t frame = i * 6;
+        trace_add(frame, x, y, x + 2, y + 32);
+        trace_add(frame, x, y, x + 16, y + 32);
+        trace_add(frame, x + 16, y, x + 18, y + 32);
+    }
+}
+
+// Slow typing, the FPGA is idle when each key arrives, so this shows the
+// cost of the coalescing window alone
+static void gen_sparse(uint32_t keys) {
+    trace.count = 0;
+    for (uint32_t i = 0; i < keys; i++) {
+        uint16_t x = 40 + i * 16;
+        trace_add(i * 20, x, 100, x + 16, 132);
+    }
+}
+
+// Text area scrolled by one line every frame, plus the scrollbar thumb
+static void gen_scroll(uint32_t steps) {
+    trace.count = 0;
+    for (uint32_t i = 0; i < steps; i++) {
+        uint16_t thumb = 100 + i * 8;
+        trace_add(i, 0, 100, 1560, 1100);
+        trace_add(i, 1560, thumb, 1600, thumb + 120);
+    }
+}
+
+static bool contains(const fpga_op_t *op, const caster_op_t *r) {
+    return (op->left <= r->x0) && (op->right >= r->x1) &&
+            (op->top <= r->y0) && (op->bottom >= r->y1);
+}
+
+// Called with the model lock held, from whichever task touched the SPI
+static void op_start(void *ctx, fpga_model_t *m, const fpga_op_t *op) {
+    // Frame n is processed once it's over, the op starts at its end
+    uint64_t start_us = m->realtime_base_us + (op->start_frame + 1 -
+            m->realtime_base_frame) * fpga_model_frame_ns(m) / 1000;
+    pthread_mutex_lock(&trace.lock);
+    for (int i = 0; i < trace.count; i++) {
+        trace_op_t *t = &trace.ops[i];
+        // The callback may run a bit after the op started, don't credit it
+        // to ops the host hadn't sent yet at that point
+        if (t->started || (t->submit_us == 0) || (t->submit_us > start_us) ||
+                (op->cmd != t->op.cmd) || !contains(op, &t->op))
+            continue;
+        t->started = true;
+        t->start_us = start_us;
+    }
+    pthread_mutex_unlock(&trace.lock);
+}
+
+static int cmp_u64(const void *a, const void *b) {
+    uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+    return (x > y) - (x < y);
+}
+
+static void run_trace(const char *name, uint32_t frame_us, bool coalesce) {
+    caster_queue_stats_t before, after;
+    caster_queue_get_stats(&before);
+    caster_queue_set_coalesce(coalesce);
+    uint32_t dropped = model.stats.ops_dropped;
+
+    uint64_t start = host_time_us();
+    for (int i = 0; i < trace.count; i++) {
+        trace_op_t *t = &trace.ops[i];
+        uint64_t due = start + (uint64_t)t->frame * frame_us;
+        uint64_t now = host_time_us();
+        if (due > now)
+            host_sleep_us(due - now);
+        // Latency counts from when the host wanted to send it
+        pthread_mutex_lock(&trace.lock);
+        t->submit_us = due;
+        pthread_mutex_unlock(&trace.lock);
+        caster_submit(&t->op, portMAX_DELAY);
+    }
+    do {
+        host_sleep_us(1000);
+        caster_queue_get_stats(&after);
+    } while (after.completed + after.timeout - before.completed -
+            before.timeout < (uint32_t)trace.count);
+
+    uint64_t *lat = malloc(trace.count * sizeof(uint64_t));
+    int n = 0;
+    for (int i = 0; i < trace.count; i++) {
+        if (trace.ops[i].started)
+            lat[n++] = trace.ops[i].start_us - trace.ops[i].submit_us;
+    }
+    qsort(lat, n, sizeof(uint64_t), cmp_u64);
+    uint32_t issued = after.issued - before.issued;
+    printf("  %-8s %-4s %4d ops -> %4u FPGA ops (%5.1f%% saved), "
+            "latency p50 %7.1f ms p99 %7.1f ms, %u dropped\n",
+            name, coalesce ? "on" : "off", trace.count, issued,
+            100.0 * (trace.count - issued) / trace.count,
+            n ? lat[n / 2] / 1000.0 : 0.0,
+            n ? lat[(n * 99) / 100] / 1000.0 : 0.0,
+            model.stats.ops_dropped - dropped);
+    free(lat);
+    for (int i = 0; i < trace.count; i++) {
+        trace.ops[i].started = false;
+        trace.ops[i].submit_us = 0;
+    }
+}
+
+int bench_coalesce(int argc, char **argv) {
+    uint32_t frame_us = 4000;
+    if (argc > 1)
+        frame_us = atoi(argv[1]);
+    if (frame_us == 0) {
+        fprintf(stderr, "Usage: coalesce [frame_us]\n");
+        return 1;
+    }
+    pthread_mutex_init(&trace.lock, NULL);
+    bench_reset_fpga(&model);
+    caster_init();
+    model.clk_hz = (uint64_t)fpga_model_h_total(&model) *
+            fpga_model_v_total(&model) * 1000000ull / frame_us;
+    fpga_model_set_callbacks(&model, NULL, op_start, NULL);
+    fpga_model_set_realtime(&model, true);
+    caster_queue_init();
+    xTaskCreate(caster_task, "CasterTask", 0, NULL, 0, NULL);
+
+    printf("%u us frames, %u frames per op, %u ms coalescing window\n",
+            frame_us, 16, CASTER_COALESCE_MS);
+    gen_sparse(16);
+    run_trace("sparse", frame_us, false);
+    run_trace("sparse", frame_us, true);
+    gen_typing(24);
+    run_trace("typing", frame_us, false);
+    run_trace("typing", frame_us, true);
+    gen_scroll(30);
+    run_trace("scroll", frame_us, false);
+    run_trace("scroll", frame_us, true);
+    return 0;
+}
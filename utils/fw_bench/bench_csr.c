@@ -0,0 +1,253 @@
+//
+// Glider firmware benchmarks
+// Copyright 2025 Wenting Zhang
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+// CSR write cost of caster.c, batched against the previous one register per
+// chip select sequences kept below as reference. Both have to leave the CSR
+// model in the same state and submit the same ops. Repeated calls show the
+// writes dropped by the CSR shadow in fpga.c.
+//
+#include "bench.h"
+
+#define OP_LOG_SIZE 16
+
+typedef struct {
+    fpga_op_t ops[OP_LOG_SIZE];
+    int count;
+} op_log_t;
+
+static void legacy_init(void) {
+    fpga_write_reg8(CSR_CFG_V_FP, config.tcon_vfp);
+    fpga_write_reg8(CSR_CFG_V_SYNC, config.tcon_vsync);
+    fpga_write_reg8(CSR_CFG_V_BP, config.tcon_vbp);
+    fpga_write_reg16(CSR_CFG_V_ACT, config.tcon_vact);
+    fpga_write_reg8(CSR_CFG_H_FP, config.tcon_hfp);
+    fpga_write_reg8(CSR_CFG_H_SYNC, config.tcon_hsync);
+    fpga_write_reg8(CSR_CFG_H_BP, config.tcon_hbp);
+    fpga_write_reg16(CSR_CFG_H_ACT, config.tcon_hact);
+    uint32_t frame_bytes = config.tcon_hact * 4 * config.tcon_vact * 2;
+    fpga_write_reg8(CSR_CFG_FBYTES_B0, frame_bytes & 0xff);
+    fpga_write_reg8(CSR_CFG_FBYTES_B1, (frame_bytes >> 8) & 0xff);
+    fpga_write_reg8(CSR_CFG_FBYTES_B2, (frame_bytes >> 16) & 0xff);
+    fpga_write_reg8(CSR_CFG_MINDRV, 2);
+    fpga_write_reg8(CSR_LUT_FRAME, 38);
+    fpga_write_reg16(CSR_OSD_LEFT, 0);
+    fpga_write_reg16(CSR_OSD_RIGHT, 256/4);
+    fpga_write_reg16(CSR_OSD_TOP, 0);
+    fpga_write_reg16(CSR_OSD_BOTTOM, 128);
+    fpga_write_reg8(CSR_OSD_EN, 0);
+    fpga_write_reg8(CSR_CFG_MIRROR, config.mirror);
+    fpga_write_reg8(CSR_ENABLE, 1);
+}
+
+static void legacy_redraw(uint16_t x0, uint16_t y0, uint16_t x1, uint16_t y1) {
+    fpga_write_reg16(CSR_OP_LEFT, x0);
+    fpga_write_reg16(CSR_OP_TOP, y0);
+    fpga_write_reg16(CSR_OP_RIGHT, x1);
+    fpga_write_reg16(CSR_OP_BOTTOM, y1);
+    fpga_write_reg8(CSR_OP_LENGTH, 16);
+    fpga_write_reg8(CSR_OP_CMD, OP_EXT_REDRAW);
+}
+
+static void legacy_setmode(uint16_t x0, uint16_t y0, uint16_t x1, uint16_t y1,
+        update_mode_t mode) {
+    fpga_write_reg16(CSR_OP_LEFT, x0);
+    fpga_write_reg16(CSR_OP_TOP, y0);
+    fpga_write_reg16(CSR_OP_RIGHT, x1);
+    fpga_write_reg16(CSR_OP_BOTTOM, y1);
+    fpga_write_reg8(CSR_OP_LENGTH, 16);
+    fpga_write_reg8(CSR_OP_PARAM, (uint8_t)mode);
+    fpga_write_reg8(CSR_OP_CMD, OP_EXT_SETMODE);
+}
+
+static void legacy_load_waveform(uint8_t *waveform, uint8_t frames) {
+    fpga_write_reg8(CSR_LUT_FRAME, 0);
+    fpga_write_reg16(CSR_LUT_ADDR, 0);
+    fpga_write_bulk(CSR_LUT_WR, waveform, WAVEFORM_SIZE);
+    fpga_write_reg8(CSR_LUT_FRAME, frames);
+}
+
+// Ops are taken out of the queue slot right after they are submitted, so
+// back to back submissions are all recorded
+static void log_op(fpga_model_t *model, op_log_t *log) {
+    if (model->queued_valid && (log->count < OP_LOG_SIZE)) {
+        log->ops[log->count] = model->queued;
+        log->ops[log->count].submit_frame = 0;
+        log->count++;
+    }
+    model->queued_valid = false;
+}
+
+static void run_sequence(fpga_model_t *model, bool legacy, op_log_t *log,
+        uint8_t *waveform) {
+    log->count = 0;
+    if (legacy) {
+        legacy_init();
+        legacy_setmode(0, 0, 400, 1200, UM_FAST_MONO_BAYER);
+        log_op(model, log);
+        legacy_redraw(10, 20, 100, 200);
+        log_op(model, log);
+        // Same area again, then only the bottom edge changing
+        legacy_setmode(10, 20, 100, 200, UM_FAST_GREY);
+        log_op(model, log);
+        legacy_redraw(10, 20, 100, 300);
+        log_op(model, log);
+        legacy_load_waveform(waveform, 38);
+    }
+    else {
+        caster_init();
+        caster_setmode(0, 0, 400, 1200, UM_FAST_MONO_BAYER);
+        log_op(model, log);
+        caster_redraw(10, 20, 100, 200);
+        log_op(model, log);
+        caster_setmode(10, 20, 100, 200, UM_FAST_GREY);
+        log_op(model, log);
+        caster_redraw(10, 20, 100, 300);
+        log_op(model, log);
+        caster_load_waveform(waveform, 38);
+    }
+}
+
+static bool check_equivalence(void) {
+    static fpga_model_t ref, dut;
+    static uint8_t waveform[WAVEFORM_SIZE];
+    op_log_t ref_log, dut_log;
+
+    for (int i = 0; i < WAVEFORM_SIZE; i++)
+        waveform[i] = i * 37;
+    bench_reset_fpga(&ref);
+    run_sequence(&ref, true, &ref_log, waveform);
+    bench_reset_fpga(&dut);
+    run_sequence(&dut, false, &dut_log, waveform);
+
+    bool pass = true;
+    for (int i = 0; i < CSR_STATUS; i++) {
+        if (ref.regs[i] != dut.regs[i]) {
+            printf("  CSR %d: expected %02x, got %02x\n", i, ref.regs[i],
+                    dut.regs[i]);
+            pass = false;
+        }
+    }
+    if (memcmp(ref.lut, dut.lut, WAVEFORM_SIZE) != 0) {
+        printf("  LUT content mismatch\n");
+        pass = false;
+    }
+    if ((ref_log.count != dut_log.count) ||
+            (memcmp(ref_log.ops, dut_log.ops,
+            sizeof(fpga_op_t) * ref_log.count) != 0)) {
+        printf("  Submitted ops mismatch\n");
+        pass = false;
+    }
+    return pass;
+}
+
+typedef struct {
+    const char *name;
+    void (*legacy)(void);
+    void (*batched)(void);
+    bool cold;              // Always runs right after an FPGA reset
+} csr_case_t;
+
+static void legacy_setmode_case(void) {
+    legacy_setmode(0, 0, 400, 1200, UM_FAST_MONO_BAYER);
+}
+
+static void batched_setmode_case(void) {
+    caster_setmode(0, 0, 400, 1200, UM_FAST_MONO_BAYER);
+}
+
+static void legacy_redraw_case(void) {
+    legacy_redraw(10, 20, 100, 200);
+}
+
+static void batched_redraw_case(void) {
+    caster_redraw(10, 20, 100, 200);
+}
+
+// Cursor moving along a text line, only the horizontal edges change
+static uint32_t typing_pos;
+
+static void legacy_typing_case(void) {
+    uint16_t x = 24 * (typing_pos++ % 64);
+    legacy_redraw(x, 400, x + 24, 440);
+}
+
+static void batched_typing_case(void) {
+    uint16_t x = 24 * (typing_pos++ % 64);
+    caster_redraw(x, 400, x + 24, 440);
+}
+
+static const csr_case_t cases[] = {
+    {"caster_init", legacy_init, caster_init, true},
+    {"caster_setmode", legacy_setmode_case, batched_setmode_case, false},
+    {"caster_redraw", legacy_redraw_case, batched_redraw_case, false},
+    {"caster_redraw, typing", legacy_typing_case, batched_typing_case, false},
+};
+
+int bench_csr(int argc, char **argv) {
+    static fpga_model_t model;
+    uint32_t iterations = 1000;
+    if (argc > 1)
+        iterations = atoi(argv[1]);
+    if (iterations == 0)
+        iterations = 1;
+
+    // Timings mean nothing if both don't end up in the same state
+    if (!check_equivalence()) {
+        fprintf(stderr, "Register state: MISMATCH\n");
+        return 1;
+    }
+    printf("Register state: match\n");
+    printf("SPI clock: %u Hz, per call averages over %u calls\n",
+            host_spi_get_freq(FPGA_SPI), iterations);
+
+    for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+        host_spi_stats_t legacy, batched;
+        bench_reset_fpga(&model);
+        typing_pos = 0;
+        for (uint32_t j = 0; j < iterations; j++) {
+            cases[i].legacy();
+            model.queued_valid = false;
+        }
+        host_spi_get_stats(&legacy);
+        bench_reset_fpga(&model);
+        typing_pos = 0;
+        for (uint32_t j = 0; j < iterations; j++) {
+            if (cases[i].cold)
+                fpga_shadow_invalidate();
+            cases[i].batched();
+            model.queued_valid = false;
+        }
+        host_spi_get_stats(&batched);
+        fpga_shadow_stats_t shadow;
+        fpga_shadow_get_stats(&shadow);
+        printf("%s\n", cases[i].name);
+        bench_print_spi("per register", &legacy, iterations);
+        bench_print_spi("batched", &batched, iterations);
+        printf("  %-24s %7.1f hit %7.1f miss %7.1f fill\n", "shadow",
+                (double)shadow.hits / iterations,
+                (double)shadow.misses / iterations,
+                (double)shadow.fills / iterations);
+        printf("  %-24s %7.2fx\n", "speedup",
+                (double)legacy.modeled_ns / batched.modeled_ns);
+    }
+    return 0;
+}
@@ -0,0 +1,290 @@
+//
+// Glider firmware benchmarks
+// Copyright 2025 Wenting Zhang
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+// pal_i2c.c against the register model of the I2C peripheral in
+// ../fw_host/host_i2c.c, at the 100kHz the board runs. Compares the polled
+// LL path every transfer used to take with the interrupt driven queues:
+// bus time, wall time, interrupts, task wakeups and CPU time for one power
+// monitor round,
+// and how long an interactive register read waits while the power monitor
+// is polling in the background. The polled rows are slowed down by the
+// granularity of sleep_us() on the host, which the flag loops call between
+// polls. Their CPU figure is the bus time, as the MCU spins through it.
+//
+#include "bench.h"
+
+#define INA_READS       16
+#define LATENCY_READS   40
+
+static host_i2c_regfile_t ina[3];
+static host_i2c_regfile_t adv7611;
+static host_i2c_regfile_t edid;
+static pal_i2c_xfer_t ina_xfers[INA_READS];
+static uint8_t ina_buf[INA_READS][2];
+static volatile bool background_run;
+static volatile bool background_polled;
+static volatile bool background_done;
+
+// Same as I2C1_EV_IRQHandler and I2C1_ER_IRQHandler in stm32h7xx_it.c
+static void i2c1_ev_irq(void) {
+    pal_i2c_ev_isr(&pi2c1);
+}
+
+static void i2c1_er_irq(void) {
+    pal_i2c_er_isr(&pi2c1);
+}
+
+void bench_i2c_setup(void) {
+    pal_i2c_init();
+    host_i2c_set_irq(I2C1, i2c1_ev_irq, i2c1_er_irq);
+    LL_I2C_Enable(I2C1);
+}
+
+// pal_i2c_read_payload() as it was before the transfer queues, polling
+// every flag through the LL functions
+static int polled_read(uint8_t addr, uint8_t reg, uint8_t *buf, size_t len) {
+    int result = -1;
+    pal_i2c_ll_lock(&pi2c1);
+    if (!pal_i2c_ll_start(&pi2c1, REQ_WRITE, addr << 1, 1))
+        goto stop;
+    if (!pal_i2c_ll_send(&pi2c1, reg))
+        goto stop;
+    if (!pal_i2c_ll_start(&pi2c1, REQ_RESTART_READ, addr << 1, len))
+        goto stop;
+    for (size_t i = 0; i < len; i++) {
+        if (!pal_i2c_ll_recv(&pi2c1, &buf[i]))
+            goto stop;
+    }
+    result = 0;
+stop:
+    pal_i2c_ll_stop(&pi2c1);
+    pal_i2c_ll_unlock(&pi2c1);
+    return result;
+}
+
+static void setup_ina_xfers(void) {
+    for (int i = 0; i < INA_READS; i++) {
+        ina_xfers[i].addr = INA3221_0_I2C_ADDR + (i / 6);
+        ina_xfers[i].flags = PAL_I2C_XFER_REG;
+        ina_xfers[i].reg = 1 + (i % 6);
+        ina_xfers[i].rx = ina_buf[i];
+        ina_xfers[i].rx_len = 2;
+    }
+}
+
+static bool check_ina(void) {
+    for (int i = 0; i < INA_READS; i++) {
+        host_i2c_regfile_t *rf = &ina[i / 6];
+        uint8_t reg = 1 + (i % 6);
+        if ((ina_buf[i][0] != rf->regs[reg * 2]) ||
+                (ina_buf[i][1] != rf->regs[reg * 2 + 1]))
+            return false;
+    }
+    return true;
+}
+
+typedef enum {
+    ROUND_POLLED,
+    ROUND_SINGLE,
+    ROUND_BATCH
+} round_mode_t;
+
+static int power_round(round_mode_t mode) {
+    int result = 0;
+    memset(ina_buf, 0, sizeof(ina_buf));
+    switch (mode) {
+    case ROUND_POLLED:
+        for (int i = 0; i < INA_READS; i++)
+            result |= polled_read(ina_xfers[i].addr, ina_xfers[i].reg,
+                    ina_buf[i], 2);
+        break;
+    case ROUND_SINGLE:
+        for (int i = 0; i < INA_READS; i++)
+            result |= pal_i2c_read_payload(&pi2c1, ina_xfers[i].addr,
+                    &ina_xfers[i].reg, 1, ina_buf[i], 2);
+        break;
+    case ROUND_BATCH:
+        result = pal_i2c_transfer(&pi2c1, ina_xfers, INA_READS,
+                PAL_I2C_PRIO_LOW);
+        break;
+    }
+    return result;
+}
+
+static void bench_round(const char *name, round_mode_t mode, int rounds) {
+    host_i2c_stats_t stats;
+    pal_i2c_stats_t before, after;
+    host_i2c_reset_stats(I2C1);
+    pal_i2c_get_stats(&pi2c1, &before);
+    uint64_t start = host_time_us();
+    int result = 0;
+    for (int i = 0; i < rounds; i++)
+        result |= power_round(mode);
+    double wall = (host_time_us() - start) / 1000.0 / rounds;
+    host_i2c_get_stats(I2C1, &stats);
+    pal_i2c_get_stats(&pi2c1, &after);
+    double bus = stats.bus_ns / 1000000.0 / rounds;
+    double wakeups = (double)(after.wakeups - before.wakeups) / rounds;
+    // The polled path spins for the whole transfer, the interrupt driven
+    // one costs the CPU its interrupts and waking the task for every call
+    double cpu = (mode == ROUND_POLLED) ? bus * 1000.0 :
+            ((double)stats.irqs / rounds * HOST_I2C_IRQ_NS +
+            wakeups * HOST_TASK_WAKE_NS) / 1000.0;
+    printf("  %-22s %7.2f ms %7.2f ms %6.1f %7.1f %8.1f us  %s\n", name, wall,
+            bus, (double)stats.irqs / rounds, wakeups, cpu,
+            ((result == 0) && check_ina()) ? "ok" : "MISMATCH");
+}
+
+static portTASK_FUNCTION(background, pvParameters) {
+    while (background_run) {
+        power_round(background_polled ? ROUND_POLLED : ROUND_BATCH);
+        vTaskDelay(1);
+    }
+    background_done = true;
+    vTaskDelete(NULL);
+}
+
+static void start_background(bool polled) {
+    background_polled = polled;
+    background_run = true;
+    background_done = false;
+    xTaskCreate(background, "power", 512, NULL, 2, NULL);
+    // Let it get onto the bus
+    vTaskDelay(pdMS_TO_TICKS(5));
+}
+
+static void stop_background(void) {
+    background_run = false;
+    while (!background_done)
+        vTaskDelay(1);
+}
+
+typedef enum {
+    READ_POLLED,
+    READ_HIGH,
+    READ_LOW
+} read_mode_t;
+
+static void bench_latency(const char *name, read_mode_t mode) {
+    uint64_t total = 0;
+    uint64_t worst = 0;
+    int failed = 0;
+    for (int i = 0; i < LATENCY_READS; i++) {
+        uint8_t reg = (uint8_t)rand();
+        uint8_t val = 0;
+        int result;
+        // Spread the reads over the background round
+        host_sleep_us(rand() % 3000);
+        uint64_t start = host_time_us();
+        if (mode == READ_POLLED) {
+            result = polled_read(ADV7611_I2C_ADDR, reg, &val, 1);
+        }
+        else {
+            pal_i2c_xfer_t xfer = {
+                .addr = ADV7611_I2C_ADDR,
+                .flags = PAL_I2C_XFER_REG,
+                .reg = reg,
+                .rx = &val,
+                .rx_len = 1
+            };
+            result = pal_i2c_transfer(&pi2c1, &xfer, 1,
+                    (mode == READ_HIGH) ? PAL_I2C_PRIO_HIGH : PAL_I2C_PRIO_LOW);
+        }
+        uint64_t latency = host_time_us() - start;
+        if ((result != 0) || (val != adv7611.regs[reg]))
+            failed++;
+        total += latency;
+        if (latency > worst)
+            worst = latency;
+    }
+    printf("  %-34s %7.2f ms avg %7.2f ms max  %s\n", name,
+            total / 1000.0 / LATENCY_READS, worst / 1000.0,
+            failed ? "MISMATCH" : "ok");
+}
+
+static void bench_edid(void) {
+    uint8_t buf[256];
+    for (int i = 0; i < 256; i++)
+        buf[i] = (uint8_t)(i * 7 + 3);
+    host_i2c_stats_t stats;
+    pal_i2c_stats_t before, after;
+    host_i2c_reset_stats(I2C1);
+    pal_i2c_get_stats(&pi2c1, &before);
+    uint64_t start = host_time_us();
+    int result = pal_i2c_write_longreg(&pi2c1, EDID_I2C_ADDR, 0, buf, 256);
+    double wall = (host_time_us() - start) / 1000.0;
+    host_i2c_get_stats(I2C1, &stats);
+    pal_i2c_get_stats(&pi2c1, &after);
+    uint32_t wakeups = after.wakeups - before.wakeups;
+    bool match = (result == 0) && (memcmp(edid.regs, buf, 256) == 0);
+    printf("  %-22s %7.2f ms %7.2f ms %6u %7u %8.1f us  %s\n",
+            "EDID, 257 byte write", wall, stats.bus_ns / 1000000.0,
+            stats.irqs, wakeups, ((double)stats.irqs * HOST_I2C_IRQ_NS +
+            wakeups * HOST_TASK_WAKE_NS) / 1000.0,
+            match ? "ok" : "MISMATCH");
+}
+
+int bench_i2c(int argc, char **argv) {
+    int rounds = (argc > 1) ? atoi(argv[1]) : 10;
+    if (rounds < 1)
+        rounds = 1;
+
+    bench_i2c_setup();
+    for (int i = 0; i < 3; i++) {
+        host_i2c_attach_regfile(I2C1, INA3221_0_I2C_ADDR + i, &ina[i], 2);
+        for (int j = 0; j < (int)sizeof(ina[i].regs); j++)
+            ina[i].regs[j] = (uint8_t)(i * 31 + j * 13);
+    }
+    host_i2c_attach_regfile(I2C1, ADV7611_I2C_ADDR, &adv7611, 1);
+    for (int j = 0; j < 256; j++)
+        adv7611.regs[j] = (uint8_t)(j ^ 0x5a);
+    host_i2c_attach_regfile(I2C1, EDID_I2C_ADDR, &edid, 1);
+    setup_ina_xfers();
+    srand(1);
+
+    printf("Power monitor round, %d INA3221 reads at %d kHz, %d rounds\n",
+            INA_READS, HOST_I2C_DEFAULT_HZ / 1000, rounds);
+    printf("  %-22s %10s %10s %6s %7s %11s\n", "", "wall", "bus", "IRQs",
+            "wakeups", "CPU");
+    bench_round("polled LL", ROUND_POLLED, rounds);
+    bench_round("interrupt, one by one", ROUND_SINGLE, rounds);
+    bench_round("interrupt, batch", ROUND_BATCH, rounds);
+    bench_edid();
+
+    printf("ADV7611 register read latency, %d reads\n", LATENCY_READS);
+    bench_latency("idle bus", READ_HIGH);
+    start_background(true);
+    bench_latency("polled, polled monitor running", READ_POLLED);
+    stop_background();
+    start_background(false);
+    bench_latency("same queue as the batch", READ_LOW);
+    bench_latency("high priority queue", READ_HIGH);
+    stop_background();
+
+    pal_i2c_stats_t stats;
+    pal_i2c_get_stats(&pi2c1, &stats);
+    printf("pal_i2c: %u transfers, %u failed, %u timeouts, %u bytes, "
+            "%u IRQs, %u wakeups, max %u queued\n", stats.xfers, stats.failed,
+            stats.timeouts, stats.bytes, stats.irqs, stats.wakeups,
+            stats.max_queued);
+    return 0;
+}
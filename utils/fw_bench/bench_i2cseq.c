@@ -0,0 +1,166 @@
+//
+// Glider firmware benchmarks
+// Copyright 2025 Wenting Zhang
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+// Video bridge bring-up over I2C: adv7611_init() with its writes compiled
+// by i2c_seq.c, against the same register writes sent the way the driver
+// used to, one transaction per register. Both end with the same register
+// contents in the device models.
+//
+#include "bench.h"
+
+#define MAX_WRITES      512
+
+typedef struct {
+    uint8_t addr;
+    uint8_t regs[256];
+    uint8_t ptr;
+    bool have_ptr;
+} bridge_dev_t;
+
+typedef struct {
+    uint8_t addr;
+    uint8_t reg;
+    uint8_t val;
+} bridge_write_t;
+
+static const uint8_t adv7611_maps[] = {
+    ADV7611_I2C_ADDR, CEC_I2C_ADDR, INFOFRAME_I2C_ADDR, DPLL_I2C_ADDR,
+    KSV_I2C_ADDR, EDID_I2C_ADDR, HDMI_I2C_ADDR, CP_I2C_ADDR
+};
+
+#define DEV_COUNT       (sizeof(adv7611_maps))
+
+static bridge_dev_t devs[DEV_COUNT];
+static uint8_t compiled_regs[DEV_COUNT][256];
+static bridge_write_t writes[MAX_WRITES];
+static int write_count;
+static bool recording;
+
+static bool dev_start(void *ctx, bool read) {
+    bridge_dev_t *dev = ctx;
+    if (!read)
+        dev->have_ptr = false;
+    return true;
+}
+
+static bool dev_write(void *ctx, uint8_t val) {
+    bridge_dev_t *dev = ctx;
+    if (!dev->have_ptr) {
+        dev->ptr = val;
+        dev->have_ptr = true;
+        return true;
+    }
+    if (recording && (write_count < MAX_WRITES)) {
+        writes[write_count].addr = dev->addr;
+        writes[write_count].reg = dev->ptr;
+        writes[write_count].val = val;
+        write_count++;
+    }
+    dev->regs[dev->ptr++] = val;
+    return true;
+}
+
+static uint8_t dev_read(void *ctx) {
+    bridge_dev_t *dev = ctx;
+    return dev->regs[dev->ptr++];
+}
+
+static void reset_devs(void) {
+    for (size_t i = 0; i < DEV_COUNT; i++) {
+        devs[i].addr = adv7611_maps[i];
+        memset(devs[i].regs, 0, sizeof(devs[i].regs));
+        host_i2c_dev_t dev = {
+            .ctx = &devs[i],
+            .start = dev_start,
+            .write = dev_write,
+            .read = dev_read
+        };
+        host_i2c_attach(I2C1, devs[i].addr, &dev);
+    }
+}
+
+typedef struct {
+    host_i2c_stats_t stats;
+    double wall_ms;
+} bridge_run_t;
+
+static void run_begin(void) {
+    host_i2c_reset_stats(I2C1);
+}
+
+static void run_end(bridge_run_t *run, uint64_t start) {
+    run->wall_ms = (host_time_us() - start) / 1000.0;
+    host_i2c_get_stats(I2C1, &run->stats);
+}
+
+static void print_run(const char *name, const bridge_run_t *run) {
+    printf("  %-28s %5u %9.2f ms %9.2f ms\n", name, run->stats.starts,
+            run->stats.bus_ns / 1000000.0, run->wall_ms);
+}
+
+// The ADV7611 writes as adv7611_send_init_seq() and adv7611_load_edid()
+// used to send them
+static void adv7611_per_register(void) {
+    for (int i = 0; i < write_count; i++) {
+        uint8_t buf[2] = {writes[i].reg, writes[i].val};
+        pal_i2c_write_payload(&pi2c1, writes[i].addr, buf, 2);
+    }
+}
+
+int bench_i2cseq(int argc, char **argv) {
+    bridge_run_t adv_compiled, adv_single;
+    uint64_t start;
+
+    bench_i2c_setup();
+    edid_init();
+    reset_devs();
+
+    // Compiled sequences, recording what reaches the devices
+    recording = true;
+    run_begin();
+    start = host_time_us();
+    adv7611_init();
+    run_end(&adv_compiled, start);
+    recording = false;
+    for (size_t i = 0; i < DEV_COUNT; i++)
+        memcpy(compiled_regs[i], devs[i].regs, 256);
+
+    reset_devs();
+    run_begin();
+    start = host_time_us();
+    adv7611_per_register();
+    run_end(&adv_single, start);
+
+    bool match = true;
+    for (size_t i = 0; i < DEV_COUNT; i++) {
+        if (memcmp(compiled_regs[i], devs[i].regs, 256) != 0)
+            match = false;
+    }
+
+    printf("ADV7611 init, %d register writes at %d kHz\n", write_count,
+            HOST_I2C_DEFAULT_HZ / 1000);
+    printf("  %-28s %5s %12s %12s\n", "", "xfers", "bus", "wall");
+    print_run("ADV7611, one per register", &adv_single);
+    print_run("ADV7611, compiled", &adv_compiled);
+    printf("  Register contents %s\n", match ? "match" : "MISMATCH");
+    return match ? 0 : 1;
+}
@@ -0,0 +1,146 @@
+//
+// Glider firmware benchmarks
+// Copyright 2025 Wenting Zhang
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+// Bursts of region ops against the CSR model running in real time, once
+// written straight to the FPGA as before, once through the caster command
+// queue task. The model drops ops submitted while its queue slot is taken,
+// same as the gateware.
+//
+#include "bench.h"
+
+#define RECT_W  64
+#define RECT_H  64
+
+static fpga_model_t model;
+
+static void setup(uint32_t frame_us) {
+    bench_reset_fpga(&model);
+    caster_init();
+    // Scale the EPDC clock so a frame takes frame_us
+    model.clk_hz = (uint64_t)fpga_model_h_total(&model) *
+            fpga_model_v_total(&model) * 1000000ull / frame_us;
+    fpga_model_set_realtime(&model, true);
+}
+
+static void op_rect(uint32_t i, uint16_t *x0, uint16_t *y0) {
+    // Walk across the screen like a line of typed characters
+    *x0 = (i * RECT_W / 4) % (config.tcon_hact - RECT_W / 4);
+    *y0 = (i / 32) * RECT_H % (config.tcon_vact - RECT_H);
+}
+
+static uint64_t wait_idle(void) {
+    uint64_t start = host_time_us();
+    while (fpga_write_reg8(CSR_STATUS, 0x00) &
+            ((1 << STATUS_OP_BUSY) | (1 << STATUS_OP_QUEUE)))
+        host_sleep_us(200);
+    return host_time_us() - start;
+}
+
+static int cmp_u64(const void *a, const void *b) {
+    uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+    return (x > y) - (x < y);
+}
+
+int bench_queue(int argc, char **argv) {
+    uint32_t ops = 32;
+    uint32_t frame_us = 2000;
+    if (argc > 1)
+        ops = atoi(argv[1]);
+    if (argc > 2)
+        frame_us = atoi(argv[2]);
+    if ((ops == 0) || (frame_us == 0)) {
+        fprintf(stderr, "Usage: queue [ops] [frame_us]\n");
+        return 1;
+    }
+    uint32_t op_frames = 16; // get_update_frames()
+    // The FPGA starts the queued op in the frame the active one retires
+    double ideal_ms = ((double)ops * op_frames + 1) * frame_us / 1000.0;
+    printf("%u ops back to back, %u us frames, %u frames per op\n", ops,
+            frame_us, op_frames);
+
+    // Fire and forget, as caster_redraw used to be called
+    setup(frame_us);
+    uint64_t start = host_time_us();
+    for (uint32_t i = 0; i < ops; i++) {
+        uint16_t x0, y0;
+        op_rect(i, &x0, &y0);
+        caster_redraw(x0, y0, x0 + RECT_W / 4, y0 + RECT_H);
+    }
+    wait_idle();
+    double direct_ms = (host_time_us() - start) / 1000.0;
+    printf("direct\n");
+    printf("  submitted %u, dropped %u, completed %u, %.1f ms\n",
+            model.stats.ops_submitted, model.stats.ops_dropped,
+            model.stats.ops_completed, direct_ms);
+    bool pass = true;
+
+    // Through the command queue
+    setup(frame_us);
+    caster_queue_init();
+    // The burst is adjacent rects, measure the queue alone without merging
+    caster_queue_set_coalesce(false);
+    xTaskCreate(caster_task, "CasterTask", 0, NULL, 0, NULL);
+    start = host_time_us();
+    for (uint32_t i = 0; i < ops; i++) {
+        uint16_t x0, y0;
+        op_rect(i, &x0, &y0);
+        caster_queue_redraw(x0, y0, x0 + RECT_W / 4, y0 + RECT_H,
+                portMAX_DELAY);
+    }
+    uint64_t submit_us = host_time_us() - start;
+    caster_queue_stats_t stats;
+    do {
+        host_sleep_us(500);
+        caster_queue_get_stats(&stats);
+    } while (stats.completed + stats.timeout < ops);
+    double queued_ms = (host_time_us() - start) / 1000.0;
+    printf("queued\n");
+    printf("  submitted %u, dropped %u, completed %u, %.1f ms "
+            "(ideal %.1f ms, +%.1f%%)\n",
+            model.stats.ops_submitted, model.stats.ops_dropped,
+            stats.completed, queued_ms, ideal_ms,
+            (queued_ms / ideal_ms - 1.0) * 100.0);
+    printf("  submitter blocked %.1f ms, max queue depth %u / %u\n",
+            submit_us / 1000.0, stats.max_depth, CASTER_QUEUE_LENGTH);
+    if ((model.stats.ops_dropped != 0) || (stats.completed != ops))
+        pass = false;
+
+    // Completion latency of single ops, submitter waits for each
+    uint32_t samples = (ops < 16) ? ops : 16;
+    uint64_t *lat = malloc(samples * sizeof(uint64_t));
+    for (uint32_t i = 0; i < samples; i++) {
+        caster_op_t op = {.cmd = OP_EXT_REDRAW};
+        op_rect(i, &op.x0, &op.y0);
+        op.x1 = op.x0 + RECT_W / 4;
+        op.y1 = op.y0 + RECT_H;
+        uint64_t t = host_time_us();
+        if (caster_submit_wait(&op, portMAX_DELAY))
+            pass = false;
+        lat[i] = host_time_us() - t;
+    }
+    qsort(lat, samples, sizeof(uint64_t), cmp_u64);
+    printf("  completion latency p50 %.2f ms, p99 %.2f ms (op %.2f ms)\n",
+            lat[samples / 2] / 1000.0, lat[(samples * 99) / 100] / 1000.0,
+            op_frames * frame_us / 1000.0);
+    free(lat);
+    return pass ? 0 : 1;
+}
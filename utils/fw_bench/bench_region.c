@@ -0,0 +1,219 @@
+//
+// Glider firmware benchmarks
+// Copyright 2025 Wenting Zhang
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+// Window level update modes: a terminal and a video player side by side,
+// with the terminal dragged around, raised over the video and the video
+// switching modes. The ops from region_ops() are applied to a per pixel
+// mode map and checked against the region table after every change. The
+// reference reprograms the whole screen bottom to top on every change, which
+// is what a single full screen mode needs.
+//
+#include "bench.h"
+
+#define SCREEN_W        1600
+#define SCREEN_H        1200
+
+enum {
+    WIN_TERMINAL,
+    WIN_VIDEO,
+    WIN_DIALOG
+};
+
+typedef struct {
+    uint32_t changes;
+    uint32_t ops;
+    uint64_t pixels;
+    uint32_t repaints;
+    uint64_t time_ns;
+} trace_result_t;
+
+static uint8_t mode_map[SCREEN_W * SCREEN_H];
+static region_table_t current;
+static trace_result_t diff_result;
+static trace_result_t full_result;
+static bool pass;
+
+static void fill(const caster_op_t *op) {
+    for (int y = op->y0; y < op->y1; y++)
+        memset(&mode_map[y * SCREEN_W + op->x0], op->param, op->x1 - op->x0);
+}
+
+static bool check_map(const region_table_t *t) {
+    for (int y = 0; y < SCREEN_H; y++) {
+        for (int x = 0; x < SCREEN_W; x++) {
+            if (mode_map[y * SCREEN_W + x] != region_mode_at(t, x, y)) {
+                printf("  Mode mismatch at %d, %d\n", x, y);
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+static void count_full(const region_table_t *t) {
+    full_result.changes++;
+    full_result.ops += 1 + t->count;
+    full_result.pixels += SCREEN_W * SCREEN_H;
+    for (int i = 0; i < t->count; i++) {
+        const region_t *r = &t->regions[i];
+        full_result.pixels += (uint64_t)(r->x1 - r->x0) * (r->y1 - r->y0);
+    }
+}
+
+// Area is what region.c passes, the bounding box of where the region was
+// and where it is now
+static void change(const region_table_t *next, const region_t *a,
+        const region_t *b) {
+    static caster_op_t ops[REGION_MAX_OPS];
+    caster_op_t area = {.cmd = OP_EXT_SETMODE,
+            .x0 = (a->x0 < b->x0) ? a->x0 : b->x0,
+            .y0 = (a->y0 < b->y0) ? a->y0 : b->y0,
+            .x1 = (a->x1 > b->x1) ? a->x1 : b->x1,
+            .y1 = (a->y1 > b->y1) ? a->y1 : b->y1};
+    bool repaint;
+    uint64_t start = host_time_us();
+    int count = region_ops(&current, next, &area, ops, &repaint);
+    diff_result.time_ns += (host_time_us() - start) * 1000;
+    diff_result.changes++;
+    if (repaint)
+        diff_result.repaints++;
+    for (int i = 0; i < count; i++) {
+        diff_result.ops++;
+        diff_result.pixels += (uint64_t)(ops[i].x1 - ops[i].x0) *
+                (ops[i].y1 - ops[i].y0);
+        fill(&ops[i]);
+    }
+    count_full(next);
+    current = *next;
+    if (pass && !check_map(&current))
+        pass = false;
+}
+
+static int find(region_table_t *t, uint8_t id) {
+    for (int i = 0; i < t->count; i++) {
+        if (t->regions[i].id == id)
+            return i;
+    }
+    return -1;
+}
+
+static void set_region(uint8_t id, int x0, int y0, int x1, int y1,
+        update_mode_t mode) {
+    region_table_t next = current;
+    region_t r = {.id = id, .mode = mode, .x0 = x0, .y0 = y0, .x1 = x1,
+            .y1 = y1};
+    int pos = find(&next, id);
+    region_t old = r;
+    if (pos >= 0) {
+        old = next.regions[pos];
+        next.regions[pos] = r;
+    }
+    else
+        next.regions[next.count++] = r;
+    change(&next, &old, &r);
+}
+
+static void raise_region(uint8_t id) {
+    region_table_t next = current;
+    int pos = find(&next, id);
+    region_t r = next.regions[pos];
+    memmove(&next.regions[pos], &next.regions[pos + 1],
+            sizeof(region_t) * (next.count - pos - 1));
+    next.regions[next.count - 1] = r;
+    change(&next, &r, &r);
+}
+
+static void remove_region(uint8_t id) {
+    region_table_t next = current;
+    int pos = find(&next, id);
+    region_t r = next.regions[pos];
+    next.count--;
+    memmove(&next.regions[pos], &next.regions[pos + 1],
+            sizeof(region_t) * (next.count - pos));
+    change(&next, &r, &r);
+}
+
+static void print_result(const char *name, const trace_result_t *r) {
+    printf("  %-16s %7.1f ops %10.0f pixels", name,
+            (double)r->ops / r->changes, (double)r->pixels / r->changes);
+    if (r == &diff_result)
+        printf(" %6.1f us %u repaints", (double)r->time_ns / r->changes / 1000.0,
+                r->repaints);
+    printf("\n");
+}
+
+static void run_trace(const char *name, void (*trace)(void)) {
+    memset(&diff_result, 0, sizeof(diff_result));
+    memset(&full_result, 0, sizeof(full_result));
+    trace();
+    printf("%s, %u changes, per change:\n", name, diff_result.changes);
+    print_result("full screen", &full_result);
+    print_result("region ops", &diff_result);
+}
+
+static void trace_drag(void) {
+    // Terminal dragged diagonally over the video
+    for (int i = 0; i < 64; i++)
+        set_region(WIN_TERMINAL, 100 + i * 8, 100 + i * 4, 800 + i * 8,
+                700 + i * 4, UM_FAST_GREY);
+}
+
+static void trace_drag_clear(void) {
+    // Same, left of the video
+    for (int i = 0; i < 64; i++)
+        set_region(WIN_TERMINAL, 20 + i, 100 + i * 4, 620 + i, 700 + i * 4,
+                UM_FAST_GREY);
+}
+
+static void trace_modes(void) {
+    // Video paused and resumed, a dialog popping up and going away
+    for (int i = 0; i < 16; i++) {
+        set_region(WIN_VIDEO, 700, 300, 1500, 900,
+                (i & 1) ? UM_AUTO_LUT_NO_DITHER : UM_FAST_MONO_BLUE_NOISE);
+        set_region(WIN_DIALOG, 600, 500, 1000, 700, UM_FAST_MONO_NO_DITHER);
+        remove_region(WIN_DIALOG);
+    }
+}
+
+static void trace_focus(void) {
+    // Focus going back and forth between the overlapping windows
+    for (int i = 0; i < 16; i++)
+        raise_region((i & 1) ? WIN_TERMINAL : WIN_VIDEO);
+}
+
+int bench_region(int argc, char **argv) {
+    pass = true;
+    memset(&current, 0, sizeof(current));
+    current.background = UM_FAST_MONO_BAYER;
+    memset(mode_map, UM_FAST_MONO_BAYER, sizeof(mode_map));
+    set_region(WIN_TERMINAL, 100, 100, 800, 700, UM_FAST_GREY);
+    set_region(WIN_VIDEO, 700, 300, 1500, 900, UM_FAST_MONO_BLUE_NOISE);
+
+    printf("%d x %d, background mode %d\n", SCREEN_W, SCREEN_H,
+            UM_FAST_MONO_BAYER);
+    run_trace("drag", trace_drag);
+    run_trace("modes", trace_modes);
+    run_trace("focus", trace_focus);
+    run_trace("drag clear", trace_drag_clear);
+    printf("Mode map: %s\n", pass ? "match" : "MISMATCH");
+    return pass ? 0 : 1;
+}
@@ -0,0 +1,119 @@
+//
+// Glider firmware benchmarks
+// Copyright 2025 Wenting Zhang
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+// File upload time over the HID reports (USBCMD_RECV) against the vendor
+// bulk interface (USBCMD_RECV_BULK). The data is written to the host SPIFFS
+// image for real, the flash time of every write comes from its modelled
+// cost, the USB side is modelled from the link rates below.
+//
+#include "bench.h"
+#include "host_spiffs.h"
+
+#define HID_INTERVAL_NS     (2000000ull)    // bInterval 2 at full speed
+#define HID_PAYLOAD         (63)
+#define HID_BLK_SIZE        (64*1024 - 64)  // Flush threshold in usbapp.c
+#define BULK_BPS            (1000000ull)    // Full speed bulk, typical host
+
+static uint64_t flash_write(spiffs_file f, uint8_t *buf, uint32_t len) {
+    host_flash_stats_t before, after;
+    host_flash_get_stats(&before);
+    SPIFFS_write(&spiffs_fs, f, buf, len);
+    host_flash_get_stats(&after);
+    return after.modeled_ns - before.modeled_ns;
+}
+
+static spiffs_file open_target(void) {
+    // Every run starts from an erased flash, so none of them pays for the
+    // garbage collection of the previous one
+    host_spiffs_format();
+    return SPIFFS_open(&spiffs_fs, "upload.bin",
+            SPIFFS_O_CREAT | SPIFFS_O_TRUNC | SPIFFS_O_WRONLY, 0);
+}
+
+// The USB task writes to the flash from within the report callback, no
+// report is taken in the meantime
+static uint64_t upload_hid(uint8_t *data, uint32_t size) {
+    spiffs_file f = open_target();
+    uint64_t t = 0;
+    uint32_t pending = 0;
+    for (uint32_t pos = 0; pos < size; pos += HID_PAYLOAD) {
+        uint32_t len = MIN((uint32_t)HID_PAYLOAD, size - pos);
+        t += HID_INTERVAL_NS;
+        pending += len;
+        if ((pending >= HID_BLK_SIZE) || (pos + len == size)) {
+            t += flash_write(f, data + pos + len - pending, pending);
+            pending = 0;
+        }
+    }
+    SPIFFS_close(&spiffs_fs, f);
+    return t;
+}
+
+// USB fills one buffer while the writer task flushes the others. With a
+// single buffer, reception stops until the flash write is done.
+static uint64_t upload_bulk(uint8_t *data, uint32_t size, int nbufs) {
+    spiffs_file f = open_target();
+    uint64_t usb_done = 0;      // When the last block finished arriving
+    uint64_t flash_done = 0;    // When the writer becomes idle
+    uint64_t buf_free[2] = {0, 0};
+    int buf = 0;
+    for (uint32_t pos = 0; pos < size; pos += USBBULK_BLK_SIZE) {
+        uint32_t len = MIN((uint32_t)USBBULK_BLK_SIZE, size - pos);
+        uint64_t start = MAX(usb_done, buf_free[buf]);
+        usb_done = start + (uint64_t)len * 1000000000ull / BULK_BPS;
+        flash_done = MAX(flash_done, usb_done) + flash_write(f, data + pos, len);
+        buf_free[buf] = flash_done;
+        buf = (buf + 1) % nbufs;
+    }
+    SPIFFS_close(&spiffs_fs, f);
+    return flash_done;
+}
+
+static void print_result(const char *name, uint32_t size, uint64_t ns) {
+    printf("  %-22s %8.2f s %8.1f KB/s\n", name, ns / 1e9,
+            size / 1000.0 / (ns / 1e9));
+}
+
+int bench_upload(int argc, char **argv) {
+    uint32_t size = 1024 * 1024;
+    if (argc > 1)
+        size = atoi(argv[1]);
+    if (size == 0) {
+        fprintf(stderr, "Usage: upload [bytes]\n");
+        return 1;
+    }
+    uint8_t *data = malloc(size);
+    uint32_t seed = 1;
+    for (uint32_t i = 0; i < size; i++) {
+        seed = seed * 1103515245 + 12345;
+        data[i] = seed >> 16;
+    }
+    spiffs_init();
+
+    printf("%u byte upload, %u KB bulk buffers, bulk link %llu KB/s\n", size,
+            USBBULK_BLK_SIZE / 1024, BULK_BPS / 1000);
+    print_result("HID reports", size, upload_hid(data, size));
+    print_result("bulk, single buffer", size, upload_bulk(data, size, 1));
+    print_result("bulk, double buffer", size, upload_bulk(data, size, 2));
+    free(data);
+    return 0;
+}
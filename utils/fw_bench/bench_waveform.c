@@ -0,0 +1,150 @@
+//
+// Glider firmware benchmarks
+// Copyright 2025 Wenting Zhang
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+// Cost of following the panel temperature with a waveform set: flash read
+// and SPI upload time of one LUT swap, then the number of swaps and flash
+// reads over a day like temperature trace with sensor noise, with and
+// without the hysteresis. The set is synthetic, with the temperature ranges
+// commonly found in WBF files.
+//
+#include <math.h>
+#include "bench.h"
+#include "host_spiffs.h"
+
+#define TRACE_HOURS         (24)
+#define TRACE_PERIOD_S      (10)
+#define TRACE_NOISE         (1.0)   // Sensor noise, +/- degC
+
+static const int8_t ranges[] = {
+    0, 3, 6, 9, 12, 15, 18, 21, 24, 27, 30, 33, 38, 43, 50
+};
+
+#define RANGES  ((int)sizeof(ranges) - 1)
+
+static void write_set(void) {
+    size_t size = sizeof(waveform_set_header_t) +
+            RANGES * sizeof(waveform_set_entry_t) + RANGES * WAVEFORM_SIZE;
+    uint8_t *buf = calloc(size, 1);
+    waveform_set_header_t *hdr = (waveform_set_header_t *)buf;
+    hdr->magic = WAVEFORM_SET_MAGIC;
+    hdr->temps = RANGES;
+    hdr->luts = RANGES;
+    strcpy(hdr->name, "GC16");
+    waveform_set_entry_t *entries = (waveform_set_entry_t *)(hdr + 1);
+    uint8_t *luts = (uint8_t *)(entries + RANGES);
+    uint32_t seed = 1;
+    for (int i = 0; i < RANGES; i++) {
+        entries[i].temp_min = ranges[i];
+        entries[i].temp_max = ranges[i + 1];
+        // Colder panels need longer waveforms
+        entries[i].frames = WAVEFORM_MAX_FRAMES - i * 2;
+        entries[i].lut = i;
+        for (int j = 0; j < entries[i].frames * WAVEFORM_FRAME_SIZE; j++) {
+            seed = seed * 1103515245 + 12345;
+            luts[i * WAVEFORM_SIZE + j] = seed >> 16;
+        }
+    }
+    host_spiffs_format();
+    host_spiffs_write_file(WAVEFORM_FILE, buf, size);
+    free(buf);
+}
+
+// Flash and SPI time of one swap
+static void measure_swap(fpga_model_t *model, int entry, const char *name) {
+    host_flash_stats_t f0, f1;
+    host_spi_stats_t spi;
+    host_flash_get_stats(&f0);
+    const uint8_t *lut = waveform_get_lut(entry);
+    host_flash_get_stats(&f1);
+    bench_reset_fpga(model);
+    caster_load_waveform((uint8_t *)lut, waveform_get_entry(entry)->frames);
+    host_spi_get_stats(&spi);
+    bench_print_spi(name, &spi, 1);
+    printf("  %-24s %8.2f us flash, %.2f frames at %d Hz in total\n", "",
+            (f1.modeled_ns - f0.modeled_ns) / 1000.0,
+            (f1.modeled_ns - f0.modeled_ns + spi.modeled_ns) / 1e9 *
+            FRAME_RATE_HZ, FRAME_RATE_HZ);
+}
+
+static double trace_temp(int sample, uint32_t *seed) {
+    double hours = (double)sample * TRACE_PERIOD_S / 3600.0;
+    // Cool night, warm afternoon
+    double t = 21.0 - 6.0 * cos((hours - 3.0) / 24.0 * 2.0 * M_PI);
+    *seed = *seed * 1103515245 + 12345;
+    return t + ((int)((*seed >> 16) % 2001) - 1000) / 1000.0 * TRACE_NOISE;
+}
+
+static void run_trace(fpga_model_t *model, bool hysteresis) {
+    // Every run starts with a cold cache
+    waveform_init(WAVEFORM_FILE);
+    bench_reset_fpga(model);
+    host_flash_reset_stats();
+    uint32_t seed = 1;
+    int samples = TRACE_HOURS * 3600 / TRACE_PERIOD_S;
+    int loaded = -1;
+    for (int i = 0; i < samples; i++) {
+        int temp = lround(trace_temp(i, &seed));
+        // Without the current range, the lookup has no hysteresis
+        waveform_set_current(hysteresis ? loaded : -1);
+        int entry = waveform_select(temp);
+        if (entry != loaded) {
+            const uint8_t *lut = waveform_get_lut(entry);
+            caster_load_waveform((uint8_t *)lut,
+                    waveform_get_entry(entry)->frames);
+            waveform_add_upload(0, false);
+            loaded = entry;
+        }
+    }
+    waveform_stats_t stats;
+    host_spi_stats_t spi;
+    host_flash_stats_t flash;
+    waveform_get_stats(&stats);
+    host_spi_get_stats(&spi);
+    host_flash_get_stats(&flash);
+    printf("  %-18s %6u %6u %10.2f %10.2f\n",
+            hysteresis ? "hysteresis" : "no hysteresis", stats.swaps,
+            stats.cache_misses, flash.modeled_ns / 1e6, spi.modeled_ns / 1e6);
+}
+
+int bench_waveform(int argc, char **argv) {
+    fpga_model_t model;
+    spiffs_init();
+    write_set();
+    if (waveform_init(WAVEFORM_FILE) != 0) {
+        fprintf(stderr, "Failed to load the waveform set\n");
+        return 1;
+    }
+
+    printf("%d temperature ranges, %d LUT cache slots, %d degC hysteresis\n",
+            RANGES, WAVEFORM_CACHE_SLOTS, WAVEFORM_HYSTERESIS);
+    printf("One swap:\n");
+    measure_swap(&model, 0, "not cached");
+    measure_swap(&model, 0, "cached");
+
+    printf("%d hour trace, a sample every %d s, +/-%.1f degC noise:\n",
+            TRACE_HOURS, TRACE_PERIOD_S, TRACE_NOISE);
+    printf("  %-18s %6s %6s %10s %10s\n", "", "swaps", "reads", "flash ms",
+            "SPI ms");
+    run_trace(&model, false);
+    run_trace(&model, true);
+    return 0;
+}
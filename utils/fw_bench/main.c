@@ -0,0 +1,79 @@
+//
+// Glider firmware benchmarks
+// Copyright 2025 Wenting Zhang
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+// Benchmarks for the firmware code running on the host port. Each
+// subcommand drives unmodified firmware sources against the models in
+// ../fw_host and reports the modelled MCU side cost.
+//
+#include "bench.h"
+
+static const bench_t benches[] = {
+    {"csr", "Batched vs per register CSR writes in caster.c", bench_csr},
+    {"queue", "Region op bursts with and without the command queue", bench_queue},
+    {"coalesce", "Typing and scrolling traces with damage coalescing", bench_coalesce},
+    {"upload", "File upload time over HID reports and vendor bulk", bench_upload},
+    {"bitstream", "FPGA bitstream load time, raw and compressed", bench_bitstream},
+    {"boot", "Boot sequence with the dependency scheduler", bench_boot},
+    {"i2c", "Polled vs interrupt driven I2C, power monitor and latency", bench_i2c},
+    {"i2cseq", "ADV7611 and PTN3460 init with merged register writes", bench_i2cseq},
+    {"region", "Window level update modes against full screen setmode", bench_region},
+    {"waveform", "LUT swaps following the temperature, cache and hysteresis", bench_waveform},
+};
+
+#define BENCH_COUNT (sizeof(benches) / sizeof(benches[0]))
+
+void bench_reset_fpga(fpga_model_t *model) {
+    fpga_model_init(model, config.pclk_hz / 4);
+    fpga_shadow_invalidate();
+    fpga_shadow_reset_stats();
+    host_spi_reset_stats();
+}
+
+void bench_print_spi(const char *name, const host_spi_stats_t *stats,
+        uint32_t calls) {
+    printf("  %-24s %7.1f CS %7.1f HAL %7.1f bytes %8.2f us\n", name,
+            (double)stats->cs_cycles / calls,
+            (double)stats->hal_calls / calls,
+            (double)stats->bytes / calls,
+            (double)stats->modeled_ns / calls / 1000.0);
+}
+
+static void print_usage(const char *name) {
+    fprintf(stderr, "Usage: %s <benchmark> [options]\n", name);
+    for (size_t i = 0; i < BENCH_COUNT; i++)
+        fprintf(stderr, "  %-10s %s\n", benches[i].name, benches[i].help);
+}
+
+int main(int argc, char *argv[]) {
+    if (argc < 2) {
+        print_usage(argv[0]);
+        return 1;
+    }
+    host_init();
+    config_init();
+    for (size_t i = 0; i < BENCH_COUNT; i++) {
+        if (strcmp(argv[1], benches[i].name) == 0)
+            return benches[i].run(argc - 1, argv + 1);
+    }
+    print_usage(argv[0]);
+    return 1;
+}
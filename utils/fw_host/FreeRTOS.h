@@ -0,0 +1,79 @@
+//
+// Glider firmware host port
+// Copyright 2025 Wenting Zhang
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+// Minimal FreeRTOS API on top of pthreads, so firmware modules under fw/User
+// can be compiled and exercised on a Linux host. Only the subset used by the
+// firmware is provided. Priorities are accepted but ignored, one tick is 1ms
+// of wall clock time, same as configTICK_RATE_HZ in Core/Inc/FreeRTOSConfig.h.
+//
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+
+#define configTICK_RATE_HZ          (1000)
+#define configMINIMAL_STACK_SIZE    (128)
+#define configMAX_PRIORITIES        (7)
+#define configTOTAL_HEAP_SIZE       (480 * 1024)
+
+typedef long BaseType_t;
+typedef unsigned long UBaseType_t;
+typedef uint32_t TickType_t;
+typedef uint32_t StackType_t;
+
+#define pdFALSE                     ((BaseType_t)0)
+#define pdTRUE                      ((BaseType_t)1)
+#define pdPASS                      (pdTRUE)
+#define pdFAIL                      (pdFALSE)
+#define errQUEUE_EMPTY              ((BaseType_t)0)
+#define errQUEUE_FULL               ((BaseType_t)0)
+
+#define portMAX_DELAY               ((TickType_t)0xffffffffUL)
+#define portTICK_PERIOD_MS          ((TickType_t)1000 / configTICK_RATE_HZ)
+#define pdMS_TO_TICKS(x)            ((TickType_t)(((TickType_t)(x) * \
+                                        (TickType_t)configTICK_RATE_HZ) / \
+                                        (TickType_t)1000U))
+#define pdTICKS_TO_MS(x)            ((TickType_t)(x) * 1000U / configTICK_RATE_HZ)
+
+#define portTASK_FUNCTION_PROTO(f, p)   void f(void *p)
+#define portTASK_FUNCTION(f, p)         void f(void *p)
+#define portYIELD_FROM_ISR(x)           ((void)(x))
+#define portEND_SWITCHING_ISR(x)        ((void)(x))
+
+#define tskIDLE_PRIORITY            ((UBaseType_t)0)
+
+#define taskENTER_CRITICAL()        host_critical_enter()
+#define taskEXIT_CRITICAL()         host_critical_exit()
+#define taskENTER_CRITICAL_FROM_ISR()   (host_critical_enter(), 0)
+#define taskEXIT_CRITICAL_FROM_ISR(x)   ((void)(x), host_critical_exit())
+
+#define configASSERT(x)             do { if (!(x)) host_assert_failed(__FILE__, __LINE__); } while (0)
+
+void *pvPortMalloc(size_t size);
+void vPortFree(void *ptr);
+size_t xPortGetFreeHeapSize(void);
+size_t xPortGetMinimumEverFreeHeapSize(void);
+
+void host_critical_enter(void);
+void host_critical_exit(void);
+void host_assert_failed(const char *file, int line);
@@ -0,0 +1,229 @@
+//
+// Glider firmware host port
+// Copyright 2025 Wenting Zhang
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#include "platform.h"
+#include "board.h"
+#include "host_hal.h"
+#include "fpga_model.h"
+
+static void op_engine_frame(fpga_model_t *model) {
+    // Retire the active op once it has been held for OP_LENGTH frames
+    if (model->active_valid) {
+        model->active_frames++;
+        if (model->active_frames >= model->active.length) {
+            model->active_valid = false;
+            model->stats.ops_completed++;
+        }
+    }
+    if (!model->active_valid && model->queued_valid) {
+        model->active = model->queued;
+        model->active.start_frame = model->frame;
+        model->active_valid = true;
+        model->queued_valid = false;
+        model->active_frames = 0;
+        if (model->op_start_cb)
+            model->op_start_cb(model->cb_ctx, model, &model->active);
+    }
+    if (model->frame_cb)
+        model->frame_cb(model->cb_ctx, model);
+    model->frame++;
+}
+
+static void realtime_sync(fpga_model_t *model) {
+    if (!model->realtime || !model->regs[CSR_ENABLE])
+        return;
+    uint64_t frame_ns = fpga_model_frame_ns(model);
+    uint64_t target = model->realtime_base_frame +
+            (host_time_us() - model->realtime_base_us) * 1000 / frame_ns;
+    while (model->frame < target)
+        op_engine_frame(model);
+}
+
+static void submit_op(fpga_model_t *model) {
+    model->stats.ops_submitted++;
+    if (model->queued_valid) {
+        model->stats.ops_dropped++;
+        return;
+    }
+    fpga_op_t *op = &model->queued;
+    op->cmd = model->regs[CSR_OP_CMD];
+    op->param = model->regs[CSR_OP_PARAM];
+    op->length = model->regs[CSR_OP_LENGTH];
+    op->left = fpga_model_reg16(model, CSR_OP_LEFT);
+    op->right = fpga_model_reg16(model, CSR_OP_RIGHT);
+    op->top = fpga_model_reg16(model, CSR_OP_TOP);
+    op->bottom = fpga_model_reg16(model, CSR_OP_BOTTOM);
+    op->submit_frame = model->frame;
+    model->queued_valid = true;
+}
+
+static uint8_t reg_read(fpga_model_t *model, uint8_t addr) {
+    if (addr == CSR_STATUS) {
+        model->stats.status_reads++;
+        return fpga_model_status(model);
+    }
+    else if (addr == CSR_ID0) {
+        return FPGA_MODEL_ID0;
+    }
+    return model->regs[addr];
+}
+
+static void reg_write(fpga_model_t *model, uint8_t addr, uint8_t val) {
+    if (addr >= CSR_STATUS)
+        return; // Read only
+    model->stats.csr_writes++;
+    switch (addr) {
+    case CSR_LUT_WR:
+        model->lut[model->lut_addr % WAVEFORM_SIZE] = val;
+        model->lut_addr++;
+        model->stats.lut_bytes++;
+        return;
+    case CSR_OSD_WR:
+        model->osd[model->osd_addr % sizeof(model->osd)] = val;
+        model->osd_addr++;
+        model->stats.osd_bytes++;
+        return;
+    default:
+        break;
+    }
+    model->regs[addr] = val;
+    if (addr == CSR_LUT_ADDR_LO) {
+        model->lut_addr = fpga_model_reg16(model, CSR_LUT_ADDR);
+    }
+    else if (addr == CSR_OSD_ADDR_LO) {
+        model->osd_addr = fpga_model_reg16(model, CSR_OSD_ADDR);
+    }
+    else if (addr == CSR_OP_CMD) {
+        submit_op(model);
+    }
+    else if ((addr == CSR_ENABLE) && model->realtime) {
+        model->realtime_base_us = host_time_us();
+        model->realtime_base_frame = model->frame;
+    }
+}
+
+static void spi_select(void *ctx, bool selected) {
+    fpga_model_t *model = ctx;
+    pthread_mutex_lock(&model->lock);
+    model->selected = selected;
+    model->have_addr = false;
+    pthread_mutex_unlock(&model->lock);
+}
+
+static void spi_xfer(void *ctx, const uint8_t *tx, uint8_t *rx, size_t len) {
+    fpga_model_t *model = ctx;
+    pthread_mutex_lock(&model->lock);
+    realtime_sync(model);
+    for (size_t i = 0; i < len; i++) {
+        uint8_t out = 0x00;
+        if (!model->have_addr) {
+            model->addr = tx[i];
+            model->have_addr = true;
+        }
+        else {
+            out = reg_read(model, model->addr);
+            reg_write(model, model->addr, tx[i]);
+            if ((model->addr != CSR_LUT_WR) && (model->addr != CSR_OSD_WR))
+                model->addr++;
+        }
+        if (rx)
+            rx[i] = out;
+    }
+    pthread_mutex_unlock(&model->lock);
+}
+
+void fpga_model_init(fpga_model_t *model, uint32_t clk_hz) {
+    memset(model, 0, sizeof(fpga_model_t));
+    pthread_mutex_init(&model->lock, NULL);
+    model->clk_hz = clk_hz;
+    host_spi_dev_t dev = {
+        .ctx = model,
+        .select = spi_select,
+        .xfer = spi_xfer
+    };
+    host_spi_attach(FPGA_SPI, FPGA_CS, &dev);
+    // Configuration done, as seen by fpga_wait_done()
+    host_gpio_set_input(FPGA_DONE, true);
+}
+
+void fpga_model_set_realtime(fpga_model_t *model, bool realtime) {
+    pthread_mutex_lock(&model->lock);
+    model->realtime = realtime;
+    model->realtime_base_us = host_time_us();
+    model->realtime_base_frame = model->frame;
+    pthread_mutex_unlock(&model->lock);
+}
+
+void fpga_model_set_callbacks(fpga_model_t *model, void *ctx,
+        fpga_op_cb_t op_start_cb, fpga_frame_cb_t frame_cb) {
+    model->cb_ctx = ctx;
+    model->op_start_cb = op_start_cb;
+    model->frame_cb = frame_cb;
+}
+
+void fpga_model_step(fpga_model_t *model, uint32_t frames) {
+    pthread_mutex_lock(&model->lock);
+    while (frames--)
+        op_engine_frame(model);
+    pthread_mutex_unlock(&model->lock);
+}
+
+uint16_t fpga_model_reg16(fpga_model_t *model, uint8_t addr) {
+    return ((uint16_t)model->regs[addr] << 8) | model->regs[addr + 1];
+}
+
+uint32_t fpga_model_h_total(fpga_model_t *model) {
+    return model->regs[CSR_CFG_H_FP] + model->regs[CSR_CFG_H_SYNC] +
+            model->regs[CSR_CFG_H_BP] + fpga_model_reg16(model, CSR_CFG_H_ACT);
+}
+
+uint32_t fpga_model_v_total(fpga_model_t *model) {
+    return model->regs[CSR_CFG_V_FP] + model->regs[CSR_CFG_V_SYNC] +
+            model->regs[CSR_CFG_V_BP] + fpga_model_reg16(model, CSR_CFG_V_ACT);
+}
+
+uint32_t fpga_model_h_active(fpga_model_t *model) {
+    return fpga_model_reg16(model, CSR_CFG_H_ACT) * 4;
+}
+
+uint32_t fpga_model_v_active(fpga_model_t *model) {
+    return fpga_model_reg16(model, CSR_CFG_V_ACT);
+}
+
+uint64_t fpga_model_frame_ns(fpga_model_t *model) {
+    uint64_t clocks = (uint64_t)fpga_model_h_total(model) *
+            fpga_model_v_total(model);
+    if ((clocks == 0) || (model->clk_hz == 0))
+        return 16666667; // Not configured yet, assume 60Hz
+    return clocks * 1000000000ull / model->clk_hz;
+}
+
+uint8_t fpga_model_status(fpga_model_t *model) {
+    uint8_t status = 0;
+    if (model->regs[CSR_ENABLE] & (1 << CTRL_ENABLE))
+        status |= 1 << STATUS_SYS_READY;
+    if (model->active_valid)
+        status |= 1 << STATUS_OP_BUSY;
+    if (model->queued_valid)
+        status |= 1 << STATUS_OP_QUEUE;
+    return status;
+}
@@ -0,0 +1,119 @@
+//
+// Glider firmware host port
+// Copyright 2025 Wenting Zhang
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+// Model of the Caster CSR block as seen over SPI from the MCU.
+//
+// Every chip select starts with an address byte, the following data bytes go
+// to consecutive addresses (auto increment), except for the LUT_WR and OSD_WR
+// data ports which stay on the same address and advance the LUT/OSD pointer
+// instead. While a data byte is clocked in, the current value of the
+// addressed register is clocked out, which is how CSR_STATUS and CSR_ID0 are
+// read. Writing CSR_OP_CMD submits the op latched in the OP_* registers.
+//
+// The op engine has one active slot and one queue slot: an op starts at the
+// next frame boundary and stays active for OP_LENGTH frames. STATUS_OP_BUSY
+// reflects the active slot and STATUS_OP_QUEUE the queue slot. An op
+// submitted while the queue slot is occupied is dropped, same as the
+// gateware.
+//
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <pthread.h>
+#include "caster.h"
+
+#define FPGA_MODEL_ID0      (0x35)
+
+typedef struct {
+    uint8_t cmd;
+    uint8_t param;
+    uint8_t length;
+    uint16_t left;
+    uint16_t right;
+    uint16_t top;
+    uint16_t bottom;
+    uint64_t submit_frame;
+    uint64_t start_frame;
+} fpga_op_t;
+
+typedef struct {
+    uint32_t csr_writes;
+    uint32_t ops_submitted;
+    uint32_t ops_dropped;
+    uint32_t ops_completed;
+    uint32_t lut_bytes;
+    uint32_t osd_bytes;
+    uint32_t status_reads;
+} fpga_model_stats_t;
+
+typedef struct fpga_model fpga_model_t;
+
+typedef void (*fpga_op_cb_t)(void *ctx, fpga_model_t *model,
+        const fpga_op_t *op);
+typedef void (*fpga_frame_cb_t)(void *ctx, fpga_model_t *model);
+
+struct fpga_model {
+    uint8_t regs[256];
+    uint8_t lut[WAVEFORM_SIZE];
+    uint8_t osd[4096];
+    uint16_t lut_addr;
+    uint16_t osd_addr;
+    // SPI frontend
+    bool selected;
+    bool have_addr;
+    uint8_t addr;
+    // Op engine
+    fpga_op_t active;
+    fpga_op_t queued;
+    bool active_valid;
+    bool queued_valid;
+    uint32_t active_frames;
+    uint64_t frame;
+    // Timing
+    uint32_t clk_hz;        // EPDC clock, 4 pixels per clock
+    bool realtime;          // Frames advance with wall clock time
+    uint64_t realtime_base_us;
+    uint64_t realtime_base_frame;
+    // Hooks for the pixel pipeline model
+    void *cb_ctx;
+    fpga_op_cb_t op_start_cb;
+    fpga_frame_cb_t frame_cb;
+    fpga_model_stats_t stats;
+    pthread_mutex_t lock;
+};
+
+// Create the model and attach it to FPGA_SPI / FPGA_CS
+void fpga_model_init(fpga_model_t *model, uint32_t clk_hz);
+void fpga_model_set_realtime(fpga_model_t *model, bool realtime);
+void fpga_model_set_callbacks(fpga_model_t *model, void *ctx,
+        fpga_op_cb_t op_start_cb, fpga_frame_cb_t frame_cb);
+// Advance by a number of frames, only for non-realtime mode
+void fpga_model_step(fpga_model_t *model, uint32_t frames);
+// Frame timing derived from the TCON CSRs
+uint32_t fpga_model_h_total(fpga_model_t *model);
+uint32_t fpga_model_v_total(fpga_model_t *model);
+uint32_t fpga_model_h_active(fpga_model_t *model); // In pixels
+uint32_t fpga_model_v_active(fpga_model_t *model);
+uint64_t fpga_model_frame_ns(fpga_model_t *model);
+uint8_t fpga_model_status(fpga_model_t *model);
+uint16_t fpga_model_reg16(fpga_model_t *model, uint8_t addr);
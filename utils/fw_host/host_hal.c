@@ -0,0 +1,305 @@
+//
+// Glider firmware host port
+// Copyright 2025 Wenting Zhang
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+// HAL stand-in and the board.c functions for the host build.
+//
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include <stdbool.h>
+#include <time.h>
+#include "stm32h7xx_hal.h"
+#include "FreeRTOS.h"
+#include "task.h"
+#include "host_hal.h"
+
+#define MAX_SPI_DEVS    4
+
+typedef struct {
+    SPI_HandleTypeDef *spi;
+    GPIO_TypeDef *cs_port;
+    uint16_t cs_pin;
+    host_spi_dev_t dev;
+    bool selected;
+} spi_slot_t;
+
+GPIO_TypeDef host_gpio[5];
+
+SPI_HandleTypeDef hspi2;
+ADC_HandleTypeDef hadc1;
+DAC_HandleTypeDef hdac1;
+QSPI_HandleTypeDef hqspi;
+TIM_HandleTypeDef htim1;
+
+static spi_slot_t spi_slots[MAX_SPI_DEVS];
+static int spi_slot_count;
+static host_spi_stats_t spi_stats;
+static struct timespec start_time;
+static volatile bool tx_complete = false;
+
+void host_init(void) {
+    clock_gettime(CLOCK_MONOTONIC, &start_time);
+    memset(host_gpio, 0, sizeof(host_gpio));
+    host_spi_reset_stats();
+}
+
+uint64_t host_time_us(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)(now.tv_sec - start_time.tv_sec) * 1000000ull +
+            (now.tv_nsec - start_time.tv_nsec) / 1000;
+}
+
+void host_sleep_us(uint64_t us) {
+    struct timespec ts = {
+        .tv_sec = us / 1000000,
+        .tv_nsec = (us % 1000000) * 1000
+    };
+    while (nanosleep(&ts, &ts) != 0);
+}
+
+// GPIO
+void HAL_GPIO_WritePin(GPIO_TypeDef *port, uint16_t pin, GPIO_PinState state) {
+    if (state)
+        port->odr |= pin;
+    else
+        port->odr &= ~pin;
+    for (int i = 0; i < spi_slot_count; i++) {
+        spi_slot_t *slot = &spi_slots[i];
+        if ((slot->cs_port != port) || (slot->cs_pin != pin))
+            continue;
+        bool selected = (state == GPIO_PIN_RESET);
+        if (selected == slot->selected)
+            continue;
+        slot->selected = selected;
+        if (!selected) {
+            spi_stats.cs_cycles++;
+            spi_stats.modeled_ns += HOST_SPI_CS_NS;
+        }
+        if (slot->dev.select)
+            slot->dev.select(slot->dev.ctx, selected);
+    }
+}
+
+GPIO_PinState HAL_GPIO_ReadPin(GPIO_TypeDef *port, uint16_t pin) {
+    return (port->idr & pin) ? GPIO_PIN_SET : GPIO_PIN_RESET;
+}
+
+void host_gpio_set_input(GPIO_TypeDef *port, uint16_t pin, bool level) {
+    if (level)
+        port->idr |= pin;
+    else
+        port->idr &= ~pin;
+}
+
+// SPI
+void host_spi_attach(SPI_HandleTypeDef *spi, GPIO_TypeDef *cs_port,
+        uint16_t cs_pin, const host_spi_dev_t *dev) {
+    spi_slot_t *slot = NULL;
+    // Attaching to the same CS again replaces the previous device
+    for (int i = 0; i < spi_slot_count; i++) {
+        if ((spi_slots[i].cs_port == cs_port) && (spi_slots[i].cs_pin == cs_pin))
+            slot = &spi_slots[i];
+    }
+    if (!slot) {
+        if (spi_slot_count == MAX_SPI_DEVS) {
+            fprintf(stderr, "Too many SPI devices\n");
+            abort();
+        }
+        slot = &spi_slots[spi_slot_count++];
+    }
+    slot->spi = spi;
+    slot->cs_port = cs_port;
+    slot->cs_pin = cs_pin;
+    slot->dev = *dev;
+    slot->selected = false;
+    // CS idles high
+    cs_port->odr |= cs_pin;
+}
+
+uint32_t host_spi_get_freq(SPI_HandleTypeDef *spi) {
+    uint32_t div = 2u << (spi->Init.BaudRatePrescaler >> 28);
+    return HOST_SPI_KERNEL_CLK_HZ / div;
+}
+
+void host_spi_get_stats(host_spi_stats_t *stats) {
+    *stats = spi_stats;
+}
+
+void host_spi_reset_stats(void) {
+    memset(&spi_stats, 0, sizeof(spi_stats));
+}
+
+static void spi_transfer(SPI_HandleTypeDef *spi, const uint8_t *tx,
+        uint8_t *rx, uint16_t size, bool dma) {
+    spi_stats.hal_calls++;
+    if (dma)
+        spi_stats.dma_calls++;
+    spi_stats.bytes += size;
+    spi_stats.modeled_ns += dma ? HOST_SPI_DMA_CALL_NS : HOST_SPI_HAL_CALL_NS;
+    spi_stats.modeled_ns += (uint64_t)size * 8 * 1000000000ull /
+            host_spi_get_freq(spi);
+    for (int i = 0; i < spi_slot_count; i++) {
+        spi_slot_t *slot = &spi_slots[i];
+        if ((slot->spi == spi) && slot->selected && slot->dev.xfer) {
+            slot->dev.xfer(slot->dev.ctx, tx, rx, size);
+            return;
+        }
+    }
+    // Nobody is listening, the bus floats high
+    if (rx)
+        memset(rx, 0xff, size);
+}
+
+HAL_StatusTypeDef HAL_SPI_Init(SPI_HandleTypeDef *hspi) {
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_SPI_DeInit(SPI_HandleTypeDef *hspi) {
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_SPI_Transmit(SPI_HandleTypeDef *hspi, uint8_t *data,
+        uint16_t size, uint32_t timeout) {
+    spi_transfer(hspi, data, NULL, size, false);
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_SPI_Transmit_DMA(SPI_HandleTypeDef *hspi, uint8_t *data,
+        uint16_t size) {
+    // The transfer completes immediately, completion is still signalled
+    // through the callback so spi_wait_dma_complete() behaves the same
+    spi_transfer(hspi, data, NULL, size, true);
+    HAL_SPI_TxCpltCallback(hspi);
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_SPI_TransmitReceive(SPI_HandleTypeDef *hspi,
+        uint8_t *txdata, uint8_t *rxdata, uint16_t size, uint32_t timeout) {
+    spi_transfer(hspi, txdata, rxdata, size, false);
+    return HAL_OK;
+}
+
+// Peripherals without a model
+HAL_StatusTypeDef HAL_DAC_Start(DAC_HandleTypeDef *hdac, uint32_t channel) {
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_DAC_Stop(DAC_HandleTypeDef *hdac, uint32_t channel) {
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_DAC_SetValue(DAC_HandleTypeDef *hdac, uint32_t channel,
+        uint32_t alignment, uint32_t data) {
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_TIM_PWM_Start(TIM_HandleTypeDef *htim, uint32_t channel) {
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_TIM_PWM_Stop(TIM_HandleTypeDef *htim, uint32_t channel) {
+    return HAL_OK;
+}
+
+uint32_t HAL_GetTick(void) {
+    return (uint32_t)(host_time_us() / 1000);
+}
+
+uint32_t HAL_GetUIDw0(void) {
+    return 0x47444c52; // "GDLR"
+}
+
+void NVIC_SystemReset(void) {
+    fprintf(stderr, "NVIC_SystemReset called, exiting\n");
+    exit(2);
+}
+
+// board.c
+void HAL_SPI_TxCpltCallback(SPI_HandleTypeDef *hspi) {
+    tx_complete = true;
+}
+
+void spi_wait_dma_complete(SPI_HandleTypeDef *spi) {
+    while (!tx_complete);
+    tx_complete = false;
+}
+
+size_t board_usb_get_serial(uint16_t desc_str1[], size_t max_chars) {
+    const char *serial = "HOST0001";
+    size_t len = strlen(serial);
+    if (len > max_chars)
+        len = max_chars;
+    for (size_t i = 0; i < len; i++)
+        desc_str1[i] = serial[i];
+    return len;
+}
+
+void board_switch_spi_freq(SPI_HandleTypeDef *spi, uint32_t target) {
+    // Same thresholds as board.c
+    if (target >= 24000000)
+        spi->Init.BaudRatePrescaler = SPI_BAUDRATEPRESCALER_2;
+    else if (target > 12000000)
+        spi->Init.BaudRatePrescaler = SPI_BAUDRATEPRESCALER_4;
+    else if (target > 6000000)
+        spi->Init.BaudRatePrescaler = SPI_BAUDRATEPRESCALER_8;
+    else if (target > 3000000)
+        spi->Init.BaudRatePrescaler = SPI_BAUDRATEPRESCALER_16;
+    else if (target > 1500000)
+        spi->Init.BaudRatePrescaler = SPI_BAUDRATEPRESCALER_32;
+    else if (target > 750000)
+        spi->Init.BaudRatePrescaler = SPI_BAUDRATEPRESCALER_64;
+    else if (target > 375000)
+        spi->Init.BaudRatePrescaler = SPI_BAUDRATEPRESCALER_128;
+    else
+        spi->Init.BaudRatePrescaler = SPI_BAUDRATEPRESCALER_256;
+}
+
+void board_late_init(void) {
+}
+
+void sleep_us(uint32_t us) {
+    host_sleep_us(us);
+}
+
+// syslog.c, log lines go straight to stderr. Weak so tools that want the
+// shell syslog command can link the real one.
+__attribute__((weak)) void syslog_init(void) {
+}
+
+__attribute__((weak)) void syslog_print(char *msg) {
+    fprintf(stderr, "[%8.3f] %s\n", host_time_us() / 1000000.0, msg);
+}
+
+__attribute__((weak)) void syslog_printf(char *fmt, ...) {
+    char buf[128];
+    va_list args;
+    va_start(args, fmt);
+    vsnprintf(buf, sizeof(buf), fmt, args);
+    va_end(args);
+    // Firmware messages are inconsistent about trailing newlines
+    size_t len = strlen(buf);
+    while (len && (buf[len - 1] == '\n'))
+        buf[--len] = '\0';
+    syslog_print(buf);
+}
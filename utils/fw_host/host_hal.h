@@ -0,0 +1,123 @@
+//
+// Glider firmware host port
+// Copyright 2025 Wenting Zhang
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+// Host side hooks into the HAL stand-in. Not visible to firmware code.
+//
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "stm32h7xx_hal.h"
+#include "stm32h7xx_ll_i2c.h"
+
+// SPI device model. select() is called on chip select edges, xfer() for
+// every byte clocked while selected. rx may be NULL for transmit only calls.
+typedef struct {
+    void *ctx;
+    void (*select)(void *ctx, bool selected);
+    void (*xfer)(void *ctx, const uint8_t *tx, uint8_t *rx, size_t len);
+} host_spi_dev_t;
+
+// SPI traffic counters. The modelled time assumes the SPI kernel clock
+// below divided by the configured prescaler, plus a fixed cost for every
+// blocking HAL call and every chip select cycle.
+typedef struct {
+    uint32_t cs_cycles;     // Number of CS assert/deassert pairs
+    uint32_t hal_calls;     // Number of HAL_SPI_* calls
+    uint32_t dma_calls;     // Of which started as DMA
+    uint64_t bytes;         // Bytes clocked
+    uint64_t modeled_ns;    // Estimated time spent on the MCU side
+} host_spi_stats_t;
+
+#define HOST_SPI_KERNEL_CLK_HZ      (48000000)
+#define HOST_SPI_HAL_CALL_NS        (1500)  // Blocking HAL_SPI_Transmit setup
+#define HOST_SPI_DMA_CALL_NS        (800)   // DMA stream setup
+#define HOST_SPI_CS_NS              (200)   // Two GPIO writes plus CS hold
+
+void host_spi_attach(SPI_HandleTypeDef *spi, GPIO_TypeDef *cs_port,
+        uint16_t cs_pin, const host_spi_dev_t *dev);
+uint32_t host_spi_get_freq(SPI_HandleTypeDef *spi);
+void host_spi_get_stats(host_spi_stats_t *stats);
+void host_spi_reset_stats(void);
+
+// I2C device model, attached to a 7 bit address. start() is called for
+// every START or repeated START addressed to the device and returns the
+// address ACK, write() returns the data ACK. read() supplies the next byte
+// of a read. stop() is called when the transfer ends on the bus.
+typedef struct {
+    void *ctx;
+    bool (*start)(void *ctx, bool read);
+    bool (*write)(void *ctx, uint8_t val);
+    uint8_t (*read)(void *ctx);
+    void (*stop)(void *ctx);
+} host_i2c_dev_t;
+
+// Register file device: a pointer byte written first, then auto
+// incremented register access. width is the register size in bytes,
+// 1 for ADV7611 style devices. With width 2 (INA3221) the pointer selects
+// a 16 bit big endian register and doesn't advance.
+typedef struct {
+    uint8_t regs[256 * 2];
+    uint8_t width;
+    uint8_t ptr;
+    uint8_t byte;
+    bool have_ptr;
+    uint32_t writes;
+    uint32_t reads;
+} host_i2c_regfile_t;
+
+// I2C bus counters. Bus time follows the bit clock below, the interrupt
+// count is what an interrupt driven driver costs on the CPU side.
+typedef struct {
+    uint32_t starts;        // START and repeated START conditions
+    uint32_t stops;
+    uint32_t nacks;
+    uint32_t irqs;          // Interrupt handler invocations
+    uint64_t bytes;         // Data bytes, address bytes not included
+    uint64_t bus_ns;        // Time the bus was clocking
+} host_i2c_stats_t;
+
+#define HOST_I2C_DEFAULT_HZ         (100000)
+#define HOST_I2C_IRQ_NS             (600)   // ISR entry, flag dispatch, exit
+// Semaphore given from the ISR, switch to the waiting task and back out of
+// the blocking call, about 1000 cycles at 480MHz
+#define HOST_TASK_WAKE_NS           (2000)
+
+void host_i2c_attach(I2C_TypeDef *i2c, uint8_t addr,
+        const host_i2c_dev_t *dev);
+void host_i2c_attach_regfile(I2C_TypeDef *i2c, uint8_t addr,
+        host_i2c_regfile_t *regfile, uint8_t width);
+void host_i2c_set_irq(I2C_TypeDef *i2c, void (*ev_handler)(void),
+        void (*er_handler)(void));
+void host_i2c_set_freq(I2C_TypeDef *i2c, uint32_t hz);
+void host_i2c_get_stats(I2C_TypeDef *i2c, host_i2c_stats_t *stats);
+void host_i2c_reset_stats(I2C_TypeDef *i2c);
+
+// Drive an input pin, as the outside world would
+void host_gpio_set_input(GPIO_TypeDef *port, uint16_t pin, bool level);
+
+// Time since host_init() in microseconds
+uint64_t host_time_us(void);
+void host_sleep_us(uint64_t us);
+
+// Must be called before any firmware code
+void host_init(void);
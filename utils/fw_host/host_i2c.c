@@ -0,0 +1,516 @@
+//
+// Glider firmware host port
+// Copyright 2025 Wenting Zhang
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+// Register level model of the STM32H7 I2C master, behind the LL stand-in
+// in stm32h7xx_ll_i2c.h. A bus thread clocks the transfer programmed into
+// CR2 at the configured bit rate: 10 bit times for START plus address, 9
+// per data byte, 1 for STOP. It stretches the clock while TXDR is empty or
+// RXDR is still full, the same as the peripheral does. ISR flags follow
+// RM0433, and the registered interrupt handler is called in a critical
+// section whenever an enabled flag is set.
+//
+#include <pthread.h>
+#include <time.h>
+#include "platform.h"
+#include "host_hal.h"
+
+#define MAX_DEVICES         16
+// A late bus thread catches up instead of stretching the bus, up to this
+#define PACE_SLACK_NS       (200000)
+// An interrupt that fires this many times without bus progress is a bug
+#define IRQ_STORM_LIMIT     (10000)
+
+typedef enum {
+    BUS_IDLE,
+    BUS_ADDR,       // START or repeated START requested
+    BUS_TX,
+    BUS_RX,
+    BUS_HOLD,       // SCL held low on TC or TCR
+    BUS_STOP        // STOP requested
+} bus_state_t;
+
+typedef enum {
+    ACT_ADDR,
+    ACT_TX,
+    ACT_RX,
+    ACT_STOP
+} bus_action_t;
+
+typedef struct {
+    uint8_t addr;
+    host_i2c_dev_t dev;
+} attached_dev_t;
+
+struct host_i2c {
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    pthread_t thread;
+    bool running;
+    // Registers
+    uint32_t cr1;
+    uint32_t cr2;
+    uint32_t isr;
+    uint8_t txdr;
+    uint8_t rxdr;
+    bool txdr_full;
+    // Bus state
+    bus_state_t state;
+    bool read;
+    bool stop_pending;
+    uint32_t count;         // Bytes done in the current NBYTES chunk
+    uint8_t shift;          // Byte being shifted out
+    uint32_t generation;    // Bumped on every peripheral reset
+    attached_dev_t *cur;
+    attached_dev_t devices[MAX_DEVICES];
+    int dev_count;
+    uint32_t hz;
+    uint64_t deadline_ns;
+    uint32_t storm;
+    void (*ev_handler)(void);
+    void (*er_handler)(void);
+    host_i2c_stats_t stats;
+};
+
+I2C_TypeDef host_i2c1 = {
+    .lock = PTHREAD_MUTEX_INITIALIZER,
+    .cond = PTHREAD_COND_INITIALIZER,
+    .hz = HOST_I2C_DEFAULT_HZ
+};
+
+static uint64_t mono_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+static uint32_t nbytes(I2C_TypeDef *i2c) {
+    return (i2c->cr2 & I2C_CR2_NBYTES) >> I2C_CR2_NBYTES_Pos;
+}
+
+static void reset_bus(I2C_TypeDef *i2c) {
+    if (i2c->cur && i2c->cur->dev.stop)
+        i2c->cur->dev.stop(i2c->cur->dev.ctx);
+    i2c->cur = NULL;
+    i2c->isr = 0;
+    i2c->cr2 &= ~(I2C_CR2_START | I2C_CR2_STOP);
+    i2c->txdr_full = false;
+    i2c->state = BUS_IDLE;
+    i2c->stop_pending = false;
+    i2c->count = 0;
+    i2c->generation++;
+}
+
+static void end_chunk(I2C_TypeDef *i2c) {
+    if (i2c->cr2 & I2C_CR2_RELOAD) {
+        i2c->isr |= I2C_ISR_TCR;
+        i2c->state = BUS_HOLD;
+    }
+    else if ((i2c->cr2 & I2C_CR2_AUTOEND) || i2c->stop_pending) {
+        i2c->state = BUS_STOP;
+    }
+    else {
+        i2c->isr |= I2C_ISR_TC;
+        i2c->state = BUS_HOLD;
+    }
+}
+
+static void resume_chunk(I2C_TypeDef *i2c) {
+    i2c->isr &= ~I2C_ISR_TCR;
+    i2c->count = 0;
+    if (nbytes(i2c) == 0) {
+        end_chunk(i2c);
+    }
+    else if (i2c->read) {
+        i2c->state = BUS_RX;
+    }
+    else {
+        i2c->state = BUS_TX;
+        if (!i2c->txdr_full)
+            i2c->isr |= I2C_ISR_TXIS;
+    }
+}
+
+static void nack(I2C_TypeDef *i2c) {
+    // Master mode sends STOP on its own after a NACK
+    i2c->isr |= I2C_ISR_NACKF;
+    i2c->isr &= ~I2C_ISR_TXIS;
+    i2c->stats.nacks++;
+    i2c->state = BUS_STOP;
+}
+
+static void cr2_written(I2C_TypeDef *i2c, bool nbytes_written) {
+    if (i2c->cr2 & I2C_CR2_START) {
+        i2c->isr &= ~I2C_ISR_TC;
+        if ((i2c->state == BUS_IDLE) || (i2c->state == BUS_HOLD)) {
+            i2c->isr |= I2C_ISR_BUSY;
+            i2c->state = BUS_ADDR;
+        }
+    }
+    else if (i2c->cr2 & I2C_CR2_STOP) {
+        i2c->isr &= ~I2C_ISR_TC;
+        if (i2c->state == BUS_HOLD)
+            i2c->state = BUS_STOP;
+        else if (i2c->state == BUS_IDLE)
+            i2c->cr2 &= ~I2C_CR2_STOP;
+        else
+            i2c->stop_pending = true;
+    }
+    else if (nbytes_written && (i2c->isr & I2C_ISR_TCR)) {
+        resume_chunk(i2c);
+    }
+}
+
+static attached_dev_t *find_dev(I2C_TypeDef *i2c, uint8_t addr) {
+    for (int i = 0; i < i2c->dev_count; i++) {
+        if (i2c->devices[i].addr == addr)
+            return &i2c->devices[i];
+    }
+    return NULL;
+}
+
+// Decide the next bus action, returns its length in bit times, or 0 when
+// the bus has to wait for the CPU
+static uint32_t bus_begin(I2C_TypeDef *i2c, bus_action_t *action) {
+    if (!(i2c->cr1 & I2C_CR1_PE))
+        return 0;
+    switch (i2c->state) {
+    case BUS_ADDR:
+        *action = ACT_ADDR;
+        return 10;
+    case BUS_TX:
+        if (!i2c->txdr_full)
+            return 0;
+        i2c->shift = i2c->txdr;
+        i2c->txdr_full = false;
+        // TXDR is free again as soon as the byte moves to the shifter
+        if (i2c->count + 1 < nbytes(i2c))
+            i2c->isr |= I2C_ISR_TXIS;
+        *action = ACT_TX;
+        return 9;
+    case BUS_RX:
+        if (i2c->isr & I2C_ISR_RXNE)
+            return 0;
+        *action = ACT_RX;
+        return 9;
+    case BUS_STOP:
+        *action = ACT_STOP;
+        return 1;
+    default:
+        return 0;
+    }
+}
+
+static void bus_end(I2C_TypeDef *i2c, bus_action_t action) {
+    switch (action) {
+    case ACT_ADDR: {
+        i2c->cr2 &= ~I2C_CR2_START;
+        i2c->stats.starts++;
+        i2c->read = !!(i2c->cr2 & I2C_CR2_RD_WRN);
+        attached_dev_t *dev = find_dev(i2c, (i2c->cr2 & I2C_CR2_SADD) >> 1);
+        if (dev)
+            i2c->cur = dev;
+        if (!dev || !dev->dev.start || !dev->dev.start(dev->dev.ctx, i2c->read))
+            nack(i2c);
+        else
+            resume_chunk(i2c);
+        break;
+    }
+    case ACT_TX:
+        i2c->count++;
+        i2c->stats.bytes++;
+        if (!i2c->cur->dev.write ||
+                !i2c->cur->dev.write(i2c->cur->dev.ctx, i2c->shift))
+            nack(i2c);
+        else if (i2c->count >= nbytes(i2c))
+            end_chunk(i2c);
+        break;
+    case ACT_RX:
+        i2c->rxdr = i2c->cur->dev.read ? i2c->cur->dev.read(i2c->cur->dev.ctx)
+                : 0xff;
+        i2c->isr |= I2C_ISR_RXNE;
+        i2c->count++;
+        i2c->stats.bytes++;
+        if (i2c->count >= nbytes(i2c))
+            end_chunk(i2c);
+        break;
+    case ACT_STOP:
+        if (i2c->cur && i2c->cur->dev.stop)
+            i2c->cur->dev.stop(i2c->cur->dev.ctx);
+        i2c->cur = NULL;
+        i2c->isr |= I2C_ISR_STOPF;
+        i2c->isr &= ~(I2C_ISR_BUSY | I2C_ISR_TXIS | I2C_ISR_TC);
+        i2c->cr2 &= ~I2C_CR2_STOP;
+        i2c->stop_pending = false;
+        i2c->state = BUS_IDLE;
+        i2c->stats.stops++;
+        break;
+    }
+}
+
+static uint32_t irq_pending(I2C_TypeDef *i2c) {
+    uint32_t cr1 = i2c->cr1;
+    uint32_t pending = 0;
+    if (!(cr1 & I2C_CR1_PE))
+        return 0;
+    if (cr1 & I2C_CR1_TXIE)
+        pending |= i2c->isr & I2C_ISR_TXIS;
+    if (cr1 & I2C_CR1_RXIE)
+        pending |= i2c->isr & I2C_ISR_RXNE;
+    if (cr1 & I2C_CR1_TCIE)
+        pending |= i2c->isr & (I2C_ISR_TC | I2C_ISR_TCR);
+    if (cr1 & I2C_CR1_STOPIE)
+        pending |= i2c->isr & I2C_ISR_STOPF;
+    if (cr1 & I2C_CR1_NACKIE)
+        pending |= i2c->isr & I2C_ISR_NACKF;
+    if (cr1 & I2C_CR1_ERRIE)
+        pending |= i2c->isr & (I2C_ISR_BERR | I2C_ISR_ARLO | I2C_ISR_OVR);
+    return pending;
+}
+
+static bool call_irq(I2C_TypeDef *i2c) {
+    uint32_t pending = irq_pending(i2c);
+    void (*handler)(void) = (pending & (I2C_ISR_BERR | I2C_ISR_ARLO |
+            I2C_ISR_OVR)) ? i2c->er_handler : i2c->ev_handler;
+    if (!pending || !handler)
+        return false;
+    if (++i2c->storm > IRQ_STORM_LIMIT) {
+        fprintf(stderr, "I2C interrupt storm, ISR 0x%08x\n", i2c->isr);
+        abort();
+    }
+    i2c->stats.irqs++;
+    // Lock order is critical section first, same as a task touching the
+    // peripheral from within taskENTER_CRITICAL()
+    pthread_mutex_unlock(&i2c->lock);
+    host_critical_enter();
+    handler();
+    host_critical_exit();
+    pthread_mutex_lock(&i2c->lock);
+    return true;
+}
+
+static void pace(I2C_TypeDef *i2c, uint32_t bits) {
+    uint64_t ns = (uint64_t)bits * 1000000000ull / i2c->hz;
+    uint64_t now = mono_ns();
+    if (now > i2c->deadline_ns + PACE_SLACK_NS)
+        i2c->deadline_ns = now;
+    i2c->deadline_ns += ns;
+    i2c->stats.bus_ns += ns;
+    struct timespec ts = {
+        .tv_sec = i2c->deadline_ns / 1000000000ull,
+        .tv_nsec = i2c->deadline_ns % 1000000000ull
+    };
+    pthread_mutex_unlock(&i2c->lock);
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) != 0);
+    pthread_mutex_lock(&i2c->lock);
+}
+
+static void *bus_thread(void *arg) {
+    I2C_TypeDef *i2c = arg;
+    pthread_mutex_lock(&i2c->lock);
+    for (;;) {
+        if (call_irq(i2c))
+            continue;
+        bus_action_t action;
+        uint32_t bits = bus_begin(i2c, &action);
+        if (!bits) {
+            pthread_cond_wait(&i2c->cond, &i2c->lock);
+            continue;
+        }
+        uint32_t generation = i2c->generation;
+        pace(i2c, bits);
+        if (generation != i2c->generation)
+            continue; // Peripheral reset mid byte
+        bus_end(i2c, action);
+        i2c->storm = 0;
+    }
+    return NULL;
+}
+
+// Called with the lock held
+static void ensure_running(I2C_TypeDef *i2c) {
+    if (i2c->running)
+        return;
+    i2c->running = true;
+    pthread_create(&i2c->thread, NULL, bus_thread, i2c);
+    pthread_detach(i2c->thread);
+}
+
+uint32_t host_i2c_read_reg(I2C_TypeDef *i2c, int reg) {
+    uint32_t val = 0;
+    pthread_mutex_lock(&i2c->lock);
+    switch (reg) {
+    case HOST_I2C_CR1:
+        val = i2c->cr1;
+        break;
+    case HOST_I2C_CR2:
+        val = i2c->cr2;
+        break;
+    case HOST_I2C_ISR:
+        val = i2c->isr | (i2c->txdr_full ? 0 : I2C_ISR_TXE);
+        break;
+    case HOST_I2C_RXDR:
+        val = i2c->rxdr;
+        i2c->isr &= ~I2C_ISR_RXNE;
+        pthread_cond_signal(&i2c->cond);
+        break;
+    default:
+        break;
+    }
+    pthread_mutex_unlock(&i2c->lock);
+    return val;
+}
+
+static void write_reg(I2C_TypeDef *i2c, int reg, uint32_t val,
+        uint32_t mask) {
+    switch (reg) {
+    case HOST_I2C_CR1: {
+        bool was_enabled = i2c->cr1 & I2C_CR1_PE;
+        i2c->cr1 = val;
+        if (was_enabled && !(val & I2C_CR1_PE))
+            reset_bus(i2c);
+        break;
+    }
+    case HOST_I2C_CR2:
+        i2c->cr2 = val;
+        cr2_written(i2c, mask & I2C_CR2_NBYTES);
+        break;
+    case HOST_I2C_ICR:
+        i2c->isr &= ~(val & (I2C_ISR_NACKF | I2C_ISR_STOPF | I2C_ISR_BERR |
+                I2C_ISR_ARLO | I2C_ISR_OVR));
+        break;
+    case HOST_I2C_TXDR:
+        i2c->txdr = val;
+        i2c->txdr_full = true;
+        i2c->isr &= ~I2C_ISR_TXIS;
+        break;
+    default:
+        break;
+    }
+}
+
+void host_i2c_write_reg(I2C_TypeDef *i2c, int reg, uint32_t val) {
+    pthread_mutex_lock(&i2c->lock);
+    ensure_running(i2c);
+    write_reg(i2c, reg, val, 0xffffffff);
+    pthread_cond_signal(&i2c->cond);
+    pthread_mutex_unlock(&i2c->lock);
+}
+
+void host_i2c_modify_reg(I2C_TypeDef *i2c, int reg, uint32_t clear,
+        uint32_t set) {
+    pthread_mutex_lock(&i2c->lock);
+    ensure_running(i2c);
+    uint32_t val = (reg == HOST_I2C_CR1) ? i2c->cr1 : i2c->cr2;
+    write_reg(i2c, reg, (val & ~clear) | set, clear | set);
+    pthread_cond_signal(&i2c->cond);
+    pthread_mutex_unlock(&i2c->lock);
+}
+
+void host_i2c_attach(I2C_TypeDef *i2c, uint8_t addr,
+        const host_i2c_dev_t *dev) {
+    pthread_mutex_lock(&i2c->lock);
+    attached_dev_t *slot = find_dev(i2c, addr);
+    if (!slot && (i2c->dev_count < MAX_DEVICES))
+        slot = &i2c->devices[i2c->dev_count++];
+    if (slot) {
+        slot->addr = addr;
+        slot->dev = *dev;
+    }
+    pthread_mutex_unlock(&i2c->lock);
+}
+
+static bool regfile_start(void *ctx, bool read) {
+    host_i2c_regfile_t *rf = ctx;
+    if (!read)
+        rf->have_ptr = false;
+    rf->byte = 0;
+    return true;
+}
+
+static void regfile_advance(host_i2c_regfile_t *rf) {
+    if (++rf->byte == rf->width) {
+        rf->byte = 0;
+        if (rf->width == 1)
+            rf->ptr++;
+    }
+}
+
+static bool regfile_write(void *ctx, uint8_t val) {
+    host_i2c_regfile_t *rf = ctx;
+    if (!rf->have_ptr) {
+        rf->ptr = val;
+        rf->have_ptr = true;
+        rf->byte = 0;
+        return true;
+    }
+    rf->regs[rf->ptr * rf->width + rf->byte] = val;
+    rf->writes++;
+    regfile_advance(rf);
+    return true;
+}
+
+static uint8_t regfile_read(void *ctx) {
+    host_i2c_regfile_t *rf = ctx;
+    uint8_t val = rf->regs[rf->ptr * rf->width + rf->byte];
+    rf->reads++;
+    regfile_advance(rf);
+    return val;
+}
+
+void host_i2c_attach_regfile(I2C_TypeDef *i2c, uint8_t addr,
+        host_i2c_regfile_t *regfile, uint8_t width) {
+    memset(regfile, 0, sizeof(host_i2c_regfile_t));
+    regfile->width = width;
+    host_i2c_dev_t dev = {
+        .ctx = regfile,
+        .start = regfile_start,
+        .write = regfile_write,
+        .read = regfile_read
+    };
+    host_i2c_attach(i2c, addr, &dev);
+}
+
+void host_i2c_set_irq(I2C_TypeDef *i2c, void (*ev_handler)(void),
+        void (*er_handler)(void)) {
+    pthread_mutex_lock(&i2c->lock);
+    i2c->ev_handler = ev_handler;
+    i2c->er_handler = er_handler;
+    pthread_mutex_unlock(&i2c->lock);
+}
+
+void host_i2c_set_freq(I2C_TypeDef *i2c, uint32_t hz) {
+    pthread_mutex_lock(&i2c->lock);
+    i2c->hz = hz;
+    pthread_mutex_unlock(&i2c->lock);
+}
+
+void host_i2c_get_stats(I2C_TypeDef *i2c, host_i2c_stats_t *stats) {
+    pthread_mutex_lock(&i2c->lock);
+    *stats = i2c->stats;
+    pthread_mutex_unlock(&i2c->lock);
+}
+
+void host_i2c_reset_stats(I2C_TypeDef *i2c) {
+    pthread_mutex_lock(&i2c->lock);
+    memset(&i2c->stats, 0, sizeof(host_i2c_stats_t));
+    pthread_mutex_unlock(&i2c->lock);
+}
@@ -0,0 +1,645 @@
+//
+// Glider firmware host port
+// Copyright 2025 Wenting Zhang
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+// FreeRTOS subset implemented with pthreads. Every task is a detached
+// thread, queues and semaphores are mutex/condition variable pairs.
+//
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <pthread.h>
+#include <time.h>
+#include <errno.h>
+#include <sched.h>
+#include "FreeRTOS.h"
+#include "task.h"
+#include "queue.h"
+#include "semphr.h"
+#include "timers.h"
+#include "host_hal.h"
+
+struct host_timer {
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    TimerCallbackFunction_t callback;
+    void *id;
+    TickType_t period;
+    bool auto_reload;
+    bool active;
+    uint32_t generation;    // Bumped on every start/stop/reset
+};
+
+struct host_task {
+    pthread_t thread;
+    TaskFunction_t code;
+    void *param;
+    char name[16];
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    uint32_t notify_value;
+    bool notify_pending;
+};
+
+struct host_queue {
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    uint8_t *storage;
+    UBaseType_t length;
+    UBaseType_t item_size;
+    UBaseType_t head;
+    UBaseType_t count;
+    pthread_t holder;       // Recursive mutexes only, while depth != 0
+    UBaseType_t depth;
+};
+
+static pthread_mutex_t critical_lock;
+static pthread_once_t critical_once = PTHREAD_ONCE_INIT;
+static __thread struct host_task *current_task;
+static size_t heap_used;
+static size_t heap_peak;
+
+static void critical_lock_init(void) {
+    pthread_mutexattr_t attr;
+    pthread_mutexattr_init(&attr);
+    pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+    pthread_mutex_init(&critical_lock, &attr);
+}
+
+void host_critical_enter(void) {
+    pthread_once(&critical_once, critical_lock_init);
+    pthread_mutex_lock(&critical_lock);
+}
+
+void host_critical_exit(void) {
+    pthread_mutex_unlock(&critical_lock);
+}
+
+void host_assert_failed(const char *file, int line) {
+    fprintf(stderr, "configASSERT failed at %s:%d\n", file, line);
+    abort();
+}
+
+// Heap, tracked only to report usage the same way heap_4 would
+void *pvPortMalloc(size_t size) {
+    size_t *p = malloc(size + sizeof(size_t));
+    if (!p)
+        return NULL;
+    *p = size;
+    host_critical_enter();
+    heap_used += size;
+    if (heap_used > heap_peak)
+        heap_peak = heap_used;
+    host_critical_exit();
+    return p + 1;
+}
+
+void vPortFree(void *ptr) {
+    if (!ptr)
+        return;
+    size_t *p = (size_t *)ptr - 1;
+    host_critical_enter();
+    heap_used -= *p;
+    host_critical_exit();
+    free(p);
+}
+
+size_t xPortGetFreeHeapSize(void) {
+    return configTOTAL_HEAP_SIZE - heap_used;
+}
+
+size_t xPortGetMinimumEverFreeHeapSize(void) {
+    return configTOTAL_HEAP_SIZE - heap_peak;
+}
+
+static void cond_init(pthread_cond_t *cond) {
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(cond, &attr);
+    pthread_condattr_destroy(&attr);
+}
+
+static void deadline_from_ticks(struct timespec *ts, TickType_t ticks) {
+    clock_gettime(CLOCK_MONOTONIC, ts);
+    uint64_t ns = (uint64_t)pdTICKS_TO_MS(ticks) * 1000000ull;
+    ts->tv_sec += ns / 1000000000ull;
+    ts->tv_nsec += ns % 1000000000ull;
+    if (ts->tv_nsec >= 1000000000) {
+        ts->tv_sec++;
+        ts->tv_nsec -= 1000000000;
+    }
+}
+
+// Wait on cond until pred() is true or the timeout expires. Lock is held.
+static bool cond_wait_ticks(pthread_cond_t *cond, pthread_mutex_t *lock,
+        TickType_t ticks, bool (*pred)(void *), void *arg) {
+    struct timespec deadline;
+    if (ticks != portMAX_DELAY)
+        deadline_from_ticks(&deadline, ticks);
+    while (!pred(arg)) {
+        if (ticks == 0)
+            return false;
+        if (ticks == portMAX_DELAY) {
+            pthread_cond_wait(cond, lock);
+        }
+        else if (pthread_cond_timedwait(cond, lock, &deadline) == ETIMEDOUT) {
+            return pred(arg);
+        }
+    }
+    return true;
+}
+
+// Tasks
+static struct host_task *task_self(void) {
+    if (!current_task) {
+        // Threads not created by xTaskCreate (main) get a handle on demand
+        current_task = calloc(1, sizeof(struct host_task));
+        current_task->thread = pthread_self();
+        strcpy(current_task->name, "main");
+        pthread_mutex_init(&current_task->lock, NULL);
+        cond_init(&current_task->cond);
+    }
+    return current_task;
+}
+
+static void *task_entry(void *arg) {
+    struct host_task *task = arg;
+    current_task = task;
+    task->code(task->param);
+    return NULL;
+}
+
+BaseType_t xTaskCreate(TaskFunction_t code, const char *name,
+        uint32_t stack_depth, void *param, UBaseType_t priority,
+        TaskHandle_t *handle) {
+    struct host_task *task = calloc(1, sizeof(struct host_task));
+    task->code = code;
+    task->param = param;
+    strncpy(task->name, name ? name : "", sizeof(task->name) - 1);
+    pthread_mutex_init(&task->lock, NULL);
+    cond_init(&task->cond);
+    if (handle)
+        *handle = task;
+    if (pthread_create(&task->thread, NULL, task_entry, task) != 0) {
+        free(task);
+        return pdFAIL;
+    }
+    pthread_detach(task->thread);
+    return pdPASS;
+}
+
+char *pcTaskGetName(TaskHandle_t task) {
+    if (task == NULL)
+        task = task_self();
+    return task->name;
+}
+
+UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t task) {
+    // Host threads have megabytes of stack, nothing useful to report
+    (void)task;
+    return 0;
+}
+
+// All host tasks are plain threads, priorities are not modelled
+UBaseType_t uxTaskPriorityGet(TaskHandle_t task) {
+    (void)task;
+    return 0;
+}
+
+void vTaskPrioritySet(TaskHandle_t task, UBaseType_t priority) {
+    (void)task;
+    (void)priority;
+}
+
+void vTaskDelete(TaskHandle_t task) {
+    if ((task == NULL) || (task == current_task))
+        pthread_exit(NULL);
+    // Deleting other tasks is not supported, the firmware never does it
+}
+
+void vTaskDelay(TickType_t ticks) {
+    host_sleep_us((uint64_t)pdTICKS_TO_MS(ticks) * 1000);
+}
+
+void vTaskDelayUntil(TickType_t *prev_wake, TickType_t increment) {
+    TickType_t target = *prev_wake + increment;
+    TickType_t now = xTaskGetTickCount();
+    if ((int32_t)(target - now) > 0)
+        vTaskDelay(target - now);
+    *prev_wake = target;
+}
+
+TickType_t xTaskGetTickCount(void) {
+    return (TickType_t)(host_time_us() / (1000000 / configTICK_RATE_HZ));
+}
+
+TickType_t xTaskGetTickCountFromISR(void) {
+    return xTaskGetTickCount();
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle(void) {
+    return task_self();
+}
+
+void vTaskSuspendAll(void) {
+    host_critical_enter();
+}
+
+BaseType_t xTaskResumeAll(void) {
+    host_critical_exit();
+    return pdFALSE;
+}
+
+void taskYIELD(void) {
+    sched_yield();
+}
+
+// Task notifications
+static bool notify_pending(void *arg) {
+    return ((struct host_task *)arg)->notify_pending;
+}
+
+static bool notify_nonzero(void *arg) {
+    return ((struct host_task *)arg)->notify_value != 0;
+}
+
+BaseType_t xTaskNotify(TaskHandle_t task, uint32_t value,
+        eNotifyAction action) {
+    BaseType_t result = pdPASS;
+    pthread_mutex_lock(&task->lock);
+    switch (action) {
+    case eSetBits: task->notify_value |= value; break;
+    case eIncrement: task->notify_value++; break;
+    case eSetValueWithOverwrite: task->notify_value = value; break;
+    case eSetValueWithoutOverwrite:
+        if (task->notify_pending)
+            result = pdFAIL;
+        else
+            task->notify_value = value;
+        break;
+    default: break;
+    }
+    task->notify_pending = true;
+    pthread_cond_broadcast(&task->cond);
+    pthread_mutex_unlock(&task->lock);
+    return result;
+}
+
+BaseType_t xTaskNotifyFromISR(TaskHandle_t task, uint32_t value,
+        eNotifyAction action, BaseType_t *woken) {
+    if (woken)
+        *woken = pdTRUE;
+    return xTaskNotify(task, value, action);
+}
+
+BaseType_t xTaskNotifyGive(TaskHandle_t task) {
+    return xTaskNotify(task, 0, eIncrement);
+}
+
+void vTaskNotifyGiveFromISR(TaskHandle_t task, BaseType_t *woken) {
+    xTaskNotifyFromISR(task, 0, eIncrement, woken);
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t clear_on_exit, TickType_t ticks) {
+    struct host_task *task = task_self();
+    uint32_t value;
+    pthread_mutex_lock(&task->lock);
+    cond_wait_ticks(&task->cond, &task->lock, ticks, notify_nonzero, task);
+    value = task->notify_value;
+    if (value) {
+        if (clear_on_exit)
+            task->notify_value = 0;
+        else
+            task->notify_value--;
+    }
+    task->notify_pending = false;
+    pthread_mutex_unlock(&task->lock);
+    return value;
+}
+
+BaseType_t xTaskNotifyWait(uint32_t clear_on_entry, uint32_t clear_on_exit,
+        uint32_t *value, TickType_t ticks) {
+    struct host_task *task = task_self();
+    BaseType_t result;
+    pthread_mutex_lock(&task->lock);
+    if (!task->notify_pending)
+        task->notify_value &= ~clear_on_entry;
+    result = cond_wait_ticks(&task->cond, &task->lock, ticks,
+            notify_pending, task) ? pdTRUE : pdFALSE;
+    if (value)
+        *value = task->notify_value;
+    if (result) {
+        task->notify_value &= ~clear_on_exit;
+        task->notify_pending = false;
+    }
+    pthread_mutex_unlock(&task->lock);
+    return result;
+}
+
+// Queues
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t item_size) {
+    struct host_queue *queue = calloc(1, sizeof(struct host_queue));
+    pthread_mutex_init(&queue->lock, NULL);
+    cond_init(&queue->cond);
+    queue->length = length;
+    queue->item_size = item_size;
+    if (item_size)
+        queue->storage = malloc(length * item_size);
+    return queue;
+}
+
+void vQueueDelete(QueueHandle_t queue) {
+    pthread_mutex_destroy(&queue->lock);
+    pthread_cond_destroy(&queue->cond);
+    free(queue->storage);
+    free(queue);
+}
+
+static bool queue_has_space(void *arg) {
+    struct host_queue *queue = arg;
+    return queue->count < queue->length;
+}
+
+static bool queue_has_item(void *arg) {
+    struct host_queue *queue = arg;
+    return queue->count != 0;
+}
+
+static BaseType_t queue_send(QueueHandle_t queue, const void *item,
+        TickType_t ticks, bool front) {
+    pthread_mutex_lock(&queue->lock);
+    if (!cond_wait_ticks(&queue->cond, &queue->lock, ticks, queue_has_space,
+            queue)) {
+        pthread_mutex_unlock(&queue->lock);
+        return errQUEUE_FULL;
+    }
+    if (queue->item_size) {
+        UBaseType_t slot;
+        if (front) {
+            queue->head = (queue->head + queue->length - 1) % queue->length;
+            slot = queue->head;
+        }
+        else {
+            slot = (queue->head + queue->count) % queue->length;
+        }
+        memcpy(queue->storage + slot * queue->item_size, item,
+                queue->item_size);
+    }
+    queue->count++;
+    pthread_cond_broadcast(&queue->cond);
+    pthread_mutex_unlock(&queue->lock);
+    return pdPASS;
+}
+
+static BaseType_t queue_receive(QueueHandle_t queue, void *item,
+        TickType_t ticks, bool peek) {
+    pthread_mutex_lock(&queue->lock);
+    if (!cond_wait_ticks(&queue->cond, &queue->lock, ticks, queue_has_item,
+            queue)) {
+        pthread_mutex_unlock(&queue->lock);
+        return errQUEUE_EMPTY;
+    }
+    if (queue->item_size && item)
+        memcpy(item, queue->storage + queue->head * queue->item_size,
+                queue->item_size);
+    if (!peek) {
+        if (queue->item_size)
+            queue->head = (queue->head + 1) % queue->length;
+        queue->count--;
+        pthread_cond_broadcast(&queue->cond);
+    }
+    pthread_mutex_unlock(&queue->lock);
+    return pdPASS;
+}
+
+BaseType_t xQueueSend(QueueHandle_t queue, const void *item, TickType_t ticks) {
+    return queue_send(queue, item, ticks, false);
+}
+
+BaseType_t xQueueSendToFront(QueueHandle_t queue, const void *item,
+        TickType_t ticks) {
+    return queue_send(queue, item, ticks, true);
+}
+
+BaseType_t xQueueSendFromISR(QueueHandle_t queue, const void *item,
+        BaseType_t *woken) {
+    if (woken)
+        *woken = pdTRUE;
+    return queue_send(queue, item, 0, false);
+}
+
+BaseType_t xQueueOverwrite(QueueHandle_t queue, const void *item) {
+    pthread_mutex_lock(&queue->lock);
+    queue->count = 0;
+    queue->head = 0;
+    pthread_mutex_unlock(&queue->lock);
+    return queue_send(queue, item, 0, false);
+}
+
+BaseType_t xQueueReceive(QueueHandle_t queue, void *item, TickType_t ticks) {
+    return queue_receive(queue, item, ticks, false);
+}
+
+BaseType_t xQueueReceiveFromISR(QueueHandle_t queue, void *item,
+        BaseType_t *woken) {
+    if (woken)
+        *woken = pdFALSE;
+    return queue_receive(queue, item, 0, false);
+}
+
+BaseType_t xQueuePeek(QueueHandle_t queue, void *item, TickType_t ticks) {
+    return queue_receive(queue, item, ticks, true);
+}
+
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t queue) {
+    pthread_mutex_lock(&queue->lock);
+    UBaseType_t count = queue->count;
+    pthread_mutex_unlock(&queue->lock);
+    return count;
+}
+
+UBaseType_t uxQueueSpacesAvailable(QueueHandle_t queue) {
+    pthread_mutex_lock(&queue->lock);
+    UBaseType_t spaces = queue->length - queue->count;
+    pthread_mutex_unlock(&queue->lock);
+    return spaces;
+}
+
+BaseType_t xQueueReset(QueueHandle_t queue) {
+    pthread_mutex_lock(&queue->lock);
+    queue->count = 0;
+    queue->head = 0;
+    pthread_cond_broadcast(&queue->cond);
+    pthread_mutex_unlock(&queue->lock);
+    return pdPASS;
+}
+
+// Semaphores, count is the number of items in a zero item size queue
+SemaphoreHandle_t xSemaphoreCreateMutex(void) {
+    SemaphoreHandle_t sem = xQueueCreate(1, 0);
+    sem->count = 1;
+    return sem;
+}
+
+SemaphoreHandle_t xSemaphoreCreateBinary(void) {
+    return xQueueCreate(1, 0);
+}
+
+SemaphoreHandle_t xSemaphoreCreateCounting(UBaseType_t max,
+        UBaseType_t initial) {
+    SemaphoreHandle_t sem = xQueueCreate(max, 0);
+    sem->count = initial;
+    return sem;
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t sem, TickType_t ticks) {
+    return queue_receive(sem, NULL, ticks, false);
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t sem) {
+    return queue_send(sem, NULL, 0, false);
+}
+
+BaseType_t xSemaphoreGiveFromISR(SemaphoreHandle_t sem, BaseType_t *woken) {
+    if (woken)
+        *woken = pdTRUE;
+    return queue_send(sem, NULL, 0, false);
+}
+
+BaseType_t xSemaphoreTakeFromISR(SemaphoreHandle_t sem, BaseType_t *woken) {
+    if (woken)
+        *woken = pdFALSE;
+    return queue_receive(sem, NULL, 0, false);
+}
+
+SemaphoreHandle_t xSemaphoreCreateRecursiveMutex(void) {
+    return xSemaphoreCreateMutex();
+}
+
+BaseType_t xSemaphoreTakeRecursive(SemaphoreHandle_t sem, TickType_t ticks) {
+    pthread_mutex_lock(&sem->lock);
+    if (sem->depth && pthread_equal(sem->holder, pthread_self())) {
+        sem->depth++;
+        pthread_mutex_unlock(&sem->lock);
+        return pdPASS;
+    }
+    pthread_mutex_unlock(&sem->lock);
+    if (queue_receive(sem, NULL, ticks, false) != pdPASS)
+        return pdFAIL;
+    pthread_mutex_lock(&sem->lock);
+    sem->holder = pthread_self();
+    sem->depth = 1;
+    pthread_mutex_unlock(&sem->lock);
+    return pdPASS;
+}
+
+BaseType_t xSemaphoreGiveRecursive(SemaphoreHandle_t sem) {
+    pthread_mutex_lock(&sem->lock);
+    if (!sem->depth || !pthread_equal(sem->holder, pthread_self())) {
+        pthread_mutex_unlock(&sem->lock);
+        return pdFAIL;
+    }
+    bool release = (--sem->depth == 0);
+    pthread_mutex_unlock(&sem->lock);
+    return release ? queue_send(sem, NULL, 0, false) : pdPASS;
+}
+
+UBaseType_t uxSemaphoreGetCount(SemaphoreHandle_t sem) {
+    return uxQueueMessagesWaiting(sem);
+}
+
+// Timers
+static void *timer_entry(void *arg) {
+    struct host_timer *timer = arg;
+    pthread_mutex_lock(&timer->lock);
+    while (1) {
+        while (!timer->active)
+            pthread_cond_wait(&timer->cond, &timer->lock);
+        uint32_t generation = timer->generation;
+        struct timespec deadline;
+        deadline_from_ticks(&deadline, timer->period);
+        int res = 0;
+        while ((generation == timer->generation) && (res != ETIMEDOUT))
+            res = pthread_cond_timedwait(&timer->cond, &timer->lock, &deadline);
+        if (generation != timer->generation)
+            continue; // Restarted or stopped
+        if (!timer->auto_reload)
+            timer->active = false;
+        pthread_mutex_unlock(&timer->lock);
+        timer->callback(timer);
+        pthread_mutex_lock(&timer->lock);
+    }
+    return NULL;
+}
+
+TimerHandle_t xTimerCreate(const char *name, TickType_t period,
+        UBaseType_t auto_reload, void *id, TimerCallbackFunction_t callback) {
+    (void)name;
+    struct host_timer *timer = calloc(1, sizeof(struct host_timer));
+    pthread_mutex_init(&timer->lock, NULL);
+    cond_init(&timer->cond);
+    timer->callback = callback;
+    timer->id = id;
+    timer->period = period;
+    timer->auto_reload = auto_reload;
+    if (pthread_create(&timer->thread, NULL, timer_entry, timer) != 0) {
+        free(timer);
+        return NULL;
+    }
+    pthread_detach(timer->thread);
+    return timer;
+}
+
+static BaseType_t timer_set(TimerHandle_t timer, bool active,
+        TickType_t period) {
+    pthread_mutex_lock(&timer->lock);
+    timer->active = active;
+    if (period)
+        timer->period = period;
+    timer->generation++;
+    pthread_cond_broadcast(&timer->cond);
+    pthread_mutex_unlock(&timer->lock);
+    return pdPASS;
+}
+
+BaseType_t xTimerStart(TimerHandle_t timer, TickType_t ticks) {
+    return timer_set(timer, true, 0);
+}
+
+BaseType_t xTimerStop(TimerHandle_t timer, TickType_t ticks) {
+    return timer_set(timer, false, 0);
+}
+
+BaseType_t xTimerReset(TimerHandle_t timer, TickType_t ticks) {
+    return timer_set(timer, true, 0);
+}
+
+BaseType_t xTimerChangePeriod(TimerHandle_t timer, TickType_t period,
+        TickType_t ticks) {
+    return timer_set(timer, true, period);
+}
+
+void *pvTimerGetTimerID(TimerHandle_t timer) {
+    return timer->id;
+}
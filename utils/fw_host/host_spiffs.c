@@ -0,0 +1,141 @@
+//
+// Glider firmware host port
+// Copyright 2025 Wenting Zhang
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+// SPIFFS on a RAM backed flash image, replacing the QSPI half of spiflash.c.
+// The real SPIFFS sources are used, so file system overhead is included.
+// QSPI flash access time is estimated with the figures below.
+//
+#include "platform.h"
+#include "spiffs.h"
+#include "host_spiffs.h"
+
+#define FLASH_SIZE          (4 * 1024 * 1024)
+#define FLASH_ERASE_SIZE    (4096)
+
+spiffs spiffs_fs;
+SemaphoreHandle_t spiffs_lock;
+
+static spiffs_config spiffs_cfg;
+static uint8_t fs_work_buf[256 * 2];
+static uint8_t fs_fds[32 * 4];
+static uint8_t fs_cache_buf[(256 + 32) * 4];
+static uint8_t *flash_image;
+static host_flash_stats_t flash_stats;
+
+static int32_t _spiffs_erase(uint32_t addr, uint32_t len) {
+    memset(flash_image + addr, 0xff, len);
+    flash_stats.erase_bytes += len;
+    flash_stats.modeled_ns += (uint64_t)(len / FLASH_ERASE_SIZE) *
+            HOST_FLASH_ERASE_NS;
+    return 0;
+}
+
+static int32_t _spiffs_read(uint32_t addr, uint32_t size, uint8_t *dst) {
+    memcpy(dst, flash_image + addr, size);
+    flash_stats.read_bytes += size;
+    flash_stats.read_calls++;
+    flash_stats.modeled_ns += HOST_FLASH_CMD_NS +
+            (uint64_t)size * 1000000000ull / HOST_FLASH_READ_BPS;
+    return 0;
+}
+
+static int32_t _spiffs_write(uint32_t addr, uint32_t size, uint8_t *dst) {
+    // NOR flash can only clear bits
+    for (uint32_t i = 0; i < size; i++)
+        flash_image[addr + i] &= dst[i];
+    flash_stats.write_bytes += size;
+    flash_stats.modeled_ns += HOST_FLASH_CMD_NS +
+            (uint64_t)size * 1000000000ull / HOST_FLASH_WRITE_BPS;
+    return 0;
+}
+
+void spiffs_init(void) {
+    if (!flash_image) {
+        flash_image = malloc(FLASH_SIZE);
+        memset(flash_image, 0xff, FLASH_SIZE);
+    }
+    spiffs_lock = xSemaphoreCreateMutex();
+    spiffs_cfg.hal_erase_f = _spiffs_erase;
+    spiffs_cfg.hal_read_f = _spiffs_read;
+    spiffs_cfg.hal_write_f = _spiffs_write;
+    int res = SPIFFS_mount(&spiffs_fs, &spiffs_cfg, fs_work_buf, fs_fds,
+            sizeof(fs_fds), fs_cache_buf, sizeof(fs_cache_buf), NULL);
+    if ((res != SPIFFS_OK) && (SPIFFS_errno(&spiffs_fs) == SPIFFS_ERR_NOT_A_FS)) {
+        SPIFFS_format(&spiffs_fs);
+        res = SPIFFS_mount(&spiffs_fs, &spiffs_cfg, fs_work_buf, fs_fds,
+                sizeof(fs_fds), fs_cache_buf, sizeof(fs_cache_buf), NULL);
+    }
+    if (res != SPIFFS_OK) {
+        syslog_printf("SPIFFS mount failed: %d\n", SPIFFS_errno(&spiffs_fs));
+    }
+}
+
+void host_spiffs_format(void) {
+    SPIFFS_unmount(&spiffs_fs);
+    memset(flash_image, 0xff, FLASH_SIZE);
+    SPIFFS_format(&spiffs_fs);
+    SPIFFS_mount(&spiffs_fs, &spiffs_cfg, fs_work_buf, fs_fds,
+            sizeof(fs_fds), fs_cache_buf, sizeof(fs_cache_buf), NULL);
+}
+
+int host_spiffs_import(const char *host_path, const char *name) {
+    FILE *fp = fopen(host_path, "rb");
+    if (!fp)
+        return -1;
+    spiffs_file f = SPIFFS_open(&spiffs_fs, name,
+            SPIFFS_O_CREAT | SPIFFS_O_TRUNC | SPIFFS_O_WRONLY, 0);
+    if (f < 0) {
+        fclose(fp);
+        return -1;
+    }
+    uint8_t buf[4096];
+    size_t len;
+    int total = 0;
+    while ((len = fread(buf, 1, sizeof(buf), fp)) > 0) {
+        if (SPIFFS_write(&spiffs_fs, f, buf, len) != (int32_t)len) {
+            total = -1;
+            break;
+        }
+        total += len;
+    }
+    SPIFFS_close(&spiffs_fs, f);
+    fclose(fp);
+    return total;
+}
+
+int host_spiffs_write_file(const char *name, const void *buf, size_t len) {
+    spiffs_file f = SPIFFS_open(&spiffs_fs, name,
+            SPIFFS_O_CREAT | SPIFFS_O_TRUNC | SPIFFS_O_WRONLY, 0);
+    if (f < 0)
+        return -1;
+    int res = SPIFFS_write(&spiffs_fs, f, (void *)buf, len);
+    SPIFFS_close(&spiffs_fs, f);
+    return res;
+}
+
+void host_flash_get_stats(host_flash_stats_t *stats) {
+    *stats = flash_stats;
+}
+
+void host_flash_reset_stats(void) {
+    memset(&flash_stats, 0, sizeof(flash_stats));
+}
@@ -0,0 +1,51 @@
+//
+// Glider firmware host port
+// Copyright 2025 Wenting Zhang
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Rough figures for a quad SPI NOR flash: quad output fast read, page
+// program and 4KB subsector erase
+#define HOST_FLASH_READ_BPS     (40 * 1000 * 1000)
+#define HOST_FLASH_WRITE_BPS    (600 * 1000)
+#define HOST_FLASH_CMD_NS       (1000)
+#define HOST_FLASH_ERASE_NS     (45 * 1000 * 1000)
+
+typedef struct {
+    uint64_t read_bytes;
+    uint64_t write_bytes;
+    uint64_t erase_bytes;
+    uint32_t read_calls;
+    uint64_t modeled_ns;
+} host_flash_stats_t;
+
+// Same entry point as spiflash.c
+void spiffs_init(void);
+// Start over with an empty, erased flash
+void host_spiffs_format(void);
+// Copy a file from the host file system into SPIFFS, returns size or -1
+int host_spiffs_import(const char *host_path, const char *name);
+int host_spiffs_write_file(const char *name, const void *buf, size_t len);
+void host_flash_get_stats(host_flash_stats_t *stats);
+void host_flash_reset_stats(void);
@@ -0,0 +1,534 @@
+//
+// Glider firmware host port
+// Copyright 2025 Wenting Zhang
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+// All class callbacks run in tud_task(), in the USB device task, as on the
+// device. A reader thread turns socket frames into events for it, another
+// one does the same for the CDC pty.
+//
+#define _GNU_SOURCE
+#include "platform.h"
+#include "usbapp.h"
+#include "tusb.h"
+#include "device/usbd_pvt.h"
+#include "host_hal.h"
+#include "host_tusb.h"
+#include <pthread.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <termios.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#define EVENT_QUEUE_LENGTH  8
+#define CDC_RX_SIZE         4096
+#define CDC_TX_SIZE         256
+#define STATS_SAMPLES       8192
+#define BULK_ITF            3
+
+typedef enum {
+    EV_MOUNT,
+    EV_RESET,
+    EV_HID_OUT,
+    EV_HID_IN_DONE,
+    EV_XFER,
+    EV_DEFER,
+    EV_CDC_RX
+} event_type_t;
+
+typedef struct {
+    event_type_t type;
+    uint8_t ep;
+    uint32_t len;
+    void (*func)(void *);
+    void *param;
+    uint8_t data[CFG_TUD_HID_EP_BUFSIZE];
+} event_t;
+
+typedef struct {
+    uint32_t count;
+    uint64_t total_ns;
+    uint64_t max_ns;
+    uint32_t *samples;      // Last STATS_SAMPLES, in ns
+} cmd_stats_t;
+
+static const char *socket_path = "/tmp/glider.sock";
+static QueueHandle_t events;
+static usbd_class_driver_t const *app_driver;
+static int listen_fd = -1;
+static int client_fd = -1;
+static bool mounted;
+static bool hid_in_busy;
+static pthread_mutex_t write_lock = PTHREAD_MUTEX_INITIALIZER;
+
+// Bulk OUT endpoint, filled by the socket thread
+static pthread_mutex_t ep_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t ep_cond = PTHREAD_COND_INITIALIZER;
+static uint8_t bulk_ep_out;
+static uint8_t bulk_ep_in;
+static uint8_t *out_buf;
+static uint32_t out_len;
+static uint32_t out_done;
+static bool out_armed;
+
+// CDC
+static int pty_fd = -1;
+static pthread_mutex_t cdc_lock = PTHREAD_MUTEX_INITIALIZER;
+static uint8_t cdc_rx[CDC_RX_SIZE];
+static uint32_t cdc_rx_head;
+static uint32_t cdc_rx_tail;
+static bool cdc_rx_pending;
+static char cdc_tx[CDC_TX_SIZE];
+static uint32_t cdc_tx_len;
+
+static pthread_mutex_t stats_lock = PTHREAD_MUTEX_INITIALIZER;
+static cmd_stats_t stats[256];
+
+static uint64_t time_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+static void post_event(const event_t *ev) {
+    xQueueSend(events, ev, portMAX_DELAY);
+}
+
+static bool send_frame(uint8_t type, const void *data, uint16_t len) {
+    uint8_t hdr[HOST_USB_FRAME_HDR] = {type, 0, len & 0xff, (len >> 8) & 0xff};
+    bool ok = false;
+    pthread_mutex_lock(&write_lock);
+    if (client_fd >= 0) {
+        ok = (send(client_fd, hdr, sizeof(hdr), MSG_NOSIGNAL) == sizeof(hdr)) &&
+                (send(client_fd, data, len, MSG_NOSIGNAL) == len);
+    }
+    pthread_mutex_unlock(&write_lock);
+    return ok;
+}
+
+static bool recv_all(int fd, void *buf, size_t len) {
+    uint8_t *p = buf;
+    while (len) {
+        ssize_t res = recv(fd, p, len, 0);
+        if (res < 0 && errno == EINTR)
+            continue;
+        if (res <= 0)
+            return false;
+        p += res;
+        len -= res;
+    }
+    return true;
+}
+
+static void record_service(uint8_t key, uint64_t ns) {
+    cmd_stats_t *s = &stats[key];
+    pthread_mutex_lock(&stats_lock);
+    if (!s->samples)
+        s->samples = calloc(STATS_SAMPLES, sizeof(uint32_t));
+    s->samples[s->count % STATS_SAMPLES] = (ns > UINT32_MAX) ? UINT32_MAX : ns;
+    s->count++;
+    s->total_ns += ns;
+    if (ns > s->max_ns)
+        s->max_ns = ns;
+    pthread_mutex_unlock(&stats_lock);
+}
+
+static int cmp_u32(const void *a, const void *b) {
+    uint32_t x = *(const uint32_t *)a;
+    uint32_t y = *(const uint32_t *)b;
+    return (x > y) - (x < y);
+}
+
+static const char *cmd_name(int key) {
+    switch (key) {
+    case USBCMD_RESET: return "RESET";
+    case USBCMD_POWERDOWN: return "POWERDOWN";
+    case USBCMD_POWERUP: return "POWERUP";
+    case USBCMD_SETINPUT: return "SETINPUT";
+    case USBCMD_REDRAW: return "REDRAW";
+    case USBCMD_SETMODE: return "SETMODE";
+    case USBCMD_NUKE: return "NUKE";
+    case USBCMD_USBBOOT: return "USBBOOT";
+    case USBCMD_RECV: return "RECV";
+    case USBCMD_RECV_BULK: return "RECV_BULK";
+    case USBV2_MAGIC: return "V2";
+    default: return NULL;
+    }
+}
+
+void host_tusb_print_stats(FILE *fp) {
+    pthread_mutex_lock(&stats_lock);
+    fprintf(fp, "HID report service time, us\n");
+    fprintf(fp, "  %-10s %8s %8s %8s %8s %8s\n", "command", "count", "mean",
+            "p50", "p99", "max");
+    for (int i = 0; i < 256; i++) {
+        cmd_stats_t *s = &stats[i];
+        if (s->count == 0)
+            continue;
+        uint32_t n = (s->count > STATS_SAMPLES) ? STATS_SAMPLES : s->count;
+        uint32_t *sorted = malloc(n * sizeof(uint32_t));
+        memcpy(sorted, s->samples, n * sizeof(uint32_t));
+        qsort(sorted, n, sizeof(uint32_t), cmp_u32);
+        const char *name = cmd_name(i);
+        char buf[16];
+        if (!name) {
+            snprintf(buf, sizeof(buf), "0x%02x", i);
+            name = buf;
+        }
+        fprintf(fp, "  %-10s %8u %8.1f %8.1f %8.1f %8.1f\n", name, s->count,
+                s->total_ns / 1000.0 / s->count, sorted[n / 2] / 1000.0,
+                sorted[(n * 99) / 100] / 1000.0, s->max_ns / 1000.0);
+        free(sorted);
+    }
+    pthread_mutex_unlock(&stats_lock);
+}
+
+void host_tusb_reset_stats(void) {
+    pthread_mutex_lock(&stats_lock);
+    for (int i = 0; i < 256; i++) {
+        free(stats[i].samples);
+        memset(&stats[i], 0, sizeof(cmd_stats_t));
+    }
+    pthread_mutex_unlock(&stats_lock);
+}
+
+static void send_stats(void) {
+    char *text = NULL;
+    size_t len = 0;
+    FILE *fp = open_memstream(&text, &len);
+    host_tusb_print_stats(fp);
+    fclose(fp);
+    if (len > UINT16_MAX)
+        len = UINT16_MAX;
+    send_frame(HOST_USB_STATS, text, len);
+    free(text);
+}
+
+// Returns false if the client went away
+static bool bulk_out(uint32_t len) {
+    bool short_packet = (len % HOST_USB_PACKET_SIZE) != 0;
+    while (len) {
+        pthread_mutex_lock(&ep_lock);
+        // Not armed means NAK, the client waits
+        while (!out_armed)
+            pthread_cond_wait(&ep_cond, &ep_lock);
+        uint32_t chunk = out_len - out_done;
+        if (chunk > len)
+            chunk = len;
+        uint8_t *dst = out_buf + out_done;
+        pthread_mutex_unlock(&ep_lock);
+        if (!recv_all(client_fd, dst, chunk))
+            return false;
+        len -= chunk;
+        pthread_mutex_lock(&ep_lock);
+        out_done += chunk;
+        bool full = out_done == out_len;
+        bool done = full || ((len == 0) && short_packet);
+        event_t ev = {.type = EV_XFER, .ep = bulk_ep_out, .len = out_done};
+        if (done)
+            out_armed = false;
+        pthread_mutex_unlock(&ep_lock);
+        if (done)
+            post_event(&ev);
+    }
+    return true;
+}
+
+static void *socket_thread(void *arg) {
+    (void)arg;
+    while (1) {
+        int fd = accept(listen_fd, NULL, NULL);
+        if (fd < 0)
+            continue;
+        pthread_mutex_lock(&write_lock);
+        client_fd = fd;
+        pthread_mutex_unlock(&write_lock);
+        event_t ev = {.type = EV_MOUNT};
+        post_event(&ev);
+
+        uint8_t hdr[HOST_USB_FRAME_HDR];
+        while (recv_all(fd, hdr, sizeof(hdr))) {
+            uint16_t len = hdr[2] | (hdr[3] << 8);
+            if (hdr[0] == HOST_USB_HID_OUT) {
+                event_t ev = {.type = EV_HID_OUT, .len = len};
+                if ((len > sizeof(ev.data)) || !recv_all(fd, ev.data, len))
+                    break;
+                post_event(&ev);
+            }
+            else if (hdr[0] == HOST_USB_BULK_OUT) {
+                if (!bulk_out(len))
+                    break;
+            }
+            else if (hdr[0] == HOST_USB_STATS) {
+                send_stats();
+            }
+            else {
+                break;
+            }
+        }
+
+        pthread_mutex_lock(&write_lock);
+        client_fd = -1;
+        pthread_mutex_unlock(&write_lock);
+        close(fd);
+        ev.type = EV_RESET;
+        post_event(&ev);
+    }
+    return NULL;
+}
+
+static void *pty_thread(void *arg) {
+    (void)arg;
+    uint8_t buf[256];
+    while (1) {
+        struct pollfd pfd = {.fd = pty_fd, .events = POLLIN};
+        poll(&pfd, 1, 100);
+        ssize_t len = (pfd.revents & POLLIN) ? read(pty_fd, buf, sizeof(buf)) : 0;
+        if (len <= 0) {
+            // No one has the slave open
+            if (pfd.revents & POLLHUP)
+                host_sleep_us(10000);
+            continue;
+        }
+        pthread_mutex_lock(&cdc_lock);
+        for (ssize_t i = 0; i < len; i++) {
+            if (cdc_rx_tail - cdc_rx_head < CDC_RX_SIZE)
+                cdc_rx[cdc_rx_tail++ % CDC_RX_SIZE] = buf[i];
+        }
+        bool notify = !cdc_rx_pending;
+        cdc_rx_pending = true;
+        pthread_mutex_unlock(&cdc_lock);
+        if (notify) {
+            event_t ev = {.type = EV_CDC_RX};
+            post_event(&ev);
+        }
+    }
+    return NULL;
+}
+
+void host_tusb_set_socket(const char *path) {
+    socket_path = path;
+}
+
+const char *host_tusb_open_pty(void) {
+    pty_fd = posix_openpt(O_RDWR | O_NOCTTY);
+    if ((pty_fd < 0) || (grantpt(pty_fd) != 0) || (unlockpt(pty_fd) != 0))
+        return NULL;
+    // Output is dropped rather than blocking while no terminal is attached
+    fcntl(pty_fd, F_SETFL, O_NONBLOCK);
+    // Raw, linenoise in the shell does the line editing
+    struct termios tio;
+    tcgetattr(pty_fd, &tio);
+    cfmakeraw(&tio);
+    tcsetattr(pty_fd, TCSANOW, &tio);
+    return ptsname(pty_fd);
+}
+
+// The vendor interface from usb_descriptors.c
+static void mount_bulk(void) {
+    static const uint8_t desc[] = {
+        9, TUSB_DESC_INTERFACE, BULK_ITF, 0, 2, TUSB_CLASS_VENDOR_SPECIFIC, 0, 0, 0,
+        7, TUSB_DESC_ENDPOINT, 0x04, TUSB_XFER_BULK, 64, 0, 0,
+        7, TUSB_DESC_ENDPOINT, 0x84, TUSB_XFER_BULK, 64, 0, 0
+    };
+    if (app_driver && app_driver->open)
+        app_driver->open(BOARD_TUD_RHPORT,
+                (tusb_desc_interface_t const *)desc, sizeof(desc));
+}
+
+bool tusb_init(uint8_t rhport, const tusb_rhport_init_t *init) {
+    (void)rhport;
+    (void)init;
+    events = xQueueCreate(EVENT_QUEUE_LENGTH, sizeof(event_t));
+    uint8_t count = 0;
+    app_driver = usbd_app_driver_get_cb(&count);
+    if (count == 0)
+        app_driver = NULL;
+    if (app_driver && app_driver->init)
+        app_driver->init();
+
+    struct sockaddr_un addr = {.sun_family = AF_UNIX};
+    strncpy(addr.sun_path, socket_path, sizeof(addr.sun_path) - 1);
+    unlink(socket_path);
+    listen_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if ((listen_fd < 0) ||
+            (bind(listen_fd, (struct sockaddr *)&addr, sizeof(addr)) != 0) ||
+            (listen(listen_fd, 1) != 0)) {
+        fprintf(stderr, "Failed to listen on %s: %s\n", socket_path,
+                strerror(errno));
+        return false;
+    }
+    pthread_t thread;
+    pthread_create(&thread, NULL, socket_thread, NULL);
+    pthread_detach(thread);
+    if (pty_fd >= 0) {
+        pthread_create(&thread, NULL, pty_thread, NULL);
+        pthread_detach(thread);
+    }
+    return true;
+}
+
+bool tud_mounted(void) {
+    return mounted;
+}
+
+void tud_task(void) {
+    event_t ev;
+    xQueueReceive(events, &ev, portMAX_DELAY);
+    switch (ev.type) {
+    case EV_MOUNT:
+        mounted = true;
+        hid_in_busy = false;
+        mount_bulk();
+        break;
+    case EV_RESET:
+        mounted = false;
+        hid_in_busy = false;
+        pthread_mutex_lock(&ep_lock);
+        out_armed = false;
+        pthread_mutex_unlock(&ep_lock);
+        if (app_driver && app_driver->reset)
+            app_driver->reset(BOARD_TUD_RHPORT);
+        break;
+    case EV_HID_OUT: {
+        uint64_t start = time_ns();
+        tud_hid_set_report_cb(0, 0, HID_REPORT_TYPE_OUTPUT, ev.data, ev.len);
+        record_service(ev.data[0], time_ns() - start);
+        break;
+    }
+    case EV_HID_IN_DONE:
+        hid_in_busy = false;
+        tud_hid_report_complete_cb(0, ev.data, ev.len);
+        break;
+    case EV_XFER:
+        if (app_driver && app_driver->xfer_cb)
+            app_driver->xfer_cb(BOARD_TUD_RHPORT, ev.ep, XFER_RESULT_SUCCESS,
+                    ev.len);
+        break;
+    case EV_DEFER:
+        ev.func(ev.param);
+        break;
+    case EV_CDC_RX:
+        pthread_mutex_lock(&cdc_lock);
+        cdc_rx_pending = false;
+        pthread_mutex_unlock(&cdc_lock);
+        tud_cdc_rx_cb(0);
+        break;
+    }
+}
+
+bool tud_hid_report(uint8_t report_id, void const *report, uint16_t len) {
+    (void)report_id;
+    if (!mounted || hid_in_busy)
+        return false;
+    if (len > CFG_TUD_HID_EP_BUFSIZE)
+        len = CFG_TUD_HID_EP_BUFSIZE;
+    event_t ev = {.type = EV_HID_IN_DONE, .len = len};
+    memcpy(ev.data, report, len);
+    // Queued before the client can see the report and answer it, so the
+    // endpoint is free again by the time the answer is handled. Posted from
+    // the USB task itself, so don't wait on a full queue.
+    hid_in_busy = xQueueSend(events, &ev, 0) == pdTRUE;
+    send_frame(HOST_USB_HID_IN, report, len);
+    return true;
+}
+
+bool usbd_open_edpt_pair(uint8_t rhport, uint8_t const *p_desc, uint8_t ep_count,
+        uint8_t xfer_type, uint8_t *ep_out, uint8_t *ep_in) {
+    (void)rhport;
+    for (int i = 0; i < ep_count; i++) {
+        tusb_desc_endpoint_t const *ep = (tusb_desc_endpoint_t const *)p_desc;
+        if ((ep->bDescriptorType != TUSB_DESC_ENDPOINT) ||
+                ((ep->bmAttributes & 0x03) != xfer_type))
+            return false;
+        if (ep->bEndpointAddress & TUSB_DIR_IN_MASK)
+            *ep_in = bulk_ep_in = ep->bEndpointAddress;
+        else
+            *ep_out = bulk_ep_out = ep->bEndpointAddress;
+        p_desc = tu_desc_next(p_desc);
+    }
+    return true;
+}
+
+bool usbd_edpt_xfer(uint8_t rhport, uint8_t ep_addr, uint8_t *buffer,
+        uint16_t total_bytes) {
+    (void)rhport;
+    if (!mounted)
+        return false;
+    if (ep_addr & TUSB_DIR_IN_MASK) {
+        event_t ev = {.type = EV_XFER, .ep = ep_addr, .len = total_bytes};
+        xQueueSend(events, &ev, 0);
+        send_frame(HOST_USB_BULK_IN, buffer, total_bytes);
+        return true;
+    }
+    pthread_mutex_lock(&ep_lock);
+    out_buf = buffer;
+    out_len = total_bytes;
+    out_done = 0;
+    out_armed = true;
+    pthread_cond_signal(&ep_cond);
+    pthread_mutex_unlock(&ep_lock);
+    return true;
+}
+
+void usbd_defer_func(void (*func)(void *), void *param, bool in_isr) {
+    (void)in_isr;
+    event_t ev = {.type = EV_DEFER, .func = func, .param = param};
+    post_event(&ev);
+}
+
+uint32_t tud_cdc_available(void) {
+    pthread_mutex_lock(&cdc_lock);
+    uint32_t count = cdc_rx_tail - cdc_rx_head;
+    pthread_mutex_unlock(&cdc_lock);
+    return count;
+}
+
+int32_t tud_cdc_read_char(void) {
+    int32_t c = -1;
+    pthread_mutex_lock(&cdc_lock);
+    if (cdc_rx_head != cdc_rx_tail)
+        c = cdc_rx[cdc_rx_head++ % CDC_RX_SIZE];
+    pthread_mutex_unlock(&cdc_lock);
+    return c;
+}
+
+uint32_t tud_cdc_write_char(char ch) {
+    pthread_mutex_lock(&cdc_lock);
+    if (cdc_tx_len < CDC_TX_SIZE)
+        cdc_tx[cdc_tx_len++] = ch;
+    pthread_mutex_unlock(&cdc_lock);
+    return 1;
+}
+
+uint32_t tud_cdc_write_flush(void) {
+    pthread_mutex_lock(&cdc_lock);
+    uint32_t len = cdc_tx_len;
+    if ((pty_fd >= 0) && len) {
+        if (write(pty_fd, cdc_tx, len) < 0)
+            len = 0;
+    }
+    cdc_tx_len = 0;
+    pthread_mutex_unlock(&cdc_lock);
+    return len;
+}
@@ -0,0 +1,51 @@
+//
+// Glider firmware host port
+// Copyright 2025 Wenting Zhang
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+// USB device controller stand-in for the TinyUSB shim. A host client
+// connects to a UNIX stream socket and exchanges frames:
+//   [0] type, [1] reserved, [2:3] payload length, little endian, payload
+// HID reports are 64 bytes. Bulk OUT frames may have any length, the data
+// is split into 64 byte packets and a frame not ending on a packet boundary
+// ends with a short packet, like a USB transfer. The CDC interface is a pty.
+//
+#pragma once
+
+#include <stdio.h>
+#include <stdint.h>
+
+#define HOST_USB_HID_OUT        0x01    // Client to device
+#define HOST_USB_HID_IN         0x02    // Device to client
+#define HOST_USB_BULK_OUT       0x03
+#define HOST_USB_BULK_IN        0x04
+#define HOST_USB_STATS          0x05    // Request, answered with text
+#define HOST_USB_FRAME_HDR      4
+#define HOST_USB_PACKET_SIZE    64
+
+// Call before tusb_init()
+void host_tusb_set_socket(const char *path);
+// Create the pty for the CDC interface, returns the slave device path
+const char *host_tusb_open_pty(void);
+
+// Service time of tud_hid_set_report_cb() per first report byte (command,
+// or the v2 magic)
+void host_tusb_print_stats(FILE *fp);
+void host_tusb_reset_stats(void);
@@ -0,0 +1,138 @@
+//
+// Glider firmware host port
+// Copyright 2025 Wenting Zhang
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+// Stand-in for the STM32H7 HAL. GPIO is a plain pin state table, SPI
+// transfers are routed to a device model attached with host_spi_attach()
+// (see host_hal.h). Peripherals without a model are accepted and ignored.
+//
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+typedef enum {
+    HAL_OK = 0x00,
+    HAL_ERROR = 0x01,
+    HAL_BUSY = 0x02,
+    HAL_TIMEOUT = 0x03
+} HAL_StatusTypeDef;
+
+#define HAL_MAX_DELAY       0xFFFFFFFFU
+
+// GPIO
+typedef struct {
+    uint16_t odr;
+    uint16_t idr;
+} GPIO_TypeDef;
+
+extern GPIO_TypeDef host_gpio[5];
+
+#define GPIOA               (&host_gpio[0])
+#define GPIOB               (&host_gpio[1])
+#define GPIOC               (&host_gpio[2])
+#define GPIOD               (&host_gpio[3])
+#define GPIOE               (&host_gpio[4])
+
+#define GPIO_PIN_0          ((uint16_t)0x0001)
+#define GPIO_PIN_1          ((uint16_t)0x0002)
+#define GPIO_PIN_2          ((uint16_t)0x0004)
+#define GPIO_PIN_3          ((uint16_t)0x0008)
+#define GPIO_PIN_4          ((uint16_t)0x0010)
+#define GPIO_PIN_5          ((uint16_t)0x0020)
+#define GPIO_PIN_6          ((uint16_t)0x0040)
+#define GPIO_PIN_7          ((uint16_t)0x0080)
+#define GPIO_PIN_8          ((uint16_t)0x0100)
+#define GPIO_PIN_9          ((uint16_t)0x0200)
+#define GPIO_PIN_10         ((uint16_t)0x0400)
+#define GPIO_PIN_11         ((uint16_t)0x0800)
+#define GPIO_PIN_12         ((uint16_t)0x1000)
+#define GPIO_PIN_13         ((uint16_t)0x2000)
+#define GPIO_PIN_14         ((uint16_t)0x4000)
+#define GPIO_PIN_15         ((uint16_t)0x8000)
+
+typedef enum {
+    GPIO_PIN_RESET = 0,
+    GPIO_PIN_SET
+} GPIO_PinState;
+
+void HAL_GPIO_WritePin(GPIO_TypeDef *port, uint16_t pin, GPIO_PinState state);
+GPIO_PinState HAL_GPIO_ReadPin(GPIO_TypeDef *port, uint16_t pin);
+void HAL_GPIO_EXTI_Callback(uint16_t pin);
+
+// SPI
+#define SPI_BAUDRATEPRESCALER_2     (0x00000000UL)
+#define SPI_BAUDRATEPRESCALER_4     (0x10000000UL)
+#define SPI_BAUDRATEPRESCALER_8     (0x20000000UL)
+#define SPI_BAUDRATEPRESCALER_16    (0x30000000UL)
+#define SPI_BAUDRATEPRESCALER_32    (0x40000000UL)
+#define SPI_BAUDRATEPRESCALER_64    (0x50000000UL)
+#define SPI_BAUDRATEPRESCALER_128   (0x60000000UL)
+#define SPI_BAUDRATEPRESCALER_256   (0x70000000UL)
+
+typedef struct {
+    uint32_t BaudRatePrescaler;
+} SPI_InitTypeDef;
+
+typedef struct __SPI_HandleTypeDef {
+    SPI_InitTypeDef Init;
+    void *host_dev; // Attached device model, see host_hal.h
+} SPI_HandleTypeDef;
+
+HAL_StatusTypeDef HAL_SPI_Init(SPI_HandleTypeDef *hspi);
+HAL_StatusTypeDef HAL_SPI_DeInit(SPI_HandleTypeDef *hspi);
+HAL_StatusTypeDef HAL_SPI_Transmit(SPI_HandleTypeDef *hspi, uint8_t *data,
+        uint16_t size, uint32_t timeout);
+HAL_StatusTypeDef HAL_SPI_Transmit_DMA(SPI_HandleTypeDef *hspi, uint8_t *data,
+        uint16_t size);
+HAL_StatusTypeDef HAL_SPI_TransmitReceive(SPI_HandleTypeDef *hspi,
+        uint8_t *txdata, uint8_t *rxdata, uint16_t size, uint32_t timeout);
+void HAL_SPI_TxCpltCallback(SPI_HandleTypeDef *hspi);
+
+// Other peripherals referenced by board.h, no behaviour on the host
+typedef struct { int unused; } ADC_HandleTypeDef;
+typedef struct { int unused; } DAC_HandleTypeDef;
+typedef struct { int unused; } QSPI_HandleTypeDef;
+typedef struct { int unused; } TIM_HandleTypeDef;
+
+#define DAC_CHANNEL_1       (0x00000000UL)
+#define DAC_CHANNEL_2       (0x00000010UL)
+#define DAC_ALIGN_12B_R     (0x00000000UL)
+#define TIM_CHANNEL_1       (0x00000000UL)
+#define TIM_CHANNEL_2       (0x00000004UL)
+
+HAL_StatusTypeDef HAL_DAC_Start(DAC_HandleTypeDef *hdac, uint32_t channel);
+HAL_StatusTypeDef HAL_DAC_Stop(DAC_HandleTypeDef *hdac, uint32_t channel);
+HAL_StatusTypeDef HAL_DAC_SetValue(DAC_HandleTypeDef *hdac, uint32_t channel,
+        uint32_t alignment, uint32_t data);
+HAL_StatusTypeDef HAL_TIM_PWM_Start(TIM_HandleTypeDef *htim, uint32_t channel);
+HAL_StatusTypeDef HAL_TIM_PWM_Stop(TIM_HandleTypeDef *htim, uint32_t channel);
+
+uint32_t HAL_GetTick(void);
+uint32_t HAL_GetUIDw0(void);
+void NVIC_SystemReset(void);
+
+#define __disable_irq()     host_critical_enter()
+#define __enable_irq()      host_critical_exit()
+#define __NOP()             do { } while (0)
+
+void host_critical_enter(void);
+void host_critical_exit(void);
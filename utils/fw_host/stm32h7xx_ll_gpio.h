@@ -0,0 +1,54 @@
+//
+// Glider firmware host port
+// Copyright 2025 Wenting Zhang
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+// Only the pin mux call in pal_i2c_ping() is used on the host. Pin modes
+// aren't modelled, so it does nothing.
+//
+#pragma once
+
+#include <stdint.h>
+#include "stm32h7xx_hal.h"
+
+#define LL_GPIO_PIN_6               GPIO_PIN_6
+#define LL_GPIO_PIN_7               GPIO_PIN_7
+#define LL_GPIO_MODE_OUTPUT         (0x00000001U)
+#define LL_GPIO_MODE_ALTERNATE      (0x00000002U)
+#define LL_GPIO_SPEED_FREQ_LOW      (0x00000000U)
+#define LL_GPIO_OUTPUT_OPENDRAIN    (0x00000001U)
+#define LL_GPIO_PULL_NO             (0x00000000U)
+#define LL_GPIO_AF_4                (0x00000004U)
+
+typedef struct {
+    uint32_t Pin;
+    uint32_t Mode;
+    uint32_t Speed;
+    uint32_t OutputType;
+    uint32_t Pull;
+    uint32_t Alternate;
+} LL_GPIO_InitTypeDef;
+
+static inline int LL_GPIO_Init(GPIO_TypeDef *GPIOx,
+        LL_GPIO_InitTypeDef *GPIO_InitStruct) {
+    (void)GPIOx;
+    (void)GPIO_InitStruct;
+    return 0;
+}
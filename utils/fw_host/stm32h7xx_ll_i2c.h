@@ -0,0 +1,196 @@
+//
+// Glider firmware host port
+// Copyright 2025 Wenting Zhang
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+// Stand-in for the STM32H7 LL I2C driver. The register block is modelled
+// in host_i2c.c: a bus thread clocks bytes at the configured bus speed,
+// sets the ISR flags the way the peripheral does and calls the interrupt
+// handler registered with host_i2c_set_irq() (see host_hal.h). Only the
+// master mode subset used by pal_i2c.c is provided.
+//
+#pragma once
+
+#include <stdint.h>
+
+typedef struct host_i2c I2C_TypeDef;
+
+extern I2C_TypeDef host_i2c1;
+
+#define I2C1                        (&host_i2c1)
+
+// Register offsets understood by host_i2c_read_reg()/host_i2c_write_reg()
+#define HOST_I2C_CR1                0
+#define HOST_I2C_CR2                1
+#define HOST_I2C_ISR                2
+#define HOST_I2C_ICR                3
+#define HOST_I2C_RXDR               4
+#define HOST_I2C_TXDR               5
+
+uint32_t host_i2c_read_reg(I2C_TypeDef *i2c, int reg);
+void host_i2c_write_reg(I2C_TypeDef *i2c, int reg, uint32_t val);
+void host_i2c_modify_reg(I2C_TypeDef *i2c, int reg, uint32_t clear,
+        uint32_t set);
+
+// Register bits, same positions as the real peripheral
+#define I2C_CR1_PE                  (1UL << 0)
+#define I2C_CR1_TXIE                (1UL << 1)
+#define I2C_CR1_RXIE                (1UL << 2)
+#define I2C_CR1_NACKIE              (1UL << 4)
+#define I2C_CR1_STOPIE              (1UL << 5)
+#define I2C_CR1_TCIE                (1UL << 6)
+#define I2C_CR1_ERRIE               (1UL << 7)
+
+#define I2C_CR2_SADD                (0x3FFUL << 0)
+#define I2C_CR2_RD_WRN              (1UL << 10)
+#define I2C_CR2_ADD10               (1UL << 11)
+#define I2C_CR2_START               (1UL << 13)
+#define I2C_CR2_STOP                (1UL << 14)
+#define I2C_CR2_NBYTES_Pos          (16U)
+#define I2C_CR2_NBYTES              (0xFFUL << I2C_CR2_NBYTES_Pos)
+#define I2C_CR2_RELOAD              (1UL << 24)
+#define I2C_CR2_AUTOEND             (1UL << 25)
+
+#define I2C_ISR_TXE                 (1UL << 0)
+#define I2C_ISR_TXIS                (1UL << 1)
+#define I2C_ISR_RXNE                (1UL << 2)
+#define I2C_ISR_NACKF               (1UL << 4)
+#define I2C_ISR_STOPF               (1UL << 5)
+#define I2C_ISR_TC                  (1UL << 6)
+#define I2C_ISR_TCR                 (1UL << 7)
+#define I2C_ISR_BERR                (1UL << 8)
+#define I2C_ISR_ARLO                (1UL << 9)
+#define I2C_ISR_OVR                 (1UL << 10)
+#define I2C_ISR_BUSY                (1UL << 15)
+
+#define I2C_ICR_NACKCF              I2C_ISR_NACKF
+#define I2C_ICR_STOPCF              I2C_ISR_STOPF
+#define I2C_ICR_BERRCF              I2C_ISR_BERR
+#define I2C_ICR_ARLOCF              I2C_ISR_ARLO
+#define I2C_ICR_OVRCF               I2C_ISR_OVR
+
+#define LL_I2C_ADDRSLAVE_7BIT       0x00000000U
+#define LL_I2C_MODE_RELOAD          I2C_CR2_RELOAD
+#define LL_I2C_MODE_AUTOEND         I2C_CR2_AUTOEND
+#define LL_I2C_MODE_SOFTEND         0x00000000U
+
+#define LL_I2C_GENERATE_NOSTARTSTOP         0x00000000U
+#define LL_I2C_GENERATE_STOP                (0x80000000U | I2C_CR2_STOP)
+#define LL_I2C_GENERATE_START_READ          (0x80000000U | I2C_CR2_START | I2C_CR2_RD_WRN)
+#define LL_I2C_GENERATE_START_WRITE         (0x80000000U | I2C_CR2_START)
+#define LL_I2C_GENERATE_RESTART_7BIT_READ   (0x80000000U | I2C_CR2_START | I2C_CR2_RD_WRN)
+#define LL_I2C_GENERATE_RESTART_7BIT_WRITE  (0x80000000U | I2C_CR2_START)
+
+#define LL_I2C_ReadReg(I2Cx, REG)   host_i2c_read_reg(I2Cx, HOST_I2C_##REG)
+#define LL_I2C_WriteReg(I2Cx, REG, VALUE) \
+        host_i2c_write_reg(I2Cx, HOST_I2C_##REG, VALUE)
+
+static inline void LL_I2C_HandleTransfer(I2C_TypeDef *I2Cx, uint32_t SlaveAddr,
+        uint32_t SlaveAddrSize, uint32_t TransferSize, uint32_t EndMode,
+        uint32_t Request) {
+    uint32_t val = ((SlaveAddr & I2C_CR2_SADD) |
+            (SlaveAddrSize & I2C_CR2_ADD10) |
+            ((TransferSize << I2C_CR2_NBYTES_Pos) & I2C_CR2_NBYTES) |
+            EndMode | Request) & ~0x80000000U;
+    host_i2c_modify_reg(I2Cx, HOST_I2C_CR2, I2C_CR2_SADD | I2C_CR2_ADD10 |
+            I2C_CR2_RD_WRN | I2C_CR2_START | I2C_CR2_STOP | I2C_CR2_NBYTES |
+            I2C_CR2_RELOAD | I2C_CR2_AUTOEND, val);
+}
+
+static inline void LL_I2C_SetTransferSize(I2C_TypeDef *I2Cx,
+        uint32_t TransferSize) {
+    host_i2c_modify_reg(I2Cx, HOST_I2C_CR2, I2C_CR2_NBYTES,
+            TransferSize << I2C_CR2_NBYTES_Pos);
+}
+
+static inline void LL_I2C_EnableReloadMode(I2C_TypeDef *I2Cx) {
+    host_i2c_modify_reg(I2Cx, HOST_I2C_CR2, 0, I2C_CR2_RELOAD);
+}
+
+static inline void LL_I2C_DisableReloadMode(I2C_TypeDef *I2Cx) {
+    host_i2c_modify_reg(I2Cx, HOST_I2C_CR2, I2C_CR2_RELOAD, 0);
+}
+
+static inline void LL_I2C_GenerateStopCondition(I2C_TypeDef *I2Cx) {
+    host_i2c_modify_reg(I2Cx, HOST_I2C_CR2, 0, I2C_CR2_STOP);
+}
+
+static inline void LL_I2C_TransmitData8(I2C_TypeDef *I2Cx, uint8_t Data) {
+    host_i2c_write_reg(I2Cx, HOST_I2C_TXDR, Data);
+}
+
+static inline uint8_t LL_I2C_ReceiveData8(I2C_TypeDef *I2Cx) {
+    return (uint8_t)host_i2c_read_reg(I2Cx, HOST_I2C_RXDR);
+}
+
+static inline void LL_I2C_Enable(I2C_TypeDef *I2Cx) {
+    host_i2c_modify_reg(I2Cx, HOST_I2C_CR1, 0, I2C_CR1_PE);
+}
+
+static inline void LL_I2C_Disable(I2C_TypeDef *I2Cx) {
+    host_i2c_modify_reg(I2Cx, HOST_I2C_CR1, I2C_CR1_PE, 0);
+}
+
+static inline uint32_t LL_I2C_IsEnabled(I2C_TypeDef *I2Cx) {
+    return !!(host_i2c_read_reg(I2Cx, HOST_I2C_CR1) & I2C_CR1_PE);
+}
+
+#define HOST_I2C_IT(name, bit) \
+    static inline void LL_I2C_EnableIT_##name(I2C_TypeDef *I2Cx) { \
+        host_i2c_modify_reg(I2Cx, HOST_I2C_CR1, 0, bit); \
+    } \
+    static inline void LL_I2C_DisableIT_##name(I2C_TypeDef *I2Cx) { \
+        host_i2c_modify_reg(I2Cx, HOST_I2C_CR1, bit, 0); \
+    }
+
+HOST_I2C_IT(TX, I2C_CR1_TXIE)
+HOST_I2C_IT(RX, I2C_CR1_RXIE)
+HOST_I2C_IT(NACK, I2C_CR1_NACKIE)
+HOST_I2C_IT(STOP, I2C_CR1_STOPIE)
+HOST_I2C_IT(TC, I2C_CR1_TCIE)
+HOST_I2C_IT(ERR, I2C_CR1_ERRIE)
+
+#define HOST_I2C_FLAG(name, bit) \
+    static inline uint32_t LL_I2C_IsActiveFlag_##name(I2C_TypeDef *I2Cx) { \
+        return !!(host_i2c_read_reg(I2Cx, HOST_I2C_ISR) & bit); \
+    }
+
+HOST_I2C_FLAG(TXE, I2C_ISR_TXE)
+HOST_I2C_FLAG(TXIS, I2C_ISR_TXIS)
+HOST_I2C_FLAG(RXNE, I2C_ISR_RXNE)
+HOST_I2C_FLAG(NACK, I2C_ISR_NACKF)
+HOST_I2C_FLAG(STOP, I2C_ISR_STOPF)
+HOST_I2C_FLAG(TC, I2C_ISR_TC)
+HOST_I2C_FLAG(TCR, I2C_ISR_TCR)
+HOST_I2C_FLAG(BERR, I2C_ISR_BERR)
+HOST_I2C_FLAG(ARLO, I2C_ISR_ARLO)
+HOST_I2C_FLAG(OVR, I2C_ISR_OVR)
+HOST_I2C_FLAG(BUSY, I2C_ISR_BUSY)
+
+#define HOST_I2C_CLEAR(name, bit) \
+    static inline void LL_I2C_ClearFlag_##name(I2C_TypeDef *I2Cx) { \
+        host_i2c_write_reg(I2Cx, HOST_I2C_ICR, bit); \
+    }
+
+HOST_I2C_CLEAR(NACK, I2C_ICR_NACKCF)
+HOST_I2C_CLEAR(STOP, I2C_ICR_STOPCF)
+HOST_I2C_CLEAR(BERR, I2C_ICR_BERRCF)
+HOST_I2C_CLEAR(ARLO, I2C_ICR_ARLOCF)
+HOST_I2C_CLEAR(OVR, I2C_ICR_OVRCF)
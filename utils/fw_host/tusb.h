@@ -0,0 +1,132 @@
+//
+// Glider firmware host port
+// Copyright 2025 Wenting Zhang
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+// TinyUSB device API stand-in, the subset used by usbapp.c and usbbulk.c.
+// Reports and transfers are carried over a UNIX socket by host_tusb.c.
+//
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+// Same as fw/User/tusb_config.h
+#define CFG_TUD_HID_EP_BUFSIZE      64
+#define CFG_TUD_ENDPOINT0_SIZE      64
+#define CFG_TUSB_MEM_ALIGN          __attribute__((aligned(4)))
+#define BOARD_TUD_RHPORT            0
+
+#define TUSB_CLASS_VENDOR_SPECIFIC  0xff
+#define TUSB_DESC_INTERFACE         0x04
+#define TUSB_DESC_ENDPOINT          0x05
+#define TUSB_DIR_IN_MASK            0x80
+
+typedef enum {
+    TUSB_XFER_CONTROL = 0,
+    TUSB_XFER_ISOCHRONOUS,
+    TUSB_XFER_BULK,
+    TUSB_XFER_INTERRUPT
+} tusb_xfer_type_t;
+
+typedef enum {
+    XFER_RESULT_SUCCESS = 0,
+    XFER_RESULT_FAILED,
+    XFER_RESULT_STALLED,
+    XFER_RESULT_TIMEOUT
+} xfer_result_t;
+
+typedef enum {
+    HID_REPORT_TYPE_INVALID = 0,
+    HID_REPORT_TYPE_INPUT,
+    HID_REPORT_TYPE_OUTPUT,
+    HID_REPORT_TYPE_FEATURE
+} hid_report_type_t;
+
+typedef enum {
+    TUSB_ROLE_INVALID = 0,
+    TUSB_ROLE_DEVICE,
+    TUSB_ROLE_HOST
+} tusb_role_t;
+
+typedef enum {
+    TUSB_SPEED_FULL = 0,
+    TUSB_SPEED_LOW,
+    TUSB_SPEED_HIGH,
+    TUSB_SPEED_AUTO = 0xff
+} tusb_speed_t;
+
+typedef struct {
+    tusb_role_t role;
+    tusb_speed_t speed;
+} tusb_rhport_init_t;
+
+typedef struct __attribute__((packed)) {
+    uint8_t bLength;
+    uint8_t bDescriptorType;
+    uint8_t bInterfaceNumber;
+    uint8_t bAlternateSetting;
+    uint8_t bNumEndpoints;
+    uint8_t bInterfaceClass;
+    uint8_t bInterfaceSubClass;
+    uint8_t bInterfaceProtocol;
+    uint8_t iInterface;
+} tusb_desc_interface_t;
+
+typedef struct __attribute__((packed)) {
+    uint8_t bLength;
+    uint8_t bDescriptorType;
+    uint8_t bEndpointAddress;
+    uint8_t bmAttributes;
+    uint16_t wMaxPacketSize;
+    uint8_t bInterval;
+} tusb_desc_endpoint_t;
+
+typedef struct __attribute__((packed)) {
+    uint8_t bmRequestType;
+    uint8_t bRequest;
+    uint16_t wValue;
+    uint16_t wIndex;
+    uint16_t wLength;
+} tusb_control_request_t;
+
+static inline uint8_t const *tu_desc_next(void const *desc) {
+    uint8_t const *p = (uint8_t const *)desc;
+    return p + p[0];
+}
+
+bool tusb_init(uint8_t rhport, const tusb_rhport_init_t *init);
+void tud_task(void);
+bool tud_mounted(void);
+
+bool tud_hid_report(uint8_t report_id, void const *report, uint16_t len);
+
+uint32_t tud_cdc_available(void);
+int32_t tud_cdc_read_char(void);
+uint32_t tud_cdc_write_char(char ch);
+uint32_t tud_cdc_write_flush(void);
+
+// Application callbacks
+void tud_hid_set_report_cb(uint8_t instance, uint8_t report_id,
+        hid_report_type_t report_type, uint8_t const *buffer, uint16_t bufsize);
+void tud_hid_report_complete_cb(uint8_t instance, uint8_t const *report,
+        uint16_t len);
+void tud_cdc_rx_cb(uint8_t itf);
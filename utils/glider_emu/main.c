@@ -0,0 +1,163 @@
+//
+// Glider device emulator
+// Copyright 2025 Wenting Zhang
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+// Runs the USB side of the firmware on a Linux host: the usbapp.c and
+// usbbulk.c handlers, the caster command queue on top of the FPGA register
+// model, SPIFFS in RAM, and the shell. Host tools connect to the UNIX
+// socket (see ../fw_host/host_tusb.h) instead of the HID device, and to
+// the printed pty instead of the CDC serial port.
+//
+#include <signal.h>
+#include <unistd.h>
+#include "platform.h"
+#include "board.h"
+#include "app.h"
+#include "host_hal.h"
+#include "host_spiffs.h"
+#include "host_tusb.h"
+#include "fpga_model.h"
+
+TaskHandle_t housekeeping_task_handle;
+TaskHandle_t startup_task_handle;
+TaskHandle_t idle_task_handle;
+TaskHandle_t usb_device_task_handle;
+TaskHandle_t usb_bulk_task_handle;
+TaskHandle_t usb_pd_task_handle;
+TaskHandle_t ui_task_handle;
+TaskHandle_t caster_task_handle;
+TaskHandle_t key_scan_task_handle;
+TaskHandle_t power_mon_task_handle;
+
+static fpga_model_t fpga;
+static shell_context_t shell;
+
+static portTASK_FUNCTION(shell_task, pvParameters) {
+    shell_init(&shell, usbapp_term_out, usbapp_term_in, SHELL_MODE_BLOCKING,
+            NULL);
+    while (1) {
+        shell_start(&shell);
+    }
+}
+
+static void print_usage(const char *name) {
+    fprintf(stderr, "Usage: %s [options]\n"
+            "  -s path        UNIX socket to listen on (default /tmp/glider.sock)\n"
+            "  -f host:name   Copy a host file into SPIFFS before starting,\n"
+            "                 may be repeated\n"
+            "  -F us          Panel frame time, default from the config. A\n"
+            "                 region op takes a whole waveform, shorten this to\n"
+            "                 keep the FPGA out of USB measurements\n"
+            "  -h             Show this help\n"
+            "Service times are printed on SIGUSR1 and on exit.\n", name);
+}
+
+int main(int argc, char *argv[]) {
+    const char *socket_path = "/tmp/glider.sock";
+    const char *imports[16];
+    int nimports = 0;
+    uint32_t frame_us = 0;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "s:f:F:h")) != -1) {
+        switch (opt) {
+        case 's':
+            socket_path = optarg;
+            break;
+        case 'f':
+            if (nimports < 16)
+                imports[nimports++] = optarg;
+            break;
+        case 'F':
+            frame_us = atoi(optarg);
+            break;
+        default:
+            print_usage(argv[0]);
+            return 1;
+        }
+    }
+
+    // Handled by sigwait() below, block before any thread is created
+    sigset_t sigs;
+    sigemptyset(&sigs);
+    sigaddset(&sigs, SIGINT);
+    sigaddset(&sigs, SIGTERM);
+    sigaddset(&sigs, SIGUSR1);
+    pthread_sigmask(SIG_BLOCK, &sigs, NULL);
+
+    host_init();
+    syslog_init();
+    config_init();
+    spiffs_init();
+    for (int i = 0; i < nimports; i++) {
+        char host_path[256];
+        const char *sep = strchr(imports[i], ':');
+        if (!sep || (sep - imports[i] >= (int)sizeof(host_path))) {
+            print_usage(argv[0]);
+            return 1;
+        }
+        memcpy(host_path, imports[i], sep - imports[i]);
+        host_path[sep - imports[i]] = '\0';
+        if (host_spiffs_import(host_path, sep + 1) < 0) {
+            fprintf(stderr, "Failed to import %s\n", host_path);
+            return 1;
+        }
+    }
+    config_load();
+    waveform_init(WAVEFORM_FILE);
+
+    fpga_model_init(&fpga, config.pclk_hz / 4);
+    caster_init();
+    if (frame_us)
+        fpga.clk_hz = (uint64_t)fpga_model_h_total(&fpga) *
+                fpga_model_v_total(&fpga) * 1000000ull / frame_us;
+    fpga_model_set_realtime(&fpga, true);
+    caster_queue_init();
+    region_init();
+    usbbulk_init();
+
+    const char *pty = host_tusb_open_pty();
+    host_tusb_set_socket(socket_path);
+
+    xTaskCreate(caster_task, "CasterTask", CASTER_TASK_STACK_SIZE,
+        NULL, CASTER_TASK_PRIORITY, &caster_task_handle);
+    xTaskCreate(usbbulk_task, "USBBulkTask", USB_BULK_TASK_STACK_SIZE,
+        NULL, USB_BULK_TASK_PRIORITY, &usb_bulk_task_handle);
+    xTaskCreate(usb_device_task, "USBDeviceTask", USB_DEVICE_TASK_STACK_SIZE,
+        NULL, USB_DEVICE_TASK_PRIORITY, &usb_device_task_handle);
+    xTaskCreate(shell_task, "StartupTask", STARTUP_TASK_STACK_SIZE,
+        NULL, STARTUP_TASK_LOW_PRIORITY, &startup_task_handle);
+
+    printf("HID and bulk on %s\n", socket_path);
+    printf("Shell on %s\n", pty ? pty : "(no pty)");
+    fflush(stdout);
+
+    while (1) {
+        int sig;
+        sigwait(&sigs, &sig);
+        host_tusb_print_stats(stdout);
+        fflush(stdout);
+        if (sig != SIGUSR1)
+            break;
+    }
+    unlink(socket_path);
+    return 0;
+}
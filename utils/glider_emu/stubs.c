@@ -0,0 +1,79 @@
+//
+// Glider device emulator
+// Copyright 2025 Wenting Zhang
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+// Parts of the board the emulator doesn't model. The shell commands using
+// them still run, and see an idle board with nothing on the I2C bus.
+//
+#include "platform.h"
+#include "app.h"
+#include "pal_i2c.h"
+
+struct pal_i2c_t {
+    int unused;
+};
+
+pal_i2c_t pi2c1;
+
+static float vcom_set;
+static float vgh_set;
+
+bool pal_i2c_ping(pal_i2c_t *i2c, uint8_t addr) {
+    return false;
+}
+
+void power_set_vcom(float vcom) {
+    vcom_set = vcom;
+}
+
+void power_set_vgh(float vgh) {
+    vgh_set = vgh;
+}
+
+float power_get_rail_voltage(power_rail_t rail) {
+    switch (rail) {
+    case RAIL_VCOM: return vcom_set;
+    case RAIL_VGH: return vgh_set;
+    case RAIL_3V3:
+    case RAIL_3V3VID: return 3.3f;
+    case RAIL_VBUS:
+    case RAIL_5VES:
+    case RAIL_5VEG: return 5.0f;
+    default: return 0.0f;
+    }
+}
+
+float power_get_rail_current(power_rail_t rail) {
+    return 0.0f;
+}
+
+void power_get_rail_power(power_rail_t rail, float *cur, float *avg,
+        float *max) {
+    *cur = *avg = *max = 0.0f;
+}
+
+// No ui task, there is no panel or buttons
+void ui_set_health_period(uint32_t ms) {
+}
+
+void ui_get_stats(ui_stats_t *stats) {
+    memset(stats, 0, sizeof(ui_stats_t));
+}
@@ -0,0 +1,404 @@
+//
+// libdither, Caster dithering reference
+// Copyright 2025 Wenting Zhang
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#include <stdlib.h>
+#include <string.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define HAVE_AVX2
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#include "dither.h"
+
+// Threshold rows are stored 64 pixels wide, so a vector load at any x that
+// is a multiple of the vector width stays inside the row
+#define ROW_SIZE        DITHER_BLUE_NOISE_SIZE
+#define ROW_MASK        (ROW_SIZE - 1)
+// Quantizer input range for error diffusion, the diffused error keeps the
+// value within a few levels of 0-255
+#define QUANT_OFFSET    512
+#define QUANT_SIZE      1024
+
+typedef void (*gt_row_fn)(const uint8_t *src, const uint8_t *thr,
+        uint8_t *dst, int width);
+
+static const uint8_t bayer4[4][4] = {
+    { 0,  8,  2, 10},
+    {12,  4, 14,  6},
+    { 3, 11,  1,  9},
+    {15,  7, 13,  5}
+};
+
+static bool initialized;
+static dither_simd_t simd_best;
+static dither_simd_t simd_level;
+static uint8_t mid_row[ROW_SIZE];
+static uint8_t bayer_rows[4][ROW_SIZE];
+static uint8_t blue_noise[DITHER_BLUE_NOISE_SIZE][ROW_SIZE];
+static uint8_t quant[QUANT_SIZE];
+
+// Stand-in for the blue noise texture in the bitstream: interleaved
+// gradient noise, which has a similar high frequency spectrum
+static uint8_t blue_noise_at(int x, int y) {
+    float f = 52.9829189f * ((0.06711056f * (x & 63) + 0.00583715f * (y & 63)) -
+            (int)(0.06711056f * (x & 63) + 0.00583715f * (y & 63)));
+    f = f - (int)f;
+    return (uint8_t)(f * 255.0f);
+}
+
+static int clampi(int x, int lo, int hi) {
+    return (x < lo) ? lo : (x > hi) ? hi : x;
+}
+
+void dither_init(void) {
+    if (initialized)
+        return;
+    memset(mid_row, 127, sizeof(mid_row));
+    for (int y = 0; y < 4; y++)
+        for (int x = 0; x < ROW_SIZE; x++)
+            bayer_rows[y][x] = bayer4[y][x & 3] * 16 + 8;
+    for (int y = 0; y < DITHER_BLUE_NOISE_SIZE; y++)
+        for (int x = 0; x < ROW_SIZE; x++)
+            blue_noise[y][x] = blue_noise_at(x, y);
+    for (int i = 0; i < QUANT_SIZE; i++)
+        quant[i] = clampi((i - QUANT_OFFSET + 8) / 17, 0, 15);
+    simd_best = DITHER_SIMD_NONE;
+#ifdef __SSE2__
+    simd_best = DITHER_SIMD_SSE2;
+#endif
+#ifdef HAVE_AVX2
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+        simd_best = DITHER_SIMD_AVX2;
+#endif
+    simd_level = simd_best;
+    initialized = true;
+}
+
+dither_simd_t dither_set_simd(dither_simd_t simd) {
+    simd_level = (simd > simd_best) ? simd_best : simd;
+    return simd_level;
+}
+
+dither_simd_t dither_get_simd(void) {
+    return simd_level;
+}
+
+const char *dither_simd_name(dither_simd_t simd) {
+    static const char *names[] = { "C", "SSE2", "AVX2" };
+    return names[simd];
+}
+
+const uint8_t *dither_blue_noise_texture(void) {
+    return &blue_noise[0][0];
+}
+
+// dst = src > thr, the threshold row repeats every 64 pixels
+static void gt_row_c(const uint8_t *src, const uint8_t *thr, uint8_t *dst,
+        int width) {
+    for (int x = 0; x < width; x++)
+        dst[x] = src[x] > thr[x & ROW_MASK];
+}
+
+#ifdef __SSE2__
+static void gt_row_sse2(const uint8_t *src, const uint8_t *thr, uint8_t *dst,
+        int width) {
+    const __m128i one = _mm_set1_epi8(1);
+    int x = 0;
+    for (; x + 16 <= width; x += 16) {
+        __m128i s = _mm_loadu_si128((const __m128i *)(src + x));
+        __m128i t = _mm_loadu_si128((const __m128i *)(thr + (x & ROW_MASK)));
+        // Saturating subtract is non zero only when src > thr
+        _mm_storeu_si128((__m128i *)(dst + x),
+                _mm_min_epu8(_mm_subs_epu8(s, t), one));
+    }
+    gt_row_c(src + x, thr + (x & ROW_MASK), dst + x, width - x);
+}
+#endif
+
+#ifdef HAVE_AVX2
+TARGET_AVX2
+static void gt_row_avx2(const uint8_t *src, const uint8_t *thr, uint8_t *dst,
+        int width) {
+    const __m256i one = _mm256_set1_epi8(1);
+    int x = 0;
+    for (; x + 32 <= width; x += 32) {
+        __m256i s = _mm256_loadu_si256((const __m256i *)(src + x));
+        __m256i t = _mm256_loadu_si256(
+                (const __m256i *)(thr + (x & ROW_MASK)));
+        _mm256_storeu_si256((__m256i *)(dst + x),
+                _mm256_min_epu8(_mm256_subs_epu8(s, t), one));
+    }
+    gt_row_c(src + x, thr + (x & ROW_MASK), dst + x, width - x);
+}
+#endif
+
+static gt_row_fn gt_row(void) {
+#ifdef HAVE_AVX2
+    if (simd_level == DITHER_SIMD_AVX2)
+        return gt_row_avx2;
+#endif
+#ifdef __SSE2__
+    if (simd_level >= DITHER_SIMD_SSE2)
+        return gt_row_sse2;
+#endif
+    return gt_row_c;
+}
+
+void dither_threshold(const uint8_t *src, uint8_t *dst, int width, int height,
+        int stride) {
+    gt_row_fn fn = gt_row();
+    for (int y = 0; y < height; y++)
+        fn(src + y * stride, mid_row, dst + y * stride, width);
+}
+
+void dither_bayer(const uint8_t *src, uint8_t *dst, int width, int height,
+        int stride) {
+    gt_row_fn fn = gt_row();
+    for (int y = 0; y < height; y++)
+        fn(src + y * stride, bayer_rows[y & 3], dst + y * stride, width);
+}
+
+void dither_blue_noise(const uint8_t *src, uint8_t *dst, int width,
+        int height, int stride) {
+    gt_row_fn fn = gt_row();
+    for (int y = 0; y < height; y++)
+        fn(src + y * stride, blue_noise[y & (DITHER_BLUE_NOISE_SIZE - 1)],
+                dst + y * stride, width);
+}
+
+static void shr4_row_c(const uint8_t *src, uint8_t *dst, int width) {
+    for (int x = 0; x < width; x++)
+        dst[x] = src[x] >> 4;
+}
+
+static void shr4_row(const uint8_t *src, uint8_t *dst, int width) {
+    int x = 0;
+#ifdef __SSE2__
+    if (simd_level >= DITHER_SIMD_SSE2) {
+        const __m128i mask = _mm_set1_epi8(0x0f);
+        for (; x + 16 <= width; x += 16) {
+            __m128i s = _mm_loadu_si128((const __m128i *)(src + x));
+            _mm_storeu_si128((__m128i *)(dst + x),
+                    _mm_and_si128(_mm_srli_epi16(s, 4), mask));
+        }
+    }
+#endif
+    shr4_row_c(src + x, dst + x, width - x);
+}
+
+void dither_quantize4(const uint8_t *src, uint8_t *dst, int width, int height,
+        int stride) {
+    for (int y = 0; y < height; y++)
+        shr4_row(src + y * stride, dst + y * stride, width);
+}
+
+// Floyd-Steinberg down to 16 levels. The error buffers are offset by one so
+// x - 1 and x + 1 never go out of bounds. The error going right and down is
+// kept in registers and every nxt entry is written once, which gives the
+// same sums as adding each share in turn. With a mode row, only pixels in an
+// error diffusion mode are dithered, the rest diffuse no error and their
+// output is left as is.
+static inline void ed_row_common(const uint8_t *src, const uint8_t *mode,
+        uint8_t *dst, const int16_t *cur, int16_t *nxt, int width) {
+    int right = 0;          // e[x - 1] * 7
+    int e1 = 0;             // e[x - 1]
+    int e2 = 0;             // e[x - 2]
+    for (int x = 0; x < width; x++) {
+        int e = 0;
+        if (!mode || (mode[x] == DITHER_UM_MANUAL_LUT_ERROR_DIFFUSION) ||
+                (mode[x] == DITHER_UM_AUTO_LUT_ERROR_DIFFUSION)) {
+            int v = src[x] + (cur[x + 1] + right) / 16;
+            int q = quant[v + QUANT_OFFSET];
+            e = v - q * 17;
+            dst[x] = q;
+        }
+        nxt[x] = e2 + e1 * 5 + e * 3;
+        right = e * 7;
+        e2 = e1;
+        e1 = e;
+    }
+    nxt[width] = e2 + e1 * 5;
+    nxt[width + 1] = e1;
+}
+
+static void ed_row(const uint8_t *src, uint8_t *dst, const int16_t *cur,
+        int16_t *nxt, int width) {
+    ed_row_common(src, NULL, dst, cur, nxt, width);
+}
+
+static void ed_row_masked(const uint8_t *src, const uint8_t *mode,
+        uint8_t *dst, const int16_t *cur, int16_t *nxt, int width) {
+    ed_row_common(src, mode, dst, cur, nxt, width);
+}
+
+void dither_error_diffusion(const uint8_t *src, uint8_t *dst, int width,
+        int height, int stride) {
+    int16_t *cur = calloc(width + 2, sizeof(int16_t));
+    int16_t *nxt = calloc(width + 2, sizeof(int16_t));
+    for (int y = 0; y < height; y++) {
+        ed_row(src + y * stride, dst + y * stride, cur, nxt, width);
+        int16_t *t = cur;
+        cur = nxt;
+        nxt = t;
+    }
+    free(cur);
+    free(nxt);
+}
+
+// Mode mux for the 1 bit output, and the undithered 4 bit output. Returns
+// true if any pixel in the row uses error diffusion.
+static bool stage2_row_c(const uint8_t *src, const uint8_t *mode,
+        const uint8_t *bayer, const uint8_t *bn, uint8_t *out1, uint8_t *out4,
+        int width) {
+    bool ed = false;
+    for (int x = 0; x < width; x++) {
+        uint8_t t;
+        switch (mode[x]) {
+        case DITHER_UM_FAST_MONO_BAYER:
+            t = bayer[x & ROW_MASK];
+            break;
+        case DITHER_UM_FAST_MONO_BLUE_NOISE:
+            t = bn[x & ROW_MASK];
+            break;
+        case DITHER_UM_MANUAL_LUT_ERROR_DIFFUSION:
+        case DITHER_UM_AUTO_LUT_ERROR_DIFFUSION:
+            ed = true;
+            // fall through
+        default:
+            t = 127;
+            break;
+        }
+        out1[x] = src[x] > t;
+        out4[x] = src[x] >> 4;
+    }
+    return ed;
+}
+
+#ifdef __SSE2__
+static bool stage2_row_sse2(const uint8_t *src, const uint8_t *mode,
+        const uint8_t *bayer, const uint8_t *bn, uint8_t *out1, uint8_t *out4,
+        int width) {
+    const __m128i one = _mm_set1_epi8(1);
+    const __m128i mid = _mm_set1_epi8(127);
+    const __m128i nibble = _mm_set1_epi8(0x0f);
+    const __m128i m_bayer = _mm_set1_epi8(DITHER_UM_FAST_MONO_BAYER);
+    const __m128i m_bn = _mm_set1_epi8(DITHER_UM_FAST_MONO_BLUE_NOISE);
+    const __m128i m_ed1 = _mm_set1_epi8(DITHER_UM_MANUAL_LUT_ERROR_DIFFUSION);
+    const __m128i m_ed2 = _mm_set1_epi8(DITHER_UM_AUTO_LUT_ERROR_DIFFUSION);
+    __m128i ed = _mm_setzero_si128();
+    int x = 0;
+    for (; x + 16 <= width; x += 16) {
+        __m128i s = _mm_loadu_si128((const __m128i *)(src + x));
+        __m128i m = _mm_loadu_si128((const __m128i *)(mode + x));
+        __m128i tb = _mm_loadu_si128((const __m128i *)(bayer + (x & ROW_MASK)));
+        __m128i tn = _mm_loadu_si128((const __m128i *)(bn + (x & ROW_MASK)));
+        __m128i is_b = _mm_cmpeq_epi8(m, m_bayer);
+        __m128i is_n = _mm_cmpeq_epi8(m, m_bn);
+        __m128i t = _mm_or_si128(
+                _mm_or_si128(_mm_and_si128(is_b, tb), _mm_and_si128(is_n, tn)),
+                _mm_andnot_si128(_mm_or_si128(is_b, is_n), mid));
+        ed = _mm_or_si128(ed, _mm_or_si128(_mm_cmpeq_epi8(m, m_ed1),
+                _mm_cmpeq_epi8(m, m_ed2)));
+        _mm_storeu_si128((__m128i *)(out1 + x),
+                _mm_min_epu8(_mm_subs_epu8(s, t), one));
+        _mm_storeu_si128((__m128i *)(out4 + x),
+                _mm_and_si128(_mm_srli_epi16(s, 4), nibble));
+    }
+    bool tail = stage2_row_c(src + x, mode + x, bayer + (x & ROW_MASK),
+            bn + (x & ROW_MASK), out1 + x, out4 + x, width - x);
+    return tail || _mm_movemask_epi8(ed);
+}
+#endif
+
+#ifdef HAVE_AVX2
+TARGET_AVX2
+static bool stage2_row_avx2(const uint8_t *src, const uint8_t *mode,
+        const uint8_t *bayer, const uint8_t *bn, uint8_t *out1, uint8_t *out4,
+        int width) {
+    const __m256i one = _mm256_set1_epi8(1);
+    const __m256i mid = _mm256_set1_epi8(127);
+    const __m256i nibble = _mm256_set1_epi8(0x0f);
+    const __m256i m_bayer = _mm256_set1_epi8(DITHER_UM_FAST_MONO_BAYER);
+    const __m256i m_bn = _mm256_set1_epi8(DITHER_UM_FAST_MONO_BLUE_NOISE);
+    const __m256i m_ed1 =
+            _mm256_set1_epi8(DITHER_UM_MANUAL_LUT_ERROR_DIFFUSION);
+    const __m256i m_ed2 = _mm256_set1_epi8(DITHER_UM_AUTO_LUT_ERROR_DIFFUSION);
+    __m256i ed = _mm256_setzero_si256();
+    int x = 0;
+    for (; x + 32 <= width; x += 32) {
+        __m256i s = _mm256_loadu_si256((const __m256i *)(src + x));
+        __m256i m = _mm256_loadu_si256((const __m256i *)(mode + x));
+        __m256i tb = _mm256_loadu_si256(
+                (const __m256i *)(bayer + (x & ROW_MASK)));
+        __m256i tn = _mm256_loadu_si256(
+                (const __m256i *)(bn + (x & ROW_MASK)));
+        __m256i t = _mm256_blendv_epi8(mid, tb, _mm256_cmpeq_epi8(m, m_bayer));
+        t = _mm256_blendv_epi8(t, tn, _mm256_cmpeq_epi8(m, m_bn));
+        ed = _mm256_or_si256(ed, _mm256_or_si256(_mm256_cmpeq_epi8(m, m_ed1),
+                _mm256_cmpeq_epi8(m, m_ed2)));
+        _mm256_storeu_si256((__m256i *)(out1 + x),
+                _mm256_min_epu8(_mm256_subs_epu8(s, t), one));
+        _mm256_storeu_si256((__m256i *)(out4 + x),
+                _mm256_and_si256(_mm256_srli_epi16(s, 4), nibble));
+    }
+    bool tail = stage2_row_c(src + x, mode + x, bayer + (x & ROW_MASK),
+            bn + (x & ROW_MASK), out1 + x, out4 + x, width - x);
+    return tail || _mm256_movemask_epi8(ed);
+}
+#endif
+
+void dither_stage2(const uint8_t *src, const uint8_t *mode, uint8_t *out1,
+        uint8_t *out4, int width, int height, int stride) {
+    bool (*row_fn)(const uint8_t *, const uint8_t *, const uint8_t *,
+            const uint8_t *, uint8_t *, uint8_t *, int) = stage2_row_c;
+#ifdef __SSE2__
+    if (simd_level >= DITHER_SIMD_SSE2)
+        row_fn = stage2_row_sse2;
+#endif
+#ifdef HAVE_AVX2
+    if (simd_level == DITHER_SIMD_AVX2)
+        row_fn = stage2_row_avx2;
+#endif
+    int16_t *cur = calloc(width + 2, sizeof(int16_t));
+    int16_t *nxt = calloc(width + 2, sizeof(int16_t));
+    for (int y = 0; y < height; y++) {
+        const uint8_t *s = src + y * stride;
+        const uint8_t *m = mode + y * stride;
+        uint8_t *o4 = out4 + y * stride;
+        bool ed = row_fn(s, m, bayer_rows[y & 3],
+                blue_noise[y & (DITHER_BLUE_NOISE_SIZE - 1)],
+                out1 + y * stride, o4, width);
+        if (ed)
+            ed_row_masked(s, m, o4, cur, nxt, width);
+        else
+            memset(nxt, 0, (width + 2) * sizeof(int16_t));
+        int16_t *t = cur;
+        cur = nxt;
+        nxt = t;
+    }
+    free(cur);
+    free(nxt);
+}
@@ -0,0 +1,193 @@
+//
+// libdither, Caster dithering reference
+// Copyright 2025 Wenting Zhang
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+//
+// Software version of stage 2 of the Caster pixel pipeline, which dithers
+// the 8 bit input down to 1 bit for the fast mono modes and to 4 bit for
+// the LUT modes. Output is one byte per pixel, 0/1 or 0-15, and matches the
+// pipeline model in caster_sim bit for bit, so it can be used to pre-render
+// content on the host or to check gateware changes against.
+//
+// Ordered dithering and thresholding use SSE2 or AVX2 where available,
+// selected at dither_init() time. Error diffusion is serial within a row
+// and always runs in C.
+//
+// dither_ed() is a more general error diffusion for pre-rendering: any
+// kernel, 2 to 16 levels, optionally in linear light, and split over a
+// thread pool. Rows run as a wavefront, each row trails the rows it takes
+// error from by the kernel reach, so the output is the same for any number
+// of threads. With dither_kernel_floyd_steinberg and dither_quant_init(q,
+// 16, false) it matches dither_error_diffusion().
+//
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Update modes handled by dither_stage2(), same values as update_mode_t in
+// fw/User/caster.h
+#define DITHER_UM_MANUAL_LUT_ERROR_DIFFUSION    1
+#define DITHER_UM_FAST_MONO_BAYER               3
+#define DITHER_UM_FAST_MONO_BLUE_NOISE          4
+#define DITHER_UM_AUTO_LUT_ERROR_DIFFUSION      7
+
+#define DITHER_BLUE_NOISE_SIZE  64
+#define DITHER_MAX_TAPS         12
+#define DITHER_MAX_LEVELS       16
+// Largest value in the error diffusion domain, linear light uses 12 bits
+#define DITHER_LINEAR_MAX       4095
+
+typedef enum {
+    DITHER_SIMD_NONE,
+    DITHER_SIMD_SSE2,
+    DITHER_SIMD_AVX2
+} dither_simd_t;
+
+// Error diffusion kernel, each tap receives weight / divisor of the error
+// of the pixel at (x, y). Taps on the same row must have dx from 1 to 4,
+// other rows dy up to 2 and dx from -8 to 8.
+typedef struct {
+    int8_t dx;
+    int8_t dy;
+    uint8_t weight;
+} dither_tap_t;
+
+typedef struct {
+    const char *name;
+    uint16_t divisor;
+    uint8_t count;
+    dither_tap_t taps[DITHER_MAX_TAPS];
+} dither_kernel_t;
+
+// Floyd-Steinberg, as used by the UM_*_ERROR_DIFFUSION modes
+extern const dither_kernel_t dither_kernel_floyd_steinberg;
+// Two row Sierra
+extern const dither_kernel_t dither_kernel_sierra2;
+// Floyd-Steinberg weights moved to the nearest pixel of the same colour, for
+// a colour filter array repeating every 3 pixels and shifted left by one
+// pixel on every row, so error is only diffused within one colour
+extern const dither_kernel_t dither_kernel_cfa;
+
+// Maps input to output levels. Input goes through to_linear, then a single
+// lookup gives both the nearest level and the error left to diffuse.
+typedef struct {
+    int16_t residual;
+    uint8_t level;
+} dither_qentry_t;
+
+typedef struct {
+    uint16_t to_linear[256];
+    uint16_t level[DITHER_MAX_LEVELS];  // Value of each output level
+    uint8_t levels;
+    uint16_t max;                       // Largest input or level value
+    // Nearest level for each input without dithering
+    uint8_t direct[256];
+    // For values from -(max + 1) to 2 * max + 1
+    dither_qentry_t lookup[3 * (DITHER_LINEAR_MAX + 1)];
+} dither_quant_t;
+
+// Packed quantizer tables, little endian:
+//   0   magic "GDQT"
+//   4   version, levels, 2 bytes reserved
+//   8   to_linear, 256 x uint16
+//   520 level, levels x uint16
+//   ... direct, 256 x uint8, the table an input LUT in the gateware would use
+// The lookup table is rebuilt when loading.
+#define DITHER_QUANT_MAGIC      "GDQT"
+#define DITHER_QUANT_VERSION    1
+#define DITHER_QUANT_PACKED_SIZE(levels) (8 + 512 + (levels) * 2 + 256)
+
+typedef struct dither_pool dither_pool_t;
+
+// Builds the blue noise texture and picks the best SIMD level, call once
+// before anything else
+void dither_init(void);
+// Limit the SIMD level, returns the level actually used
+dither_simd_t dither_set_simd(dither_simd_t simd);
+dither_simd_t dither_get_simd(void);
+const char *dither_simd_name(dither_simd_t simd);
+// 64x64 threshold texture used by UM_FAST_MONO_BLUE_NOISE
+const uint8_t *dither_blue_noise_texture(void);
+
+// All functions below take width x height pixels, with the same stride for
+// every plane. The pattern phase follows the x and y inside the image, pass
+// a full frame to match the panel.
+
+// 1 bit, UM_FAST_MONO_NO_DITHER
+void dither_threshold(const uint8_t *src, uint8_t *dst, int width, int height,
+        int stride);
+// 1 bit, UM_FAST_MONO_BAYER, 4x4 Bayer matrix
+void dither_bayer(const uint8_t *src, uint8_t *dst, int width, int height,
+        int stride);
+// 1 bit, UM_FAST_MONO_BLUE_NOISE
+void dither_blue_noise(const uint8_t *src, uint8_t *dst, int width,
+        int height, int stride);
+// 4 bit, the LUT modes without dithering
+void dither_quantize4(const uint8_t *src, uint8_t *dst, int width, int height,
+        int stride);
+// 4 bit, UM_*_LUT_ERROR_DIFFUSION, Floyd-Steinberg
+void dither_error_diffusion(const uint8_t *src, uint8_t *dst, int width,
+        int height, int stride);
+// Whole stage 2 with a per pixel update mode map, produces both the 1 bit
+// and the 4 bit result for every pixel. Error is only diffused between
+// pixels in an error diffusion mode.
+void dither_stage2(const uint8_t *src, const uint8_t *mode, uint8_t *out1,
+        uint8_t *out4, int width, int height, int stride);
+
+// Evenly spaced levels, on the 8 bit input as is, or in linear light with
+// the input taken as sRGB
+void dither_quant_init(dither_quant_t *q, int levels, bool linear_light);
+// Custom curve, to_linear and the level values in the same domain, both
+// increasing and at most DITHER_LINEAR_MAX. Returns false if invalid.
+bool dither_quant_init_custom(dither_quant_t *q, const uint16_t *to_linear,
+        const uint16_t *level, int levels);
+// From measured reflectance of each panel level, darkest first, in any
+// unit. The input is taken as sRGB, or a power law if gamma is not 0.
+// Returns false unless the values are increasing.
+bool dither_quant_init_measured(dither_quant_t *q, const double *reflectance,
+        int levels, double gamma);
+// Returns the packed size, nothing is written if len is too small
+size_t dither_quant_pack(const dither_quant_t *q, uint8_t *buf, size_t len);
+bool dither_quant_unpack(dither_quant_t *q, const uint8_t *buf, size_t len);
+// Nearest level without dithering, one lookup per pixel
+void dither_quantize(const dither_quant_t *q, const uint8_t *src,
+        uint8_t *dst, int width, int height, int stride);
+
+// Worker threads for dither_ed(), 0 for one per core
+dither_pool_t *dither_pool_create(int threads);
+void dither_pool_destroy(dither_pool_t *pool);
+int dither_pool_threads(dither_pool_t *pool);
+
+// Output is the level index, 0 to levels - 1. Runs on the calling thread
+// if pool is NULL. Returns false if the kernel is invalid or out of memory.
+bool dither_ed(const dither_kernel_t *kernel, const dither_quant_t *q,
+        const uint8_t *src, uint8_t *dst, int width, int height, int stride,
+        dither_pool_t *pool);
+
+#ifdef __cplusplus
+}
+#endif
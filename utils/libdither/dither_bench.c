@@ -0,0 +1,433 @@
+//
+// libdither, Caster dithering reference
+// Copyright 2025 Wenting Zhang
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+//
+// Throughput of the dithering kernels at every SIMD level, against the
+// 133 MP/s the gateware processes with dithering enabled. Every level is
+// checked against the C path, and the C path of dither_stage2() against a
+// straight per pixel copy of the stage 2 model in caster_sim. The input is
+// a synthetic test image (gradients, text and a photo-like pattern) or a
+// raw 8 bit greyscale frame.
+//
+// The second part runs dither_ed() serially and on 1 to N pool threads, and
+// checks every run against the serial output.
+//
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <math.h>
+#include <time.h>
+#include "dither.h"
+
+#define HW_DITHER_MPS   133.0
+
+typedef enum {
+    K_THRESHOLD,
+    K_BAYER,
+    K_BLUE_NOISE,
+    K_QUANTIZE4,
+    K_ERROR_DIFFUSION,
+    K_STAGE2,
+    K_COUNT
+} kernel_t;
+
+static const char *kernel_names[K_COUNT] = {
+    "threshold", "bayer", "blue noise", "quantize4", "error diffusion",
+    "stage2 mixed"
+};
+
+typedef struct {
+    int w;
+    int h;
+    const uint8_t *src;
+    const uint8_t *mode;
+    uint8_t *out1;
+    uint8_t *out4;
+} image_t;
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+static void make_image(uint8_t *img, int w, int h) {
+    uint32_t seed = 1;
+    for (int y = 0; y < h; y++) {
+        for (int x = 0; x < w; x++) {
+            uint8_t v;
+            if (y < h / 4) {
+                // Horizontal gradient
+                v = (w > 1) ? x * 255 / (w - 1) : 0;
+            }
+            else if (y < h / 2) {
+                // Text-like black strokes on white
+                seed = seed * 1103515245 + 12345;
+                v = (((x / 8) * 7 + (y / 14) * 3) % 5 && ((seed >> 16) & 3))
+                        ? 255 : 0;
+            }
+            else {
+                // Smooth photo-like content
+                double f = sin(x * 0.013) * cos(y * 0.021) +
+                        0.5 * sin((x + y) * 0.0047);
+                v = (uint8_t)(127.5 + 84.0 * f);
+            }
+            img[y * w + x] = v;
+        }
+    }
+}
+
+// Mode map for the mixed stage 2 case, vertical bands of the modes used
+// most: reading, browsing, watching and error diffused greyscale
+static void make_mode_map(uint8_t *mode, int w, int h) {
+    static const uint8_t bands[4] = { 6, DITHER_UM_FAST_MONO_BAYER,
+            DITHER_UM_FAST_MONO_BLUE_NOISE,
+            DITHER_UM_AUTO_LUT_ERROR_DIFFUSION };
+    for (int y = 0; y < h; y++)
+        for (int x = 0; x < w; x++)
+            mode[y * w + x] = bands[x * 4 / w];
+}
+
+// Stage 2 exactly as written in caster_sim before it used this library
+static void reference_stage2(const image_t *img, uint8_t *in1, uint8_t *in4) {
+    static const uint8_t bayer4[4][4] = {
+        { 0,  8,  2, 10},
+        {12,  4, 14,  6},
+        { 3, 11,  1,  9},
+        {15,  7, 13,  5}
+    };
+    int w = img->w;
+    int16_t *err_cur = calloc(w + 2, sizeof(int16_t));
+    int16_t *err_nxt = calloc(w + 2, sizeof(int16_t));
+    for (int y = 0; y < img->h; y++) {
+        memset(err_nxt, 0, (w + 2) * sizeof(int16_t));
+        for (int x = 0; x < w; x++) {
+            int i = y * w + x;
+            int in = img->src[i];
+            uint8_t mode = img->mode[i];
+            if (mode == DITHER_UM_FAST_MONO_BAYER) {
+                in1[i] = in > (bayer4[y & 3][x & 3] * 16 + 8);
+            }
+            else if (mode == DITHER_UM_FAST_MONO_BLUE_NOISE) {
+                float f = 52.9829189f * ((0.06711056f * (x & 63) +
+                        0.00583715f * (y & 63)) - (int)(0.06711056f *
+                        (x & 63) + 0.00583715f * (y & 63)));
+                f = f - (int)f;
+                in1[i] = in > (uint8_t)(f * 255.0f);
+            }
+            else {
+                in1[i] = in >= 128;
+            }
+            if ((mode == DITHER_UM_MANUAL_LUT_ERROR_DIFFUSION) ||
+                    (mode == DITHER_UM_AUTO_LUT_ERROR_DIFFUSION)) {
+                int v = in + err_cur[x + 1] / 16;
+                int q = (v + 8) / 17;
+                q = (q < 0) ? 0 : (q > 15) ? 15 : q;
+                int e = v - q * 17;
+                err_cur[x + 2] += e * 7;
+                err_nxt[x] += e * 3;
+                err_nxt[x + 1] += e * 5;
+                err_nxt[x + 2] += e * 1;
+                in4[i] = q;
+            }
+            else {
+                in4[i] = in >> 4;
+            }
+        }
+        int16_t *t = err_cur;
+        err_cur = err_nxt;
+        err_nxt = t;
+    }
+    free(err_cur);
+    free(err_nxt);
+}
+
+static void run_kernel(kernel_t k, image_t *img) {
+    int w = img->w, h = img->h;
+    switch (k) {
+    case K_THRESHOLD:
+        dither_threshold(img->src, img->out1, w, h, w);
+        break;
+    case K_BAYER:
+        dither_bayer(img->src, img->out1, w, h, w);
+        break;
+    case K_BLUE_NOISE:
+        dither_blue_noise(img->src, img->out1, w, h, w);
+        break;
+    case K_QUANTIZE4:
+        dither_quantize4(img->src, img->out4, w, h, w);
+        break;
+    case K_ERROR_DIFFUSION:
+        dither_error_diffusion(img->src, img->out4, w, h, w);
+        break;
+    default:
+        dither_stage2(img->src, img->mode, img->out1, img->out4, w, h, w);
+        break;
+    }
+}
+
+static bool outputs_match(kernel_t k, image_t *img, const uint8_t *ref1,
+        const uint8_t *ref4) {
+    size_t px = (size_t)img->w * img->h;
+    bool uses1 = (k != K_QUANTIZE4) && (k != K_ERROR_DIFFUSION);
+    bool uses4 = (k >= K_QUANTIZE4);
+    return (!uses1 || !memcmp(img->out1, ref1, px)) &&
+            (!uses4 || !memcmp(img->out4, ref4, px));
+}
+
+typedef struct {
+    const char *name;
+    const dither_kernel_t *kernel;
+    int levels;
+    bool linear_light;
+    const dither_quant_t *quant;    // Loaded with -q, instead of the above
+} ed_case_t;
+
+#define ED_CASES    4
+
+static const ed_case_t ed_cases[ED_CASES - 1] = {
+    { "fs 16 levels", &dither_kernel_floyd_steinberg, 16, false, NULL },
+    { "sierra2 mono linear", &dither_kernel_sierra2, 2, true, NULL },
+    { "cfa 16 linear", &dither_kernel_cfa, 16, true, NULL },
+};
+
+static uint64_t time_ed(const ed_case_t *c, const dither_quant_t *q,
+        image_t *img, dither_pool_t *pool, int runs) {
+    uint64_t min_ns = UINT64_MAX;
+    for (int r = 0; r < runs; r++) {
+        uint64_t start = now_ns();
+        dither_ed(c->kernel, q, img->src, img->out4, img->w, img->h, img->w,
+                pool);
+        uint64_t ns = now_ns() - start;
+        if (ns < min_ns)
+            min_ns = ns;
+    }
+    return min_ns;
+}
+
+// Serial against 1, 2, 4 ... max_threads pool threads
+static bool ed_scaling(image_t *img, int max_threads, int runs,
+        const dither_quant_t *measured) {
+    size_t px = (size_t)img->w * img->h;
+    uint8_t *ref = malloc(px);
+    bool all_match = true;
+    ed_case_t cases[ED_CASES];
+    int count = ED_CASES - 1;
+    memcpy(cases, ed_cases, sizeof(ed_cases));
+    if (measured)
+        cases[count++] = (ed_case_t){ "fs measured",
+                &dither_kernel_floyd_steinberg, 0, false, measured };
+
+    // The generic engine with the gateware kernel must agree with the
+    // hardware path
+    static dither_quant_t q;
+    dither_quant_init(&q, 16, false);
+    dither_error_diffusion(img->src, ref, img->w, img->h, img->w);
+    dither_ed(&dither_kernel_floyd_steinberg, &q, img->src, img->out4,
+            img->w, img->h, img->w, NULL);
+    bool hw_match = !memcmp(ref, img->out4, px);
+    all_match = all_match && hw_match;
+    printf("\nError diffusion, wavefront over a thread pool. Floyd-Steinberg "
+            "against the gateware path: %s\n", hw_match ? "match" : "MISMATCH");
+    printf("%-20s%9s", "", "serial");
+    for (int t = 1; t <= max_threads; t = (t * 2 > max_threads && t != max_threads) ?
+            max_threads : t * 2)
+        printf("%7d thr", t);
+    printf("\n");
+    for (int c = 0; c < count; c++) {
+        const ed_case_t *ec = &cases[c];
+        if (ec->quant)
+            q = *ec->quant;
+        else
+            dither_quant_init(&q, ec->levels, ec->linear_light);
+        dither_ed(ec->kernel, &q, img->src, ref, img->w, img->h, img->w, NULL);
+        uint64_t serial_ns = time_ed(ec, &q, img, NULL, runs);
+        printf("%-20s%9.0f", ec->name, px * 1e3 / serial_ns);
+        for (int t = 1; t <= max_threads; t = (t * 2 > max_threads &&
+                t != max_threads) ? max_threads : t * 2) {
+            dither_pool_t *pool = dither_pool_create(t);
+            if (!pool) {
+                printf("%11s", "-");
+                continue;
+            }
+            memset(img->out4, 0xff, px);
+            dither_ed(ec->kernel, &q, img->src, img->out4, img->w, img->h,
+                    img->w, pool);
+            bool match = !memcmp(ref, img->out4, px);
+            all_match = all_match && match;
+            uint64_t ns = time_ed(ec, &q, img, pool, runs);
+            printf("%6.0f %3.1fx%s", px * 1e3 / ns, (double)serial_ns / ns,
+                    match ? "" : "!");
+            dither_pool_destroy(pool);
+        }
+        printf("\n");
+    }
+    printf("MP/s and speedup over serial, %ld cores online. Pool output %s "
+            "the serial output\n", sysconf(_SC_NPROCESSORS_ONLN),
+            all_match ? "matches" : "DOES NOT MATCH");
+    free(ref);
+    return all_match;
+}
+
+static void write_pgm(const char *prefix, const char *name,
+        const uint8_t *plane, int w, int h, int scale) {
+    char fn[256];
+    snprintf(fn, sizeof(fn), "%s_%s.pgm", prefix, name);
+    FILE *fp = fopen(fn, "wb");
+    if (!fp) {
+        fprintf(stderr, "Failed to open %s\n", fn);
+        return;
+    }
+    fprintf(fp, "P5\n%d %d\n255\n", w, h);
+    for (size_t i = 0; i < (size_t)w * h; i++)
+        fputc(plane[i] * scale, fp);
+    fclose(fp);
+}
+
+static void usage(const char *name) {
+    fprintf(stderr, "Usage: %s [options]\n"
+            "  -i file      Raw 8 bit greyscale input\n"
+            "  -w width     Image width (default 1600)\n"
+            "  -h height    Image height (default 1200)\n"
+            "  -n runs      Runs per kernel (default 20)\n"
+            "  -t threads   Most error diffusion threads (default cores)\n"
+            "  -q file      Also run quantizer tables from dither_quant_gen\n"
+            "  -o prefix    Write every result as <prefix>_<kernel>.pgm\n",
+            name);
+}
+
+int main(int argc, char *argv[]) {
+    const char *in_fn = NULL;
+    const char *out_prefix = NULL;
+    const char *quant_fn = NULL;
+    static dither_quant_t measured;
+    int w = 1600, h = 1200, runs = 20;
+    int max_threads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    int opt;
+
+    while ((opt = getopt(argc, argv, "i:w:h:n:o:t:q:")) != -1) {
+        switch (opt) {
+        case 'i': in_fn = optarg; break;
+        case 'w': w = atoi(optarg); break;
+        case 'h': h = atoi(optarg); break;
+        case 'n': runs = atoi(optarg); break;
+        case 'o': out_prefix = optarg; break;
+        case 't': max_threads = atoi(optarg); break;
+        case 'q': quant_fn = optarg; break;
+        default:
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    if ((w <= 0) || (h <= 0) || (runs <= 0) || (max_threads <= 0)) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    dither_init();
+    size_t px = (size_t)w * h;
+    uint8_t *src = malloc(px);
+    uint8_t *mode = malloc(px);
+    uint8_t *ref1 = malloc(px);
+    uint8_t *ref4 = malloc(px);
+    image_t img = { w, h, src, mode, malloc(px), malloc(px) };
+    if (in_fn) {
+        FILE *fp = fopen(in_fn, "rb");
+        if (!fp || (fread(src, 1, px, fp) != px)) {
+            fprintf(stderr, "Failed to read %zu bytes from %s\n", px, in_fn);
+            return 1;
+        }
+        fclose(fp);
+    }
+    else {
+        make_image(src, w, h);
+    }
+    make_mode_map(mode, w, h);
+    if (quant_fn) {
+        uint8_t buf[DITHER_QUANT_PACKED_SIZE(DITHER_MAX_LEVELS)];
+        FILE *fp = fopen(quant_fn, "rb");
+        size_t len = fp ? fread(buf, 1, sizeof(buf), fp) : 0;
+        if (fp)
+            fclose(fp);
+        if (!dither_quant_unpack(&measured, buf, len)) {
+            fprintf(stderr, "Invalid quantizer tables in %s\n", quant_fn);
+            return 1;
+        }
+    }
+
+    printf("%d x %d, %d runs, hardware %.0f MP/s with dithering\n", w, h,
+            runs, HW_DITHER_MPS);
+    dither_simd_t best = dither_get_simd();
+    dither_set_simd(DITHER_SIMD_NONE);
+    reference_stage2(&img, ref1, ref4);
+    run_kernel(K_STAGE2, &img);
+    printf("Stage 2 against caster_sim model: %s\n",
+            outputs_match(K_STAGE2, &img, ref1, ref4) ? "match" : "MISMATCH");
+
+    bool all_match = true;
+    printf("%-16s", "");
+    for (int s = DITHER_SIMD_NONE; s <= (int)best; s++)
+        printf("%10s", dither_simd_name(s));
+    printf("   vs hw\n");
+    for (int k = 0; k < K_COUNT; k++) {
+        dither_set_simd(DITHER_SIMD_NONE);
+        run_kernel(k, &img);
+        memcpy(ref1, img.out1, px);
+        memcpy(ref4, img.out4, px);
+        printf("%-16s", kernel_names[k]);
+        double mps = 0.0;
+        for (int s = DITHER_SIMD_NONE; s <= (int)best; s++) {
+            dither_set_simd(s);
+            run_kernel(k, &img);
+            bool match = outputs_match(k, &img, ref1, ref4);
+            all_match = all_match && match;
+            uint64_t min_ns = UINT64_MAX;
+            for (int r = 0; r < runs; r++) {
+                uint64_t start = now_ns();
+                run_kernel(k, &img);
+                uint64_t ns = now_ns() - start;
+                if (ns < min_ns)
+                    min_ns = ns;
+            }
+            mps = px * 1e3 / min_ns;
+            printf("%8.0f%s ", mps, match ? "  " : " !");
+        }
+        printf("%6.1fx\n", mps / HW_DITHER_MPS);
+        if (out_prefix) {
+            char name[32];
+            int j = 0;
+            for (const char *c = kernel_names[k]; *c && j < 31; c++)
+                name[j++] = (*c == ' ') ? '_' : *c;
+            name[j] = '\0';
+            if ((k == K_QUANTIZE4) || (k == K_ERROR_DIFFUSION))
+                write_pgm(out_prefix, name, img.out4, w, h, 17);
+            else
+                write_pgm(out_prefix, name, img.out1, w, h, 255);
+        }
+    }
+    printf("MP/s, best of %d runs on one core. SIMD output %s the C path\n",
+            runs, all_match ? "matches" : "DOES NOT MATCH");
+    all_match = ed_scaling(&img, max_threads, runs,
+            quant_fn ? &measured : NULL) && all_match;
+    return all_match ? 0 : 1;
+}
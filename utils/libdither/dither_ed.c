@@ -0,0 +1,382 @@
+//
+// libdither, Caster dithering reference
+// Copyright 2025 Wenting Zhang
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+//
+// Error diffusion with any kernel and level mapping, on one thread or as a
+// wavefront over a thread pool.
+//
+// Error is pulled instead of pushed: every pixel stores its own error, and
+// sums the shares of the pixels above and to the left when it's visited.
+// Each error row then has a single writer, and a row only has to wait
+// until the rows above it have got far enough to the right. Integer sums
+// don't depend on the order of the additions, so the result is the same as
+// the serial push version, and the same for any number of threads.
+//
+// Rows are handed out round robin. Error rows live in a ring with room for
+// the rows in flight and the rows they read from, and every slot has a
+// progress word holding the row number and the pixels done. A row finishes
+// only after the row above it has, so when a thread starts a row all rows
+// that could still read the slot it reuses are done.
+//
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <sched.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include "dither.h"
+
+#define MAX_DY          2
+#define MAX_DX          8
+// Same row taps are kept in registers
+#define MAX_ROW_DX      4
+// Pixels done between progress updates
+#define CHUNK_PX        64
+#define SPIN_COUNT      64
+
+const dither_kernel_t dither_kernel_floyd_steinberg = {
+    .name = "floyd-steinberg", .divisor = 16, .count = 4,
+    .taps = { {1, 0, 7}, {-1, 1, 3}, {0, 1, 5}, {1, 1, 1} }
+};
+
+const dither_kernel_t dither_kernel_sierra2 = {
+    .name = "sierra2", .divisor = 16, .count = 7,
+    .taps = { {1, 0, 4}, {2, 0, 3},
+            {-2, 1, 1}, {-1, 1, 2}, {0, 1, 3}, {1, 1, 2}, {2, 1, 1} }
+};
+
+const dither_kernel_t dither_kernel_cfa = {
+    .name = "cfa", .divisor = 16, .count = 4,
+    .taps = { {3, 0, 7}, {-4, 1, 1}, {-1, 1, 5}, {2, 1, 3} }
+};
+
+struct dither_pool {
+    int threads;
+    pthread_t *tids;
+    pthread_mutex_t lock;
+    pthread_cond_t start;
+    pthread_cond_t done;
+    uint32_t generation;
+    int running;
+    bool quit;
+    void (*fn)(void *arg, int index, int count);
+    void *arg;
+};
+
+typedef struct {
+    int index;
+    dither_pool_t *pool;
+} worker_arg_t;
+
+typedef struct {
+    const dither_kernel_t *kernel;
+    const dither_quant_t *q;
+    const uint8_t *src;
+    uint8_t *dst;
+    int width;
+    int height;
+    int stride;
+    int pad;                // Zero error columns on each side of a row
+    int row_size;
+    int ring;
+    int32_t *err;           // ring rows of row_size
+    _Atomic uint64_t *progress; // Row number << 32 | pixels done
+    bool parallel;
+    int max_dy;
+    int reach[MAX_DY + 1];  // Pixels right of x a row waits for, per dy
+} ed_job_t;
+
+static void *pool_worker(void *p) {
+    worker_arg_t *wa = p;
+    dither_pool_t *pool = wa->pool;
+    uint32_t seen = 0;
+    pthread_mutex_lock(&pool->lock);
+    while (1) {
+        while (!pool->quit && (pool->generation == seen))
+            pthread_cond_wait(&pool->start, &pool->lock);
+        if (pool->quit)
+            break;
+        seen = pool->generation;
+        pthread_mutex_unlock(&pool->lock);
+        pool->fn(pool->arg, wa->index, pool->threads);
+        pthread_mutex_lock(&pool->lock);
+        if (--pool->running == 0)
+            pthread_cond_signal(&pool->done);
+    }
+    pthread_mutex_unlock(&pool->lock);
+    free(wa);
+    return NULL;
+}
+
+dither_pool_t *dither_pool_create(int threads) {
+    if (threads <= 0)
+        threads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    if (threads <= 0)
+        threads = 1;
+    dither_pool_t *pool = calloc(1, sizeof(dither_pool_t));
+    if (!pool)
+        return NULL;
+    pool->tids = calloc(threads, sizeof(pthread_t));
+    if (!pool->tids) {
+        free(pool);
+        return NULL;
+    }
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->start, NULL);
+    pthread_cond_init(&pool->done, NULL);
+    for (int i = 0; i < threads; i++) {
+        worker_arg_t *wa = malloc(sizeof(worker_arg_t));
+        if (wa) {
+            wa->index = i;
+            wa->pool = pool;
+        }
+        if (!wa || pthread_create(&pool->tids[i], NULL, pool_worker, wa)) {
+            free(wa);
+            pool->threads = i;
+            dither_pool_destroy(pool);
+            return NULL;
+        }
+    }
+    pool->threads = threads;
+    return pool;
+}
+
+void dither_pool_destroy(dither_pool_t *pool) {
+    if (!pool)
+        return;
+    pthread_mutex_lock(&pool->lock);
+    pool->quit = true;
+    pthread_cond_broadcast(&pool->start);
+    pthread_mutex_unlock(&pool->lock);
+    for (int i = 0; i < pool->threads; i++)
+        pthread_join(pool->tids[i], NULL);
+    pthread_mutex_destroy(&pool->lock);
+    pthread_cond_destroy(&pool->start);
+    pthread_cond_destroy(&pool->done);
+    free(pool->tids);
+    free(pool);
+}
+
+int dither_pool_threads(dither_pool_t *pool) {
+    return pool->threads;
+}
+
+// Runs fn once on every worker and waits for all of them
+static void pool_run(dither_pool_t *pool, void (*fn)(void *, int, int),
+        void *arg) {
+    pthread_mutex_lock(&pool->lock);
+    pool->fn = fn;
+    pool->arg = arg;
+    pool->running = pool->threads;
+    pool->generation++;
+    pthread_cond_broadcast(&pool->start);
+    while (pool->running)
+        pthread_cond_wait(&pool->done, &pool->lock);
+    pthread_mutex_unlock(&pool->lock);
+}
+
+static int32_t *err_row(ed_job_t *job, int y) {
+    return job->err + (size_t)(y % job->ring) * job->row_size + job->pad;
+}
+
+// Pixels of row y done so far, 0 if it hasn't started
+static int row_done(ed_job_t *job, int y) {
+    uint64_t v = atomic_load_explicit(&job->progress[y % job->ring],
+            memory_order_acquire);
+    return ((int)(v >> 32) == y) ? (int)(v & 0xffffffff) : 0;
+}
+
+static void wait_row(ed_job_t *job, int y, int need) {
+    int spins = 0;
+    while (row_done(job, y) < need) {
+        if (++spins > SPIN_COUNT) {
+            sched_yield();
+            spins = 0;
+        }
+    }
+}
+
+static void publish(ed_job_t *job, int y, int done) {
+    atomic_store_explicit(&job->progress[y % job->ring],
+            ((uint64_t)y << 32) | (uint32_t)done, memory_order_release);
+}
+
+// First x that can't be done yet with what the rows above have finished
+static int row_limit(ed_job_t *job, int y, int x) {
+    int limit = job->width;
+    for (int dy = 1; dy <= job->max_dy; dy++) {
+        if ((y - dy < 0) || (job->reach[dy] == INT_MIN))
+            continue;
+        int need = x + job->reach[dy] + 1;
+        if (need > job->width)
+            need = job->width;
+        int done = row_done(job, y - dy);
+        if (done < need) {
+            wait_row(job, y - dy, need);
+            done = row_done(job, y - dy);
+        }
+        // Pixels up to done - 1 are there, so x can go up to done - reach
+        int l = (done >= job->width) ? job->width : done - job->reach[dy];
+        if (l < limit)
+            limit = l;
+    }
+    return (limit <= x) ? x + 1 : limit;
+}
+
+static void ed_run_row(ed_job_t *job, int y) {
+    const dither_kernel_t *k = job->kernel;
+    const dither_quant_t *q = job->q;
+    const int32_t *tap_src[DITHER_MAX_TAPS];
+    int tap_w[DITHER_MAX_TAPS];
+    int taps = 0;
+    // Same row shares come from the last few pixels, kept in registers
+    int rw1 = 0, rw2 = 0, rw3 = 0, rw4 = 0;
+    int32_t *erow = err_row(job, y);
+    for (int t = 0; t < k->count; t++) {
+        const dither_tap_t *tap = &k->taps[t];
+        int sy = y - tap->dy;
+        if (tap->dy == 0) {
+            rw1 += (tap->dx == 1) ? tap->weight : 0;
+            rw2 += (tap->dx == 2) ? tap->weight : 0;
+            rw3 += (tap->dx == 3) ? tap->weight : 0;
+            rw4 += (tap->dx == 4) ? tap->weight : 0;
+            continue;
+        }
+        if (sy < 0)
+            continue;
+        // Error from (x - dx, y - dy) lands on (x, y)
+        tap_src[taps] = err_row(job, sy) - tap->dx;
+        tap_w[taps] = tap->weight;
+        taps++;
+    }
+    const uint8_t *src = job->src + (size_t)y * job->stride;
+    uint8_t *dst = job->dst + (size_t)y * job->stride;
+    int off = q->max + 1;
+    int top = 3 * off - 1;
+    int divisor = k->divisor;
+    // Power of two divisors as a shift, rounding toward zero like /
+    int shift = ((divisor & (divisor - 1)) == 0) ? __builtin_ctz(divisor) : -1;
+    int limit = job->parallel ? 0 : job->width;
+    int e1 = 0, e2 = 0, e3 = 0, e4 = 0;
+    int32_t above[CHUNK_PX];
+    for (int x0 = 0; x0 < job->width;) {
+        if (x0 >= limit)
+            limit = row_limit(job, y, x0);
+        int n = limit - x0;
+        n = (n > CHUNK_PX) ? CHUNK_PX : n;
+        // Shares from the rows above don't depend on this row, sum them up
+        // for the whole chunk first
+        memset(above, 0, n * sizeof(int32_t));
+        for (int t = 0; t < taps; t++) {
+            const int32_t *ts = tap_src[t] + x0;
+            int tw = tap_w[t];
+            for (int i = 0; i < n; i++)
+                above[i] += tw * ts[i];
+        }
+        for (int i = 0; i < n; i++) {
+            int x = x0 + i;
+            int sum = above[i] + rw1 * e1 + rw2 * e2 + rw3 * e3 + rw4 * e4;
+            if (shift >= 0)
+                sum = (sum + ((sum >> 31) & (divisor - 1))) >> shift;
+            else
+                sum /= divisor;
+            int qi = q->to_linear[src[x]] + sum + off;
+            qi = (qi < 0) ? 0 : (qi > top) ? top : qi;
+            dither_qentry_t l = q->lookup[qi];
+            int e = l.residual;
+            erow[x] = e;
+            dst[x] = l.level;
+            e4 = e3;
+            e3 = e2;
+            e2 = e1;
+            e1 = e;
+        }
+        x0 += n;
+        if (job->parallel && (x0 < job->width))
+            publish(job, y, x0);
+    }
+    if (job->parallel) {
+        if (y > 0)
+            wait_row(job, y - 1, job->width);
+        publish(job, y, job->width);
+    }
+}
+
+static void ed_worker(void *arg, int index, int count) {
+    ed_job_t *job = arg;
+    for (int y = index; y < job->height; y += count)
+        ed_run_row(job, y);
+}
+
+bool dither_ed(const dither_kernel_t *kernel, const dither_quant_t *q,
+        const uint8_t *src, uint8_t *dst, int width, int height, int stride,
+        dither_pool_t *pool) {
+    ed_job_t job = {
+        .kernel = kernel,
+        .q = q,
+        .src = src,
+        .dst = dst,
+        .width = width,
+        .height = height,
+        .stride = stride,
+        .parallel = pool && (pool->threads > 1) && (height > 1)
+    };
+    if ((kernel->divisor == 0) || (kernel->count > DITHER_MAX_TAPS))
+        return false;
+    for (int dy = 0; dy <= MAX_DY; dy++)
+        job.reach[dy] = INT_MIN;
+    for (int t = 0; t < kernel->count; t++) {
+        const dither_tap_t *tap = &kernel->taps[t];
+        if ((tap->dy < 0) || (tap->dy > MAX_DY) || (tap->dx < -MAX_DX) ||
+                (tap->dx > MAX_DX) || ((tap->dy == 0) && ((tap->dx <= 0) || (tap->dx > MAX_ROW_DX))))
+            return false;
+        int pad = (tap->dx < 0) ? -tap->dx : tap->dx;
+        if (pad > job.pad)
+            job.pad = pad;
+        if (tap->dy > job.max_dy)
+            job.max_dy = tap->dy;
+        if ((tap->dy > 0) && (-tap->dx > job.reach[tap->dy]))
+            job.reach[tap->dy] = -tap->dx;
+    }
+    if ((width <= 0) || (height <= 0))
+        return true;
+    job.row_size = width + 2 * job.pad;
+    job.ring = job.max_dy + (job.parallel ? pool->threads : 1);
+    job.err = calloc((size_t)job.ring * job.row_size, sizeof(int32_t));
+    job.progress = calloc(job.ring, sizeof(uint64_t));
+    if (!job.err || !job.progress) {
+        free(job.err);
+        free((void *)job.progress);
+        return false;
+    }
+    // Nothing has started, no slot may claim a row yet
+    for (int i = 0; i < job.ring; i++)
+        atomic_init(&job.progress[i], (uint64_t)UINT32_MAX << 32);
+    if (job.parallel)
+        pool_run(pool, ed_worker, &job);
+    else
+        ed_worker(&job, 0, 1);
+    free(job.err);
+    free((void *)job.progress);
+    return true;
+}
@@ -0,0 +1,173 @@
+//
+// libdither, Caster dithering reference
+// Copyright 2025 Wenting Zhang
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+//
+// Quantizer tables for dither_ed() and dither_quantize(): how input maps to
+// the error diffusion domain, the value of every output level in it, and
+// the nearest level lookup built from the two.
+//
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "dither.h"
+
+static void quant_build(dither_quant_t *q) {
+    int off = q->max + 1;
+    int qi = 0;
+    for (int i = 0; i < 3 * off; i++) {
+        int v = i - off;
+        // Ties go up, like the rounding in the gateware
+        while ((qi + 1 < q->levels) &&
+                (v * 2 >= q->level[qi] + q->level[qi + 1]))
+            qi++;
+        q->lookup[i].level = qi;
+        q->lookup[i].residual = v - q->level[qi];
+    }
+    for (int i = 0; i < 256; i++)
+        q->direct[i] = q->lookup[q->to_linear[i] + off].level;
+}
+
+static double srgb_to_linear(double c) {
+    return (c <= 0.04045) ? c / 12.92 : pow((c + 0.055) / 1.055, 2.4);
+}
+
+void dither_quant_init(dither_quant_t *q, int levels, bool linear_light) {
+    memset(q, 0, sizeof(dither_quant_t));
+    levels = (levels < 2) ? 2 : (levels > DITHER_MAX_LEVELS) ?
+            DITHER_MAX_LEVELS : levels;
+    for (int i = 0; i < 256; i++)
+        q->to_linear[i] = linear_light ?
+                (uint16_t)lround(srgb_to_linear(i / 255.0) * DITHER_LINEAR_MAX) :
+                i;
+    q->levels = levels;
+    q->max = q->to_linear[255];
+    for (int i = 0; i < levels; i++)
+        q->level[i] = q->to_linear[(i * 255 + (levels - 1) / 2) / (levels - 1)];
+    quant_build(q);
+}
+
+bool dither_quant_init_custom(dither_quant_t *q, const uint16_t *to_linear,
+        const uint16_t *level, int levels) {
+    if ((levels < 2) || (levels > DITHER_MAX_LEVELS))
+        return false;
+    for (int i = 0; i < 256; i++) {
+        if ((to_linear[i] > DITHER_LINEAR_MAX) ||
+                ((i > 0) && (to_linear[i] < to_linear[i - 1])))
+            return false;
+    }
+    for (int i = 0; i < levels; i++) {
+        if ((level[i] > DITHER_LINEAR_MAX) ||
+                ((i > 0) && (level[i] <= level[i - 1])))
+            return false;
+    }
+    memset(q, 0, sizeof(dither_quant_t));
+    memcpy(q->to_linear, to_linear, sizeof(q->to_linear));
+    memcpy(q->level, level, levels * sizeof(uint16_t));
+    q->levels = levels;
+    q->max = (to_linear[255] > level[levels - 1]) ? to_linear[255] :
+            level[levels - 1];
+    quant_build(q);
+    return true;
+}
+
+bool dither_quant_init_measured(dither_quant_t *q, const double *reflectance,
+        int levels, double gamma) {
+    uint16_t to_linear[256];
+    uint16_t level[DITHER_MAX_LEVELS];
+    if ((levels < 2) || (levels > DITHER_MAX_LEVELS))
+        return false;
+    for (int i = 1; i < levels; i++)
+        if (!(reflectance[i] > reflectance[i - 1]))
+            return false;
+    for (int i = 0; i < 256; i++) {
+        double c = i / 255.0;
+        double lin = (gamma > 0.0) ? pow(c, gamma) : srgb_to_linear(c);
+        to_linear[i] = (uint16_t)lround(lin * DITHER_LINEAR_MAX);
+    }
+    // Input black and white map to the darkest and brightest level
+    double lo = reflectance[0];
+    double span = reflectance[levels - 1] - lo;
+    for (int i = 0; i < levels; i++)
+        level[i] = (uint16_t)lround((reflectance[i] - lo) / span *
+                DITHER_LINEAR_MAX);
+    // Fails if two levels are too close to tell apart after rounding
+    return dither_quant_init_custom(q, to_linear, level, levels);
+}
+
+static void put16(uint8_t *p, uint16_t v) {
+    p[0] = v & 0xff;
+    p[1] = v >> 8;
+}
+
+static uint16_t get16(const uint8_t *p) {
+    return p[0] | ((uint16_t)p[1] << 8);
+}
+
+size_t dither_quant_pack(const dither_quant_t *q, uint8_t *buf, size_t len) {
+    size_t size = DITHER_QUANT_PACKED_SIZE(q->levels);
+    if (len < size)
+        return size;
+    memcpy(buf, DITHER_QUANT_MAGIC, 4);
+    buf[4] = DITHER_QUANT_VERSION;
+    buf[5] = q->levels;
+    buf[6] = 0;
+    buf[7] = 0;
+    uint8_t *p = buf + 8;
+    for (int i = 0; i < 256; i++, p += 2)
+        put16(p, q->to_linear[i]);
+    for (int i = 0; i < q->levels; i++, p += 2)
+        put16(p, q->level[i]);
+    memcpy(p, q->direct, 256);
+    return size;
+}
+
+bool dither_quant_unpack(dither_quant_t *q, const uint8_t *buf, size_t len) {
+    uint16_t to_linear[256];
+    uint16_t level[DITHER_MAX_LEVELS];
+    if ((len < 8) || memcmp(buf, DITHER_QUANT_MAGIC, 4) ||
+            (buf[4] != DITHER_QUANT_VERSION))
+        return false;
+    int levels = buf[5];
+    if ((levels < 2) || (levels > DITHER_MAX_LEVELS) ||
+            (len < DITHER_QUANT_PACKED_SIZE(levels)))
+        return false;
+    const uint8_t *p = buf + 8;
+    for (int i = 0; i < 256; i++, p += 2)
+        to_linear[i] = get16(p);
+    for (int i = 0; i < levels; i++, p += 2)
+        level[i] = get16(p);
+    if (!dither_quant_init_custom(q, to_linear, level, levels))
+        return false;
+    // The stored direct table has to agree with the one rebuilt from the
+    // curves, otherwise the file is damaged
+    return memcmp(p, q->direct, 256) == 0;
+}
+
+void dither_quantize(const dither_quant_t *q, const uint8_t *src,
+        uint8_t *dst, int width, int height, int stride) {
+    for (int y = 0; y < height; y++) {
+        const uint8_t *s = src + (size_t)y * stride;
+        uint8_t *d = dst + (size_t)y * stride;
+        for (int x = 0; x < width; x++)
+            d[x] = q->direct[s[x]];
+    }
+}
@@ -0,0 +1,173 @@
+//
+// libdither, Caster dithering reference
+// Copyright 2025 Wenting Zhang
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+//
+// Builds the quantizer tables for a panel from measured reflectance of its
+// greyscale levels, and writes them in the packed format from dither.h.
+// The measurement file has one level per line, darkest first; only the
+// last number on a line is used, so "level value" lines work too. Lines
+// starting with # are skipped.
+//
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <math.h>
+#include "dither.h"
+
+static int read_measurements(const char *fn, double *values) {
+    FILE *fp = fopen(fn, "r");
+    if (!fp) {
+        fprintf(stderr, "Failed to open %s\n", fn);
+        return -1;
+    }
+    char line[256];
+    int count = 0;
+    while (fgets(line, sizeof(line), fp)) {
+        char *p = line + strspn(line, " \t");
+        if ((*p == '#') || (*p == '\n') || (*p == '\r') || (*p == '\0'))
+            continue;
+        double v = 0.0;
+        bool found = false;
+        char *end;
+        while (*p) {
+            double d = strtod(p, &end);
+            if (end == p) {
+                p++;
+                continue;
+            }
+            v = d;
+            found = true;
+            p = end;
+        }
+        if (!found)
+            continue;
+        if (count == DITHER_MAX_LEVELS) {
+            fprintf(stderr, "More than %d levels in %s\n", DITHER_MAX_LEVELS,
+                    fn);
+            fclose(fp);
+            return -1;
+        }
+        values[count++] = v;
+    }
+    fclose(fp);
+    return count;
+}
+
+static double lstar_to_y(double l) {
+    return (l > 8.0) ? pow((l + 16.0) / 116.0, 3.0) : l / 903.3;
+}
+
+static void usage(const char *name) {
+    fprintf(stderr, "Usage: %s [options] measurements.txt output.bin\n"
+            "  -l           Measurements are CIE L* instead of reflectance\n"
+            "  -g gamma     Input is a power law instead of sRGB\n"
+            "  -c file.csv  Also write the tables as CSV\n",
+            name);
+}
+
+int main(int argc, char *argv[]) {
+    bool lstar = false;
+    double gamma = 0.0;
+    const char *csv_fn = NULL;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "lg:c:")) != -1) {
+        switch (opt) {
+        case 'l': lstar = true; break;
+        case 'g': gamma = atof(optarg); break;
+        case 'c': csv_fn = optarg; break;
+        default:
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    if (argc - optind != 2) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    double values[DITHER_MAX_LEVELS];
+    int levels = read_measurements(argv[optind], values);
+    if (levels < 0)
+        return 1;
+    if (levels < 2) {
+        fprintf(stderr, "Need at least 2 levels\n");
+        return 1;
+    }
+    if (lstar)
+        for (int i = 0; i < levels; i++)
+            values[i] = lstar_to_y(values[i]);
+
+    static dither_quant_t q;
+    if (!dither_quant_init_measured(&q, values, levels, gamma)) {
+        fprintf(stderr, "Measurements must increase from level to level\n");
+        return 1;
+    }
+    uint8_t buf[DITHER_QUANT_PACKED_SIZE(DITHER_MAX_LEVELS)];
+    size_t size = dither_quant_pack(&q, buf, sizeof(buf));
+    FILE *fp = fopen(argv[optind + 1], "wb");
+    if (!fp || (fwrite(buf, 1, size, fp) != size)) {
+        fprintf(stderr, "Failed to write %s\n", argv[optind + 1]);
+        return 1;
+    }
+    fclose(fp);
+
+    // Compare with the evenly spaced levels the gateware assumes
+    static dither_quant_t even;
+    dither_quant_init(&even, levels, false);
+    int moved = 0;
+    for (int i = 0; i < 256; i++)
+        moved += q.direct[i] != even.direct[i];
+    printf("%d levels, %zu bytes, %s input\n", levels, size,
+            (gamma > 0.0) ? "power law" : "sRGB");
+    printf("level  linear  inputs\n");
+    for (int l = 0; l < levels; l++) {
+        int first = -1, last = -1;
+        for (int i = 0; i < 256; i++) {
+            if (q.direct[i] == l) {
+                if (first < 0)
+                    first = i;
+                last = i;
+            }
+        }
+        if (first < 0)
+            printf("%5d  %6d  none\n", l, q.level[l]);
+        else
+            printf("%5d  %6d  %d-%d\n", l, q.level[l], first, last);
+    }
+    printf("%d of 256 inputs pick another level than with even spacing\n",
+            moved);
+
+    if (csv_fn) {
+        FILE *csv = fopen(csv_fn, "w");
+        if (!csv) {
+            fprintf(stderr, "Failed to open %s\n", csv_fn);
+            return 1;
+        }
+        fprintf(csv, "input,linear,level\n");
+        for (int i = 0; i < 256; i++)
+            fprintf(csv, "%d,%d,%d\n", i, q.to_linear[i], q.direct[i]);
+        fclose(csv);
+    }
+    return 0;
+}
@@ -0,0 +1,567 @@
+//
+// libglider, Glider host library
+// Copyright 2025 Wenting Zhang
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+// Command pipeline. Callers push commands into a submission ring. The
+// transmit thread moves them into the in flight table, where they get a
+// sequence number, and packs them into reports. The receive thread retires
+// them as acks come in. Nothing holds the lock across transport calls.
+//
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <time.h>
+#include "glider.h"
+
+// Power of 2 and larger than the v2 window
+#define INFLIGHT_SIZE       64
+#define READ_POLL_MS        20
+// v1 redraw or setmode found the device queue full, send it again after
+// this, doubling up to the max while it stays full
+#define V1_BUSY_RETRY_MS    2
+#define V1_BUSY_RETRY_MAX_MS 32
+
+typedef struct {
+    uint8_t cmd;
+    uint8_t mode;
+    uint16_t x0;
+    uint16_t y0;
+    uint16_t x1;
+    uint16_t y1;
+    uint32_t tag;
+    uint64_t submit_ns;
+} glider_cmd_t;
+
+typedef struct {
+    uint32_t tag;
+    int status;
+    uint64_t latency_ns;
+} glider_done_t;
+
+struct glider {
+    glider_config_t cfg;
+    glider_transport_t tr;
+    pthread_t tx_thread;
+    pthread_t rx_thread;
+    pthread_mutex_t lock;
+    pthread_cond_t tx_cond;
+    pthread_cond_t idle_cond;
+    bool running;
+    bool session;           // Sequence numbers synced with the device
+    uint32_t window;
+    uint32_t batch;
+    // Submission ring
+    glider_cmd_t *queue;
+    uint32_t queue_mask;
+    uint32_t q_head;
+    uint32_t q_tail;
+    // Sent, or about to be sent, indexed by sequence number
+    glider_cmd_t inflight[INFLIGHT_SIZE];
+    uint16_t seq_acked;     // Oldest not yet acknowledged
+    uint16_t seq_sent;      // Next to send, rewinds on resend
+    uint16_t seq_next;      // Next to assign
+    uint16_t v1_crc;        // Echoed back in v1 replies
+    uint64_t v1_busy_ns;    // First queue full reply to the command in flight
+    uint64_t v1_retry_ns;   // Not sent again before
+    uint32_t v1_retry_ms;
+    bool force_ack;
+    uint64_t last_tx_ns;
+    uint32_t device_space;  // Command queue room in the last v2 ack
+    glider_stats_t stats;
+};
+
+static uint64_t time_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+static void deadline_after(struct timespec *ts, int timeout_ms) {
+    clock_gettime(CLOCK_MONOTONIC, ts);
+    ts->tv_sec += timeout_ms / 1000;
+    ts->tv_nsec += (long)(timeout_ms % 1000) * 1000000;
+    if (ts->tv_nsec >= 1000000000) {
+        ts->tv_sec++;
+        ts->tv_nsec -= 1000000000;
+    }
+}
+
+static void put16(uint8_t *p, uint16_t val) {
+    p[0] = val & 0xff;
+    p[1] = (val >> 8) & 0xff;
+}
+
+static uint16_t get16(const uint8_t *p) {
+    return (p[1] << 8) | p[0];
+}
+
+static uint32_t pending_locked(glider_t *g) {
+    return (g->q_tail - g->q_head) + (uint16_t)(g->seq_next - g->seq_acked);
+}
+
+// Called with the lock held, retires [seq_acked, next)
+static int retire_locked(glider_t *g, uint16_t next, uint16_t failed_seq,
+        int failed_status, glider_done_t *done) {
+    int count = 0;
+    uint64_t now = time_ns();
+    while (g->seq_acked != next) {
+        glider_cmd_t *cmd = &g->inflight[g->seq_acked % INFLIGHT_SIZE];
+        int status = (failed_status && (g->seq_acked == failed_seq)) ?
+                failed_status : GLIDER_OK;
+        done[count].tag = cmd->tag;
+        done[count].status = status;
+        done[count].latency_ns = now - cmd->submit_ns;
+        count++;
+        if (status == GLIDER_OK)
+            g->stats.completed++;
+        else
+            g->stats.failed++;
+        g->seq_acked++;
+    }
+    // Acked past what's been sent after a rewind
+    if ((int16_t)(g->seq_sent - g->seq_acked) < 0)
+        g->seq_sent = g->seq_acked;
+    if (pending_locked(g) == 0)
+        pthread_cond_broadcast(&g->idle_cond);
+    pthread_cond_signal(&g->tx_cond);
+    return count;
+}
+
+static void notify(glider_t *g, const glider_done_t *done, int count) {
+    if (!g->cfg.done_cb)
+        return;
+    for (int i = 0; i < count; i++)
+        g->cfg.done_cb(g->cfg.cb_ctx, done[i].tag, done[i].status,
+                done[i].latency_ns);
+}
+
+// Rewind so everything not acknowledged goes out again
+static void resend_locked(glider_t *g) {
+    g->stats.resent += (uint16_t)(g->seq_sent - g->seq_acked);
+    g->seq_sent = g->seq_acked;
+    g->force_ack = true;
+    pthread_cond_signal(&g->tx_cond);
+}
+
+static int build_v2(glider_t *g, uint8_t *report, uint32_t count) {
+    uint8_t flags = 0;
+    if (!g->session) {
+        flags |= GLIDER_V2_FLAG_RESET;
+        g->session = true;
+    }
+    // Ask for an ack when nothing else is coming soon, or the window or the
+    // device queue is full
+    if (g->force_ack || (g->q_tail == g->q_head) ||
+            ((uint16_t)(g->seq_next - g->seq_acked) >= g->window) ||
+            ((uint16_t)(g->seq_sent - g->seq_acked) + count >=
+            g->device_space)) {
+        flags |= GLIDER_V2_FLAG_ACK;
+        g->force_ack = false;
+    }
+    memset(report, 0, GLIDER_REPORT_SIZE);
+    report[0] = GLIDER_V2_MAGIC;
+    report[1] = count;
+    put16(report + 2, g->seq_sent);
+    report[4] = flags;
+    for (uint32_t i = 0; i < count; i++) {
+        glider_cmd_t *cmd = &g->inflight[(uint16_t)(g->seq_sent + i) %
+                INFLIGHT_SIZE];
+        uint8_t *p = report + GLIDER_V2_HDR_SIZE + i * GLIDER_V2_CMD_SIZE;
+        p[0] = cmd->cmd;
+        p[1] = cmd->mode;
+        put16(p + 2, cmd->x0);
+        put16(p + 4, cmd->y0);
+        put16(p + 6, cmd->x1);
+        put16(p + 8, cmd->y1);
+    }
+    put16(report + GLIDER_V2_CRC_OFFSET,
+            glider_crc16(report, GLIDER_V2_CRC_OFFSET));
+    return count;
+}
+
+static int build_v1(glider_t *g, uint8_t *report) {
+    glider_cmd_t *cmd = &g->inflight[g->seq_sent % INFLIGHT_SIZE];
+    memset(report, 0, GLIDER_REPORT_SIZE);
+    report[0] = cmd->cmd;
+    put16(report + 1, cmd->mode);
+    put16(report + 3, cmd->x0);
+    put16(report + 5, cmd->y0);
+    put16(report + 7, cmd->x1);
+    put16(report + 9, cmd->y1);
+    put16(report + 11, g->seq_sent);
+    g->v1_crc = glider_crc16(report, GLIDER_V1_CRC_OFFSET);
+    put16(report + GLIDER_V1_CRC_OFFSET, g->v1_crc);
+    return 1;
+}
+
+static void *tx_thread(void *arg) {
+    glider_t *g = arg;
+    uint8_t report[GLIDER_REPORT_SIZE];
+    glider_done_t done[INFLIGHT_SIZE];
+
+    pthread_mutex_lock(&g->lock);
+    while (g->running) {
+        // Assign sequence numbers as the window allows
+        while ((g->q_head != g->q_tail) &&
+                ((uint16_t)(g->seq_next - g->seq_acked) < g->window) &&
+                ((uint16_t)(g->seq_next - g->seq_sent) < g->batch)) {
+            g->inflight[g->seq_next % INFLIGHT_SIZE] =
+                    g->queue[g->q_head & g->queue_mask];
+            g->q_head++;
+            g->seq_next++;
+        }
+        uint32_t count = (uint16_t)(g->seq_next - g->seq_sent);
+        if (count > g->batch)
+            count = g->batch;
+        if (g->cfg.protocol == GLIDER_PROTO_V2) {
+            // No more than the device has room for, it acks again with the
+            // new queue space once caster_task makes some
+            uint32_t sent = (uint16_t)(g->seq_sent - g->seq_acked);
+            uint32_t room = (g->device_space > sent) ?
+                    g->device_space - sent : 0;
+            if (count > room)
+                count = room;
+        }
+        else if (count && (time_ns() < g->v1_retry_ns)) {
+            struct timespec ts;
+            deadline_after(&ts, g->v1_retry_ms);
+            pthread_cond_timedwait(&g->tx_cond, &g->lock, &ts);
+            continue;
+        }
+        if (count == 0) {
+            uint64_t now = time_ns();
+            bool waiting = (g->seq_acked != g->seq_next);
+            if (waiting && (now - g->last_tx_ns >
+                    (uint64_t)g->cfg.timeout_ms * 1000000ull)) {
+                if (g->cfg.protocol == GLIDER_PROTO_V2) {
+                    // Space ack lost, probe with one command
+                    if (g->device_space == 0)
+                        g->device_space = 1;
+                    resend_locked(g);
+                }
+                else {
+                    // v1 has no duplicate detection, give up on it
+                    int n = retire_locked(g, g->seq_acked + 1, g->seq_acked,
+                            GLIDER_ETIMEDOUT, done);
+                    pthread_mutex_unlock(&g->lock);
+                    notify(g, done, n);
+                    pthread_mutex_lock(&g->lock);
+                }
+                continue;
+            }
+            struct timespec ts;
+            deadline_after(&ts, waiting ? READ_POLL_MS : 1000);
+            pthread_cond_timedwait(&g->tx_cond, &g->lock, &ts);
+            continue;
+        }
+        if (g->cfg.protocol == GLIDER_PROTO_V2)
+            build_v2(g, report, count);
+        else
+            build_v1(g, report);
+        g->seq_sent += count;
+        g->last_tx_ns = time_ns();
+        g->stats.reports_sent++;
+        pthread_mutex_unlock(&g->lock);
+        g->tr.write(g->tr.ctx, report);
+        pthread_mutex_lock(&g->lock);
+    }
+    pthread_mutex_unlock(&g->lock);
+    return NULL;
+}
+
+static int process_v2(glider_t *g, const uint8_t *report, glider_done_t *done) {
+    if ((report[0] != GLIDER_V2_MAGIC) || (report[1] != GLIDER_V2_TYPE_ACK) ||
+            (get16(report + GLIDER_V2_CRC_OFFSET) !=
+            glider_crc16(report, GLIDER_V2_CRC_OFFSET))) {
+        g->stats.bad_reports++;
+        return 0;
+    }
+    uint16_t next = get16(report + 2);
+    uint8_t status = report[4];
+    uint8_t failed = report[5];
+    uint16_t first_failed = get16(report + 6);
+    bool resend = report[9] != 0;
+    // Stale ack from before a reset, or nonsense
+    if ((uint16_t)(next - g->seq_acked) > (uint16_t)(g->seq_next - g->seq_acked)) {
+        g->stats.bad_reports++;
+        return 0;
+    }
+    // Only the first failure is identified, the rest are counted
+    if (failed > 1)
+        g->stats.failed += failed - 1;
+    int count = retire_locked(g, next, first_failed,
+            (failed && (status != GLIDER_RET_SUCCESS)) ? GLIDER_EDEVICE : 0,
+            done);
+    if (report[8] > g->device_space)
+        pthread_cond_signal(&g->tx_cond);
+    g->device_space = report[8];
+    if (resend && (g->seq_acked != g->seq_next))
+        resend_locked(g);
+    return count;
+}
+
+static int process_v1(glider_t *g, const uint8_t *report, glider_done_t *done) {
+    if ((g->seq_acked == g->seq_next) || (get16(report + 2) != g->v1_crc)) {
+        g->stats.bad_reports++;
+        return 0;
+    }
+    if (report[1] == GLIDER_RET_CHKSUMFAIL) {
+        resend_locked(g);
+        return 0;
+    }
+    // The device doesn't wait for queue space, and that is the only way
+    // these fail. Try again for up to timeout_ms.
+    uint8_t cmd = g->inflight[g->seq_acked % INFLIGHT_SIZE].cmd;
+    if ((report[1] == GLIDER_RET_GENERALFAIL) &&
+            ((cmd == GLIDER_CMD_REDRAW) || (cmd == GLIDER_CMD_SETMODE))) {
+        uint64_t now = time_ns();
+        if (g->v1_busy_ns == 0) {
+            g->v1_busy_ns = now;
+            g->v1_retry_ms = V1_BUSY_RETRY_MS;
+        }
+        else if (g->v1_retry_ms < V1_BUSY_RETRY_MAX_MS) {
+            g->v1_retry_ms *= 2;
+        }
+        if (now - g->v1_busy_ns < (uint64_t)g->cfg.timeout_ms * 1000000ull) {
+            g->v1_retry_ns = now + g->v1_retry_ms * 1000000ull;
+            resend_locked(g);
+            return 0;
+        }
+    }
+    g->v1_busy_ns = 0;
+    return retire_locked(g, g->seq_acked + 1, g->seq_acked,
+            (report[1] == GLIDER_RET_SUCCESS) ? 0 : GLIDER_EDEVICE, done);
+}
+
+static void *rx_thread(void *arg) {
+    glider_t *g = arg;
+    uint8_t report[GLIDER_REPORT_SIZE];
+    glider_done_t done[INFLIGHT_SIZE];
+
+    while (__atomic_load_n(&g->running, __ATOMIC_RELAXED)) {
+        int res = g->tr.read(g->tr.ctx, report, READ_POLL_MS);
+        if (res <= 0)
+            continue;
+        pthread_mutex_lock(&g->lock);
+        g->stats.reports_received++;
+        int count;
+        if (g->cfg.protocol == GLIDER_PROTO_V2)
+            count = process_v2(g, report, done);
+        else
+            count = process_v1(g, report, done);
+        pthread_mutex_unlock(&g->lock);
+        notify(g, done, count);
+    }
+    return NULL;
+}
+
+void glider_config_default(glider_config_t *cfg) {
+    memset(cfg, 0, sizeof(glider_config_t));
+    cfg->backend = GLIDER_BACKEND_HIDAPI;
+    cfg->protocol = GLIDER_PROTO_V2;
+    cfg->vid = GLIDER_VID;
+    cfg->pid = GLIDER_PID;
+    cfg->queue_length = 256;
+    cfg->timeout_ms = 500;
+    cfg->socket_path = "/tmp/glider.sock";
+    // Full speed HID with bInterval 2, see fw/User/usb_descriptors.c
+    cfg->loopback_interval_us = 2000;
+    cfg->loopback_service_us = 20;
+}
+
+glider_t *glider_open_transport(const glider_config_t *cfg,
+        const glider_transport_t *transport) {
+    glider_t *g = calloc(1, sizeof(glider_t));
+    if (!g)
+        return NULL;
+    g->cfg = *cfg;
+    g->tr = *transport;
+    g->window = (cfg->protocol == GLIDER_PROTO_V2) ? GLIDER_V2_WINDOW : 1;
+    g->device_space = g->window;    // Until the first ack says otherwise
+    g->batch = (cfg->protocol == GLIDER_PROTO_V2) ? GLIDER_V2_MAX_CMDS : 1;
+    uint32_t length = 1;
+    while (length < cfg->queue_length)
+        length <<= 1;
+    g->queue = calloc(length, sizeof(glider_cmd_t));
+    if (!g->queue) {
+        free(g);
+        return NULL;
+    }
+    g->queue_mask = length - 1;
+    // Start at a random point so stale acks from a previous session
+    // are unlikely to look valid
+    g->seq_next = g->seq_sent = g->seq_acked = time_ns() & 0xffff;
+
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_mutex_init(&g->lock, NULL);
+    pthread_cond_init(&g->tx_cond, &attr);
+    pthread_cond_init(&g->idle_cond, &attr);
+    pthread_condattr_destroy(&attr);
+    g->running = true;
+    pthread_create(&g->tx_thread, NULL, tx_thread, g);
+    pthread_create(&g->rx_thread, NULL, rx_thread, g);
+    return g;
+}
+
+glider_t *glider_open(const glider_config_t *cfg) {
+    glider_transport_t tr;
+    int res;
+    switch (cfg->backend) {
+    case GLIDER_BACKEND_HIDAPI:
+        res = glider_hidapi_open(cfg, &tr);
+        break;
+    case GLIDER_BACKEND_LIBUSB:
+        res = glider_libusb_open(cfg, &tr);
+        break;
+    case GLIDER_BACKEND_LOOPBACK:
+        res = glider_loopback_open(cfg, &tr);
+        break;
+    case GLIDER_BACKEND_SOCKET:
+        res = glider_socket_open(cfg, &tr);
+        break;
+    default:
+        res = GLIDER_EINVAL;
+        break;
+    }
+    if (res != GLIDER_OK)
+        return NULL;
+    glider_t *g = glider_open_transport(cfg, &tr);
+    if (!g)
+        tr.close(tr.ctx);
+    return g;
+}
+
+void glider_close(glider_t *g, int timeout_ms) {
+    glider_flush(g, timeout_ms);
+    pthread_mutex_lock(&g->lock);
+    g->running = false;
+    pthread_cond_broadcast(&g->tx_cond);
+    pthread_mutex_unlock(&g->lock);
+    pthread_join(g->tx_thread, NULL);
+    pthread_join(g->rx_thread, NULL);
+    if (g->tr.close)
+        g->tr.close(g->tr.ctx);
+    pthread_mutex_destroy(&g->lock);
+    pthread_cond_destroy(&g->tx_cond);
+    pthread_cond_destroy(&g->idle_cond);
+    free(g->queue);
+    free(g);
+}
+
+static int submit(glider_t *g, uint8_t cmd, uint8_t mode, uint16_t x0,
+        uint16_t y0, uint16_t x1, uint16_t y1, uint32_t tag) {
+    uint64_t now = time_ns();
+    pthread_mutex_lock(&g->lock);
+    if (g->q_tail - g->q_head > g->queue_mask) {
+        g->stats.rejected++;
+        pthread_mutex_unlock(&g->lock);
+        return GLIDER_EAGAIN;
+    }
+    glider_cmd_t *entry = &g->queue[g->q_tail & g->queue_mask];
+    entry->cmd = cmd;
+    entry->mode = mode;
+    entry->x0 = x0;
+    entry->y0 = y0;
+    entry->x1 = x1;
+    entry->y1 = y1;
+    entry->tag = tag;
+    entry->submit_ns = now;
+    g->q_tail++;
+    g->stats.submitted++;
+    pthread_cond_signal(&g->tx_cond);
+    pthread_mutex_unlock(&g->lock);
+    return GLIDER_OK;
+}
+
+int glider_redraw(glider_t *g, uint16_t x0, uint16_t y0, uint16_t x1,
+        uint16_t y1, uint32_t tag) {
+    return submit(g, GLIDER_CMD_REDRAW, 0, x0, y0, x1, y1, tag);
+}
+
+int glider_setmode(glider_t *g, uint16_t x0, uint16_t y0, uint16_t x1,
+        uint16_t y1, uint8_t mode, uint32_t tag) {
+    return submit(g, GLIDER_CMD_SETMODE, mode, x0, y0, x1, y1, tag);
+}
+
+int glider_region_set(glider_t *g, uint8_t id, uint16_t x0, uint16_t y0,
+        uint16_t x1, uint16_t y1, uint8_t mode, uint32_t tag) {
+    if ((id >= GLIDER_REGION_ID_MAX) || (mode > 0x0f))
+        return GLIDER_EINVAL;
+    return submit(g, GLIDER_CMD_REGION_SET, id | (mode << 4), x0, y0, x1, y1,
+            tag);
+}
+
+int glider_region_remove(glider_t *g, uint8_t id, uint32_t tag) {
+    return glider_region_set(g, id, 0, 0, 0, 0, 0, tag);
+}
+
+int glider_region_raise(glider_t *g, uint8_t id, uint32_t tag) {
+    if (id >= GLIDER_REGION_ID_MAX)
+        return GLIDER_EINVAL;
+    return submit(g, GLIDER_CMD_REGION_RAISE, id, 0, 0, 0, 0, tag);
+}
+
+int glider_region_clear(glider_t *g, uint32_t tag) {
+    return submit(g, GLIDER_CMD_REGION_CLEAR, 0, 0, 0, 0, 0, tag);
+}
+
+int glider_flush(glider_t *g, int timeout_ms) {
+    struct timespec ts;
+    int res = GLIDER_OK;
+    deadline_after(&ts, timeout_ms);
+    pthread_mutex_lock(&g->lock);
+    while (pending_locked(g) != 0) {
+        if (pthread_cond_timedwait(&g->idle_cond, &g->lock, &ts) != 0) {
+            res = (pending_locked(g) != 0) ? GLIDER_ETIMEDOUT : GLIDER_OK;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&g->lock);
+    return res;
+}
+
+uint32_t glider_pending(glider_t *g) {
+    pthread_mutex_lock(&g->lock);
+    uint32_t pending = pending_locked(g);
+    pthread_mutex_unlock(&g->lock);
+    return pending;
+}
+
+void glider_get_stats(glider_t *g, glider_stats_t *stats) {
+    pthread_mutex_lock(&g->lock);
+    *stats = g->stats;
+    pthread_mutex_unlock(&g->lock);
+}
+
+const char *glider_strerror(int err) {
+    switch (err) {
+    case GLIDER_OK: return "Success";
+    case GLIDER_EAGAIN: return "Submission queue full";
+    case GLIDER_EIO: return "Transport error";
+    case GLIDER_ETIMEDOUT: return "Timed out";
+    case GLIDER_EDEVICE: return "Device reported failure";
+    case GLIDER_EINVAL: return "Invalid argument";
+    case GLIDER_ENODEV: return "No device or backend not built";
+    default: return "Unknown error";
+    }
+}
@@ -0,0 +1,176 @@
+//
+// libglider, Glider host library
+// Copyright 2025 Wenting Zhang
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+// C client for the Glider USB interface. Region commands are queued without
+// blocking the caller and sent by a worker thread, using HID protocol v2
+// (see fw/User/usbapp.h) to batch commands and keep several reports in
+// flight. Completion is reported through a callback.
+//
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Mirrors fw/User/usbapp.h
+#define GLIDER_CMD_REDRAW       0x04
+#define GLIDER_CMD_SETMODE      0x05
+#define GLIDER_CMD_REGION_SET   0x0a
+#define GLIDER_CMD_REGION_RAISE 0x0b
+#define GLIDER_CMD_REGION_CLEAR 0x0c
+#define GLIDER_REGION_ID_MAX    16
+#define GLIDER_RET_GENERALFAIL  0x00
+#define GLIDER_RET_CHKSUMFAIL   0x01
+#define GLIDER_RET_SUCCESS      0x55
+#define GLIDER_V2_MAGIC         0x82
+#define GLIDER_V2_TYPE_ACK      0x01
+#define GLIDER_V2_FLAG_ACK      0x01
+#define GLIDER_V2_FLAG_RESET    0x02
+#define GLIDER_V2_HDR_SIZE      5
+#define GLIDER_V2_CMD_SIZE      10
+#define GLIDER_V2_MAX_CMDS      5
+#define GLIDER_V2_CRC_OFFSET    62
+#define GLIDER_V2_WINDOW        32
+#define GLIDER_V2_ACK_INTERVAL  (GLIDER_V2_WINDOW / 2)
+#define GLIDER_V1_CRC_OFFSET    13
+
+#define GLIDER_REPORT_SIZE      64
+#define GLIDER_VID              0x0483
+#define GLIDER_PID              0x5750
+
+// Return codes, negative values are errors
+#define GLIDER_OK               0
+#define GLIDER_EAGAIN           (-1)    // Submission queue full
+#define GLIDER_EIO              (-2)    // Transport error
+#define GLIDER_ETIMEDOUT        (-3)
+#define GLIDER_EDEVICE          (-4)    // Device reported a failure
+#define GLIDER_EINVAL           (-5)
+#define GLIDER_ENODEV           (-6)    // Backend not built or no device
+
+typedef enum {
+    GLIDER_BACKEND_HIDAPI,
+    GLIDER_BACKEND_LIBUSB,
+    GLIDER_BACKEND_LOOPBACK,
+    GLIDER_BACKEND_SOCKET,      // utils/glider_emu
+    GLIDER_BACKEND_CUSTOM       // Transport passed to glider_open_transport
+} glider_backend_t;
+
+typedef enum {
+    GLIDER_PROTO_V1,            // One command per report, wait for each reply
+    GLIDER_PROTO_V2
+} glider_proto_t;
+
+// Moves 64 byte reports to and from the device. write() may block until the
+// report is on the bus, read() returns 1 when a report is received, 0 on
+// timeout and a negative value on errors. Both are only called from the
+// worker threads, write() and read() concurrently.
+typedef struct {
+    void *ctx;
+    int (*write)(void *ctx, const uint8_t *report);
+    int (*read)(void *ctx, uint8_t *report, int timeout_ms);
+    void (*close)(void *ctx);
+} glider_transport_t;
+
+// Called from the receive thread once a command is acknowledged. status is
+// GLIDER_OK or a negative error code, latency_ns is from submission.
+typedef void (*glider_done_cb_t)(void *ctx, uint32_t tag, int status,
+        uint64_t latency_ns);
+
+typedef struct {
+    glider_backend_t backend;
+    glider_proto_t protocol;
+    uint16_t vid;
+    uint16_t pid;
+    uint32_t queue_length;      // Submission queue, rounded up to power of 2
+    uint32_t timeout_ms;        // Resend (v2) or fail (v1) after no answer
+    const char *socket_path;    // Socket backend only
+    glider_done_cb_t done_cb;
+    void *cb_ctx;
+    // Loopback backend only
+    uint32_t loopback_interval_us;  // HID polling interval, each direction
+    uint32_t loopback_service_us;   // Device time spent on each command
+    uint32_t loopback_error_ppm;    // Reports corrupted on the way out
+} glider_config_t;
+
+typedef struct {
+    uint64_t submitted;
+    uint64_t rejected;          // Submission returned EAGAIN
+    uint64_t completed;
+    uint64_t failed;
+    uint64_t reports_sent;
+    uint64_t reports_received;
+    uint64_t resent;            // Commands sent again after an error
+    uint64_t bad_reports;       // Received reports failing CRC or framing
+} glider_stats_t;
+
+typedef struct glider glider_t;
+
+void glider_config_default(glider_config_t *cfg);
+glider_t *glider_open(const glider_config_t *cfg);
+glider_t *glider_open_transport(const glider_config_t *cfg,
+        const glider_transport_t *transport);
+// Waits for outstanding commands up to timeout_ms before closing
+void glider_close(glider_t *g, int timeout_ms);
+
+// Never block on the device, safe to call from a render thread. tag is passed
+// back to the completion callback.
+int glider_redraw(glider_t *g, uint16_t x0, uint16_t y0, uint16_t x1,
+        uint16_t y1, uint32_t tag);
+int glider_setmode(glider_t *g, uint16_t x0, uint16_t y0, uint16_t x1,
+        uint16_t y1, uint8_t mode, uint32_t tag);
+// Window level modes. The device keeps a stack of regions, each with an
+// update mode, and only reprograms the pixels whose mode actually changes.
+// A new id goes on top, an existing one is moved without changing its place
+// in the stack. An empty rectangle removes the region.
+int glider_region_set(glider_t *g, uint8_t id, uint16_t x0, uint16_t y0,
+        uint16_t x1, uint16_t y1, uint8_t mode, uint32_t tag);
+int glider_region_remove(glider_t *g, uint8_t id, uint32_t tag);
+int glider_region_raise(glider_t *g, uint8_t id, uint32_t tag);
+// Remove all regions, the screen goes back to the mode set on the device
+int glider_region_clear(glider_t *g, uint32_t tag);
+// Block until every submitted command is acknowledged
+int glider_flush(glider_t *g, int timeout_ms);
+uint32_t glider_pending(glider_t *g);
+void glider_get_stats(glider_t *g, glider_stats_t *stats);
+const char *glider_strerror(int err);
+
+// CRC16-CCITT as used by the firmware, 8 bytes per step
+uint16_t glider_crc16_update(uint16_t crc, const void *buf, size_t len);
+uint16_t glider_crc16(const void *buf, size_t len);
+
+// Backends, fill in a transport. Return GLIDER_OK or an error.
+int glider_hidapi_open(const glider_config_t *cfg, glider_transport_t *tr);
+int glider_libusb_open(const glider_config_t *cfg, glider_transport_t *tr);
+int glider_loopback_open(const glider_config_t *cfg, glider_transport_t *tr);
+int glider_socket_open(const glider_config_t *cfg, glider_transport_t *tr);
+// Device side service times as text, socket backend only. Returns the
+// length, or a negative error. Must not be used while a glider_t is open on
+// the same transport.
+int glider_socket_stats(const glider_config_t *cfg, char *buf, size_t len);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,424 @@
+//
+// libglider, Glider host library
+// Copyright 2025 Wenting Zhang
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#include <stdlib.h>
+#include <string.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+#include "glider_auto.h"
+
+#define CLASS_NONE          0xff
+
+typedef enum {
+    CONTENT_TEXT,           // Mostly black and white, or flat
+    CONTENT_IMAGE           // Many mid-tones
+} content_t;
+
+typedef struct {
+    uint8_t cls;            // In use
+    uint8_t sent;           // Last class sent to the device
+    uint8_t candidate;      // Class waiting for switch_frames
+    uint8_t content;
+    uint16_t candidate_frames;
+    uint16_t idle;          // Frames since the last change
+    uint16_t activity;      // Changed area average, 1/4096 units
+} tile_t;
+
+typedef struct {
+    uint16_t x0;
+    uint16_t x1;
+    uint16_t y0;
+    uint8_t cls;
+    bool matched;
+} run_t;
+
+struct glider_auto {
+    glider_auto_config_t cfg;
+    glider_t *g;
+    uint16_t tiles_x;
+    uint16_t tiles_y;
+    tile_t *tiles;
+    uint8_t *classes;
+    uint8_t *prev;
+    bool have_prev;
+    // Scratch for building rectangles, one tile row wide
+    run_t *runs;
+    run_t *open;
+    glider_auto_stats_t stats;
+};
+
+void glider_auto_config_default(glider_auto_config_t *cfg, uint16_t width,
+        uint16_t height) {
+    memset(cfg, 0, sizeof(*cfg));
+    cfg->width = width;
+    cfg->height = height;
+    cfg->tile = 64;
+    cfg->modes[GLIDER_CLASS_STILL] = 6;     // UM_AUTO_LUT_NO_DITHER
+    cfg->modes[GLIDER_CLASS_TYPING] = 5;    // UM_FAST_GREY
+    cfg->modes[GLIDER_CLASS_SCROLL] = 3;    // UM_FAST_MONO_BAYER
+    cfg->modes[GLIDER_CLASS_VIDEO] = 4;     // UM_FAST_MONO_BLUE_NOISE
+    cfg->diff_threshold = 8;
+    cfg->edge_threshold = 64;
+    cfg->still_frames = 60;
+    cfg->switch_frames = 4;
+    cfg->scroll_enter = 20;
+    cfg->scroll_leave = 8;
+    cfg->video_enter = 64;
+    cfg->video_leave = 24;
+    cfg->image_midtones = 64;
+}
+
+/*** Kernels ***/
+
+uint32_t glider_auto_count_changed(const uint8_t *cur, const uint8_t *prev,
+        int len, uint8_t threshold, bool simd) {
+    uint32_t count = 0;
+    int i = 0;
+#ifdef __SSE2__
+    if (simd) {
+        const __m128i t = _mm_set1_epi8((char)threshold);
+        const __m128i zero = _mm_setzero_si128();
+        for (; i + 16 <= len; i += 16) {
+            __m128i a = _mm_loadu_si128((const __m128i *)(cur + i));
+            __m128i b = _mm_loadu_si128((const __m128i *)(prev + i));
+            __m128i d = _mm_or_si128(_mm_subs_epu8(a, b), _mm_subs_epu8(b, a));
+            // Lanes at or below the threshold saturate to 0
+            __m128i same = _mm_cmpeq_epi8(_mm_subs_epu8(d, t), zero);
+            count += 16 - __builtin_popcount(_mm_movemask_epi8(same));
+        }
+    }
+#endif
+    for (; i < len; i++) {
+        int d = cur[i] - prev[i];
+        count += (abs(d) > threshold);
+    }
+    return count;
+}
+
+void glider_auto_row_metrics(const uint8_t *p, int len, uint8_t threshold,
+        uint32_t bins[4], uint32_t *edges, bool simd) {
+    int i = 0;
+    int e = 0;
+#ifdef __SSE2__
+    if (simd) {
+        // No unsigned compare in SSE2, flip the sign bit and compare signed
+        const __m128i sign = _mm_set1_epi8((char)0x80);
+        const __m128i t64 = _mm_set1_epi8((char)(63 ^ 0x80));
+        const __m128i t128 = _mm_set1_epi8((char)(127 ^ 0x80));
+        const __m128i t192 = _mm_set1_epi8((char)(191 ^ 0x80));
+        uint32_t n64 = 0, n128 = 0, n192 = 0;
+        for (; i + 16 <= len; i += 16) {
+            __m128i v = _mm_xor_si128(
+                    _mm_loadu_si128((const __m128i *)(p + i)), sign);
+            n64 += __builtin_popcount(_mm_movemask_epi8(_mm_cmpgt_epi8(v, t64)));
+            n128 += __builtin_popcount(_mm_movemask_epi8(_mm_cmpgt_epi8(v, t128)));
+            n192 += __builtin_popcount(_mm_movemask_epi8(_mm_cmpgt_epi8(v, t192)));
+        }
+        bins[0] += i - n64;
+        bins[1] += n64 - n128;
+        bins[2] += n128 - n192;
+        bins[3] += n192;
+        // Each step compares 16 pixels with their right neighbours
+        const __m128i t = _mm_set1_epi8((char)threshold);
+        const __m128i zero = _mm_setzero_si128();
+        for (; e + 17 <= len; e += 16) {
+            __m128i a = _mm_loadu_si128((const __m128i *)(p + e));
+            __m128i b = _mm_loadu_si128((const __m128i *)(p + e + 1));
+            __m128i d = _mm_or_si128(_mm_subs_epu8(a, b), _mm_subs_epu8(b, a));
+            __m128i flat = _mm_cmpeq_epi8(_mm_subs_epu8(d, t), zero);
+            *edges += 16 - __builtin_popcount(_mm_movemask_epi8(flat));
+        }
+    }
+#endif
+    for (; i < len; i++)
+        bins[p[i] >> 6]++;
+    for (; e + 1 < len; e++) {
+        int d = p[e + 1] - p[e];
+        *edges += (abs(d) > threshold);
+    }
+}
+
+/*** Classification ***/
+
+#ifdef __SSE2__
+#define USE_SIMD    true
+#else
+#define USE_SIMD    false
+#endif
+
+static void tile_bounds(glider_auto_t *a, int tx, int ty, int *x, int *y,
+        int *w, int *h) {
+    *x = tx * a->cfg.tile;
+    *y = ty * a->cfg.tile;
+    *w = (*x + a->cfg.tile > a->cfg.width) ? a->cfg.width - *x : a->cfg.tile;
+    *h = (*y + a->cfg.tile > a->cfg.height) ? a->cfg.height - *y : a->cfg.tile;
+}
+
+static uint8_t classify_content(glider_auto_t *a, const uint8_t *frame,
+        size_t stride, int x, int y, int w, int h) {
+    uint32_t bins[4] = {0};
+    uint32_t edges = 0;
+    for (int j = 0; j < h; j++)
+        glider_auto_row_metrics(frame + (y + j) * stride + x, w,
+                a->cfg.edge_threshold, bins, &edges, USE_SIMD);
+    uint32_t pixels = w * h;
+    uint32_t midtones = bins[1] + bins[2];
+    // Greyscale content either has plenty of mid-tones, or mid-tones without
+    // the sharp edges of anti-aliased text
+    if ((midtones * 256 >= a->cfg.image_midtones * pixels) ||
+            ((midtones * 1024 >= a->cfg.image_midtones * pixels) &&
+            (edges * 64 < pixels)))
+        return CONTENT_IMAGE;
+    return CONTENT_TEXT;
+}
+
+static uint8_t candidate_class(glider_auto_t *a, const tile_t *t) {
+    const glider_auto_config_t *cfg = &a->cfg;
+    if (t->idle >= cfg->still_frames)
+        return GLIDER_CLASS_STILL;
+    uint16_t act = t->activity >> 4;
+    bool video = (t->cls == GLIDER_CLASS_VIDEO);
+    bool fast = video || (t->cls == GLIDER_CLASS_SCROLL);
+    if ((t->content == CONTENT_IMAGE) && ((act >= cfg->video_enter) ||
+            (video && (act >= cfg->video_leave))))
+        return GLIDER_CLASS_VIDEO;
+    if ((act >= cfg->scroll_enter) || (fast && (act >= cfg->scroll_leave)))
+        return GLIDER_CLASS_SCROLL;
+    return GLIDER_CLASS_TYPING;
+}
+
+static void update_tile(glider_auto_t *a, tile_t *t, uint32_t changed,
+        uint32_t pixels) {
+    // Average over about 16 frames, a scrolling page has gaps between lines
+    uint32_t fraction = changed * 256 / pixels;
+    t->activity = t->activity - (t->activity >> 4) + fraction;
+    if (changed) {
+        t->idle = 0;
+        a->stats.tiles_changed++;
+    }
+    else if (t->idle < 0xffff) {
+        t->idle++;
+    }
+    uint8_t cls = candidate_class(a, t);
+    if (cls == t->cls) {
+        t->candidate_frames = 0;
+        return;
+    }
+    if (cls != t->candidate) {
+        t->candidate = cls;
+        t->candidate_frames = 0;
+    }
+    if (++t->candidate_frames >= a->cfg.switch_frames) {
+        t->cls = cls;
+        t->candidate_frames = 0;
+        a->stats.switches++;
+    }
+}
+
+/*** Sending ***/
+
+static void mark_sent(glider_auto_t *a, const run_t *r, uint16_t y1) {
+    for (int ty = r->y0; ty < y1; ty++) {
+        for (int tx = r->x0; tx < r->x1; tx++)
+            a->tiles[ty * a->tiles_x + tx].sent = r->cls;
+    }
+}
+
+// Send one rectangle of tiles, in tile units. Returns false if the queue is
+// full, the tiles are tried again on the next frame.
+static bool send_rect(glider_auto_t *a, const run_t *r, uint16_t y1) {
+    if (a->g) {
+        int x0 = r->x0 * a->cfg.tile;
+        int y0 = r->y0 * a->cfg.tile;
+        int x1 = r->x1 * a->cfg.tile;
+        int y1p = y1 * a->cfg.tile;
+        if (x1 > a->cfg.width)
+            x1 = a->cfg.width;
+        if (y1p > a->cfg.height)
+            y1p = a->cfg.height;
+        int err = glider_setmode(a->g, x0, y0, x1, y1p, a->cfg.modes[r->cls],
+                0);
+        if (err == GLIDER_EAGAIN) {
+            a->stats.rejected++;
+            return false;
+        }
+    }
+    a->stats.commands++;
+    mark_sent(a, r, y1);
+    return true;
+}
+
+// Tiles whose class changed since it was last sent, merged into horizontal
+// runs, and runs identical to the row above into rectangles
+static int send_changes(glider_auto_t *a) {
+    int open_count = 0;
+    int sent = 0;
+    for (int ty = 0; ty <= a->tiles_y; ty++) {
+        int run_count = 0;
+        for (int tx = 0; (ty < a->tiles_y) && (tx < a->tiles_x); tx++) {
+            tile_t *t = &a->tiles[ty * a->tiles_x + tx];
+            if (t->cls == t->sent)
+                continue;
+            run_t *last = run_count ? &a->runs[run_count - 1] : NULL;
+            if (last && (last->x1 == tx) && (last->cls == t->cls)) {
+                last->x1 = tx + 1;
+                continue;
+            }
+            run_t *r = &a->runs[run_count++];
+            r->x0 = tx;
+            r->x1 = tx + 1;
+            r->y0 = ty;
+            r->cls = t->cls;
+        }
+        for (int k = 0; k < open_count; k++)
+            a->open[k].matched = false;
+        for (int s = 0; s < run_count; s++) {
+            a->runs[s].matched = false;
+            for (int k = 0; k < open_count; k++) {
+                if (!a->open[k].matched && (a->open[k].x0 == a->runs[s].x0) &&
+                        (a->open[k].x1 == a->runs[s].x1) &&
+                        (a->open[k].cls == a->runs[s].cls)) {
+                    a->open[k].matched = true;
+                    a->runs[s].matched = true;
+                    break;
+                }
+            }
+        }
+        int kept = 0;
+        for (int k = 0; k < open_count; k++) {
+            if (a->open[k].matched) {
+                a->open[kept++] = a->open[k];
+            }
+            else {
+                if (!send_rect(a, &a->open[k], ty))
+                    return sent;
+                sent++;
+            }
+        }
+        open_count = kept;
+        for (int s = 0; s < run_count; s++) {
+            if (!a->runs[s].matched)
+                a->open[open_count++] = a->runs[s];
+        }
+    }
+    return sent;
+}
+
+/*** API ***/
+
+glider_auto_t *glider_auto_create(const glider_auto_config_t *cfg,
+        glider_t *g) {
+    if ((cfg->tile == 0) || (cfg->tile % 16) || (cfg->width == 0) ||
+            (cfg->height == 0))
+        return NULL;
+    glider_auto_t *a = calloc(1, sizeof(glider_auto_t));
+    if (!a)
+        return NULL;
+    a->cfg = *cfg;
+    a->g = g;
+    a->tiles_x = (cfg->width + cfg->tile - 1) / cfg->tile;
+    a->tiles_y = (cfg->height + cfg->tile - 1) / cfg->tile;
+    int count = a->tiles_x * a->tiles_y;
+    a->tiles = calloc(count, sizeof(tile_t));
+    a->classes = calloc(count, 1);
+    a->prev = malloc((size_t)cfg->width * cfg->height);
+    a->runs = calloc(a->tiles_x, sizeof(run_t));
+    a->open = calloc(a->tiles_x, sizeof(run_t));
+    if (!a->tiles || !a->classes || !a->prev || !a->runs || !a->open) {
+        glider_auto_destroy(a);
+        return NULL;
+    }
+    for (int i = 0; i < count; i++) {
+        // Nothing known about the screen, start still and send everything
+        a->tiles[i].cls = GLIDER_CLASS_STILL;
+        a->tiles[i].sent = CLASS_NONE;
+        a->tiles[i].candidate = GLIDER_CLASS_STILL;
+        a->tiles[i].idle = cfg->still_frames;
+    }
+    return a;
+}
+
+void glider_auto_destroy(glider_auto_t *a) {
+    if (!a)
+        return;
+    free(a->tiles);
+    free(a->classes);
+    free(a->prev);
+    free(a->runs);
+    free(a->open);
+    free(a);
+}
+
+int glider_auto_frame(glider_auto_t *a, const uint8_t *frame, size_t stride) {
+    if (stride < a->cfg.width)
+        return GLIDER_EINVAL;
+    for (int ty = 0; ty < a->tiles_y; ty++) {
+        for (int tx = 0; tx < a->tiles_x; tx++) {
+            tile_t *t = &a->tiles[ty * a->tiles_x + tx];
+            int x, y, w, h;
+            tile_bounds(a, tx, ty, &x, &y, &w, &h);
+            uint32_t changed = 0;
+            if (a->have_prev) {
+                for (int j = 0; j < h; j++)
+                    changed += glider_auto_count_changed(
+                            frame + (y + j) * stride + x,
+                            a->prev + (size_t)(y + j) * a->cfg.width + x, w,
+                            a->cfg.diff_threshold, USE_SIMD);
+            }
+            if (changed || !a->have_prev) {
+                t->content = classify_content(a, frame, stride, x, y, w, h);
+                for (int j = 0; j < h; j++)
+                    memcpy(a->prev + (size_t)(y + j) * a->cfg.width + x,
+                            frame + (y + j) * stride + x, w);
+            }
+            update_tile(a, t, changed, w * h);
+            a->classes[ty * a->tiles_x + tx] = t->cls;
+        }
+    }
+    a->have_prev = true;
+    a->stats.frames++;
+    return send_changes(a);
+}
+
+const uint8_t *glider_auto_classes(glider_auto_t *a, uint16_t *tiles_x,
+        uint16_t *tiles_y) {
+    if (tiles_x)
+        *tiles_x = a->tiles_x;
+    if (tiles_y)
+        *tiles_y = a->tiles_y;
+    return a->classes;
+}
+
+void glider_auto_get_stats(glider_auto_t *a, glider_auto_stats_t *stats) {
+    *stats = a->stats;
+}
+
+const char *glider_class_name(glider_class_t cls) {
+    switch (cls) {
+    case GLIDER_CLASS_STILL: return "still";
+    case GLIDER_CLASS_TYPING: return "typing";
+    case GLIDER_CLASS_SCROLL: return "scroll";
+    case GLIDER_CLASS_VIDEO: return "video";
+    default: return "unknown";
+    }
+}
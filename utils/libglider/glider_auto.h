@@ -0,0 +1,106 @@
+//
+// libglider, Glider host library
+// Copyright 2025 Wenting Zhang
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+// Automatic update mode selection from the framebuffer. Each frame is split
+// into tiles, and every tile that changed since the previous frame is
+// classified by how much of it changed and by its content (a 4 bin
+// histogram and horizontal edge count). Tiles settle on one of the classes
+// below, with separate enter and leave thresholds and a minimum number of
+// frames before a tile switches, so content on the border between two
+// classes doesn't flip back and forth. Tiles whose class changed are merged
+// into rectangles and sent with glider_setmode().
+//
+// Frames are 8 bit greyscale. The per pixel work uses SSE2 where available
+// and is cheap enough for 1600x1200 at 60Hz on one core, unchanged tiles
+// only cost a comparison against the previous frame.
+//
+#pragma once
+
+#include "glider.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+    GLIDER_CLASS_STILL,         // Nothing changed for a while
+    GLIDER_CLASS_TYPING,        // Small changes to text
+    GLIDER_CLASS_SCROLL,        // Large changes to text, scrolling or paging
+    GLIDER_CLASS_VIDEO,         // Large changes to greyscale content
+    GLIDER_CLASS_COUNT
+} glider_class_t;
+
+typedef struct {
+    uint16_t width;
+    uint16_t height;
+    uint16_t tile;              // Tile size in pixels, multiple of 16
+    // Update mode sent for each class, defaults follow the firmware button
+    // modes: Reading, Typing, Browsing and Watching
+    uint8_t modes[GLIDER_CLASS_COUNT];
+    uint8_t diff_threshold;     // Pixel counts as changed above this
+    uint8_t edge_threshold;     // Horizontal step counted as an edge
+    uint16_t still_frames;      // Unchanged frames before a tile is still
+    uint16_t switch_frames;     // Frames a new class must hold before use
+    // Changed area of a tile, averaged over recent frames, in 1/256 units.
+    // A tile enters a class at the first value and leaves below the second.
+    uint16_t scroll_enter;
+    uint16_t scroll_leave;
+    uint16_t video_enter;
+    uint16_t video_leave;
+    uint8_t image_midtones;     // Mid-tone pixels of a greyscale tile, 1/256
+} glider_auto_config_t;
+
+typedef struct {
+    uint64_t frames;
+    uint64_t tiles_changed;     // Tiles that differed from the previous frame
+    uint64_t switches;          // Tiles that moved to another class
+    uint64_t commands;          // glider_setmode() calls
+    uint64_t rejected;          // Calls retried because the queue was full
+} glider_auto_stats_t;
+
+typedef struct glider_auto glider_auto_t;
+
+void glider_auto_config_default(glider_auto_config_t *cfg, uint16_t width,
+        uint16_t height);
+// g may be NULL to only classify, without sending anything
+glider_auto_t *glider_auto_create(const glider_auto_config_t *cfg,
+        glider_t *g);
+void glider_auto_destroy(glider_auto_t *a);
+// Analyze one frame, stride is in bytes. Returns the number of setmode
+// commands submitted, or a negative error.
+int glider_auto_frame(glider_auto_t *a, const uint8_t *frame, size_t stride);
+// Current class of each tile, row by row
+const uint8_t *glider_auto_classes(glider_auto_t *a, uint16_t *tiles_x,
+        uint16_t *tiles_y);
+void glider_auto_get_stats(glider_auto_t *a, glider_auto_stats_t *stats);
+const char *glider_class_name(glider_class_t cls);
+
+// Per tile kernels, exposed for testing the SIMD ones against plain C
+uint32_t glider_auto_count_changed(const uint8_t *cur, const uint8_t *prev,
+        int len, uint8_t threshold, bool simd);
+// Adds to bins (below 64, 128, 192 and the rest) and the edge count
+void glider_auto_row_metrics(const uint8_t *p, int len, uint8_t threshold,
+        uint32_t bins[4], uint32_t *edges, bool simd);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,360 @@
+//
+// libglider, Glider host library
+// Copyright 2025 Wenting Zhang
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+// Cost and behaviour of the automatic mode selection. Frames come from a
+// recorded sequence (raw 8 bit greyscale, width * height bytes per frame)
+// or from a synthetic desktop with a terminal being typed into, a scrolling
+// page, a video and a still picture, one per quadrant. Reports analysis time
+// per frame, the setmode commands sent, and for the synthetic desktop how
+// often each quadrant is in the expected class.
+//
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <math.h>
+#include <time.h>
+#include "glider_auto.h"
+
+#define GLYPH_W         8
+#define GLYPH_H         14
+#define SCROLL_STEP     4
+#define WARMUP_FRAMES   120
+
+typedef struct {
+    int w;
+    int h;
+    uint8_t *page;          // Text page scrolled through, 2 screens tall
+    int8_t *wave;           // Video pattern, sine table
+    int cursor_x;
+    int cursor_y;
+    uint32_t seed;
+} desktop_t;
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+static uint32_t rnd(desktop_t *d) {
+    d->seed = d->seed * 1103515245 + 12345;
+    return d->seed >> 16;
+}
+
+// Random black strokes inside a glyph cell, with a 1 pixel margin
+static void draw_glyph(desktop_t *d, uint8_t *buf, int stride, int x, int y) {
+    for (int j = 2; j < GLYPH_H - 2; j++) {
+        uint32_t bits = rnd(d);
+        for (int i = 1; i < GLYPH_W - 1; i++)
+            buf[(y + j) * stride + x + i] = (bits & (1 << i)) ? 0x00 : 0xff;
+    }
+}
+
+static void draw_text(desktop_t *d, uint8_t *buf, int stride, int w, int h) {
+    memset(buf, 0xff, (size_t)stride * h);
+    for (int y = 0; y + GLYPH_H <= h; y += GLYPH_H) {
+        int len = (rnd(d) % (w / GLYPH_W));
+        for (int x = 0; x < len; x++) {
+            if (rnd(d) % 6)
+                draw_glyph(d, buf, stride, x * GLYPH_W, y);
+        }
+    }
+}
+
+static void desktop_init(desktop_t *d, int w, int h) {
+    d->w = w;
+    d->h = h;
+    d->seed = 1;
+    d->page = malloc((size_t)(w / 2) * h);
+    draw_text(d, d->page, w / 2, w / 2, h);
+    d->wave = malloc(1024);
+    for (int i = 0; i < 1024; i++)
+        d->wave[i] = (int8_t)(110.0 * sin(i * 2.0 * M_PI / 1024));
+    d->cursor_x = 0;
+    d->cursor_y = h / 4;
+}
+
+static void desktop_frame(desktop_t *d, uint8_t *fb, int frame) {
+    int qw = d->w / 2;
+    int qh = d->h / 2;
+    if (frame == 0) {
+        // Terminal with some output already on it, still picture
+        draw_text(d, fb, d->w, qw, d->cursor_y);
+        for (int y = d->cursor_y; y < qh; y++)
+            memset(fb + y * d->w, 0xff, qw);
+        for (int y = qh; y < d->h; y++) {
+            for (int x = qw; x < d->w; x++)
+                fb[y * d->w + x] = ((x - qw) * 255 / qw + (y - qh) * 255 / qh) / 2;
+        }
+    }
+    // Typing, a character every 3 frames
+    if (frame % 3 == 0) {
+        draw_glyph(d, fb, d->w, d->cursor_x, d->cursor_y);
+        d->cursor_x += GLYPH_W;
+        if (d->cursor_x + GLYPH_W > qw) {
+            d->cursor_x = 0;
+            d->cursor_y += GLYPH_H;
+            if (d->cursor_y + GLYPH_H > qh)
+                d->cursor_y = qh / 2;
+        }
+    }
+    // Page scrolling, wraps around the second screen
+    int offset = (frame * SCROLL_STEP) % (d->h - qh);
+    for (int y = 0; y < qh; y++)
+        memcpy(fb + y * d->w + qw, d->page + (size_t)(y + offset) * qw, qw);
+    // Video, two moving waves
+    for (int y = qh; y < d->h; y++) {
+        int wy = d->wave[(y * 7 - frame * 29) & 1023];
+        uint8_t *row = fb + y * d->w;
+        for (int x = 0; x < qw; x++)
+            row[x] = 128 + ((d->wave[(x * 9 + frame * 41) & 1023] + wy) >> 1);
+    }
+}
+
+static int cmp_u64(const void *a, const void *b) {
+    uint64_t x = *(const uint64_t *)a;
+    uint64_t y = *(const uint64_t *)b;
+    return (x > y) - (x < y);
+}
+
+// Tiles fully inside quadrant q that are in class cls
+static void count_quadrant(const uint8_t *classes, int tiles_x, int tile,
+        int w, int h, int q, uint8_t cls, uint64_t *hit, uint64_t *total) {
+    int qx0 = (q & 1) ? w / 2 : 0;
+    int qy0 = (q & 2) ? h / 2 : 0;
+    for (int ty = (qy0 + tile - 1) / tile; (ty + 1) * tile <= qy0 + h / 2; ty++) {
+        for (int tx = (qx0 + tile - 1) / tile; (tx + 1) * tile <= qx0 + w / 2;
+                tx++) {
+            *hit += (classes[ty * tiles_x + tx] == cls);
+            (*total)++;
+        }
+    }
+}
+
+static bool check_kernels(const uint8_t *a, const uint8_t *b, int len) {
+    uint32_t bins_c[4] = {0}, bins_s[4] = {0};
+    uint32_t edges_c = 0, edges_s = 0;
+    glider_auto_row_metrics(a, len, 64, bins_c, &edges_c, false);
+    glider_auto_row_metrics(a, len, 64, bins_s, &edges_s, true);
+    return (glider_auto_count_changed(a, b, len, 8, false) ==
+            glider_auto_count_changed(a, b, len, 8, true)) &&
+            (memcmp(bins_c, bins_s, sizeof(bins_c)) == 0) &&
+            (edges_c == edges_s);
+}
+
+static double kernel_ms(const uint8_t *a, const uint8_t *b, size_t len,
+        bool simd) {
+    uint64_t start = now_ns();
+    uint32_t bins[4] = {0}, edges = 0;
+    volatile uint32_t sink = 0;
+    for (int i = 0; i < 10; i++) {
+        sink += glider_auto_count_changed(a, b, len, 8, simd);
+        glider_auto_row_metrics(a, len, 64, bins, &edges, simd);
+    }
+    (void)sink;
+    return (now_ns() - start) / 10 / 1e6;
+}
+
+static void usage(const char *name) {
+    fprintf(stderr, "Usage: %s [options]\n"
+            "  -i file      Replay recorded frames, raw 8 bit greyscale\n"
+            "  -r file      Record the synthetic desktop\n"
+            "  -w width     Frame width (default 1600)\n"
+            "  -h height    Frame height (default 1200)\n"
+            "  -n frames    Frames to run (default 600)\n"
+            "  -t tile      Tile size (default 64)\n"
+            "  -b backend   none, loopback (default), hidapi, libusb or socket[:path]\n",
+            name);
+}
+
+int main(int argc, char *argv[]) {
+    const char *in_fn = NULL;
+    const char *rec_fn = NULL;
+    int w = 1600, h = 1200, frames = 600, tile = 64;
+    bool send = true;
+    glider_config_t gcfg;
+    int opt;
+
+    glider_config_default(&gcfg);
+    gcfg.backend = GLIDER_BACKEND_LOOPBACK;
+    gcfg.loopback_interval_us = 125;
+    gcfg.queue_length = 1024;
+    while ((opt = getopt(argc, argv, "i:r:w:h:n:t:b:")) != -1) {
+        switch (opt) {
+        case 'i': in_fn = optarg; break;
+        case 'r': rec_fn = optarg; break;
+        case 'w': w = atoi(optarg); break;
+        case 'h': h = atoi(optarg); break;
+        case 'n': frames = atoi(optarg); break;
+        case 't': tile = atoi(optarg); break;
+        case 'b':
+            send = strcmp(optarg, "none") != 0;
+            if (strcmp(optarg, "hidapi") == 0)
+                gcfg.backend = GLIDER_BACKEND_HIDAPI;
+            else if (strcmp(optarg, "libusb") == 0)
+                gcfg.backend = GLIDER_BACKEND_LIBUSB;
+            else if (strncmp(optarg, "socket", 6) == 0) {
+                gcfg.backend = GLIDER_BACKEND_SOCKET;
+                if (optarg[6] == ':')
+                    gcfg.socket_path = optarg + 7;
+            }
+            else
+                gcfg.backend = GLIDER_BACKEND_LOOPBACK;
+            break;
+        default:
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    if ((w <= 0) || (h <= 0) || (frames <= 0)) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    size_t frame_size = (size_t)w * h;
+    uint8_t *fb = calloc(frame_size, 1);
+    uint8_t *prev = malloc(frame_size);
+    FILE *in = NULL, *rec = NULL;
+    desktop_t desk;
+    if (in_fn) {
+        in = fopen(in_fn, "rb");
+        if (!in) {
+            fprintf(stderr, "Failed to open %s\n", in_fn);
+            return 1;
+        }
+    }
+    else {
+        desktop_init(&desk, w, h);
+    }
+    if (rec_fn && !(rec = fopen(rec_fn, "wb"))) {
+        fprintf(stderr, "Failed to open %s\n", rec_fn);
+        return 1;
+    }
+
+    glider_t *g = NULL;
+    if (send && !(g = glider_open(&gcfg))) {
+        fprintf(stderr, "Failed to open backend\n");
+        return 1;
+    }
+    glider_auto_config_t cfg;
+    glider_auto_config_default(&cfg, w, h);
+    cfg.tile = tile;
+    glider_auto_t *a = glider_auto_create(&cfg, g);
+    if (!a) {
+        fprintf(stderr, "Invalid analyzer configuration\n");
+        return 1;
+    }
+
+    uint64_t *frame_ns = calloc(frames, sizeof(uint64_t));
+    uint64_t hit[4] = {0}, total[4] = {0};
+    static const uint8_t expected[4] = {
+        GLIDER_CLASS_TYPING, GLIDER_CLASS_SCROLL,
+        GLIDER_CLASS_VIDEO, GLIDER_CLASS_STILL
+    };
+    static const char *quadrant_names[4] = {
+        "terminal", "page", "video", "picture"
+    };
+    bool kernels_match = true;
+    int run = 0;
+    for (int f = 0; f < frames; f++) {
+        memcpy(prev, fb, frame_size);
+        if (in) {
+            if (fread(fb, 1, frame_size, in) != frame_size)
+                break;
+        }
+        else {
+            desktop_frame(&desk, fb, f);
+        }
+        if (rec)
+            fwrite(fb, 1, frame_size, rec);
+        if (f < 4)
+            kernels_match &= check_kernels(fb, prev, frame_size);
+        uint64_t start = now_ns();
+        glider_auto_frame(a, fb, w);
+        frame_ns[run++] = now_ns() - start;
+
+        if (in || (f < WARMUP_FRAMES))
+            continue;
+        uint16_t tiles_x;
+        const uint8_t *classes = glider_auto_classes(a, &tiles_x, NULL);
+        // Only the tile being typed into is expected to be typing
+        int cy = desk.cursor_y / tile;
+        int cx = (desk.cursor_x ? desk.cursor_x - GLYPH_W : 0) / tile;
+        hit[0] += (classes[cy * tiles_x + cx] == GLIDER_CLASS_TYPING);
+        total[0]++;
+        for (int q = 1; q < 4; q++)
+            count_quadrant(classes, tiles_x, tile, w, h, q, expected[q],
+                    &hit[q], &total[q]);
+    }
+    if (g)
+        glider_flush(g, 1000);
+
+    glider_auto_stats_t stats;
+    glider_auto_get_stats(a, &stats);
+    qsort(frame_ns, run, sizeof(uint64_t), cmp_u64);
+    uint64_t sum = 0;
+    for (int i = 0; i < run; i++)
+        sum += frame_ns[i];
+    double avg_ms = run ? sum / 1e6 / run : 0;
+    printf("%d x %d, %d frames, %d px tiles, %s\n", w, h, run, tile,
+            in_fn ? in_fn : "synthetic desktop");
+#ifdef __SSE2__
+    printf("Kernels: SSE2, C reference %s\n", kernels_match ? "match" : "MISMATCH");
+#else
+    printf("Kernels: C only\n");
+#endif
+    printf("Full frame diff+metrics: %.2f ms C, %.2f ms SIMD\n",
+            kernel_ms(fb, prev, frame_size, false),
+            kernel_ms(fb, prev, frame_size, true));
+    if (run) {
+        printf("Analysis: %.3f ms avg, %.3f ms p99, %.3f ms max (%.0f fps)\n",
+                avg_ms, frame_ns[(int)(0.99 * (run - 1))] / 1e6,
+                frame_ns[run - 1] / 1e6, avg_ms ? 1000.0 / avg_ms : 0);
+    }
+    printf("Tiles changed: %.1f per frame, class switches: %llu\n",
+            run ? (double)stats.tiles_changed / run : 0,
+            (unsigned long long)stats.switches);
+    printf("Setmode commands: %llu (%.2f per frame), %llu retried\n",
+            (unsigned long long)stats.commands,
+            run ? (double)stats.commands / run : 0,
+            (unsigned long long)stats.rejected);
+    if (!in) {
+        printf("Expected class after %d frames:\n", WARMUP_FRAMES);
+        for (int q = 0; q < 4; q++)
+            printf("  %-10s %-8s %5.1f%%\n", quadrant_names[q],
+                    glider_class_name(expected[q]),
+                    total[q] ? 100.0 * hit[q] / total[q] : 0);
+    }
+
+    glider_auto_destroy(a);
+    if (g)
+        glider_close(g, 1000);
+    if (in)
+        fclose(in);
+    if (rec)
+        fclose(rec);
+    free(fb);
+    free(prev);
+    free(frame_ns);
+    return kernels_match ? 0 : 1;
+}
@@ -0,0 +1,211 @@
+//
+// libglider, Glider host library
+// Copyright 2025 Wenting Zhang
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+// Throughput and latency of the command pipeline. Commands are either
+// submitted as fast as the queue takes them, or paced like a compositor
+// sending a few damage rectangles every frame. Latency is from submission
+// to acknowledgement.
+//
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sched.h>
+#include <time.h>
+#include "glider.h"
+
+typedef struct {
+    uint64_t *latency_ns;
+    int *status;
+} bench_ctx_t;
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+static void done_cb(void *ctx, uint32_t tag, int status, uint64_t latency_ns) {
+    bench_ctx_t *bc = ctx;
+    bc->latency_ns[tag] = latency_ns;
+    bc->status[tag] = status;
+}
+
+static int cmp_u64(const void *a, const void *b) {
+    uint64_t x = *(const uint64_t *)a;
+    uint64_t y = *(const uint64_t *)b;
+    return (x > y) - (x < y);
+}
+
+static double percentile_us(uint64_t *sorted, int count, double p) {
+    int idx = (int)(p * (count - 1) + 0.5);
+    return sorted[idx] / 1000.0;
+}
+
+static void usage(const char *name) {
+    fprintf(stderr, "Usage: %s [options]\n"
+            "  -b backend   loopback (default), hidapi, libusb or socket[:path]\n"
+            "  -p proto     v1, v2 or both (default)\n"
+            "  -n count     Commands per run (default 1000)\n"
+            "  -f rects     Paced: rects per 60Hz frame, 0 submits back to back\n"
+            "  -i us        Loopback polling interval (default 2000)\n"
+            "  -s us        Loopback service time per command (default 20)\n"
+            "  -e ppm       Loopback corrupted reports (default 0)\n", name);
+}
+
+static int run(const glider_config_t *cfg, int count, int frame_rects) {
+    bench_ctx_t bc;
+    bc.latency_ns = calloc(count, sizeof(uint64_t));
+    bc.status = calloc(count, sizeof(int));
+    uint64_t *submit_ns = calloc(count, sizeof(uint64_t));
+    glider_config_t c = *cfg;
+    c.done_cb = done_cb;
+    c.cb_ctx = &bc;
+    for (int i = 0; i < count; i++)
+        bc.status[i] = 1;
+
+    glider_t *g = glider_open(&c);
+    if (!g) {
+        fprintf(stderr, "Failed to open backend\n");
+        return 1;
+    }
+    uint64_t start = now_ns();
+    uint64_t frame_start = start;
+    for (int i = 0; i < count; i++) {
+        if (frame_rects && (i % frame_rects == 0) && (i != 0)) {
+            frame_start += 1000000000ull / 60;
+            while (now_ns() < frame_start)
+                usleep(100);
+        }
+        // Tiles across a 1600x1200 screen
+        uint16_t x = (i % 16) * 100;
+        uint16_t y = ((i / 16) % 12) * 100;
+        uint64_t t0 = now_ns();
+        while (glider_redraw(g, x, y, x + 99, y + 99, i) == GLIDER_EAGAIN)
+            sched_yield();
+        submit_ns[i] = now_ns() - t0;
+    }
+    int res = glider_flush(g, 10000);
+    uint64_t elapsed = now_ns() - start;
+    glider_stats_t stats;
+    glider_get_stats(g, &stats);
+    glider_close(g, 0);
+    if (res != GLIDER_OK)
+        fprintf(stderr, "Flush failed: %s\n", glider_strerror(res));
+
+    int failed = 0;
+    for (int i = 0; i < count; i++)
+        if (bc.status[i] != GLIDER_OK)
+            failed++;
+    qsort(bc.latency_ns, count, sizeof(uint64_t), cmp_u64);
+    qsort(submit_ns, count, sizeof(uint64_t), cmp_u64);
+    printf("  %-3s %9.0f cmd/s  p50 %8.1f us  p99 %8.1f us  "
+            "submit p99 %5.1f us max %6.1f us\n",
+            (cfg->protocol == GLIDER_PROTO_V2) ? "v2" : "v1",
+            count * 1e9 / elapsed,
+            percentile_us(bc.latency_ns, count, 0.5),
+            percentile_us(bc.latency_ns, count, 0.99),
+            percentile_us(submit_ns, count, 0.99),
+            submit_ns[count - 1] / 1000.0);
+    printf("      %llu reports out, %llu in, %llu resent, %d failed\n",
+            (unsigned long long)stats.reports_sent,
+            (unsigned long long)stats.reports_received,
+            (unsigned long long)stats.resent, failed);
+    free(bc.latency_ns);
+    free(bc.status);
+    free(submit_ns);
+    return (failed || (res != GLIDER_OK)) ? 1 : 0;
+}
+
+int main(int argc, char *argv[]) {
+    glider_config_t cfg;
+    int count = 1000;
+    int frame_rects = 0;
+    bool v1 = true;
+    bool v2 = true;
+    int opt;
+
+    glider_config_default(&cfg);
+    cfg.backend = GLIDER_BACKEND_LOOPBACK;
+    while ((opt = getopt(argc, argv, "b:p:n:f:i:s:e:h")) != -1) {
+        switch (opt) {
+        case 'b':
+            if (strcmp(optarg, "hidapi") == 0)
+                cfg.backend = GLIDER_BACKEND_HIDAPI;
+            else if (strcmp(optarg, "libusb") == 0)
+                cfg.backend = GLIDER_BACKEND_LIBUSB;
+            else if (strncmp(optarg, "socket", 6) == 0) {
+                cfg.backend = GLIDER_BACKEND_SOCKET;
+                if (optarg[6] == ':')
+                    cfg.socket_path = optarg + 7;
+            }
+            else
+                cfg.backend = GLIDER_BACKEND_LOOPBACK;
+            break;
+        case 'p':
+            v1 = strcmp(optarg, "v2") != 0;
+            v2 = strcmp(optarg, "v1") != 0;
+            break;
+        case 'n':
+            count = atoi(optarg);
+            break;
+        case 'f':
+            frame_rects = atoi(optarg);
+            break;
+        case 'i':
+            cfg.loopback_interval_us = atoi(optarg);
+            break;
+        case 's':
+            cfg.loopback_service_us = atoi(optarg);
+            break;
+        case 'e':
+            cfg.loopback_error_ppm = atoi(optarg);
+            break;
+        default:
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    if (count <= 0) {
+        usage(argv[0]);
+        return 1;
+    }
+    if (frame_rects)
+        printf("%d commands, %d per frame at 60Hz\n", count, frame_rects);
+    else
+        printf("%d commands, back to back\n", count);
+    int res = 0;
+    if (v1) {
+        cfg.protocol = GLIDER_PROTO_V1;
+        res |= run(&cfg, count, frame_rects);
+    }
+    if (v2) {
+        cfg.protocol = GLIDER_PROTO_V2;
+        res |= run(&cfg, count, frame_rects);
+    }
+    if (cfg.backend == GLIDER_BACKEND_SOCKET) {
+        char stats[4096];
+        if (glider_socket_stats(&cfg, stats, sizeof(stats)) > 0)
+            printf("Device side:\n%s", stats);
+    }
+    return res;
+}
@@ -0,0 +1,67 @@
+//
+// libglider, Glider host library
+// Copyright 2025 Wenting Zhang
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+// CRC16-CCITT (poly 0x1021, init 0, no reflection), same as fw/User/crc16.c.
+// Slicing by 8: crc_table[k][b] is the CRC of byte b followed by k zero
+// bytes, so 8 input bytes are folded with 8 independent lookups.
+//
+#include <pthread.h>
+#include "glider.h"
+
+static uint16_t crc_table[8][256];
+static pthread_once_t crc_once = PTHREAD_ONCE_INIT;
+
+static void crc_table_init(void) {
+    for (int b = 0; b < 256; b++) {
+        uint16_t crc = b << 8;
+        for (int i = 0; i < 8; i++)
+            crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : (crc << 1);
+        crc_table[0][b] = crc;
+    }
+    for (int k = 1; k < 8; k++) {
+        for (int b = 0; b < 256; b++) {
+            uint16_t prev = crc_table[k - 1][b];
+            crc_table[k][b] = (prev << 8) ^ crc_table[0][prev >> 8];
+        }
+    }
+}
+
+uint16_t glider_crc16_update(uint16_t crc, const void *buf, size_t len) {
+    const uint8_t *p = buf;
+    pthread_once(&crc_once, crc_table_init);
+    while (len >= 8) {
+        uint16_t c = crc ^ ((p[0] << 8) | p[1]);
+        crc = crc_table[7][c >> 8] ^ crc_table[6][c & 0xff] ^
+                crc_table[5][p[2]] ^ crc_table[4][p[3]] ^
+                crc_table[3][p[4]] ^ crc_table[2][p[5]] ^
+                crc_table[1][p[6]] ^ crc_table[0][p[7]];
+        p += 8;
+        len -= 8;
+    }
+    while (len--)
+        crc = (crc << 8) ^ crc_table[0][(crc >> 8) ^ *p++];
+    return crc;
+}
+
+uint16_t glider_crc16(const void *buf, size_t len) {
+    return glider_crc16_update(0, buf, len);
+}
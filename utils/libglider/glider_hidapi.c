@@ -0,0 +1,75 @@
+//
+// libglider, Glider host library
+// Copyright 2025 Wenting Zhang
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+// hidapi backend, build with HIDAPI=1
+//
+#include <stdlib.h>
+#include <string.h>
+#include "glider.h"
+
+#ifdef GLIDER_HAVE_HIDAPI
+#include <hidapi/hidapi.h>
+
+static int hidapi_write(void *ctx, const uint8_t *report) {
+    // Report ID 0 goes first
+    uint8_t buf[GLIDER_REPORT_SIZE + 1];
+    buf[0] = 0;
+    memcpy(buf + 1, report, GLIDER_REPORT_SIZE);
+    return (hid_write(ctx, buf, sizeof(buf)) < 0) ? GLIDER_EIO : GLIDER_OK;
+}
+
+static int hidapi_read(void *ctx, uint8_t *report, int timeout_ms) {
+    int res = hid_read_timeout(ctx, report, GLIDER_REPORT_SIZE, timeout_ms);
+    if (res < 0)
+        return GLIDER_EIO;
+    return (res > 0) ? 1 : 0;
+}
+
+static void hidapi_close(void *ctx) {
+    hid_close(ctx);
+    hid_exit();
+}
+
+int glider_hidapi_open(const glider_config_t *cfg, glider_transport_t *tr) {
+    if (hid_init() != 0)
+        return GLIDER_EIO;
+    hid_device *dev = hid_open(cfg->vid, cfg->pid, NULL);
+    if (!dev) {
+        hid_exit();
+        return GLIDER_ENODEV;
+    }
+    tr->ctx = dev;
+    tr->write = hidapi_write;
+    tr->read = hidapi_read;
+    tr->close = hidapi_close;
+    return GLIDER_OK;
+}
+
+#else
+
+int glider_hidapi_open(const glider_config_t *cfg, glider_transport_t *tr) {
+    (void)cfg;
+    (void)tr;
+    return GLIDER_ENODEV;
+}
+
+#endif
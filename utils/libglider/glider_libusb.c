@@ -0,0 +1,110 @@
+//
+// libglider, Glider host library
+// Copyright 2025 Wenting Zhang
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+// libusb backend, build with LIBUSB=1. Talks to the HID interrupt endpoints
+// directly, which skips the OS HID stack but needs the interface detached
+// from the kernel driver.
+//
+#include <stdlib.h>
+#include <string.h>
+#include "glider.h"
+
+#ifdef GLIDER_HAVE_LIBUSB
+#include <libusb-1.0/libusb.h>
+
+// See fw/User/usb_descriptors.c
+#define HID_INTERFACE       0
+#define HID_EP_OUT          0x01
+#define HID_EP_IN           0x81
+#define WRITE_TIMEOUT_MS    1000
+
+typedef struct {
+    libusb_context *usb;
+    libusb_device_handle *handle;
+} libusb_ctx_t;
+
+static int libusb_write(void *ctx, const uint8_t *report) {
+    libusb_ctx_t *lc = ctx;
+    int transferred;
+    int res = libusb_interrupt_transfer(lc->handle, HID_EP_OUT,
+            (uint8_t *)report, GLIDER_REPORT_SIZE, &transferred,
+            WRITE_TIMEOUT_MS);
+    return (res == 0) ? GLIDER_OK : GLIDER_EIO;
+}
+
+static int libusb_read(void *ctx, uint8_t *report, int timeout_ms) {
+    libusb_ctx_t *lc = ctx;
+    int transferred;
+    int res = libusb_interrupt_transfer(lc->handle, HID_EP_IN, report,
+            GLIDER_REPORT_SIZE, &transferred, timeout_ms);
+    if (res == LIBUSB_ERROR_TIMEOUT)
+        return 0;
+    if (res != 0)
+        return GLIDER_EIO;
+    return 1;
+}
+
+static void libusb_close_ctx(void *ctx) {
+    libusb_ctx_t *lc = ctx;
+    libusb_release_interface(lc->handle, HID_INTERFACE);
+    libusb_close(lc->handle);
+    libusb_exit(lc->usb);
+    free(lc);
+}
+
+int glider_libusb_open(const glider_config_t *cfg, glider_transport_t *tr) {
+    libusb_ctx_t *lc = calloc(1, sizeof(libusb_ctx_t));
+    if (!lc)
+        return GLIDER_EIO;
+    if (libusb_init(&lc->usb) != 0) {
+        free(lc);
+        return GLIDER_EIO;
+    }
+    lc->handle = libusb_open_device_with_vid_pid(lc->usb, cfg->vid, cfg->pid);
+    if (!lc->handle) {
+        libusb_exit(lc->usb);
+        free(lc);
+        return GLIDER_ENODEV;
+    }
+    libusb_set_auto_detach_kernel_driver(lc->handle, 1);
+    if (libusb_claim_interface(lc->handle, HID_INTERFACE) != 0) {
+        libusb_close(lc->handle);
+        libusb_exit(lc->usb);
+        free(lc);
+        return GLIDER_EIO;
+    }
+    tr->ctx = lc;
+    tr->write = libusb_write;
+    tr->read = libusb_read;
+    tr->close = libusb_close_ctx;
+    return GLIDER_OK;
+}
+
+#else
+
+int glider_libusb_open(const glider_config_t *cfg, glider_transport_t *tr) {
+    (void)cfg;
+    (void)tr;
+    return GLIDER_ENODEV;
+}
+
+#endif
@@ -0,0 +1,340 @@
+//
+// libglider, Glider host library
+// Copyright 2025 Wenting Zhang
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+// Loopback backend, an in process model of the device side of usbapp.c.
+// Reports take one polling interval per direction, the device handles one
+// report at a time and spends loopback_service_us on each command. Used to
+// test and benchmark the pipeline without hardware.
+//
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <time.h>
+#include "glider.h"
+
+// The endpoint holds one report while the device is busy with another
+#define OUT_DEPTH           1
+#define IN_DEPTH            8
+#define DEVICE_QUEUE_SPACE  16
+
+typedef struct {
+    uint8_t data[GLIDER_REPORT_SIZE];
+    uint64_t ready_ns;
+} lb_report_t;
+
+typedef struct {
+    lb_report_t reports[IN_DEPTH];
+    uint32_t head;
+    uint32_t tail;
+    uint32_t depth;
+    uint64_t last_ns;       // Last bus slot used
+} lb_pipe_t;
+
+typedef struct {
+    glider_config_t cfg;
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    bool running;
+    lb_pipe_t out;
+    lb_pipe_t in;
+    uint32_t rand_state;
+    // Device state, same as usbapp.c
+    uint16_t next_seq;
+    uint16_t unacked;
+    uint8_t status;
+    uint8_t failed;
+    uint16_t first_failed;
+    bool resend;
+    bool gap;
+} loopback_t;
+
+static uint64_t lb_time_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+static void lb_deadline(struct timespec *ts, uint64_t ns) {
+    ts->tv_sec = ns / 1000000000ull;
+    ts->tv_nsec = ns % 1000000000ull;
+}
+
+static void lb_sleep_until(uint64_t ns) {
+    struct timespec ts;
+    lb_deadline(&ts, ns);
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) != 0);
+}
+
+// Interrupt endpoints are polled on a fixed grid, one report per poll
+static uint64_t lb_next_slot(loopback_t *lb, lb_pipe_t *pipe) {
+    uint64_t interval = (uint64_t)lb->cfg.loopback_interval_us * 1000;
+    uint64_t now = lb_time_ns();
+    if (interval == 0)
+        return now;
+    uint64_t slot = (now + interval - 1) / interval * interval;
+    if (slot < pipe->last_ns + interval)
+        slot = pipe->last_ns + interval;
+    pipe->last_ns = slot;
+    return slot;
+}
+
+// Called with the lock held
+static void lb_send_in(loopback_t *lb, const uint8_t *report) {
+    // Host not reading, the report is dropped like a full HID buffer
+    if (lb->in.tail - lb->in.head >= lb->in.depth)
+        return;
+    lb_report_t *r = &lb->in.reports[lb->in.tail % IN_DEPTH];
+    memcpy(r->data, report, GLIDER_REPORT_SIZE);
+    r->ready_ns = lb_next_slot(lb, &lb->in);
+    lb->in.tail++;
+    pthread_cond_broadcast(&lb->cond);
+}
+
+static void put16(uint8_t *p, uint16_t val) {
+    p[0] = val & 0xff;
+    p[1] = (val >> 8) & 0xff;
+}
+
+static uint16_t get16(const uint8_t *p) {
+    return (p[1] << 8) | p[0];
+}
+
+static void lb_send_ack(loopback_t *lb) {
+    uint8_t txbuf[GLIDER_REPORT_SIZE] = {0};
+    txbuf[0] = GLIDER_V2_MAGIC;
+    txbuf[1] = GLIDER_V2_TYPE_ACK;
+    put16(txbuf + 2, lb->next_seq);
+    txbuf[4] = lb->status;
+    txbuf[5] = lb->failed;
+    put16(txbuf + 6, lb->first_failed);
+    txbuf[8] = DEVICE_QUEUE_SPACE;
+    txbuf[9] = lb->resend;
+    put16(txbuf + GLIDER_V2_CRC_OFFSET,
+            glider_crc16(txbuf, GLIDER_V2_CRC_OFFSET));
+    lb_send_in(lb, txbuf);
+    lb->unacked = 0;
+    lb->status = GLIDER_RET_SUCCESS;
+    lb->failed = 0;
+    lb->resend = false;
+}
+
+static bool lb_valid_cmd(uint8_t cmd) {
+    return (cmd == GLIDER_CMD_REDRAW) || (cmd == GLIDER_CMD_SETMODE) ||
+            (cmd == GLIDER_CMD_REGION_SET) || (cmd == GLIDER_CMD_REGION_RAISE) ||
+            (cmd == GLIDER_CMD_REGION_CLEAR);
+}
+
+// Returns the number of commands in the report, for the service time
+static int lb_process_v2(loopback_t *lb, const uint8_t *buffer) {
+    uint8_t count = buffer[1];
+    uint16_t seq = get16(buffer + 2);
+    uint8_t flags = buffer[4];
+
+    if (glider_crc16(buffer, GLIDER_V2_CRC_OFFSET) !=
+            get16(buffer + GLIDER_V2_CRC_OFFSET)) {
+        lb->resend = true;
+        lb_send_ack(lb);
+        return 0;
+    }
+    if (count > GLIDER_V2_MAX_CMDS)
+        count = GLIDER_V2_MAX_CMDS;
+    if (flags & GLIDER_V2_FLAG_RESET) {
+        lb->next_seq = seq;
+        lb->unacked = 0;
+        lb->failed = 0;
+        lb->status = GLIDER_RET_SUCCESS;
+        lb->gap = false;
+    }
+    int processed = 0;
+    for (int i = 0; i < count; i++) {
+        uint16_t cmd_seq = seq + i;
+        if ((int16_t)(cmd_seq - lb->next_seq) < 0)
+            continue;
+        if (cmd_seq != lb->next_seq) {
+            if (!lb->gap) {
+                lb->gap = true;
+                lb->resend = true;
+                lb_send_ack(lb);
+            }
+            return processed;
+        }
+        lb->gap = false;
+        const uint8_t *p = buffer + GLIDER_V2_HDR_SIZE + i * GLIDER_V2_CMD_SIZE;
+        if (!lb_valid_cmd(p[0])) {
+            if (lb->failed == 0) {
+                lb->status = GLIDER_RET_GENERALFAIL;
+                lb->first_failed = cmd_seq;
+            }
+            if (lb->failed < 0xff)
+                lb->failed++;
+        }
+        lb->next_seq = cmd_seq + 1;
+        lb->unacked++;
+        processed++;
+    }
+    if ((flags & GLIDER_V2_FLAG_ACK) ||
+            (lb->unacked >= GLIDER_V2_ACK_INTERVAL) || (lb->failed != 0))
+        lb_send_ack(lb);
+    return processed;
+}
+
+static int lb_process_v1(loopback_t *lb, const uint8_t *buffer) {
+    uint8_t txbuf[GLIDER_REPORT_SIZE] = {0};
+    uint16_t exp_chksum = glider_crc16(buffer, GLIDER_V1_CRC_OFFSET);
+    if (exp_chksum != get16(buffer + GLIDER_V1_CRC_OFFSET))
+        txbuf[1] = GLIDER_RET_CHKSUMFAIL;
+    else if (lb_valid_cmd(buffer[0]))
+        txbuf[1] = GLIDER_RET_SUCCESS;
+    else
+        txbuf[1] = GLIDER_RET_GENERALFAIL;
+    txbuf[2] = buffer[13];
+    txbuf[3] = buffer[14];
+    put16(txbuf + 4, exp_chksum);
+    lb_send_in(lb, txbuf);
+    return 1;
+}
+
+static void *lb_device_thread(void *arg) {
+    loopback_t *lb = arg;
+    uint8_t report[GLIDER_REPORT_SIZE];
+
+    pthread_mutex_lock(&lb->lock);
+    while (lb->running) {
+        if (lb->out.head == lb->out.tail) {
+            pthread_cond_wait(&lb->cond, &lb->lock);
+            continue;
+        }
+        lb_report_t *r = &lb->out.reports[lb->out.head % IN_DEPTH];
+        uint64_t ready_ns = r->ready_ns;
+        memcpy(report, r->data, GLIDER_REPORT_SIZE);
+        pthread_mutex_unlock(&lb->lock);
+        lb_sleep_until(ready_ns);
+        pthread_mutex_lock(&lb->lock);
+        int count;
+        if (report[0] == GLIDER_V2_MAGIC)
+            count = lb_process_v2(lb, report);
+        else
+            count = lb_process_v1(lb, report);
+        // The endpoint stays busy until the handler returns
+        pthread_mutex_unlock(&lb->lock);
+        lb_sleep_until(lb_time_ns() +
+                (uint64_t)count * lb->cfg.loopback_service_us * 1000);
+        pthread_mutex_lock(&lb->lock);
+        lb->out.head++;
+        pthread_cond_broadcast(&lb->cond);
+    }
+    pthread_mutex_unlock(&lb->lock);
+    return NULL;
+}
+
+static int lb_write(void *ctx, const uint8_t *report) {
+    loopback_t *lb = ctx;
+    pthread_mutex_lock(&lb->lock);
+    // NAKed while the device is busy
+    while (lb->running && (lb->out.tail - lb->out.head > lb->out.depth))
+        pthread_cond_wait(&lb->cond, &lb->lock);
+    lb_report_t *r = &lb->out.reports[lb->out.tail % IN_DEPTH];
+    memcpy(r->data, report, GLIDER_REPORT_SIZE);
+    if (lb->cfg.loopback_error_ppm) {
+        lb->rand_state = lb->rand_state * 1103515245 + 12345;
+        if ((lb->rand_state >> 8) % 1000000 < lb->cfg.loopback_error_ppm)
+            r->data[GLIDER_REPORT_SIZE / 2] ^= 0x5a;
+    }
+    r->ready_ns = lb_next_slot(lb, &lb->out);
+    lb->out.tail++;
+    pthread_cond_broadcast(&lb->cond);
+    uint64_t ready_ns = r->ready_ns;
+    pthread_mutex_unlock(&lb->lock);
+    // Returns once the report has been on the bus
+    lb_sleep_until(ready_ns);
+    return GLIDER_OK;
+}
+
+static int lb_read(void *ctx, uint8_t *report, int timeout_ms) {
+    loopback_t *lb = ctx;
+    uint64_t deadline = lb_time_ns() + (uint64_t)timeout_ms * 1000000ull;
+    struct timespec ts;
+    pthread_mutex_lock(&lb->lock);
+    while (lb->running) {
+        uint64_t now = lb_time_ns();
+        if (lb->in.head != lb->in.tail) {
+            lb_report_t *r = &lb->in.reports[lb->in.head % IN_DEPTH];
+            if (r->ready_ns <= now) {
+                memcpy(report, r->data, GLIDER_REPORT_SIZE);
+                lb->in.head++;
+                pthread_mutex_unlock(&lb->lock);
+                return 1;
+            }
+            if (r->ready_ns < deadline) {
+                pthread_mutex_unlock(&lb->lock);
+                lb_sleep_until(r->ready_ns);
+                pthread_mutex_lock(&lb->lock);
+                continue;
+            }
+        }
+        if (now >= deadline)
+            break;
+        lb_deadline(&ts, deadline);
+        pthread_cond_timedwait(&lb->cond, &lb->lock, &ts);
+    }
+    pthread_mutex_unlock(&lb->lock);
+    return 0;
+}
+
+static void lb_close(void *ctx) {
+    loopback_t *lb = ctx;
+    pthread_mutex_lock(&lb->lock);
+    lb->running = false;
+    pthread_cond_broadcast(&lb->cond);
+    pthread_mutex_unlock(&lb->lock);
+    pthread_join(lb->thread, NULL);
+    pthread_mutex_destroy(&lb->lock);
+    pthread_cond_destroy(&lb->cond);
+    free(lb);
+}
+
+int glider_loopback_open(const glider_config_t *cfg, glider_transport_t *tr) {
+    loopback_t *lb = calloc(1, sizeof(loopback_t));
+    if (!lb)
+        return GLIDER_EIO;
+    lb->cfg = *cfg;
+    lb->out.depth = OUT_DEPTH;
+    lb->in.depth = IN_DEPTH;
+    lb->status = GLIDER_RET_SUCCESS;
+    lb->rand_state = 1;
+
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_mutex_init(&lb->lock, NULL);
+    pthread_cond_init(&lb->cond, &attr);
+    pthread_condattr_destroy(&attr);
+    lb->running = true;
+    pthread_create(&lb->thread, NULL, lb_device_thread, lb);
+
+    tr->ctx = lb;
+    tr->write = lb_write;
+    tr->read = lb_read;
+    tr->close = lb_close;
+    return GLIDER_OK;
+}
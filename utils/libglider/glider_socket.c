@@ -0,0 +1,187 @@
+//
+// libglider, Glider host library
+// Copyright 2025 Wenting Zhang
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+// Socket backend, talks to the device emulator in utils/glider_emu. The
+// framing is described in utils/fw_host/host_tusb.h.
+//
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include "glider.h"
+
+#define FRAME_HID_OUT       0x01
+#define FRAME_HID_IN        0x02
+#define FRAME_STATS         0x05
+#define FRAME_HDR           4
+
+typedef struct {
+    int fd;
+} socket_ctx_t;
+
+static bool sock_send_all(int fd, const void *buf, size_t len) {
+    const uint8_t *p = buf;
+    while (len) {
+        ssize_t res = send(fd, p, len, MSG_NOSIGNAL);
+        if (res < 0 && errno == EINTR)
+            continue;
+        if (res <= 0)
+            return false;
+        p += res;
+        len -= res;
+    }
+    return true;
+}
+
+static bool sock_recv_all(int fd, void *buf, size_t len) {
+    uint8_t *p = buf;
+    while (len) {
+        ssize_t res = recv(fd, p, len, 0);
+        if (res < 0 && errno == EINTR)
+            continue;
+        if (res <= 0)
+            return false;
+        p += res;
+        len -= res;
+    }
+    return true;
+}
+
+static bool sock_send_frame(int fd, uint8_t type, const void *data,
+        uint16_t len) {
+    uint8_t frame[FRAME_HDR + GLIDER_REPORT_SIZE];
+    if (len > GLIDER_REPORT_SIZE)
+        return false;
+    frame[0] = type;
+    frame[1] = 0;
+    frame[2] = len & 0xff;
+    frame[3] = (len >> 8) & 0xff;
+    memcpy(frame + FRAME_HDR, data, len);
+    return sock_send_all(fd, frame, FRAME_HDR + len);
+}
+
+// Returns the frame type, 0 on timeout, or an error. Payload beyond len is
+// discarded.
+static int sock_recv_frame(int fd, void *buf, size_t len, size_t *rx_len,
+        int timeout_ms) {
+    struct pollfd pfd = {.fd = fd, .events = POLLIN};
+    int res = poll(&pfd, 1, timeout_ms);
+    if (res == 0)
+        return 0;
+    if (res < 0)
+        return (errno == EINTR) ? 0 : GLIDER_EIO;
+    uint8_t hdr[FRAME_HDR];
+    if (!sock_recv_all(fd, hdr, sizeof(hdr)))
+        return GLIDER_EIO;
+    size_t frame_len = hdr[2] | (hdr[3] << 8);
+    size_t copy = (frame_len < len) ? frame_len : len;
+    if (!sock_recv_all(fd, buf, copy))
+        return GLIDER_EIO;
+    for (size_t i = copy; i < frame_len; i++) {
+        uint8_t discard;
+        if (!sock_recv_all(fd, &discard, 1))
+            return GLIDER_EIO;
+    }
+    if (rx_len)
+        *rx_len = copy;
+    return hdr[0];
+}
+
+static int sock_connect(const char *path) {
+    struct sockaddr_un addr = {.sun_family = AF_UNIX};
+    strncpy(addr.sun_path, path, sizeof(addr.sun_path) - 1);
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0)
+        return -1;
+    if (connect(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+static int socket_write(void *ctx, const uint8_t *report) {
+    socket_ctx_t *sc = ctx;
+    return sock_send_frame(sc->fd, FRAME_HID_OUT, report, GLIDER_REPORT_SIZE) ?
+            GLIDER_OK : GLIDER_EIO;
+}
+
+static int socket_read(void *ctx, uint8_t *report, int timeout_ms) {
+    socket_ctx_t *sc = ctx;
+    size_t len;
+    memset(report, 0, GLIDER_REPORT_SIZE);
+    int type = sock_recv_frame(sc->fd, report, GLIDER_REPORT_SIZE, &len,
+            timeout_ms);
+    if (type < 0)
+        return type;
+    return (type == FRAME_HID_IN) ? 1 : 0;
+}
+
+static void socket_close(void *ctx) {
+    socket_ctx_t *sc = ctx;
+    close(sc->fd);
+    free(sc);
+}
+
+int glider_socket_open(const glider_config_t *cfg, glider_transport_t *tr) {
+    socket_ctx_t *sc = calloc(1, sizeof(socket_ctx_t));
+    if (!sc)
+        return GLIDER_EIO;
+    sc->fd = sock_connect(cfg->socket_path);
+    if (sc->fd < 0) {
+        free(sc);
+        return GLIDER_ENODEV;
+    }
+    tr->ctx = sc;
+    tr->write = socket_write;
+    tr->read = socket_read;
+    tr->close = socket_close;
+    return GLIDER_OK;
+}
+
+int glider_socket_stats(const glider_config_t *cfg, char *buf, size_t len) {
+    if (len == 0)
+        return GLIDER_EINVAL;
+    int fd = sock_connect(cfg->socket_path);
+    if (fd < 0)
+        return GLIDER_ENODEV;
+    int res = GLIDER_ETIMEDOUT;
+    size_t rx_len = 0;
+    if (sock_send_frame(fd, FRAME_STATS, NULL, 0)) {
+        int type;
+        // Skip anything else the device sends on connect
+        while ((type = sock_recv_frame(fd, buf, len - 1, &rx_len, 1000)) > 0) {
+            if (type == FRAME_STATS) {
+                buf[rx_len] = '\0';
+                res = rx_len;
+                break;
+            }
+        }
+        if (type < 0)
+            res = type;
+    }
+    close(fd);
+    return res;
+}
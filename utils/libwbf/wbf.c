@@ -0,0 +1,499 @@
+/*******************************************************************************
+ * libwbf, Eink waveform file parser
+ * Based on https://github.com/fread-ink/inkwave and Linux kernel
+ *
+ * This is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * This software is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * the software. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * This file is partially derived from Linux kernel driver, with the following
+ * copyright information:
+ * Copyright 2004-2013 Freescale Semiconductor, Inc.
+ * Copyright 2005-2017 Amazon Technologies, Inc.
+ * Copyright 2018, 2021 Marc Juul
+ * Copyright (C) 2022 Samuel Holland <samuel@sholland.org>
+ * Copyright 2024 Wenting Zhang
+ ******************************************************************************/
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <pthread.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "wbf.h"
+
+// Mode version to mode string
+struct mode_name_lut_t {
+    uint8_t versions[2];
+    const char *mode_strings[WBF_MODE_MAX];
+};
+
+// Partially derived from linux kernel drm_epd_helper.c
+// All GL series (GL GLR GLD) are marked as GL as the underlying wavetable seems to be identical
+// Thus it's impossible to identify the correct ordering
+// -R/ -D ghosting reduction is outside of the scope of this tool
+static const struct mode_name_lut_t mode_name_lut[] = {
+    {
+        // Example: ED050SC3
+        .versions = {0x01},
+        .mode_strings = {"INIT", "DU", "GL8", "GC8"}
+    },
+    {
+        // Example: ED097TC1
+        .versions = {0x03},
+        .mode_strings = {"INIT", "DU", "GL16", "GL16", "A2"}
+    },
+    {
+        // Example: ET073TC1
+        .versions = {0x09},
+        .mode_strings = {"INIT", "DU", "GC16", "A2"}
+    },
+    {
+        // Untested
+        .versions = {0x12},
+        .mode_strings = {"INIT", "DU", "NULL", "GC16", "A2", "GL16", "GL16", "DU4"}
+    },
+    {
+        // Example: ES133UT1
+        .versions = {0x15},
+        .mode_strings = {"INIT", "DU", "GC16", "GL16", "A2", "DU4", "GC4"}
+    },
+    {
+        // Untested
+        .versions = {0x16},
+        .mode_strings = {"INIT", "DU", "GC16", "GL16", "GL16", "GC16", "A2"}
+    },
+    {
+        // Example: ES108FC1
+        .versions = {0x18, 0x20},
+        .mode_strings = {"INIT", "DU", "GC16", "GL16", "GL16", "GL16", "A2"}
+    },
+    {
+        // Example: ES103TC1
+        .versions = {0x19, 0x43},
+        .mode_strings = {"INIT", "DU", "GC16", "GL16", "GL16", "GL16", "A2", "DU4"}
+    },
+    {
+        // Untested
+        .versions = {0x23},
+        .mode_strings = {"INIT", "DU", "GC16", "GL16", "A2", "DU4"}
+    },
+    {
+        // Untested
+        .versions = {0x54},
+        .mode_strings = {"INIT", "DU", "GC16", "GL16", "GL16", "A2"}
+    },
+    {
+        // Example: ES120MC1
+        .versions = {0x48},
+        .mode_strings = {"INIT", "DU", "GC16", "GL16", "GL16", "NULL", "A2"}
+    }
+};
+#define MODE_NAME_LUTS  (sizeof(mode_name_lut) / sizeof(*mode_name_lut))
+
+static uint32_t crc_table[256];
+static pthread_once_t crc_once = PTHREAD_ONCE_INIT;
+
+static void compute_crc_table(void) {
+    for (uint32_t n = 0; n < 256; n++) {
+        uint32_t c = n;
+        for (int k = 0; k < 8; k++) {
+            if (c & 1)
+                c = 0xedb88320u ^ (c >> 1);
+            else
+                c = c >> 1;
+        }
+        crc_table[n] = c;
+    }
+}
+
+const char *wbf_strerror(int err) {
+    switch (err) {
+    case WBF_OK: return "Success";
+    case WBF_EIO: return "Could not open file";
+    case WBF_EFORMAT: return "Truncated or corrupted file";
+    case WBF_ECHECKSUM: return "Pointer checksum mismatch";
+    case WBF_ENOMEM: return "Out of memory";
+    case WBF_EINVAL: return "Invalid argument";
+    case WBF_ESPACE: return "Buffer too small";
+    default: return "Unknown error";
+    }
+}
+
+int wbf_map_file(wbf_map_t *map, const char *path) {
+    memset(map, 0, sizeof(wbf_map_t));
+    int fd = open(path, O_RDONLY);
+    if (fd < 0)
+        return WBF_EIO;
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        return WBF_EIO;
+    }
+    if (st.st_size == 0) {
+        close(fd);
+        return WBF_EFORMAT;
+    }
+    void *data = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    // The mapping keeps the file referenced
+    close(fd);
+    if (data == MAP_FAILED)
+        return WBF_EIO;
+    // Tables are scattered, but the whole file is going to be read anyway
+    madvise(data, st.st_size, MADV_WILLNEED);
+    map->data = data;
+    map->size = st.st_size;
+    map->mapped = true;
+    return WBF_OK;
+}
+
+void wbf_unmap(wbf_map_t *map) {
+    if (map->mapped)
+        munmap((void *)map->data, map->size);
+    memset(map, 0, sizeof(wbf_map_t));
+}
+
+static int parse(wbf_t *wbf) {
+    const uint8_t *data = wbf->map.data;
+    size_t size = wbf->map.size;
+
+    if (size < WBF_HEADER_SIZE)
+        return WBF_EFORMAT;
+    const wbf_header_t *header = (const wbf_header_t *)data;
+    wbf->header = header;
+    wbf->modes = header->mc + 1;
+    wbf->temps = header->trc + 1;
+
+    wbf->bpp = ((header->luts & 0xC) == 0x4) ? 5 : (header->luts == 0x1d) ? 5 : 4;
+    if (header->luts == 0x15) {
+        wbf->bpp = 5;
+        wbf->mv = true;
+    }
+    else if (header->luts == 0x1d) {
+        wbf->mv = true;
+        wbf->uni = true;
+    }
+
+    uint8_t mode_version = header->mode_version_or_adhesive_run_num;
+    for (size_t i = 0; i < MODE_NAME_LUTS; i++) {
+        if ((mode_name_lut[i].versions[0] == mode_version) ||
+                (mode_name_lut[i].versions[1] == mode_version)) {
+            wbf->mode_names = mode_name_lut[i].mode_strings;
+        }
+    }
+
+    // Right following the header is the temperature range table, with the
+    // end bound and a checksum
+    if (WBF_HEADER_SIZE + wbf->temps + 2 > size)
+        return WBF_EFORMAT;
+    wbf->temp_table = data + WBF_HEADER_SIZE;
+    uint8_t checksum = 0;
+    for (int i = 0; i <= wbf->temps; i++)
+        checksum += wbf->temp_table[i];
+    wbf->temp_checksum_ok = (checksum == wbf->temp_table[wbf->temps + 1]);
+
+    wbf->xwia_checksum_ok = true;
+    if (header->xwia != 0) {
+        if ((size_t)header->xwia + 1 > size)
+            return WBF_EFORMAT;
+        const uint8_t *ptr = data + header->xwia;
+        wbf->xwia_len = *ptr++;
+        if ((size_t)header->xwia + 1 + wbf->xwia_len + 1 > size)
+            return WBF_EFORMAT;
+        wbf->xwia = ptr;
+        checksum = wbf->xwia_len;
+        for (int i = 0; i < wbf->xwia_len; i++)
+            checksum += *ptr++;
+        wbf->xwia_checksum_ok = (checksum == *ptr);
+    }
+
+    wbf->data_offset = WBF_HEADER_SIZE + wbf->temps + 2 + 1 + wbf->xwia_len + 1;
+    // This should yield the same result
+    wbf->data_offset_ok = !header->xwia ||
+            (wbf->data_offset == header->xwia + 1 + wbf->xwia_len + 1);
+    if ((size_t)wbf->data_offset + wbf->modes * 4 > size)
+        return WBF_EFORMAT;
+    return WBF_OK;
+}
+
+int wbf_open(wbf_t *wbf, const char *path) {
+    memset(wbf, 0, sizeof(wbf_t));
+    int res = wbf_map_file(&wbf->map, path);
+    if (res != WBF_OK)
+        return res;
+    res = parse(wbf);
+    if (res != WBF_OK)
+        wbf_close(wbf);
+    return res;
+}
+
+int wbf_open_mem(wbf_t *wbf, const void *data, size_t size) {
+    memset(wbf, 0, sizeof(wbf_t));
+    wbf->map.data = data;
+    wbf->map.size = size;
+    return parse(wbf);
+}
+
+void wbf_close(wbf_t *wbf) {
+    wbf_unmap(&wbf->map);
+    memset(wbf, 0, sizeof(wbf_t));
+}
+
+const char *wbf_mode_name(const wbf_t *wbf, int mode) {
+    if (!wbf->mode_names || (mode < 0) || (mode >= WBF_MODE_MAX))
+        return NULL;
+    return wbf->mode_names[mode];
+}
+
+uint32_t wbf_crc32_update(uint32_t crc, const uint8_t *buf, size_t len) {
+    pthread_once(&crc_once, compute_crc_table);
+    uint32_t c = crc ^ 0xffffffff;
+    for (size_t i = 0; i < len; i++)
+        c = crc_table[(c ^ (buf ? buf[i] : 0)) & 0xff] ^ (c >> 8);
+    return c ^ 0xffffffff;
+}
+
+int wbf_crc(const wbf_t *wbf, uint32_t *crc) {
+    uint32_t filesize = wbf->header->filesize;
+    if (filesize == 0)
+        return WBF_EINVAL;
+    if ((filesize < 4) || (filesize > wbf->map.size))
+        return WBF_EFORMAT;
+    uint32_t c = wbf_crc32_update(0, NULL, 4);
+    *crc = wbf_crc32_update(c, wbf->map.data + 4, filesize - 4);
+    return WBF_OK;
+}
+
+int wbf_read_pointer(const wbf_t *wbf, size_t pos, uint32_t *addr) {
+    if (pos + 4 > wbf->map.size)
+        return WBF_EFORMAT;
+    const uint8_t *ptr = wbf->map.data + pos;
+    *addr = ((uint32_t)ptr[2] << 16) | ((uint32_t)ptr[1] << 8) | ((uint32_t)ptr[0]);
+    uint8_t checksum = ptr[0] + ptr[1] + ptr[2];
+    return (checksum == ptr[3]) ? WBF_OK : WBF_ECHECKSUM;
+}
+
+int wbf_mode_pointer(const wbf_t *wbf, int mode, uint32_t *addr) {
+    if ((mode < 0) || (mode >= wbf->modes))
+        return WBF_EINVAL;
+    return wbf_read_pointer(wbf, wbf->data_offset + mode * 4, addr);
+}
+
+int wbf_table_pointer(const wbf_t *wbf, int mode, int temp, uint32_t *addr) {
+    if ((temp < 0) || (temp >= wbf->temps))
+        return WBF_EINVAL;
+    uint32_t mode_addr;
+    int res = wbf_mode_pointer(wbf, mode, &mode_addr);
+    if (res == WBF_ECHECKSUM)
+        res = WBF_OK; // Only the table pointer result is reported
+    if (res != WBF_OK)
+        return res;
+    return wbf_read_pointer(wbf, (size_t)mode_addr + temp * 4, addr);
+}
+
+int wbf_get_table(const wbf_t *wbf, int mode, int temp, wbf_table_t *table) {
+    uint32_t addr;
+    int res = wbf_table_pointer(wbf, mode, temp, &addr);
+    if ((res != WBF_OK) && (res != WBF_ECHECKSUM))
+        return res;
+    if (addr >= wbf->map.size)
+        return WBF_EFORMAT;
+    table->mode = mode;
+    table->temp = temp;
+    table->offset = addr;
+    table->rle = wbf->map.data + addr;
+    table->avail = wbf->map.size - addr;
+    return res;
+}
+
+void wbf_iter_init(wbf_iter_t *iter, wbf_t *wbf) {
+    iter->wbf = wbf;
+    iter->mode = 0;
+    iter->temp = 0;
+}
+
+bool wbf_iter_next(wbf_iter_t *iter, wbf_table_t *table, int *err) {
+    if (iter->mode >= iter->wbf->modes)
+        return false;
+    int res = wbf_get_table(iter->wbf, iter->mode, iter->temp, table);
+    if (err)
+        *err = res;
+    if (++iter->temp >= iter->wbf->temps) {
+        iter->temp = 0;
+        iter->mode++;
+    }
+    return true;
+}
+
+// Decodes when buf is not NULL
+static int rle_walk(const wbf_table_t *table, uint8_t *buf, size_t len,
+        wbf_rle_info_t *info) {
+    const uint8_t *ptr = table->rle;
+    const uint8_t *end = table->rle + table->avail;
+    bool rle_mode = true;
+    size_t idx = 0;
+    uint8_t checksum = 0;
+    while (1) {
+        if (ptr >= end)
+            return WBF_EFORMAT;
+        uint8_t chr = *ptr++;
+        checksum += chr;
+        if (chr == 0xfc) {
+            // Toggle RLE mode
+            rle_mode = !rle_mode;
+        }
+        else if (chr == 0xff) {
+            // End of block
+            break;
+        }
+        else if (!rle_mode) {
+            if (buf) {
+                if (idx >= len)
+                    return WBF_ESPACE;
+                buf[idx] = chr;
+            }
+            idx++;
+        }
+        else {
+            if (ptr >= end)
+                return WBF_EFORMAT;
+            uint8_t run = *ptr++;
+            checksum += run;
+            if (buf) {
+                if (idx + run + 1 > len)
+                    return WBF_ESPACE;
+                memset(buf + idx, chr, run + 1);
+            }
+            idx += run + 1;
+        }
+    }
+    if (ptr >= end)
+        return WBF_EFORMAT;
+    if (info) {
+        info->checksum = checksum;
+        info->checksum_ok = (*ptr == checksum);
+        info->rle_len = ptr + 1 - table->rle;
+        info->decoded_len = idx;
+    }
+    return WBF_OK;
+}
+
+int wbf_table_scan(const wbf_table_t *table, wbf_rle_info_t *info) {
+    return rle_walk(table, NULL, 0, info);
+}
+
+int wbf_table_decode(const wbf_table_t *table, uint8_t *buf, size_t len,
+        wbf_rle_info_t *info) {
+    if (!buf)
+        return WBF_EINVAL;
+    return rle_walk(table, buf, len, info);
+}
+
+int wbf_states(const wbf_t *wbf) {
+    return (wbf->bpp == 4) ? 16 : 32;
+}
+
+size_t wbf_frame_size(const wbf_t *wbf) {
+    int states = wbf_states(wbf);
+    return wbf->uni ? states : states * states;
+}
+
+int wbf_table_frames(const wbf_t *wbf, size_t len) {
+    int phase_per_byte = wbf->mv ? 2 : 4;
+    int transitions = wbf->uni ? 32 : ((wbf->bpp == 3) ? (8 * 8) :
+            (wbf->bpp == 4) ? (16 * 16) : (32 * 32));
+    return len * phase_per_byte / transitions;
+}
+
+static uint64_t read_uint64_le(const uint8_t *ptr) {
+    uint64_t val = 0;
+    for (int i = 7; i >= 0; i--)
+        val = (val << 8) | ptr[i];
+    return val;
+}
+
+static uint64_t fmix64(uint64_t k) {
+    k ^= k >> 33;
+    k *= 0xff51afd7ed558ccdull;
+    k ^= k >> 33;
+    k *= 0xc4ceb9fe1a85ec53ull;
+    k ^= k >> 33;
+    return k;
+}
+
+// 8 bytes per step, names in a store must not depend on the host byte order
+uint64_t wbf_hash64(const void *data, size_t len, uint64_t seed) {
+    const uint8_t *ptr = data;
+    uint64_t h = seed ^ (len * 0x9e3779b97f4a7c15ull);
+    while (len >= 8) {
+        uint64_t k = read_uint64_le(ptr) * 0x87c37b91114253d5ull;
+        k = (k << 31) | (k >> 33);
+        h ^= k * 0x4cf5ad432745937full;
+        h = ((h << 27) | (h >> 37)) * 5 + 0x52dce729;
+        ptr += 8;
+        len -= 8;
+    }
+    uint64_t k = 0;
+    for (size_t i = 0; i < len; i++)
+        k |= (uint64_t)ptr[i] << (i * 8);
+    h ^= fmix64(k);
+    return fmix64(h);
+}
+
+uint32_t wbf_table_format(const wbf_t *wbf) {
+    return wbf->bpp | (wbf->mv << 8) | (wbf->uni << 9);
+}
+
+void wbf_table_unpack(const wbf_t *wbf, const uint8_t *decoded, int frames,
+        uint8_t *lut) {
+    int states = wbf_states(wbf);
+    int phase_per_byte = wbf->mv ? 2 : 4;
+    const uint8_t *ptr = decoded;
+
+    if (!wbf->uni) {
+        // 2D LUT
+        for (int i = 0; i < frames; i++) {
+            uint8_t *frame = lut + (size_t)i * states * states;
+            for (int x = 0; x < states; x++) { // dst
+                for (int y = 0; y < states; y += phase_per_byte) { // src
+                    uint8_t val = *ptr++;
+                    if (phase_per_byte == 4) {
+                        frame[(y + 0) * states + x] = (val >> 0) & 0x3;
+                        frame[(y + 1) * states + x] = (val >> 2) & 0x3;
+                        frame[(y + 2) * states + x] = (val >> 4) & 0x3;
+                        frame[(y + 3) * states + x] = (val >> 6) & 0x3;
+                    }
+                    else {
+                        frame[(y + 0) * states + x] = (val >> 0) & 0xf;
+                        frame[(y + 1) * states + x] = (val >> 4) & 0xf;
+                    }
+                }
+            }
+        }
+    }
+    else {
+        // 1D LUT
+        for (int i = 0; i < frames; i++) {
+            uint8_t *frame = lut + (size_t)i * states;
+            for (int x = 0; x < states; x += phase_per_byte) { // dst
+                uint8_t val = *ptr++;
+                frame[x + 0] = (val >> 0) & 0xf;
+                frame[x + 1] = (val >> 4) & 0xf;
+            }
+        }
+    }
+}
@@ -0,0 +1,385 @@
+/*******************************************************************************
+ * libwbf, Eink waveform file parser
+ * Based on https://github.com/fread-ink/inkwave and Linux kernel
+ *
+ * This is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * This software is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * the software. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * This file is partially derived from Linux kernel driver, with the following
+ * copyright information:
+ * Copyright 2004-2013 Freescale Semiconductor, Inc.
+ * Copyright 2005-2017 Amazon Technologies, Inc.
+ * Copyright 2014-2016 Freescale Semiconductor, Inc.
+ * Copyright 2017 NXP
+ * Copyright 2018, 2021 Marc Juul
+ * Copyright (C) 2022 Samuel Holland <samuel@sholland.org>
+ * Copyright 2024 Wenting Zhang
+ ******************************************************************************/
+//
+// Parser for the three waveform containers handled by the tools in utils/:
+// E Ink .wbf files, Freescale/NXP EPDC .fw files and compressed .wbf flash
+// images. Files are memory mapped read only and everything returned points
+// into the mapping, nothing is copied until a table is decoded into a
+// buffer owned by the caller. Every offset read from the file is bounds
+// checked, so a truncated or corrupted file gives an error instead of a
+// crash.
+//
+// Tables are looked up lazily, per mode and temperature range, either
+// directly with wbf_get_table() or one after another with wbf_iter_next().
+//
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Return codes, negative values are errors
+#define WBF_OK              0
+#define WBF_EIO             (-1)    // Could not open or map the file
+#define WBF_EFORMAT         (-2)    // Truncated, or an offset out of bounds
+#define WBF_ECHECKSUM       (-3)    // Pointer checksum mismatch
+#define WBF_ENOMEM          (-4)
+#define WBF_EINVAL          (-5)
+#define WBF_ESPACE          (-6)    // Output buffer too small
+
+#define WBF_MODE_MAX        10
+
+// .wbf header, 48 bytes, little endian
+typedef struct {
+    uint32_t checksum:32; // 0
+    uint32_t filesize:32; // 4
+    uint32_t serial:32; // 8 serial number
+    uint32_t run_type:8; // 12
+    uint32_t fpl_platform:8; // 13
+    uint32_t fpl_lot:16; // 14
+    uint32_t mode_version_or_adhesive_run_num:8; // 16
+    uint32_t waveform_version:8; // 17
+    uint32_t waveform_subversion:8; // 18
+    uint32_t waveform_type:8; // 19
+    uint32_t fpl_size:8; // 20 (aka panel_size)
+    uint32_t mfg_code:8; // 21 (aka amepd_part_number)
+    uint32_t waveform_tuning_bias_or_rev:8; // 22
+    uint32_t fpl_rate:8; // 23 (aka frame_rate)
+    uint32_t unknown0:8;
+    uint32_t vcom_shifted:8;
+    uint32_t unknown1:16;
+    uint32_t xwia:24; // address of extra waveform information
+    uint32_t cs1:8; // checksum 1
+    uint32_t wmta:24;
+    uint32_t fvsn:8;
+    uint32_t luts:8;
+    uint32_t mc:8; // mode count (length of mode table - 1)
+    uint32_t trc:8; // temperature range count (length of temperature table - 1)
+    uint32_t advanced_wfm_flags:8;
+    uint32_t eb:8;
+    uint32_t sb:8;
+    uint32_t reserved0_1:8;
+    uint32_t reserved0_2:8;
+    uint32_t reserved0_3:8;
+    uint32_t reserved0_4:8;
+    uint32_t reserved0_5:8;
+    uint32_t cs2:8; // checksum 2
+} __attribute__((packed)) wbf_header_t;
+
+#define WBF_HEADER_SIZE     sizeof(wbf_header_t)
+
+// Read only view of a whole file
+typedef struct {
+    const uint8_t *data;
+    size_t size;
+    bool mapped;            // Unmapped on close, otherwise owned by the caller
+} wbf_map_t;
+
+typedef struct {
+    wbf_map_t map;
+    const wbf_header_t *header;
+    int modes;
+    int temps;
+    int bpp;                // 4 or 5
+    bool mv;                // Multi-voltage, 4 bits per phase
+    bool uni;               // 1D LUT, indexed by destination only
+    // temps lower bounds followed by the upper bound of the last range
+    const uint8_t *temp_table;
+    bool temp_checksum_ok;
+    // Extra waveform information, usually the panel and waveform name, not
+    // NUL terminated
+    const uint8_t *xwia;
+    uint8_t xwia_len;
+    bool xwia_checksum_ok;
+    // Mode pointer table, computed from the header rather than read from it
+    uint32_t data_offset;
+    bool data_offset_ok;    // Agrees with the XWIA address, if any
+    const char *const *mode_names;  // NULL if the mode version is unknown
+} wbf_t;
+
+// One waveform table, the RLE stream still in the file
+typedef struct {
+    int mode;
+    int temp;
+    uint32_t offset;        // File offset of the RLE stream
+    const uint8_t *rle;     // Points into the mapping
+    size_t avail;           // Bytes from rle to the end of the file
+} wbf_table_t;
+
+// Iterates over every mode and temperature range, temperature first
+typedef struct {
+    wbf_t *wbf;
+    int mode;
+    int temp;
+} wbf_iter_t;
+
+// Result of walking a table RLE stream
+typedef struct {
+    size_t rle_len;         // Including the end marker and checksum byte
+    size_t decoded_len;
+    uint8_t checksum;       // Computed
+    bool checksum_ok;
+} wbf_rle_info_t;
+
+const char *wbf_strerror(int err);
+
+// Maps a file read only, an empty file is an error
+int wbf_map_file(wbf_map_t *map, const char *path);
+void wbf_unmap(wbf_map_t *map);
+
+// Parses the header, temperature table and XWIA. The file stays mapped until
+// wbf_close(). wbf_open_mem() uses the buffer in place, it must outlive wbf.
+int wbf_open(wbf_t *wbf, const char *path);
+int wbf_open_mem(wbf_t *wbf, const void *data, size_t size);
+void wbf_close(wbf_t *wbf);
+
+// Mode name from the mode version in the header, NULL if unknown
+const char *wbf_mode_name(const wbf_t *wbf, int mode);
+
+// CRC32 over the size reported in the header, with the checksum field
+// counted as zero. Returns WBF_EINVAL if the reported size is 0, and
+// WBF_EFORMAT if it is larger than the file.
+int wbf_crc(const wbf_t *wbf, uint32_t *crc);
+uint32_t wbf_crc32_update(uint32_t crc, const uint8_t *buf, size_t len);
+
+// 3 byte pointer followed by a checksum byte. WBF_ECHECKSUM still returns
+// the address, the caller decides whether to trust it.
+int wbf_read_pointer(const wbf_t *wbf, size_t pos, uint32_t *addr);
+int wbf_mode_pointer(const wbf_t *wbf, int mode, uint32_t *addr);
+int wbf_table_pointer(const wbf_t *wbf, int mode, int temp, uint32_t *addr);
+// View of the table for one mode and temperature range, returns the same
+// codes as wbf_read_pointer(), the table is filled in for WBF_ECHECKSUM
+int wbf_get_table(const wbf_t *wbf, int mode, int temp, wbf_table_t *table);
+
+void wbf_iter_init(wbf_iter_t *iter, wbf_t *wbf);
+// Returns false at the end. Errors for the current table are returned in
+// err, which is optional, the table is only valid for WBF_OK and
+// WBF_ECHECKSUM.
+bool wbf_iter_next(wbf_iter_t *iter, wbf_table_t *table, int *err);
+
+// Walks the RLE stream without decoding, to size the decode buffer
+int wbf_table_scan(const wbf_table_t *table, wbf_rle_info_t *info);
+// Decodes into buf. info is optional.
+int wbf_table_decode(const wbf_table_t *table, uint8_t *buf, size_t len,
+        wbf_rle_info_t *info);
+// Frames in a decoded table of len bytes
+int wbf_table_frames(const wbf_t *wbf, size_t len);
+int wbf_states(const wbf_t *wbf);
+// Phase values per frame of an unpacked table, states x states, or states
+// for 1D tables
+size_t wbf_frame_size(const wbf_t *wbf);
+// Unpacks a decoded table to one byte per phase value, frames x [src][dst],
+// or frames x [dst] for 1D tables. lut has frames * wbf_frame_size() bytes.
+void wbf_table_unpack(const wbf_t *wbf, const uint8_t *decoded, int frames,
+        uint8_t *lut);
+
+// Hash of a decoded table, seeded with wbf_table_format() so the same bytes
+// in a different layout hash differently. Not cryptographic, compare the
+// content as well before treating two tables as the same.
+uint64_t wbf_hash64(const void *data, size_t len, uint64_t seed);
+// bpp, mv and uni packed together, tables can only be shared between files
+// with the same format
+uint32_t wbf_table_format(const wbf_t *wbf);
+
+// Content addressed table store: a directory with one file per distinct
+// decoded table, named after the content hash, shared by every file dumped
+// into it. Each table is stored as <name>.bin, other representations of it
+// can be added next to it under the same name.
+
+#define WBF_STORE_NAME_MAX  24
+
+typedef struct wbf_store wbf_store_t;
+
+typedef struct {
+    uint64_t lookups;
+    uint64_t hits_session;  // Added or found earlier with the same store
+    uint64_t hits_disk;     // Found in the directory, from an earlier run
+    uint64_t added;
+    uint64_t bytes_added;
+    uint64_t bytes_reused;
+    uint64_t collisions;    // Same hash, different content
+} wbf_store_stats_t;
+
+// Creates the directory if needed
+int wbf_store_open(wbf_store_t **store, const char *dir);
+void wbf_store_close(wbf_store_t *store);
+const char *wbf_store_dir(const wbf_store_t *store);
+// Finds the table with the same content, or adds it. name receives the file
+// name without extension, WBF_STORE_NAME_MAX bytes. added is set if the
+// table was new, the caller should then write the other representations.
+int wbf_store_put(wbf_store_t *store, const uint8_t *data, size_t len,
+        uint32_t format, char *name, bool *added);
+void wbf_store_get_stats(const wbf_store_t *store, wbf_store_stats_t *stats);
+
+// Binary LUT container (.lut), for passing tables between the tools
+// without going through CSV. Little endian:
+//   0   magic "GLUT"
+//   4   version, bits per value (2 or 4), states (16 or 32), flags
+//   8   frames, uint32
+//   12  CRC32 of the packed values
+//   16  packed values, frames x [src][dst], or frames x [dst] with
+//       WBF_LUT_FLAG_1D, first value in the low bits of each byte
+// With 16 states and 2 bits a frame is 64 bytes, in the same layout as a
+// Caster LUT frame.
+#define WBF_LUT_MAGIC           "GLUT"
+#define WBF_LUT_VERSION         1
+#define WBF_LUT_HEADER_SIZE     16
+#define WBF_LUT_FLAG_1D         0x01
+
+// Unpacked table, one byte per value, frames x [src][dst] (or [dst])
+typedef struct {
+    int states;
+    int frames;
+    bool uni;
+    uint8_t *values;
+} wbf_lut_t;
+
+// values is zero filled
+int wbf_lut_alloc(wbf_lut_t *lut, int states, int frames, bool uni);
+void wbf_lut_free(wbf_lut_t *lut);
+size_t wbf_lut_frame_size(const wbf_lut_t *lut);
+// 2 if every value fits, otherwise 4
+int wbf_lut_bits(const wbf_lut_t *lut);
+// Header included
+size_t wbf_lut_packed_size(const wbf_lut_t *lut, int bits);
+// Returns the packed size, nothing is written if len is too small
+size_t wbf_lut_pack(const wbf_lut_t *lut, uint8_t *buf, size_t len);
+int wbf_lut_unpack(wbf_lut_t *lut, const uint8_t *buf, size_t len);
+int wbf_lut_save(const char *path, const wbf_lut_t *lut);
+int wbf_lut_load(const char *path, wbf_lut_t *lut);
+// Same CSV as the dumpers always wrote: "src,dst,v0,v1,...," per line, or
+// "dst,v0,v1,...," for 1D tables
+int wbf_lut_save_csv(const char *path, const wbf_lut_t *lut);
+// Reads a 2D CSV table, src and dst may be ranges like 0:14. Values past
+// frames are ignored, values not in the file are set to fill.
+int wbf_lut_load_csv(const char *path, wbf_lut_t *lut, int states,
+        int frames, uint8_t fill);
+// Either format, by the file extension. For CSV, states, frames and fill
+// are passed on, a .lut file has its own.
+int wbf_lut_load_table(const char *path, wbf_lut_t *lut, int states,
+        int frames, uint8_t fill);
+bool wbf_lut_is_binary(const char *path);
+
+// Freescale/NXP EPDC .fw files
+
+// 48 byte header, followed by the temperature table
+typedef struct {
+    unsigned int wi0;
+    unsigned int wi1;
+    unsigned int wi2;
+    unsigned int wi3;
+    unsigned int wi4;
+    unsigned int wi5;
+    unsigned int wi6;
+
+    unsigned int xwia: 24;
+    unsigned int cs1: 8;
+
+    unsigned int wmta: 24;
+    unsigned int fvsn: 8;
+    unsigned int luts: 8;
+    unsigned int mc: 8;
+    unsigned int trc: 8;
+    unsigned int advanced_wfm_flags: 8;
+    unsigned int eb: 8;
+    unsigned int sb: 8;
+    unsigned int reserved0_1: 8;
+    unsigned int reserved0_2: 8;
+    unsigned int reserved0_3: 8;
+    unsigned int reserved0_4: 8;
+    unsigned int reserved0_5: 8;
+    unsigned int cs2: 8;
+} wbf_mxc_header_t;
+
+typedef struct {
+    wbf_map_t map;
+    const wbf_mxc_header_t *header;
+    int version;            // EPDC version, 1 or 2
+    int modes;
+    int temps;
+    const uint8_t *temp_table;
+    // Offsets in the file are relative to the waveform data
+    const uint8_t *data;
+    size_t data_size;
+} wbf_mxc_t;
+
+typedef struct {
+    int mode;
+    int temp;
+    uint64_t offset;        // Relative to the waveform data
+    uint64_t frames;
+    // frames x 256 phases, [dst][src], one byte each on EPDCv1, one nibble
+    // each on EPDCv2
+    const uint8_t *phases;
+} wbf_mxc_table_t;
+
+int wbf_mxc_open(wbf_mxc_t *mxc, const char *path, int version);
+int wbf_mxc_open_mem(wbf_mxc_t *mxc, const void *data, size_t size,
+        int version);
+void wbf_mxc_close(wbf_mxc_t *mxc);
+int wbf_mxc_mode_pointer(const wbf_mxc_t *mxc, int mode, uint64_t *addr);
+int wbf_mxc_get_table(const wbf_mxc_t *mxc, int mode, int temp,
+        wbf_mxc_table_t *table);
+// frames x [src][dst], 16 x 16 each
+void wbf_mxc_table_unpack(const wbf_mxc_t *mxc, const wbf_mxc_table_t *table,
+        uint8_t *lut);
+
+// Compressed .wbf flash images: a 16 byte header with the big endian
+// compressed length and format version, followed by (offset, length, byte)
+// tokens. Each token copies length bytes from offset bytes back, then
+// appends byte.
+
+#define WBF_FLASH_HEADER_SIZE   16
+
+typedef struct {
+    uint32_t compressed_len;
+    uint32_t version;
+} wbf_flash_header_t;
+
+// Called for every token, before it is expanded
+typedef void (*wbf_flash_trace_t)(void *ctx, uint32_t pos, uint32_t offset,
+        uint8_t len, uint8_t byte);
+
+// Only parses the header, WBF_EFORMAT if len is shorter than the header
+int wbf_flash_header(const uint8_t *src, size_t len, wbf_flash_header_t *hdr);
+// Both below return WBF_EFORMAT if the file is shorter than the header says
+// or if a token copies from before the start of the output, and
+// WBF_EINVAL for versions other than 1.
+// Validates every token and returns the decompressed size.
+int wbf_flash_size(const uint8_t *src, size_t len, size_t *size);
+// trace is optional
+int wbf_flash_decompress(const uint8_t *src, size_t len, uint8_t *dst,
+        size_t dst_len, size_t *out_len, wbf_flash_trace_t trace, void *ctx);
+
+#ifdef __cplusplus
+}
+#endif
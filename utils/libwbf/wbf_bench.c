@@ -0,0 +1,239 @@
+//
+// libwbf, Eink waveform file parser
+// Copyright 2025 Wenting Zhang
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+//
+// Batch parsing throughput over a set of .wbf files, the way the dump tools
+// process them: CRC, every table pointer, then each distinct table decoded
+// and unpacked. The files are parsed three ways:
+//   read      fread into a malloc'd buffer first, like the tools used to
+//   mmap      wbf_open(), tables decoded straight from the mapping
+//   index     wbf_open() and a scan of every table, nothing decoded, enough
+//             to list tables and frame counts
+// All three must agree on the tables found, and read and mmap on a hash of
+// the unpacked phase values.
+//
+#include <stdio.h>
+#include <stdlib.h>
+#include <inttypes.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include "wbf.h"
+
+#define MAX_TABLES  (WBF_MODE_MAX * 256)
+
+typedef enum {
+    P_READ,
+    P_MMAP,
+    P_INDEX,
+    P_COUNT
+} path_t;
+
+static const char *path_names[P_COUNT] = { "read", "mmap", "index" };
+
+typedef struct {
+    uint64_t files;
+    uint64_t bytes;
+    uint64_t tables;
+    uint64_t frames;
+    uint64_t hash;
+    uint64_t errors;
+} result_t;
+
+typedef struct {
+    uint8_t *decoded;
+    size_t decoded_size;
+    uint8_t *lut;
+    size_t lut_size;
+} buffers_t;
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+static bool grow(uint8_t **buf, size_t *size, size_t len) {
+    if (len <= *size)
+        return true;
+    uint8_t *p = realloc(*buf, len);
+    if (!p)
+        return false;
+    *buf = p;
+    *size = len;
+    return true;
+}
+
+static void *read_file(const char *fn, size_t *len) {
+    FILE *fp = fopen(fn, "rb");
+    if (!fp)
+        return NULL;
+    fseek(fp, 0, SEEK_END);
+    *len = ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+    void *buf = malloc(*len ? *len : 1);
+    if (buf && (fread(buf, *len, 1, fp) != 1)) {
+        free(buf);
+        buf = NULL;
+    }
+    fclose(fp);
+    return buf;
+}
+
+static int parse(wbf_t *wbf, bool decode, buffers_t *bufs, result_t *res) {
+    uint32_t crc;
+    if (decode)
+        wbf_crc(wbf, &crc);
+
+    uint32_t offsets[MAX_TABLES];
+    int tables = 0;
+    wbf_iter_t iter;
+    wbf_table_t table;
+    int err;
+    wbf_iter_init(&iter, wbf);
+    while (wbf_iter_next(&iter, &table, &err)) {
+        if ((err != WBF_OK) && (err != WBF_ECHECKSUM))
+            return err;
+        int id = -1;
+        for (int k = 0; k < tables; k++)
+            if (offsets[k] == table.offset) {
+                id = k;
+                break;
+            }
+        if (id != -1)
+            continue;
+        offsets[tables++] = table.offset;
+
+        wbf_rle_info_t info;
+        err = wbf_table_scan(&table, &info);
+        if (err != WBF_OK)
+            return err;
+        int frames = wbf_table_frames(wbf, info.decoded_len);
+        res->tables++;
+        res->frames += frames;
+        if (!decode)
+            continue;
+
+        size_t lut_len = frames * wbf_frame_size(wbf);
+        if (!grow(&bufs->decoded, &bufs->decoded_size, info.decoded_len) ||
+                !grow(&bufs->lut, &bufs->lut_size, lut_len))
+            return WBF_ENOMEM;
+        err = wbf_table_decode(&table, bufs->decoded, bufs->decoded_size,
+                NULL);
+        if (err != WBF_OK)
+            return err;
+        wbf_table_unpack(wbf, bufs->decoded, frames, bufs->lut);
+        // FNV-1a
+        for (size_t i = 0; i < lut_len; i++)
+            res->hash = (res->hash ^ bufs->lut[i]) * 0x100000001b3ull;
+    }
+    return WBF_OK;
+}
+
+static void run(path_t path, char **files, int count, buffers_t *bufs,
+        result_t *res) {
+    for (int i = 0; i < count; i++) {
+        wbf_t wbf;
+        void *buf = NULL;
+        int err;
+        if (path == P_READ) {
+            size_t len;
+            buf = read_file(files[i], &len);
+            err = buf ? wbf_open_mem(&wbf, buf, len) : WBF_EIO;
+        }
+        else {
+            err = wbf_open(&wbf, files[i]);
+        }
+        if (err == WBF_OK) {
+            res->bytes += wbf.map.size;
+            err = parse(&wbf, path != P_INDEX, bufs, res);
+            wbf_close(&wbf);
+        }
+        free(buf);
+        res->files++;
+        if (err != WBF_OK)
+            res->errors++;
+    }
+}
+
+static void usage(const char *argv0) {
+    fprintf(stderr, "Usage: %s [-n runs] file.wbf...\n"
+            "  -n runs   Passes over the file list, default 20\n", argv0);
+}
+
+int main(int argc, char **argv) {
+    int runs = 20;
+    int opt;
+    while ((opt = getopt(argc, argv, "n:h")) != -1) {
+        switch (opt) {
+        case 'n':
+            runs = atoi(optarg);
+            break;
+        default:
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    int count = argc - optind;
+    char **files = argv + optind;
+    if ((count == 0) || (runs < 1)) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    buffers_t bufs = {0};
+    result_t results[P_COUNT];
+    uint64_t ns[P_COUNT];
+    for (int p = 0; p < P_COUNT; p++) {
+        // Warm up the page cache and the buffers
+        result_t warm = {0};
+        run(p, files, count, &bufs, &warm);
+        uint64_t start = now_ns();
+        for (int r = 0; r < runs; r++) {
+            memset(&results[p], 0, sizeof(result_t));
+            run(p, files, count, &bufs, &results[p]);
+        }
+        ns[p] = now_ns() - start;
+    }
+
+    result_t *ref = &results[P_READ];
+    printf("%d files, %.1f KB, %"PRIu64" distinct tables, %"PRIu64
+            " frames, %"PRIu64" failed to parse\n", count, ref->bytes / 1e3,
+            ref->tables, ref->frames, ref->errors);
+    printf("%-8s%12s%12s%10s\n", "", "files/s", "MB/s", "vs read");
+    for (int p = 0; p < P_COUNT; p++) {
+        double sec = ns[p] / 1e9;
+        printf("%-8s%12.0f%12.1f%9.2fx\n", path_names[p],
+                (double)count * runs / sec,
+                (double)ref->bytes * runs / sec / 1e6,
+                (double)ns[P_READ] / ns[p]);
+    }
+    bool match = (results[P_MMAP].hash == ref->hash) &&
+            (results[P_MMAP].tables == ref->tables) &&
+            (results[P_INDEX].tables == ref->tables) &&
+            (results[P_INDEX].frames == ref->frames);
+    printf("mmap and index results %s read\n", match ? "match" : "DIFFER from");
+
+    free(bufs.decoded);
+    free(bufs.lut);
+    return match ? 0 : 1;
+}
@@ -0,0 +1,101 @@
+// libwbf, Eink waveform flash decompressor
+// Copyright 2024 Wenting Zhang
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include <stdint.h>
+#include <string.h>
+#include "wbf.h"
+
+static uint32_t read_uint16_le(const uint8_t *ptr) {
+    uint32_t b0 = (uint32_t)(*ptr++);
+    uint32_t b1 = (uint32_t)(*ptr++) << 8;
+    return b0 | b1;
+}
+
+static uint32_t read_uint32_be(const uint8_t *ptr) {
+    uint32_t b0 = (uint32_t)(*ptr++) << 24;
+    uint32_t b1 = (uint32_t)(*ptr++) << 16;
+    uint32_t b2 = (uint32_t)(*ptr++) << 8;
+    uint32_t b3 = (uint32_t)(*ptr++);
+    return b0 | b1 | b2 | b3;
+}
+
+int wbf_flash_header(const uint8_t *src, size_t len, wbf_flash_header_t *hdr) {
+    if (len < WBF_FLASH_HEADER_SIZE)
+        return WBF_EFORMAT;
+    hdr->compressed_len = read_uint32_be(src);
+    hdr->version = read_uint32_be(src + 4);
+    return WBF_OK;
+}
+
+// Decompresses into dst if it's not NULL, otherwise only checks the tokens
+static int expand(const uint8_t *src, size_t len, uint8_t *dst,
+        size_t dst_len, size_t *out_len, wbf_flash_trace_t trace, void *ctx) {
+    wbf_flash_header_t hdr;
+    int res = wbf_flash_header(src, len, &hdr);
+    if (res != WBF_OK)
+        return res;
+    if (hdr.version != 1)
+        return WBF_EINVAL;
+    if ((uint64_t)hdr.compressed_len + WBF_FLASH_HEADER_SIZE > len)
+        return WBF_EFORMAT;
+
+    const uint8_t *ptr = src + WBF_FLASH_HEADER_SIZE;
+    // A partial token at the end is ignored
+    const uint8_t *ptr_end = ptr + (hdr.compressed_len & ~3u);
+    size_t wrptr = 0;
+    while (ptr < ptr_end) {
+        uint32_t offset = read_uint16_le(ptr);
+        uint8_t run = ptr[2];
+        uint8_t byte = ptr[3];
+        ptr += 4;
+        if (trace)
+            trace(ctx, wrptr, offset, run, byte);
+        if ((run != 0) && (offset > wrptr))
+            return WBF_EFORMAT;
+        if (dst) {
+            if (wrptr + run + 1 > dst_len)
+                return WBF_ESPACE;
+            if ((run != 0) && (offset == 0)) {
+                // Copies the bytes about to be written, which are still 0
+                memset(dst + wrptr, 0, run);
+            }
+            else {
+                // Source and destination overlap when offset < run
+                for (int i = 0; i < run; i++)
+                    dst[wrptr + i] = dst[wrptr - offset + i];
+            }
+            dst[wrptr + run] = byte;
+        }
+        wrptr += run + 1;
+    }
+    *out_len = wrptr;
+    return WBF_OK;
+}
+
+int wbf_flash_size(const uint8_t *src, size_t len, size_t *size) {
+    return expand(src, len, NULL, 0, size, NULL, NULL);
+}
+
+int wbf_flash_decompress(const uint8_t *src, size_t len, uint8_t *dst,
+        size_t dst_len, size_t *out_len, wbf_flash_trace_t trace, void *ctx) {
+    return expand(src, len, dst, dst_len, out_len, trace, ctx);
+}
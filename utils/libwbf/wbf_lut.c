@@ -0,0 +1,312 @@
+// libwbf, binary waveform LUT container
+// Copyright 2025 Wenting Zhang
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+// Tables are kept unpacked in memory as one byte per value. On disk they are
+// packed at 2 or 4 bits, whichever fits, so loading is a single read and a
+// shift per value instead of parsing text.
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include "wbf.h"
+
+static void write_uint32_le(uint8_t *dst, uint32_t val) {
+    dst[0] = val & 0xff;
+    dst[1] = (val >> 8) & 0xff;
+    dst[2] = (val >> 16) & 0xff;
+    dst[3] = (val >> 24) & 0xff;
+}
+
+static uint32_t read_uint32_le(const uint8_t *src) {
+    return (uint32_t)src[0] | ((uint32_t)src[1] << 8) |
+            ((uint32_t)src[2] << 16) | ((uint32_t)src[3] << 24);
+}
+
+int wbf_lut_alloc(wbf_lut_t *lut, int states, int frames, bool uni) {
+    if (((states != 16) && (states != 32)) || (frames < 0))
+        return WBF_EINVAL;
+    lut->states = states;
+    lut->frames = frames;
+    lut->uni = uni;
+    size_t len = (size_t)frames * wbf_lut_frame_size(lut);
+    lut->values = calloc(len ? len : 1, 1);
+    return lut->values ? WBF_OK : WBF_ENOMEM;
+}
+
+void wbf_lut_free(wbf_lut_t *lut) {
+    free(lut->values);
+    lut->values = NULL;
+}
+
+size_t wbf_lut_frame_size(const wbf_lut_t *lut) {
+    return lut->uni ? lut->states : lut->states * lut->states;
+}
+
+int wbf_lut_bits(const wbf_lut_t *lut) {
+    size_t len = (size_t)lut->frames * wbf_lut_frame_size(lut);
+    for (size_t i = 0; i < len; i++)
+        if (lut->values[i] > 3)
+            return 4;
+    return 2;
+}
+
+size_t wbf_lut_packed_size(const wbf_lut_t *lut, int bits) {
+    size_t values = (size_t)lut->frames * wbf_lut_frame_size(lut);
+    return WBF_LUT_HEADER_SIZE + (values * bits + 7) / 8;
+}
+
+size_t wbf_lut_pack(const wbf_lut_t *lut, uint8_t *buf, size_t len) {
+    int bits = wbf_lut_bits(lut);
+    size_t size = wbf_lut_packed_size(lut, bits);
+    if (len < size)
+        return size;
+    size_t values = (size_t)lut->frames * wbf_lut_frame_size(lut);
+    const uint8_t *src = lut->values;
+    uint8_t *dst = buf + WBF_LUT_HEADER_SIZE;
+    memset(dst, 0, size - WBF_LUT_HEADER_SIZE);
+    if (bits == 2) {
+        for (size_t i = 0; i < values; i++)
+            dst[i >> 2] |= (src[i] & 0x3) << ((i & 3) * 2);
+    }
+    else {
+        for (size_t i = 0; i < values; i++)
+            dst[i >> 1] |= (src[i] & 0xf) << ((i & 1) * 4);
+    }
+    memcpy(buf, WBF_LUT_MAGIC, 4);
+    buf[4] = WBF_LUT_VERSION;
+    buf[5] = bits;
+    buf[6] = lut->states;
+    buf[7] = lut->uni ? WBF_LUT_FLAG_1D : 0;
+    write_uint32_le(buf + 8, lut->frames);
+    write_uint32_le(buf + 12, wbf_crc32_update(0, dst,
+            size - WBF_LUT_HEADER_SIZE));
+    return size;
+}
+
+int wbf_lut_unpack(wbf_lut_t *lut, const uint8_t *buf, size_t len) {
+    memset(lut, 0, sizeof(wbf_lut_t));
+    if ((len < WBF_LUT_HEADER_SIZE) || (memcmp(buf, WBF_LUT_MAGIC, 4) != 0))
+        return WBF_EFORMAT;
+    if (buf[4] != WBF_LUT_VERSION)
+        return WBF_EINVAL;
+    int bits = buf[5];
+    if ((bits != 2) && (bits != 4))
+        return WBF_EFORMAT;
+    if ((buf[6] != 16) && (buf[6] != 32))
+        return WBF_EFORMAT;
+    uint32_t frames = read_uint32_le(buf + 8);
+    lut->states = buf[6];
+    lut->uni = buf[7] & WBF_LUT_FLAG_1D;
+    // Checked before allocating, the frame count comes from the file
+    size_t frame_bytes = wbf_lut_frame_size(lut) * bits / 8;
+    if (frames > (len - WBF_LUT_HEADER_SIZE) / frame_bytes)
+        return WBF_EFORMAT;
+    lut->frames = frames;
+    size_t size = wbf_lut_packed_size(lut, bits);
+    if (len < size)
+        return WBF_EFORMAT;
+    const uint8_t *src = buf + WBF_LUT_HEADER_SIZE;
+    if (wbf_crc32_update(0, src, size - WBF_LUT_HEADER_SIZE) !=
+            read_uint32_le(buf + 12))
+        return WBF_ECHECKSUM;
+    int res = wbf_lut_alloc(lut, lut->states, frames, lut->uni);
+    if (res != WBF_OK)
+        return res;
+    size_t values = (size_t)frames * wbf_lut_frame_size(lut);
+    uint8_t *dst = lut->values;
+    if (bits == 2) {
+        for (size_t i = 0; i < values; i++)
+            dst[i] = (src[i >> 2] >> ((i & 3) * 2)) & 0x3;
+    }
+    else {
+        for (size_t i = 0; i < values; i++)
+            dst[i] = (src[i >> 1] >> ((i & 1) * 4)) & 0xf;
+    }
+    return WBF_OK;
+}
+
+int wbf_lut_save(const char *path, const wbf_lut_t *lut) {
+    size_t size = wbf_lut_pack(lut, NULL, 0);
+    uint8_t *buf = malloc(size);
+    if (!buf)
+        return WBF_ENOMEM;
+    wbf_lut_pack(lut, buf, size);
+    FILE *fp = fopen(path, "wb");
+    int res = WBF_EIO;
+    if (fp) {
+        bool ok = fwrite(buf, size, 1, fp) == 1;
+        if ((fclose(fp) == 0) && ok)
+            res = WBF_OK;
+    }
+    free(buf);
+    return res;
+}
+
+int wbf_lut_load(const char *path, wbf_lut_t *lut) {
+    wbf_map_t map;
+    memset(lut, 0, sizeof(wbf_lut_t));
+    int res = wbf_map_file(&map, path);
+    if (res != WBF_OK)
+        return res;
+    res = wbf_lut_unpack(lut, map.data, map.size);
+    wbf_unmap(&map);
+    return res;
+}
+
+static char *put_uint(char *p, unsigned int val) {
+    if (val >= 100)
+        *p++ = '0' + val / 100;
+    if (val >= 10)
+        *p++ = '0' + (val / 10) % 10;
+    *p++ = '0' + val % 10;
+    return p;
+}
+
+int wbf_lut_save_csv(const char *path, const wbf_lut_t *lut) {
+    FILE *fp = fopen(path, "w");
+    if (!fp)
+        return WBF_EIO;
+    int states = lut->states;
+    size_t frame_size = wbf_lut_frame_size(lut);
+    // Two ranges, then up to 3 digits and a comma per value
+    char *line = malloc(16 + (size_t)lut->frames * 4);
+    if (!line) {
+        fclose(fp);
+        return WBF_ENOMEM;
+    }
+    for (int i = 0; i < states; i++) {
+        for (int j = 0; j < (lut->uni ? 1 : states); j++) {
+            char *p = line;
+            p = put_uint(p, i);
+            *p++ = ',';
+            if (!lut->uni) {
+                p = put_uint(p, j);
+                *p++ = ',';
+            }
+            const uint8_t *v = lut->values + (lut->uni ? i : i * states + j);
+            for (int k = 0; k < lut->frames; k++) {
+                p = put_uint(p, v[k * frame_size]);
+                *p++ = ',';
+            }
+            *p++ = '\n';
+            fwrite(line, p - line, 1, fp);
+        }
+    }
+    free(line);
+    return (fclose(fp) == 0) ? WBF_OK : WBF_EIO;
+}
+
+static const char *skip_space(const char *p, const char *end) {
+    while ((p < end) && ((*p == ' ') || (*p == '\t') || (*p == '\r') ||
+            (*p == '"')))
+        p++;
+    return p;
+}
+
+static bool parse_uint(const char **pp, const char *end, int *val) {
+    const char *p = skip_space(*pp, end);
+    if ((p >= end) || (*p < '0') || (*p > '9'))
+        return false;
+    int v = 0;
+    while ((p < end) && (*p >= '0') && (*p <= '9') && (v < 100000))
+        v = v * 10 + (*p++ - '0');
+    *val = v;
+    *pp = skip_space(p, end);
+    return true;
+}
+
+// A single value or a range like 0:14, followed by a comma
+static bool parse_range(const char **pp, const char *end, int *begin,
+        int *last) {
+    if (!parse_uint(pp, end, begin))
+        return false;
+    *last = *begin;
+    if ((*pp < end) && (**pp == ':')) {
+        (*pp)++;
+        if (!parse_uint(pp, end, last))
+            return false;
+    }
+    if ((*pp >= end) || (**pp != ','))
+        return false;
+    (*pp)++;
+    return true;
+}
+
+int wbf_lut_load_csv(const char *path, wbf_lut_t *lut, int states,
+        int frames, uint8_t fill) {
+    memset(lut, 0, sizeof(wbf_lut_t));
+    wbf_map_t map;
+    int res = wbf_map_file(&map, path);
+    if (res == WBF_EFORMAT)
+        map.size = 0; // Empty file, everything is fill
+    else if (res != WBF_OK)
+        return res;
+    res = wbf_lut_alloc(lut, states, frames, false);
+    if (res != WBF_OK) {
+        wbf_unmap(&map);
+        return res;
+    }
+    size_t frame_size = wbf_lut_frame_size(lut);
+    memset(lut->values, fill, (size_t)frames * frame_size);
+
+    // Parsed in place, one line at a time
+    const char *p = (const char *)map.data;
+    const char *end = p + map.size;
+    while (p < end) {
+        const char *eol = memchr(p, '\n', end - p);
+        if (!eol)
+            eol = end;
+        int src0, src1, dst0, dst1;
+        if (parse_range(&p, eol, &src0, &src1) &&
+                parse_range(&p, eol, &dst0, &dst1)) {
+            if (src1 >= states)
+                src1 = states - 1;
+            if (dst1 >= states)
+                dst1 = states - 1;
+            int val;
+            for (int i = 0; (i < frames) && parse_uint(&p, eol, &val); i++) {
+                uint8_t *frame = lut->values + i * frame_size;
+                for (int src = src0; src <= src1; src++)
+                    for (int dst = dst0; dst <= dst1; dst++)
+                        frame[src * states + dst] = val;
+                if ((p < eol) && (*p == ','))
+                    p++;
+            }
+        }
+        p = eol + 1;
+    }
+    wbf_unmap(&map);
+    return WBF_OK;
+}
+
+bool wbf_lut_is_binary(const char *path) {
+    size_t len = strlen(path);
+    return (len >= 4) && (strcmp(path + len - 4, ".lut") == 0);
+}
+
+int wbf_lut_load_table(const char *path, wbf_lut_t *lut, int states,
+        int frames, uint8_t fill) {
+    if (wbf_lut_is_binary(path))
+        return wbf_lut_load(path, lut);
+    return wbf_lut_load_csv(path, lut, states, frames, fill);
+}
@@ -0,0 +1,280 @@
+//
+// libwbf, binary waveform LUT container
+// Copyright 2025 Wenting Zhang
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+//
+// Round trip of every distinct table in a set of .wbf files, the way the
+// dump tools write them out and the assemblers load them back:
+//   printf    fprintf per value, like the dumpers used to, write only
+//   csv       wbf_lut_save_csv() and wbf_lut_load_csv()
+//   lut       wbf_lut_save() and wbf_lut_load()
+// Everything loaded back must match the tables unpacked from the .wbf.
+//
+#include <stdio.h>
+#include <stdlib.h>
+#include <inttypes.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include "wbf.h"
+
+#define MAX_TABLES  (WBF_MODE_MAX * 256)
+
+typedef enum {
+    F_PRINTF,
+    F_CSV,
+    F_LUT,
+    F_COUNT
+} format_t;
+
+static const char *format_names[F_COUNT] = { "printf", "csv", "lut" };
+static const char *format_ext[F_COUNT] = { "csv", "csv", "lut" };
+
+typedef struct {
+    uint64_t write_ns;
+    uint64_t read_ns;
+    uint64_t bytes;
+    uint64_t mismatches;
+    uint64_t errors;
+} result_t;
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+static int save_printf(const char *path, const wbf_lut_t *lut) {
+    FILE *fp = fopen(path, "w");
+    if (!fp)
+        return WBF_EIO;
+    int states = lut->states;
+    for (int i = 0; i < states; i++) {
+        for (int j = 0; j < states; j++) {
+            fprintf(fp, "%d,%d,", i, j);
+            for (int k = 0; k < lut->frames; k++)
+                fprintf(fp, "%d,", lut->values[(k * states + i) * states + j]);
+            fprintf(fp, "\n");
+        }
+    }
+    return (fclose(fp) == 0) ? WBF_OK : WBF_EIO;
+}
+
+// Distinct tables of every file, unpacked
+static int load_tables(char **files, int count, wbf_lut_t *luts, int *tables) {
+    for (int i = 0; i < count; i++) {
+        wbf_t wbf;
+        int err = wbf_open(&wbf, files[i]);
+        if (err != WBF_OK) {
+            fprintf(stderr, "%s: %s\n", files[i], wbf_strerror(err));
+            return err;
+        }
+        if (wbf.uni) {
+            // The CSV loader only takes src,dst rows
+            fprintf(stderr, "%s: 1D tables, skipped\n", files[i]);
+            wbf_close(&wbf);
+            continue;
+        }
+        uint32_t offsets[MAX_TABLES];
+        int found = 0;
+        wbf_iter_t iter;
+        wbf_table_t table;
+        wbf_iter_init(&iter, &wbf);
+        while (wbf_iter_next(&iter, &table, &err)) {
+            if ((err != WBF_OK) && (err != WBF_ECHECKSUM))
+                break;
+            err = WBF_OK;
+            int k;
+            for (k = 0; k < found; k++)
+                if (offsets[k] == table.offset)
+                    break;
+            if (k != found)
+                continue;
+            if ((found == MAX_TABLES) || (*tables == MAX_TABLES)) {
+                err = WBF_ENOMEM;
+                break;
+            }
+            offsets[found++] = table.offset;
+
+            wbf_rle_info_t info;
+            err = wbf_table_scan(&table, &info);
+            if (err != WBF_OK)
+                break;
+            uint8_t *decoded = malloc(info.decoded_len ? info.decoded_len : 1);
+            wbf_lut_t *lut = &luts[*tables];
+            int frames = wbf_table_frames(&wbf, info.decoded_len);
+            err = decoded ? wbf_lut_alloc(lut, wbf_states(&wbf), frames,
+                    false) : WBF_ENOMEM;
+            if (err == WBF_OK)
+                err = wbf_table_decode(&table, decoded, info.decoded_len,
+                        NULL);
+            if (err == WBF_OK) {
+                wbf_table_unpack(&wbf, decoded, frames, lut->values);
+                (*tables)++;
+            }
+            else {
+                wbf_lut_free(lut);
+            }
+            free(decoded);
+            if (err != WBF_OK)
+                break;
+        }
+        wbf_close(&wbf);
+        if (err != WBF_OK) {
+            fprintf(stderr, "%s: %s\n", files[i], wbf_strerror(err));
+            return err;
+        }
+    }
+    return WBF_OK;
+}
+
+static bool lut_equal(const wbf_lut_t *a, const wbf_lut_t *b) {
+    return (a->states == b->states) && (a->frames == b->frames) &&
+            (a->uni == b->uni) && (memcmp(a->values, b->values,
+            (size_t)a->frames * wbf_lut_frame_size(a)) == 0);
+}
+
+static void run(format_t format, const wbf_lut_t *luts, int tables,
+        const char *dir, char *fn, result_t *res) {
+    uint64_t start = now_ns();
+    for (int i = 0; i < tables; i++) {
+        sprintf(fn, "%s/lut_bench_%d.%s", dir, i, format_ext[format]);
+        int err;
+        if (format == F_PRINTF)
+            err = save_printf(fn, &luts[i]);
+        else if (format == F_CSV)
+            err = wbf_lut_save_csv(fn, &luts[i]);
+        else
+            err = wbf_lut_save(fn, &luts[i]);
+        if (err != WBF_OK)
+            res->errors++;
+    }
+    res->write_ns += now_ns() - start;
+
+    start = now_ns();
+    for (int i = 0; i < tables; i++) {
+        if (format == F_PRINTF)
+            break;
+        sprintf(fn, "%s/lut_bench_%d.%s", dir, i, format_ext[format]);
+        wbf_lut_t lut;
+        int err = wbf_lut_load_table(fn, &lut, luts[i].states,
+                luts[i].frames, 0);
+        if (err != WBF_OK)
+            res->errors++;
+        else if (!lut_equal(&lut, &luts[i]))
+            res->mismatches++;
+        wbf_lut_free(&lut);
+    }
+    res->read_ns += now_ns() - start;
+
+    res->bytes = 0;
+    for (int i = 0; i < tables; i++) {
+        sprintf(fn, "%s/lut_bench_%d.%s", dir, i, format_ext[format]);
+        wbf_map_t map;
+        if (wbf_map_file(&map, fn) == WBF_OK) {
+            res->bytes += map.size;
+            wbf_unmap(&map);
+        }
+    }
+}
+
+static void usage(const char *argv0) {
+    fprintf(stderr, "Usage: %s [-n runs] [-d dir] file.wbf...\n"
+            "  -n runs   Round trips of the whole set, default 5\n"
+            "  -d dir    Directory for the table files, default .\n", argv0);
+}
+
+int main(int argc, char **argv) {
+    int runs = 5;
+    const char *dir = ".";
+    int opt;
+    while ((opt = getopt(argc, argv, "n:d:h")) != -1) {
+        switch (opt) {
+        case 'n':
+            runs = atoi(optarg);
+            break;
+        case 'd':
+            dir = optarg;
+            break;
+        default:
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    int count = argc - optind;
+    char **files = argv + optind;
+    if ((count == 0) || (runs < 1)) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    wbf_lut_t *luts = calloc(MAX_TABLES, sizeof(wbf_lut_t));
+    int tables = 0;
+    if (!luts || (load_tables(files, count, luts, &tables) != WBF_OK))
+        return 1;
+    uint64_t frames = 0;
+    for (int i = 0; i < tables; i++)
+        frames += luts[i].frames;
+
+    char *fn = malloc(strlen(dir) + 32);
+    result_t results[F_COUNT] = {0};
+    for (int f = 0; f < F_COUNT; f++)
+        for (int r = 0; r < runs; r++)
+            run(f, luts, tables, dir, fn, &results[f]);
+
+    printf("%d files, %d distinct tables, %"PRIu64" frames\n", count, tables,
+            frames);
+    printf("%-8s%12s%12s%12s%10s\n", "", "write ms", "read ms", "KB",
+            "vs csv");
+    bool ok = true;
+    for (int f = 0; f < F_COUNT; f++) {
+        result_t *res = &results[f];
+        uint64_t total = res->write_ns + res->read_ns;
+        uint64_t csv = results[F_CSV].write_ns + results[F_CSV].read_ns;
+        if (f == F_PRINTF)
+            printf("%-8s%12.2f%12s%12.1f%10s\n", format_names[f],
+                    res->write_ns / 1e6 / runs, "-", res->bytes / 1e3, "-");
+        else
+            printf("%-8s%12.2f%12.2f%12.1f%9.2fx\n", format_names[f],
+                    res->write_ns / 1e6 / runs, res->read_ns / 1e6 / runs,
+                    res->bytes / 1e3, (double)csv / total);
+        if (res->errors || res->mismatches) {
+            printf("%s: %"PRIu64" errors, %"PRIu64" tables read back "
+                    "differently\n", format_names[f], res->errors,
+                    res->mismatches);
+            ok = false;
+        }
+    }
+    if (ok)
+        printf("All tables read back unchanged\n");
+
+    for (int f = 0; f < F_COUNT; f++) {
+        for (int i = 0; i < tables; i++) {
+            sprintf(fn, "%s/lut_bench_%d.%s", dir, i, format_ext[f]);
+            unlink(fn);
+        }
+    }
+    for (int i = 0; i < tables; i++)
+        wbf_lut_free(&luts[i]);
+    free(luts);
+    free(fn);
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,152 @@
+/*******************************************************************************
+ * libwbf, Freescale/NXP EPDC waveform firmware parser
+ * Based on https://github.com/julbouln/ice40_eink_controller
+ *
+ * This is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * This software is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * the software. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * This file is partially derived from Linux kernel driver, with the following
+ * copyright information:
+ * Copyright (C) 2014-2016 Freescale Semiconductor, Inc.
+ * Copyright 2017 NXP
+ ******************************************************************************/
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "wbf.h"
+
+#define MXC_HEADER_SIZE sizeof(wbf_mxc_header_t)
+
+static uint64_t read_uint64_le(const uint8_t* src) {
+    return ((uint64_t)src[7] << 56) |
+            ((uint64_t)src[6] << 48) |
+            ((uint64_t)src[5] << 40) |
+            ((uint64_t)src[4] << 32) |
+            ((uint64_t)src[3] << 24) |
+            ((uint64_t)src[2] << 16) |
+            ((uint64_t)src[1] << 8) |
+            (uint64_t)src[0];
+}
+
+static uint8_t read_uint4(const uint8_t* src, size_t addr) {
+    uint8_t val = src[addr >> 1];
+    if (addr & 1)
+        val = (val >> 4) & 0xf;
+    else
+        val = val & 0xf;
+    return val;
+}
+
+static int parse(wbf_mxc_t *mxc, int version) {
+    if ((version != 1) && (version != 2))
+        return WBF_EINVAL;
+    mxc->version = version;
+    if (mxc->map.size < MXC_HEADER_SIZE)
+        return WBF_EFORMAT;
+    mxc->header = (const wbf_mxc_header_t *)mxc->map.data;
+    mxc->modes = mxc->header->mc + 1;
+    mxc->temps = mxc->header->trc + 1;
+    // Temperature range table, then one byte of padding
+    size_t data_offset = MXC_HEADER_SIZE + mxc->temps + 1;
+    if (data_offset > mxc->map.size)
+        return WBF_EFORMAT;
+    mxc->temp_table = mxc->map.data + MXC_HEADER_SIZE;
+    mxc->data = mxc->map.data + data_offset;
+    mxc->data_size = mxc->map.size - data_offset;
+    return WBF_OK;
+}
+
+int wbf_mxc_open(wbf_mxc_t *mxc, const char *path, int version) {
+    memset(mxc, 0, sizeof(wbf_mxc_t));
+    int res = wbf_map_file(&mxc->map, path);
+    if (res != WBF_OK)
+        return res;
+    res = parse(mxc, version);
+    if (res != WBF_OK)
+        wbf_mxc_close(mxc);
+    return res;
+}
+
+int wbf_mxc_open_mem(wbf_mxc_t *mxc, const void *data, size_t size,
+        int version) {
+    memset(mxc, 0, sizeof(wbf_mxc_t));
+    mxc->map.data = data;
+    mxc->map.size = size;
+    return parse(mxc, version);
+}
+
+void wbf_mxc_close(wbf_mxc_t *mxc) {
+    wbf_unmap(&mxc->map);
+    memset(mxc, 0, sizeof(wbf_mxc_t));
+}
+
+static int read_offset(const wbf_mxc_t *mxc, uint64_t pos, uint64_t *val) {
+    if ((pos > mxc->data_size) || (mxc->data_size - pos < 8))
+        return WBF_EFORMAT;
+    *val = read_uint64_le(mxc->data + pos);
+    return WBF_OK;
+}
+
+int wbf_mxc_mode_pointer(const wbf_mxc_t *mxc, int mode, uint64_t *addr) {
+    if ((mode < 0) || (mode >= mxc->modes))
+        return WBF_EINVAL;
+    return read_offset(mxc, (uint64_t)mode * 8, addr);
+}
+
+int wbf_mxc_get_table(const wbf_mxc_t *mxc, int mode, int temp,
+        wbf_mxc_table_t *table) {
+    if ((temp < 0) || (temp >= mxc->temps))
+        return WBF_EINVAL;
+    uint64_t mode_addr, addr, frames;
+    int res = wbf_mxc_mode_pointer(mxc, mode, &mode_addr);
+    if (res != WBF_OK)
+        return res;
+    if (mode_addr > mxc->data_size)
+        return WBF_EFORMAT;
+    res = read_offset(mxc, mode_addr + temp * 8, &addr);
+    if (res != WBF_OK)
+        return res;
+    res = read_offset(mxc, addr, &frames);
+    if (res != WBF_OK)
+        return res;
+    uint64_t avail = mxc->data_size - addr - 8;
+    uint64_t frame_size = (mxc->version == 2) ? 128 : 256;
+    if (frames > avail / frame_size)
+        return WBF_EFORMAT;
+    table->mode = mode;
+    table->temp = temp;
+    table->offset = addr;
+    table->frames = frames;
+    table->phases = mxc->data + addr + 8;
+    return WBF_OK;
+}
+
+void wbf_mxc_table_unpack(const wbf_mxc_t *mxc, const wbf_mxc_table_t *table,
+        uint8_t *lut) {
+    for (uint64_t k = 0; k < table->frames; k++) {
+        size_t i = k * 256;
+        size_t j = 0;
+        for (int x = 0; x < 16; x++) {
+            for (int y = 0; y < 16; y++) {
+                uint8_t val;
+                if (mxc->version == 2)
+                    val = read_uint4(table->phases, i + j);
+                else
+                    val = table->phases[i + j];
+                lut[i + y * 16 + x] = val;
+                j++;
+            }
+        }
+    }
+}
@@ -0,0 +1,208 @@
+// libwbf, content addressed waveform table store
+// Copyright 2025 Wenting Zhang
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+//
+// Tables are found by a 64 bit hash of the content. The session index keeps
+// a second hash with a different seed, so a table seen earlier in the same
+// run is matched without reading it back. Tables only on disk, from earlier
+// runs, are compared byte by byte. Hash collisions get a numbered suffix.
+//
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <errno.h>
+#include <inttypes.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "wbf.h"
+
+#define CHECK_SEED      0x5bd1e9955bd1e995ull
+#define MAX_SUFFIX      100
+
+typedef struct {
+    uint64_t hash;
+    uint64_t check;
+    size_t len;
+    char name[WBF_STORE_NAME_MAX];
+    bool used;
+} entry_t;
+
+struct wbf_store {
+    char *dir;
+    char *path;             // Scratch for file names
+    entry_t *entries;       // Open addressing, size is a power of 2
+    size_t size;
+    size_t count;
+    wbf_store_stats_t stats;
+};
+
+int wbf_store_open(wbf_store_t **store, const char *dir) {
+    if ((mkdir(dir, 0777) != 0) && (errno != EEXIST))
+        return WBF_EIO;
+    wbf_store_t *s = calloc(1, sizeof(wbf_store_t));
+    if (!s)
+        return WBF_ENOMEM;
+    s->dir = strdup(dir);
+    s->path = malloc(strlen(dir) + WBF_STORE_NAME_MAX + 32);
+    s->size = 256;
+    s->entries = calloc(s->size, sizeof(entry_t));
+    if (!s->dir || !s->path || !s->entries) {
+        wbf_store_close(s);
+        return WBF_ENOMEM;
+    }
+    *store = s;
+    return WBF_OK;
+}
+
+void wbf_store_close(wbf_store_t *store) {
+    if (!store)
+        return;
+    free(store->dir);
+    free(store->path);
+    free(store->entries);
+    free(store);
+}
+
+const char *wbf_store_dir(const wbf_store_t *store) {
+    return store->dir;
+}
+
+void wbf_store_get_stats(const wbf_store_t *store, wbf_store_stats_t *stats) {
+    *stats = store->stats;
+}
+
+static void insert(wbf_store_t *store, const entry_t *entry) {
+    if ((store->count + 1) * 2 > store->size) {
+        size_t old_size = store->size;
+        entry_t *old = store->entries;
+        entry_t *entries = calloc(old_size * 2, sizeof(entry_t));
+        if (!entries)
+            return; // Only an index, the table is looked up on disk again
+        store->entries = entries;
+        store->size = old_size * 2;
+        store->count = 0;
+        for (size_t i = 0; i < old_size; i++)
+            if (old[i].used)
+                insert(store, &old[i]);
+        free(old);
+    }
+    size_t i = entry->hash & (store->size - 1);
+    while (store->entries[i].used)
+        i = (i + 1) & (store->size - 1);
+    store->entries[i] = *entry;
+    store->entries[i].used = true;
+    store->count++;
+}
+
+static const entry_t *find(const wbf_store_t *store, uint64_t hash,
+        uint64_t check, size_t len) {
+    size_t i = hash & (store->size - 1);
+    while (store->entries[i].used) {
+        const entry_t *e = &store->entries[i];
+        if ((e->hash == hash) && (e->check == check) && (e->len == len))
+            return e;
+        i = (i + 1) & (store->size - 1);
+    }
+    return NULL;
+}
+
+// Written under a temporary name first, so another process sharing the
+// store never sees a partial table
+static int write_table(wbf_store_t *store, const char *name,
+        const uint8_t *data, size_t len) {
+    char *tmp = malloc(strlen(store->path) + 32);
+    if (!tmp)
+        return WBF_ENOMEM;
+    sprintf(tmp, "%s/%s.bin.%d", store->dir, name, (int)getpid());
+    FILE *fp = fopen(tmp, "wb");
+    int res = WBF_EIO;
+    if (fp) {
+        bool ok = (len == 0) || (fwrite(data, len, 1, fp) == 1);
+        if (fclose(fp) != 0)
+            ok = false;
+        if (ok && (rename(tmp, store->path) == 0))
+            res = WBF_OK;
+    }
+    if (res != WBF_OK)
+        unlink(tmp);
+    free(tmp);
+    return res;
+}
+
+int wbf_store_put(wbf_store_t *store, const uint8_t *data, size_t len,
+        uint32_t format, char *name, bool *added) {
+    entry_t entry;
+    entry.hash = wbf_hash64(data, len, format);
+    entry.check = wbf_hash64(data, len, format ^ CHECK_SEED);
+    entry.len = len;
+    store->stats.lookups++;
+    *added = false;
+
+    const entry_t *e = find(store, entry.hash, entry.check, len);
+    if (e) {
+        strcpy(name, e->name);
+        store->stats.hits_session++;
+        store->stats.bytes_reused += len;
+        return WBF_OK;
+    }
+
+    for (int suffix = 0; suffix < MAX_SUFFIX; suffix++) {
+        if (suffix)
+            sprintf(entry.name, "%016"PRIx64"_%d", entry.hash, suffix);
+        else
+            sprintf(entry.name, "%016"PRIx64, entry.hash);
+        sprintf(store->path, "%s/%s.bin", store->dir, entry.name);
+
+        if (access(store->path, F_OK) == 0) {
+            wbf_map_t map;
+            bool same;
+            int res = wbf_map_file(&map, store->path);
+            if (res == WBF_OK) {
+                same = (map.size == len) && (memcmp(map.data, data, len) == 0);
+                wbf_unmap(&map);
+            }
+            else {
+                // Empty files can't be mapped
+                same = (res == WBF_EFORMAT) && (len == 0);
+            }
+            if (!same) {
+                store->stats.collisions++;
+                continue;
+            }
+            store->stats.hits_disk++;
+            store->stats.bytes_reused += len;
+        }
+        else {
+            int res = write_table(store, entry.name, data, len);
+            if (res != WBF_OK)
+                return res;
+            *added = true;
+            store->stats.added++;
+            store->stats.bytes_added += len;
+        }
+        insert(store, &entry);
+        strcpy(name, entry.name);
+        return WBF_OK;
+    }
+    return WBF_EIO;
+}
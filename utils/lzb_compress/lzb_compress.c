@@ -0,0 +1,151 @@
+//
+// Glider bitstream compressor
+// Copyright 2025 Wenting Zhang
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+// Hash chain match finder, with one step lazy matching above level 1. Speed
+// doesn't matter much here, the bitstream is compressed once on the host.
+//
+#include <stdbool.h>
+#include <string.h>
+#include "lzb.h"
+#include "lzb_compress.h"
+
+#define HASH_BITS       12
+#define HASH_SIZE       (1 << HASH_BITS)
+#define MAX_OFFSET      0xffff
+// The last bytes are always literals, so the decoder never reads a match
+// offset past the end
+#define LAST_LITERALS   5
+
+typedef struct {
+    int head[HASH_SIZE];
+    int prev[LZB_BLOCK_SIZE];
+} match_finder_t;
+
+static uint32_t hash4(const uint8_t *p) {
+    uint32_t v = p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+    return (v * 2654435761u) >> (32 - HASH_BITS);
+}
+
+static void insert(match_finder_t *mf, const uint8_t *src, int pos) {
+    uint32_t h = hash4(src + pos);
+    mf->prev[pos] = mf->head[h];
+    mf->head[h] = pos;
+}
+
+static int find_match(match_finder_t *mf, const uint8_t *src, int pos,
+        int limit, int depth, int *offset) {
+    int best = 0;
+    int cand = mf->head[hash4(src + pos)];
+    while ((cand >= 0) && (depth-- > 0) && (pos - cand <= MAX_OFFSET)) {
+        int len = 0;
+        while ((pos + len < limit) && (src[cand + len] == src[pos + len]))
+            len++;
+        if (len > best) {
+            best = len;
+            *offset = pos - cand;
+            if (pos + len == limit)
+                break;
+        }
+        cand = mf->prev[cand];
+    }
+    return best;
+}
+
+static uint8_t *write_length(uint8_t *op, int len) {
+    len -= 15;
+    while (len >= 255) {
+        *op++ = 255;
+        len -= 255;
+    }
+    *op++ = len;
+    return op;
+}
+
+static uint8_t *write_sequence(uint8_t *op, const uint8_t *lit, int lit_len,
+        int offset, int match_len) {
+    uint8_t *token = op++;
+    int ml = match_len ? match_len - LZB_MIN_MATCH : 0;
+    *token = ((lit_len < 15) ? lit_len : 15) << 4;
+    *token |= (ml < 15) ? ml : 15;
+    if (lit_len >= 15)
+        op = write_length(op, lit_len);
+    memcpy(op, lit, lit_len);
+    op += lit_len;
+    if (match_len) {
+        *op++ = offset & 0xff;
+        *op++ = offset >> 8;
+        if (ml >= 15)
+            op = write_length(op, ml);
+    }
+    return op;
+}
+
+int lzb_compress_block(const uint8_t *src, int len, uint8_t *dst, int level) {
+    static match_finder_t mf;
+    int depth = (level <= 1) ? 4 : (level == 2) ? 64 : 1024;
+    bool lazy = level > 1;
+    uint8_t *op = dst + 2;
+    int anchor = 0;
+    int pos = 0;
+    int limit = len - LAST_LITERALS;
+
+    memset(mf.head, 0xff, sizeof(mf.head));
+    while (pos + LZB_MIN_MATCH <= limit) {
+        int offset;
+        int match = find_match(&mf, src, pos, limit, depth, &offset);
+        insert(&mf, src, pos);
+        if (match < LZB_MIN_MATCH) {
+            pos++;
+            continue;
+        }
+        if (lazy && (pos + 1 + LZB_MIN_MATCH <= limit)) {
+            // Take the literal if the match starting at the next byte is
+            // longer
+            int next_offset;
+            int next = find_match(&mf, src, pos + 1, limit, depth,
+                    &next_offset);
+            if (next > match + 1) {
+                pos++;
+                continue;
+            }
+        }
+        op = write_sequence(op, src + anchor, pos - anchor, offset, match);
+        for (int i = pos + 1; (i < pos + match) &&
+                (i + LZB_MIN_MATCH <= limit); i++)
+            insert(&mf, src, i);
+        pos += match;
+        anchor = pos;
+    }
+    op = write_sequence(op, src + anchor, len - anchor, 0, 0);
+
+    int clen = op - dst - 2;
+    if (clen >= len) {
+        // Incompressible, store it
+        dst[0] = len & 0xff;
+        dst[1] = (len >> 8) | (LZB_BLOCK_STORED >> 8);
+        memcpy(dst + 2, src, len);
+        return len + 2;
+    }
+    dst[0] = clen & 0xff;
+    dst[1] = clen >> 8;
+    return clen + 2;
+}
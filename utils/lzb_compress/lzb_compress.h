@@ -0,0 +1,35 @@
+//
+// Glider bitstream compressor
+// Copyright 2025 Wenting Zhang
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+// Compressor for the block format in fw/User/lzb.h
+//
+#pragma once
+
+#include <stdint.h>
+
+// Worst case size of one compressed block, including the u16 length
+#define LZB_BOUND(len)      ((len) + (len) / 255 + 16)
+
+// Compress one block of at most LZB_BLOCK_SIZE bytes into dst, prefixed with
+// its length. Falls back to a stored block if it doesn't get smaller.
+// Returns the number of bytes written.
+int lzb_compress_block(const uint8_t *src, int len, uint8_t *dst, int level);
@@ -0,0 +1,183 @@
+//
+// Glider bitstream compressor
+// Copyright 2025 Wenting Zhang
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+// Compress an FPGA bitstream for the firmware. The output is uploaded in
+// place of the raw bitstream, the firmware tells them apart by the header.
+//
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "lzb.h"
+#include "lzb_compress.h"
+
+static uint8_t *read_file(const char *fn, long *size) {
+    FILE *fp = fopen(fn, "rb");
+    if (!fp) {
+        perror(fn);
+        return NULL;
+    }
+    fseek(fp, 0, SEEK_END);
+    *size = ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+    uint8_t *buf = malloc(*size ? *size : 1);
+    if (fread(buf, 1, *size, fp) != (size_t)*size) {
+        perror(fn);
+        free(buf);
+        buf = NULL;
+    }
+    fclose(fp);
+    return buf;
+}
+
+static int write_file(const char *fn, const uint8_t *buf, long size) {
+    FILE *fp = fopen(fn, "wb");
+    if (!fp) {
+        perror(fn);
+        return -1;
+    }
+    int res = (fwrite(buf, 1, size, fp) == (size_t)size) ? 0 : -1;
+    if (res != 0)
+        perror(fn);
+    fclose(fp);
+    return res;
+}
+
+static long compress(const uint8_t *src, long size, uint8_t *dst, int level) {
+    lzb_header_t hdr = {
+        .magic = LZB_MAGIC,
+        .size = size,
+        .block_size = LZB_BLOCK_SIZE
+    };
+    memcpy(dst, &hdr, sizeof(hdr));
+    long out = sizeof(hdr);
+    for (long pos = 0; pos < size; pos += LZB_BLOCK_SIZE) {
+        int len = (size - pos > LZB_BLOCK_SIZE) ? LZB_BLOCK_SIZE : size - pos;
+        out += lzb_compress_block(src + pos, len, dst + out, level);
+    }
+    return out;
+}
+
+// Same walk over the blocks as fpga_load_bitstream(). Returns the
+// decompressed size, or -1 if the file is corrupted.
+static long decompress(const uint8_t *src, long size, uint8_t *dst,
+        long dst_size) {
+    lzb_header_t hdr;
+    if (size < (long)sizeof(hdr))
+        return -1;
+    memcpy(&hdr, src, sizeof(hdr));
+    if ((hdr.magic != LZB_MAGIC) || (hdr.block_size != LZB_BLOCK_SIZE) ||
+            (hdr.size > dst_size))
+        return -1;
+    long pos = sizeof(hdr);
+    long out = 0;
+    while (out < hdr.size) {
+        int len = (hdr.size - out > LZB_BLOCK_SIZE) ? LZB_BLOCK_SIZE :
+                hdr.size - out;
+        if (pos + 2 > size)
+            return -1;
+        int clen = src[pos] | (src[pos + 1] << 8);
+        pos += 2;
+        int stored = clen & LZB_BLOCK_STORED;
+        clen &= ~LZB_BLOCK_STORED;
+        if (pos + clen > size)
+            return -1;
+        if (stored) {
+            if (clen != len)
+                return -1;
+            memcpy(dst + out, src + pos, len);
+        }
+        else if (lzb_decompress(src + pos, clen, dst + out, len) != len) {
+            return -1;
+        }
+        pos += clen;
+        out += len;
+    }
+    return out;
+}
+
+static void print_usage(const char *name) {
+    fprintf(stderr, "Usage: %s [-l level] [-d] <input> <output>\n", name);
+    fprintf(stderr, "  -l level  Match search effort, 1 to 3 (default 3)\n");
+    fprintf(stderr, "  -d        Decompress instead\n");
+}
+
+int main(int argc, char *argv[]) {
+    int level = 3;
+    int unpack = 0;
+    int opt;
+    while ((opt = getopt(argc, argv, "l:d")) != -1) {
+        switch (opt) {
+        case 'l':
+            level = atoi(optarg);
+            break;
+        case 'd':
+            unpack = 1;
+            break;
+        default:
+            print_usage(argv[0]);
+            return 1;
+        }
+    }
+    if (argc - optind != 2) {
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    long size;
+    uint8_t *src = read_file(argv[optind], &size);
+    if (!src)
+        return 1;
+
+    if (unpack) {
+        lzb_header_t hdr;
+        if (size < (long)sizeof(hdr)) {
+            fprintf(stderr, "Not a compressed bitstream\n");
+            return 1;
+        }
+        memcpy(&hdr, src, sizeof(hdr));
+        uint8_t *dst = malloc(hdr.size ? hdr.size : 1);
+        long out = decompress(src, size, dst, hdr.size);
+        if (out < 0) {
+            fprintf(stderr, "Corrupted or not a compressed bitstream\n");
+            return 1;
+        }
+        return write_file(argv[optind + 1], dst, out) ? 1 : 0;
+    }
+
+    long bound = sizeof(lzb_header_t) +
+            (size / LZB_BLOCK_SIZE + 1) * LZB_BOUND(LZB_BLOCK_SIZE);
+    uint8_t *dst = malloc(bound);
+    long out = compress(src, size, dst, level);
+
+    // Check the round trip with the decoder from the firmware
+    uint8_t *check = malloc(size ? size : 1);
+    if ((decompress(dst, out, check, size) != size) ||
+            (memcmp(check, src, size) != 0)) {
+        fprintf(stderr, "Round trip check failed\n");
+        return 1;
+    }
+
+    printf("%ld -> %ld bytes (%.1f%%)\n", size, out,
+            size ? out * 100.0 / size : 0.0);
+    return write_file(argv[optind + 1], dst, out) ? 1 : 0;
+}
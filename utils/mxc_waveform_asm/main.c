@@ -25,7 +25,6 @@
  * Copyright 2017 NXP
  * 
  * inih is used in this project, which is licensed under BSD-3-Clause.
- * csv_parser is used in this project, which is licensed under MIT.
  ******************************************************************************/
 #include <stdint.h>
 #include <stdio.h>
@@ -34,14 +33,14 @@
 #include <assert.h>
 #include <libgen.h>
 #include <inttypes.h>
+#include <strings.h>
+#include <stdbool.h>
 #include "ini.h"
-#include "csv.h"
+#include "wbf.h"
 
 #define MAX_MODES (32) // Maximum waveform modes supported
 #define MAX_TEMPS (32) // Maximum temperature ranges supported
 
-#define MAX_CSV_LINE (1024)
-
 #define GREYSCALE_BPP   (2)
 #define GREYSCALE_LEVEL (16)
 
@@ -80,6 +79,7 @@ typedef struct {
 
 typedef struct {
     char *prefix;
+    bool binary; // FORMAT = LUT, tables are .lut instead of .csv
     int modes;
     char **mode_names;
     int *frame_counts; // frame_counts[mode * temps + temp]
@@ -99,6 +99,16 @@ static int ini_parser_handler(void* user, const char* section, const char* name,
         else if (strcmp(name, "PREFIX") == 0) {
             pcontext->prefix = strdup(value);
         }
+        else if (strcmp(name, "FORMAT") == 0) {
+            if (strcasecmp(value, "LUT") == 0)
+                pcontext->binary = true;
+            else if (strcasecmp(value, "CSV") == 0)
+                pcontext->binary = false;
+            else {
+                fprintf(stderr, "Unknown table format %s\n", value);
+                return 0;
+            }
+        }
         else if (strcmp(name, "MODES") == 0) {
             // Allocate memory for modes
             pcontext->modes = atoi(value);
@@ -171,75 +181,34 @@ static void write_uint64_le(uint8_t* dst, uint64_t val) {
     dst[0] = (val) & 0xff;
 }
 
-static void parse_range(const char* str, int* begin, int* end) {
-    // Parse range specified in the waveform.
-    // Example:
-    // 2 - 2 to 2
-    // 0:15 - 0 to 15
-    // 4:7 - 4 to 7
-    char* delim = strchr(str, ':');
-    if (delim) {
-        *begin = atoi(str);
-        *end = atoi(delim + 1);
-    }
-    else {
-        *begin = atoi(str);
-        *end = *begin;
-    }
-}
-
-static void load_waveform_csv(const char* filename, int frame_count,
+static int load_waveform(const char* filename, int frame_count,
         uint8_t* lut) {
-    FILE* fp = fopen(filename, "r");
-    assert(fp);
-
     // Unspecified parts of LUT will be filled with 3 instead of 0 for debugging
-    memset(lut, 3, frame_count * 256);
-
-    char* line;
-    int done = 0;
-    int err = 0;
-    int rst = 1; // Reset fread_csv_line internal state in the first call
-    while (!done) {
-        line = fread_csv_line(fp, MAX_CSV_LINE, &done, &err, rst);
-        rst = 0;
-        if (!line) continue;
-        char** parsed = parse_csv(line);
-        if (!parsed) continue;
-        // Parse source/ destination range
-        int src0, src1, dst0, dst1;
-        // Skip empty lines
-        if (!parsed[0]) continue;
-        if (!parsed[1]) continue;
-        parse_range(parsed[0], &src0, &src1);
-        parse_range(parsed[1], &dst0, &dst1);
-        // Fill in LUT
-        for (int i = 0; i < frame_count; i++) {
-            assert(parsed[i]);
-            uint8_t val = atoi(parsed[i + 2]);
-            for (int src = src0; src <= src1; src++) {
-                for (int dst = dst0; dst <= dst1; dst++) {
-                    lut[i * 256 + dst * 16 + src] = val;
-                }
-            }
-        }
-        free_csv_line(parsed);
-        free(line);
+    wbf_lut_t table;
+    int res = wbf_lut_load_table(filename, &table, GREYSCALE_LEVEL,
+            frame_count, 3);
+    if (res != WBF_OK) {
+        fprintf(stderr, "Failed to load %s: %s\n", filename,
+                wbf_strerror(res));
+        return -1;
     }
-
-    fclose(fp);
-}
-
-static void dump_lut(int frame_count, uint8_t* lut) {
-    for (int src = 0; src < 16; src++) {
-        for (int dst = 0; dst < 16; dst++) {
-            printf("%x -> %x: ", src, dst);
-            for (int frame = 0; frame < frame_count; frame++) {
-                printf("%d ", lut[frame * 256 + dst * 16 + src]);
+    if ((table.states != GREYSCALE_LEVEL) || table.uni ||
+            (table.frames != frame_count)) {
+        fprintf(stderr, "%s doesn't match the descriptor\n", filename);
+        wbf_lut_free(&table);
+        return -1;
+    }
+    // Tables are [src][dst], the EPDC wants [dst][src]
+    for (int i = 0; i < frame_count; i++) {
+        const uint8_t *frame = &table.values[i * 256];
+        for (int src = 0; src < 16; src++) {
+            for (int dst = 0; dst < 16; dst++) {
+                lut[i * 256 + dst * 16 + src] = frame[src * 16 + dst];
             }
-            printf("\n");
         }
     }
+    wbf_lut_free(&table);
+    return 0;
 }
 
 static void copy_lut(uint8_t* dst, uint8_t* src, size_t src_count, int ver) {
@@ -258,7 +227,7 @@ static void copy_lut(uint8_t* dst, uint8_t* src, size_t src_count, int ver) {
 }
 
 int main(int argc, char *argv[]) {
-    context_t context;
+    context_t context = { 0 };
     
     printf("Freescale/NXP i.MX EPDC waveform assembler\n");
 
@@ -334,9 +303,11 @@ int main(int argc, char *argv[]) {
             assert(context.luts[i][j]);
             char* fn = malloc(dirlen + strlen(context.prefix) + 14);
             assert(fn);
-            sprintf(fn, "%s/%s_M%d_T%d.csv", dir, context.prefix, i, j);
+            sprintf(fn, "%s/%s_M%d_T%d.%s", dir, context.prefix, i, j,
+                    context.binary ? "lut" : "csv");
             printf("Loading %s...\n", fn);
-            load_waveform_csv(fn, frame_count, context.luts[i][j]);
+            if (load_waveform(fn, frame_count, context.luts[i][j]) != 0)
+                return 1;
             free(fn);
         }
     }
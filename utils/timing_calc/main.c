@@ -0,0 +1,479 @@
+//
+// Glider panel timing calculator
+// Copyright 2025 Wenting Zhang
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+//
+// Checks a panel configuration (the config_t fields set with setcfg) against
+// the limits of the board before it's tried on hardware: pixel rate of the
+// video input and of the pipeline, DDR bandwidth for the pixel state, TCON
+// timing against the input timing, and the frame size constraints of the
+// Caster. Also lists which refresh rates would fit with the same blanking.
+//
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <stddef.h>
+#include <unistd.h>
+#include "config.h"
+
+// Figures from the README, pixel rates in MP/s
+#define PIPELINE_DITHER_MPS     133.0
+#define PIPELINE_NODITHER_MPS   280.0
+// 2 byte state read and write, half a byte of input per pixel
+#define STATE_BYTES_PER_PX      4.5
+// EPDC processes 4 pixels per clock
+#define PIXELS_PER_CLK          4
+// Frame size is written to a 24 bit register, and the memory interface
+// works on 128 pixel bursts
+#define FBYTES_MAX              0xffffff
+#define FRAME_PX_ALIGN          128
+
+#define MAX_RATES               32
+
+typedef struct {
+    const char *name;
+    const char *desc;
+    double mps;
+} limit_t;
+
+// Assuming 90% bandwidth utilization
+static const limit_t memories[] = {
+    { "sdr166x16", "SDR-166 x16", 60.0 },
+    { "sdr166x32", "SDR-166 x32", 120.0 },
+    { "ddr400x16", "DDR-400 x16", 180.0 },
+    { "ddr667x16", "DDR2/3-667 x16", 300.0 },
+    { "ddr800x16", "DDR3-800 x16 (Glider)", 360.0 },
+    { "ddr1066x16", "DDR2/3-1066 x16", 480.0 },
+    { "ddr800x32", "DDR2/3-800 x32", 720.0 },
+};
+
+static const limit_t interfaces[] = {
+    { "dvi", "DVI, ADV7611 (Glider)", 165.0 },
+    { "dvi-direct", "DVI, direct deserializer", 105.0 },
+    { "dp", "DisplayPort, PTN3460", 224.0 },
+    { "dp-serdes", "DisplayPort, 7-series SerDes", 720.0 },
+    { "mipi", "MIPI, 1.05Gbps LVDS", 230.0 },
+};
+
+typedef enum { U8, U16, U32 } field_type_t;
+
+typedef struct {
+    const char *name;
+    size_t offset;
+    field_type_t type;
+} field_t;
+
+// Timing fields, same names as setcfg
+static const field_t fields[] = {
+    { "pclk_hz", offsetof(config_t, pclk_hz), U32 },
+    { "hfp", offsetof(config_t, hfp), U8 },
+    { "vfp", offsetof(config_t, vfp), U8 },
+    { "hsync", offsetof(config_t, hsync), U8 },
+    { "vsync", offsetof(config_t, vsync), U8 },
+    { "hact", offsetof(config_t, hact), U16 },
+    { "hblk", offsetof(config_t, hblk), U16 },
+    { "vact", offsetof(config_t, vact), U16 },
+    { "vblk", offsetof(config_t, vblk), U16 },
+    { "tcon_vfp", offsetof(config_t, tcon_vfp), U8 },
+    { "tcon_vsync", offsetof(config_t, tcon_vsync), U8 },
+    { "tcon_vbp", offsetof(config_t, tcon_vbp), U8 },
+    { "tcon_vact", offsetof(config_t, tcon_vact), U16 },
+    { "tcon_hfp", offsetof(config_t, tcon_hfp), U8 },
+    { "tcon_hsync", offsetof(config_t, tcon_hsync), U8 },
+    { "tcon_hbp", offsetof(config_t, tcon_hbp), U8 },
+    { "tcon_hact", offsetof(config_t, tcon_hact), U16 },
+};
+
+typedef struct {
+    const limit_t *memory;
+    const limit_t *interface;
+    bool dither;
+} target_t;
+
+typedef struct {
+    int fails;
+    int warnings;
+    bool verbose;
+} report_t;
+
+static const limit_t *find_limit(const limit_t *list, int count,
+        const char *name) {
+    for (int i = 0; i < count; i++)
+        if (strcmp(list[i].name, name) == 0)
+            return &list[i];
+    return NULL;
+}
+
+static bool set_field(config_t *cfg, const char *name, const char *value) {
+    for (size_t i = 0; i < sizeof(fields) / sizeof(fields[0]); i++) {
+        if (strcmp(fields[i].name, name) != 0)
+            continue;
+        char *end;
+        unsigned long v = strtoul(value, &end, 10);
+        unsigned long max = (fields[i].type == U8) ? 0xff :
+                (fields[i].type == U16) ? 0xffff : 0xffffffff;
+        if ((end == value) || (v > max)) {
+            fprintf(stderr, "Invalid value %s for %s\n", value, name);
+            return false;
+        }
+        uint8_t *p = (uint8_t *)cfg + fields[i].offset;
+        if (fields[i].type == U8)
+            *p = v;
+        else if (fields[i].type == U16)
+            *(uint16_t *)p = v;
+        else
+            *(uint32_t *)p = v;
+        return true;
+    }
+    // Other setcfg keys (vcom, size_x_mm...) don't affect timing
+    return true;
+}
+
+// Accepts setcfg scripts ("setcfg set hact 1600"), setcfg get output
+// ("hact: 1600") and key=value lines
+static bool load_file(config_t *cfg, const char *fn) {
+    FILE *fp = fopen(fn, "r");
+    if (!fp) {
+        perror(fn);
+        return false;
+    }
+    char line[256];
+    bool ok = true;
+    while (ok && fgets(line, sizeof(line), fp)) {
+        char *tok[4];
+        int n = 0;
+        for (char *t = strtok(line, " \t\r\n:="); t && (n < 4);
+                t = strtok(NULL, " \t\r\n:="))
+            tok[n++] = t;
+        if ((n == 0) || (tok[0][0] == '#'))
+            continue;
+        if ((n >= 4) && (strcmp(tok[0], "setcfg") == 0) &&
+                (strcmp(tok[1], "set") == 0))
+            ok = set_field(cfg, tok[2], tok[3]);
+        else if ((n == 2) && (strcmp(tok[0], "setcfg") != 0))
+            ok = set_field(cfg, tok[0], tok[1]);
+    }
+    fclose(fp);
+    return ok;
+}
+
+static void check(report_t *r, bool ok, bool fatal, const char *fmt, ...)
+        __attribute__((format(printf, 4, 5)));
+
+static void check(report_t *r, bool ok, bool fatal, const char *fmt, ...) {
+    if (!ok) {
+        if (fatal)
+            r->fails++;
+        else
+            r->warnings++;
+    }
+    if (!r->verbose)
+        return;
+    va_list ap;
+    va_start(ap, fmt);
+    printf("  %-5s ", ok ? "ok" : fatal ? "FAIL" : "WARN");
+    vprintf(fmt, ap);
+    printf("\n");
+    va_end(ap);
+}
+
+static uint32_t h_total(const config_t *cfg) {
+    return cfg->hact + cfg->hblk;
+}
+
+static uint32_t v_total(const config_t *cfg) {
+    return cfg->vact + cfg->vblk;
+}
+
+static double pipeline_mps(const target_t *t) {
+    return t->dither ? PIPELINE_DITHER_MPS : PIPELINE_NODITHER_MPS;
+}
+
+// Highest pixel rate allowed by the board, and what sets it
+static double max_mps(const target_t *t, const char **limiter) {
+    double mps = t->interface->mps;
+    *limiter = "video input";
+    if (t->memory->mps < mps) {
+        mps = t->memory->mps;
+        *limiter = "memory";
+    }
+    if (pipeline_mps(t) < mps) {
+        mps = pipeline_mps(t);
+        *limiter = "pipeline";
+    }
+    return mps;
+}
+
+// Runs every check, prints them if the report is verbose
+static void check_config(const config_t *cfg, const target_t *t,
+        report_t *r) {
+    double pclk_mhz = cfg->pclk_hz / 1e6;
+    uint32_t tcon_hblk = cfg->tcon_hfp + cfg->tcon_hsync + cfg->tcon_hbp;
+    uint32_t tcon_vblk = cfg->tcon_vfp + cfg->tcon_vsync + cfg->tcon_vbp;
+    uint32_t tcon_vtotal = cfg->tcon_vact + tcon_vblk;
+    uint32_t width = cfg->tcon_hact * PIXELS_PER_CLK;
+    uint32_t frame_px = width * cfg->tcon_vact;
+    uint32_t frame_bytes = frame_px * 2;
+
+    check(r, (cfg->pclk_hz > 0) && (cfg->hact > 0) && (cfg->vact > 0), true,
+            "pixel clock and active size set");
+    check(r, cfg->hfp + cfg->hsync < cfg->hblk, true,
+            "input HFP + HSYNC (%u) leave a back porch in HBLK (%u)",
+            cfg->hfp + cfg->hsync, cfg->hblk);
+    check(r, cfg->vfp + cfg->vsync < cfg->vblk, true,
+            "input VFP + VSYNC (%u) leave a back porch in VBLK (%u)",
+            cfg->vfp + cfg->vsync, cfg->vblk);
+    check(r, width <= cfg->hact, true,
+            "tcon_hact x 4 (%u) within hact (%u)", width, cfg->hact);
+    check(r, width == cfg->hact, false,
+            "tcon_hact x 4 (%u) covers hact (%u)%s", width, cfg->hact,
+            (cfg->hact % PIXELS_PER_CLK) ? ", hact is not a multiple of 4" : "");
+    check(r, cfg->tcon_vact <= cfg->vact, true,
+            "tcon_vact (%u) within vact (%u)", cfg->tcon_vact, cfg->vact);
+    check(r, tcon_hblk * PIXELS_PER_CLK == cfg->hblk, true,
+            "TCON line follows the input line, HFP + HSYNC + HBP = %u, "
+            "should be hblk / 4 = %u", tcon_hblk, cfg->hblk / PIXELS_PER_CLK);
+    check(r, (cfg->tcon_hsync > 0) && (cfg->tcon_vsync > 0), true,
+            "TCON sync pulses not empty");
+    // The TCON frame restarts on every input frame, it has to end first
+    check(r, tcon_vtotal <= v_total(cfg), true,
+            "TCON frame (%u lines) fits the input frame (%u lines), "
+            "%d lines spare", tcon_vtotal, v_total(cfg),
+            (int)v_total(cfg) - (int)tcon_vtotal);
+    int expect_vfp = (int)cfg->vblk - cfg->vfp - cfg->tcon_vsync -
+            cfg->tcon_vbp;
+    check(r, cfg->tcon_vfp == expect_vfp, false,
+            "tcon_vfp (%u) = vblk - vfp - tcon_vsync - tcon_vbp = %d",
+            cfg->tcon_vfp, expect_vfp);
+    if (frame_px % FRAME_PX_ALIGN) {
+        int v = cfg->tcon_vact;
+        while ((v > 0) && ((width * v) % FRAME_PX_ALIGN))
+            v--;
+        check(r, false, true,
+                "%u x %u is not a multiple of %d pixels, %u x %d would be",
+                width, cfg->tcon_vact, FRAME_PX_ALIGN, width, v);
+    }
+    else {
+        check(r, true, true, "%u x %u is a multiple of %d pixels", width,
+                cfg->tcon_vact, FRAME_PX_ALIGN);
+    }
+    check(r, frame_bytes <= FBYTES_MAX, true,
+            "frame state (%u bytes) fits CSR_CFG_FBYTES", frame_bytes);
+    check(r, pclk_mhz <= t->interface->mps, true,
+            "pixel clock %.3f MHz within %s (%.0f MHz)", pclk_mhz,
+            t->interface->desc, t->interface->mps);
+    check(r, pclk_mhz <= t->memory->mps, true,
+            "%.1f MP/s within %s (%.0f MP/s), %.0f%% headroom", pclk_mhz,
+            t->memory->desc, t->memory->mps,
+            (1.0 - pclk_mhz / t->memory->mps) * 100.0);
+    check(r, pclk_mhz <= pipeline_mps(t), !t->dither,
+            "%.1f MP/s within the pipeline rate %s (%.0f MP/s)", pclk_mhz,
+            t->dither ? "with dithering" : "without dithering",
+            pipeline_mps(t));
+}
+
+static void print_report(const config_t *cfg, const target_t *t,
+        const int *rates, int rate_count) {
+    double pclk = cfg->pclk_hz;
+    double refresh = pclk / ((double)h_total(cfg) * v_total(cfg));
+    double epdc_hz = pclk / PIXELS_PER_CLK;
+    uint32_t tcon_htotal = cfg->tcon_hact + cfg->tcon_hfp + cfg->tcon_hsync +
+            cfg->tcon_hbp;
+    uint32_t tcon_vtotal = cfg->tcon_vact + cfg->tcon_vfp + cfg->tcon_vsync +
+            cfg->tcon_vbp;
+    double active_mps = (double)cfg->hact * cfg->vact * refresh / 1e6;
+
+    printf("Panel %u x %u, input %u x %u total, %.3f MHz, %.2f Hz\n",
+            cfg->hact, cfg->vact, h_total(cfg), v_total(cfg), pclk / 1e6,
+            refresh);
+    printf("EPDC clock %.3f MHz, TCON %u x %u, %.2f ms of the %.2f ms frame\n",
+            epdc_hz / 1e6, tcon_htotal, tcon_vtotal,
+            tcon_htotal * tcon_vtotal / epdc_hz * 1e3, 1e3 / refresh);
+    printf("Blanking: %.2f us per line, %.2f ms per frame, %.1f%% of the "
+            "pixel clock\n", cfg->hblk / pclk * 1e6,
+            cfg->vblk * h_total(cfg) / pclk * 1e3,
+            (1.0 - cfg->hact * (double)cfg->vact /
+            ((double)h_total(cfg) * v_total(cfg))) * 100.0);
+    printf("Pixel rate: %.1f MP/s peak, %.1f MP/s averaged over the frame\n",
+            pclk / 1e6, active_mps);
+    printf("DDR state traffic: %.0f MB/s peak, %.0f MB/s average, %s "
+            "allows %.0f MB/s\n", pclk / 1e6 * STATE_BYTES_PER_PX,
+            active_mps * STATE_BYTES_PER_PX, t->memory->desc,
+            t->memory->mps * STATE_BYTES_PER_PX);
+
+    report_t r = { .verbose = true };
+    printf("Checks:\n");
+    check_config(cfg, t, &r);
+
+    const char *limiter;
+    double mps = max_mps(t, &limiter);
+    double px_per_frame = (double)h_total(cfg) * v_total(cfg);
+    printf("Refresh rates with this blanking, up to %.1f Hz (%s):\n",
+            mps * 1e6 / px_per_frame, limiter);
+    printf("  %5s %10s %9s\n", "Hz", "pclk MHz", "headroom");
+    // Feasible rates first, fastest first
+    int order[MAX_RATES];
+    for (int i = 0; i < rate_count; i++)
+        order[i] = i;
+    for (int i = 0; i < rate_count; i++) {
+        for (int j = i + 1; j < rate_count; j++) {
+            bool fi = rates[order[i]] * px_per_frame / 1e6 <= mps;
+            bool fj = rates[order[j]] * px_per_frame / 1e6 <= mps;
+            if ((fj && !fi) || ((fi == fj) && (rates[order[j]] >
+                    rates[order[i]]))) {
+                int tmp = order[i];
+                order[i] = order[j];
+                order[j] = tmp;
+            }
+        }
+    }
+    for (int i = 0; i < rate_count; i++) {
+        int hz = rates[order[i]];
+        double need = hz * px_per_frame / 1e6;
+        if (need <= mps)
+            printf("  %5d %10.3f %8.0f%%\n", hz, need,
+                    (1.0 - need / mps) * 100.0);
+        else
+            printf("  %5d %10.3f %9s over the %s limit\n", hz, need, "-",
+                    limiter);
+    }
+    printf("%d failed, %d warnings\n", r.fails, r.warnings);
+}
+
+static void print_summary(const target_t *t) {
+    printf("%-14s %7s %9s %8s %6s\n", "preset", "Hz", "pclk MHz", "memory",
+            "result");
+    for (int i = 0; i < config_preset_count; i++) {
+        const config_t *cfg = &config_presets[i].config;
+        report_t r = { .verbose = false };
+        check_config(cfg, t, &r);
+        double refresh = (double)cfg->pclk_hz /
+                ((double)h_total(cfg) * v_total(cfg));
+        printf("%-14s %7.2f %9.3f %7.0f%% %s", config_presets[i].name,
+                refresh, cfg->pclk_hz / 1e6,
+                (1.0 - cfg->pclk_hz / 1e6 / t->memory->mps) * 100.0,
+                r.fails ? "FAIL" : r.warnings ? "warn" : "ok");
+        if (r.fails || r.warnings)
+            printf(" (%d failed, %d warnings)", r.fails, r.warnings);
+        printf("\n");
+    }
+}
+
+static int parse_rates(const char *s, int *rates) {
+    int n = 0;
+    while (*s && (n < MAX_RATES)) {
+        char *end;
+        long v = strtol(s, &end, 10);
+        if ((end == s) || (v <= 0))
+            return -1;
+        rates[n++] = v;
+        s = (*end == ',') ? end + 1 : end;
+    }
+    return n;
+}
+
+static void usage(const char *name) {
+    fprintf(stderr, "Usage: %s [options] [key=value ...]\n"
+            "  -p preset    Start from a preset (default %s)\n"
+            "  -f file      Load a setcfg script or setcfg get output\n"
+            "  -m memory    Memory profile (default ddr800x16)\n"
+            "  -i input     Video input (default dvi)\n"
+            "  -n           Check without dithering\n"
+            "  -r list      Refresh rates to rank (default 30,40,45,50,60,72,75,85)\n"
+            "  -a           Check every preset\n"
+            "Presets:", name, CONFIG_DEFAULT_PRESET);
+    for (int i = 0; i < config_preset_count; i++)
+        fprintf(stderr, " %s", config_presets[i].name);
+    fprintf(stderr, "\nMemory:");
+    for (size_t i = 0; i < sizeof(memories) / sizeof(memories[0]); i++)
+        fprintf(stderr, " %s", memories[i].name);
+    fprintf(stderr, "\nInput:");
+    for (size_t i = 0; i < sizeof(interfaces) / sizeof(interfaces[0]); i++)
+        fprintf(stderr, " %s", interfaces[i].name);
+    fprintf(stderr, "\n");
+}
+
+int main(int argc, char *argv[]) {
+    const char *preset_name = CONFIG_DEFAULT_PRESET;
+    const char *file = NULL;
+    bool all = false;
+    int rates[MAX_RATES] = { 30, 40, 45, 50, 60, 72, 75, 85 };
+    int rate_count = 8;
+    target_t t = {
+        .memory = find_limit(memories, sizeof(memories) / sizeof(memories[0]),
+                "ddr800x16"),
+        .interface = find_limit(interfaces,
+                sizeof(interfaces) / sizeof(interfaces[0]), "dvi"),
+        .dither = true
+    };
+    int opt;
+
+    while ((opt = getopt(argc, argv, "p:f:m:i:nr:a")) != -1) {
+        switch (opt) {
+        case 'p': preset_name = optarg; break;
+        case 'f': file = optarg; break;
+        case 'm':
+            t.memory = find_limit(memories,
+                    sizeof(memories) / sizeof(memories[0]), optarg);
+            break;
+        case 'i':
+            t.interface = find_limit(interfaces,
+                    sizeof(interfaces) / sizeof(interfaces[0]), optarg);
+            break;
+        case 'n': t.dither = false; break;
+        case 'r': rate_count = parse_rates(optarg, rates); break;
+        case 'a': all = true; break;
+        default:
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    const config_preset_t *preset = config_find_preset(preset_name);
+    if (!preset || !t.memory || !t.interface || (rate_count <= 0)) {
+        usage(argv[0]);
+        return 1;
+    }
+    if (all) {
+        print_summary(&t);
+        return 0;
+    }
+
+    config_t cfg = preset->config;
+    if (file && !load_file(&cfg, file))
+        return 1;
+    for (int i = optind; i < argc; i++) {
+        char *eq = strchr(argv[i], '=');
+        if (!eq) {
+            usage(argv[0]);
+            return 1;
+        }
+        *eq = '\0';
+        if (!set_field(&cfg, argv[i], eq + 1))
+            return 1;
+    }
+    print_report(&cfg, &t, rates, rate_count);
+    report_t r = { .verbose = false };
+    check_config(&cfg, &t, &r);
+    return r.fails ? 2 : 0;
+}
@@ -15,6 +15,14 @@ USBRET_GENERALFAIL =    0x00
 USBRET_CHKSUMFAIL =     0x01
 USBRET_SUCCESS =        0x55
 
+# Protocol v2, see usbapp.h
+USBV2_MAGIC =           0x82
+USBV2_TYPE_ACK =        0x01
+USBV2_FLAG_ACK =        0x01
+USBV2_FLAG_RESET =      0x02
+USBV2_MAX_CMDS =        5
+USBV2_WINDOW =          32
+
 def crc16(data: bytes):
     '''
     CRC-16 (CCITT) implemented with a precomputed lookup table
@@ -73,6 +81,102 @@ def send_cmd():
     str_in = h.read(16)
     print("Received from HID Device:", str_in, '\n')
 
+class GliderV2:
+    '''
+    Sends region commands with protocol v2: up to 5 commands per report, and
+    no more commands in flight than the window and the device's queue space
+    allow. Commands stay queued until they are acked, so they can be sent
+    again when the device asks for a resend or an ack goes missing.
+    '''
+    ACK_TIMEOUT_MS = 100
+
+    def __init__(self, h):
+        self.h = h
+        self.acked = 0          # Sequence number of queue[0]
+        self.queue = []         # Commands not acked yet, oldest first
+        self.sent = 0           # Number of them sent since the last resend
+        self.space = USBV2_WINDOW
+        self.first = True
+
+    def _send_report(self, seq, cmds, ack):
+        flags = USBV2_FLAG_ACK if ack else 0
+        if self.first:
+            flags |= USBV2_FLAG_RESET
+            self.first = False
+        report = struct.pack('<BBHB', USBV2_MAGIC, len(cmds), seq, flags)
+        for (cmd, mode, x0, y0, x1, y1) in cmds:
+            report += struct.pack('<BBHHHH', cmd, mode, x0, y0, x1, y1)
+        report += bytearray(62 - len(report))
+        report += struct.pack('<H', crc16(report))
+        self.h.write(b'\0' + report)
+
+    def _pump(self, partial):
+        # Stop at the device's queue space, it acks again once there is room
+        limit = min(USBV2_WINDOW, self.space, len(self.queue))
+        while self.sent < limit:
+            count = min(USBV2_MAX_CMDS, limit - self.sent)
+            if (count < USBV2_MAX_CMDS) and not partial and (limit == len(self.queue)):
+                break
+            cmds = self.queue[self.sent:self.sent + count]
+            seq = (self.acked + self.sent) & 0xffff
+            self.sent += count
+            self._send_report(seq, cmds, self.sent == limit)
+
+    def _read_ack(self):
+        ack = self.h.read(64, self.ACK_TIMEOUT_MS)
+        if not ack:
+            # Ack lost, go back to the oldest command, probing with one
+            # if the last ack said the queue was full
+            self.sent = 0
+            self.space = max(self.space, 1)
+            return
+        if (ack[0] != USBV2_MAGIC) or (ack[1] != USBV2_TYPE_ACK):
+            raise Exception("Unexpected report")
+        next_seq, status, failed, first_failed, space, resend = \
+                struct.unpack('<HBBHBB', bytes(ack[2:10]))
+        done = (next_seq - self.acked) & 0xffff
+        if done > len(self.queue):
+            raise Exception(f"Ack for {next_seq} was never sent")
+        self.queue = self.queue[done:]
+        self.sent = max(self.sent - done, 0)
+        self.acked = next_seq
+        self.space = space
+        if resend:
+            # The device dropped everything after next_seq
+            self.sent = 0
+        if status != USBRET_SUCCESS:
+            raise Exception(f"{failed} commands failed, first one {first_failed}")
+
+    def _submit(self, cmd):
+        self.queue.append(cmd)
+        self._pump(False)
+        # Only stop for an ack when a full window is waiting
+        while len(self.queue) > USBV2_WINDOW:
+            self._read_ack()
+            self._pump(False)
+
+    def redraw(self, x0, y0, x1, y1):
+        self._submit((USBCMD_REDRAW, 0, x0, y0, x1, y1))
+
+    def setmode(self, x0, y0, x1, y1, mode):
+        self._submit((USBCMD_SETMODE, mode, x0, y0, x1, y1))
+
+    def flush(self, wait = True):
+        self._pump(True)
+        while wait and self.queue:
+            self._read_ack()
+            self._pump(True)
+
+def send_batch():
+    h = hid.device()
+    h.open(0x0483, 0x5750)
+    glider = GliderV2(h)
+    # Per window update modes, all sent before waiting for a single ack
+    for i in range(12):
+        glider.setmode(i * 100, 0, i * 100 + 100, 600, 2 + (i % 4))
+    glider.flush()
+    print("All commands acknowledged")
+
 def main():
     send_cmd()
 
@@ -0,0 +1,348 @@
+//
+// Waveform table format converter
+// Copyright 2025 Wenting Zhang
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+//
+// Converts the tables of an .iwf waveform (as written by wbf_wvfm_dump or
+// mxc_wvfm_dump) between CSV and the binary .lut container. CSV is the format
+// to edit or diff waveforms in, .lut is much faster for the assemblers to
+// load. Converted tables are written next to the originals, which are kept,
+// and the descriptor is updated in place to point to them.
+//
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <stdbool.h>
+#include <libgen.h>
+#include <unistd.h>
+#include <time.h>
+#include "ini.h"
+#include "wbf.h"
+
+#define MAX_MODES       (32)
+#define MAX_TEMPS       (32)
+#define MAX_TABLES      (MAX_MODES * MAX_TEMPS)
+
+// Unspecified entries, same as mxc_wvfm_asm. The Caster drives 3 as GND.
+#define FILL_VALUE      (3)
+
+typedef struct {
+    int version;
+    char *prefix;
+    int bpp;
+    int modes;
+    int temps;
+    int tables;
+    bool binary;
+    // Version 1 has a table for every mode and temp, version 2 shares them
+    int frame_counts[MAX_TABLES];
+    char *table_files[MAX_TABLES];
+} iwf_t;
+
+// Number after a prefix and before the given suffix, such as T3FC or TB12FILE,
+// -1 if the name doesn't match
+static int parse_index(const char *name, const char *prefix,
+        const char *suffix) {
+    size_t plen = strlen(prefix);
+    size_t slen = strlen(suffix);
+    size_t len = strlen(name);
+    if ((len <= plen + slen) || (strncmp(name, prefix, plen) != 0) ||
+            (strcmp(name + len - slen, suffix) != 0))
+        return -1;
+    int id = 0;
+    for (size_t i = plen; i < len - slen; i++) {
+        if ((name[i] < '0') || (name[i] > '9'))
+            return -1;
+        id = id * 10 + (name[i] - '0');
+    }
+    return id;
+}
+
+static int iwf_handler(void *user, const char *section, const char *name,
+        const char *value) {
+    iwf_t *iwf = user;
+    int id;
+
+    if (strcmp(section, "WAVEFORM") == 0) {
+        if (strcmp(name, "VERSION") == 0)
+            iwf->version = atoi(value);
+        else if (strcmp(name, "PREFIX") == 0)
+            iwf->prefix = strdup(value);
+        else if (strcmp(name, "BPP") == 0)
+            iwf->bpp = atoi(value);
+        else if (strcmp(name, "MODES") == 0)
+            iwf->modes = atoi(value);
+        else if (strcmp(name, "TEMPS") == 0)
+            iwf->temps = atoi(value);
+        else if (strcmp(name, "TABLES") == 0)
+            iwf->tables = atoi(value);
+        else if (strcmp(name, "FORMAT") == 0) {
+            if (strcasecmp(value, "LUT") == 0)
+                iwf->binary = true;
+            else if (strcasecmp(value, "CSV") != 0)
+                return 0;
+        }
+        else if ((id = parse_index(name, "TB", "FC")) >= 0) {
+            if (id >= MAX_TABLES)
+                return 0;
+            iwf->frame_counts[id] = atoi(value);
+        }
+        else if ((id = parse_index(name, "TB", "FILE")) >= 0) {
+            if (id >= MAX_TABLES)
+                return 0;
+            iwf->table_files[id] = strdup(value);
+        }
+    }
+    else if (strncmp(section, "MODE", 4) == 0) {
+        int mode = atoi(section + 4);
+        if ((mode < 0) || (mode >= MAX_MODES))
+            return 0;
+        if ((id = parse_index(name, "T", "FC")) >= 0) {
+            if (id >= MAX_TEMPS)
+                return 0;
+            iwf->frame_counts[mode * MAX_TEMPS + id] = atoi(value);
+        }
+    }
+    return 1;
+}
+
+// Table file without the extension, relative to the descriptor directory
+static void table_base(const iwf_t *iwf, const char *dir, int table,
+        char *fn) {
+    if (iwf->version == 1)
+        sprintf(fn, "%s/%s_M%d_T%d", dir, iwf->prefix, table / MAX_TEMPS,
+                table % MAX_TEMPS);
+    else if (iwf->table_files[table]) {
+        sprintf(fn, "%s/%s", dir, iwf->table_files[table]);
+        char *ext = strrchr(fn, '.');
+        if (ext && (strchr(ext, '/') == NULL))
+            *ext = '\0';
+    }
+    else
+        sprintf(fn, "%s/%s_TB%d", dir, iwf->prefix, table);
+}
+
+static int convert_table(const char *src, const char *dst, bool binary,
+        int states, int frames) {
+    wbf_lut_t lut;
+    int res = wbf_lut_load_table(src, &lut, states, frames, FILL_VALUE);
+    if (res == WBF_OK) {
+        if ((lut.states != states) || (lut.frames != frames)) {
+            fprintf(stderr, "%s doesn't match the descriptor\n", src);
+            wbf_lut_free(&lut);
+            return -1;
+        }
+        res = binary ? wbf_lut_save(dst, &lut) : wbf_lut_save_csv(dst, &lut);
+        wbf_lut_free(&lut);
+    }
+    if (res != WBF_OK) {
+        fprintf(stderr, "Failed to convert %s: %s\n", src, wbf_strerror(res));
+        return -1;
+    }
+    return 0;
+}
+
+static const char *key_end(const char *line, const char *end) {
+    const char *p = line;
+    while ((p < end) && (*p != '=') && (*p != ':') && (*p != ' ') &&
+            (*p != '\t'))
+        p++;
+    return p;
+}
+
+// Copies the key at the start of the line, empty if it doesn't fit
+static void get_key(const char *line, const char *end, char *key,
+        size_t size) {
+    size_t len = key_end(line, end) - line;
+    if (len >= size)
+        len = 0;
+    memcpy(key, line, len);
+    key[len] = '\0';
+}
+
+// Rewrites FORMAT and the TBxFILE extensions, everything else is copied as is
+static int update_descriptor(const char *path, bool binary) {
+    wbf_map_t map;
+    int res = wbf_map_file(&map, path);
+    if (res != WBF_OK)
+        return -1;
+    char *tmp = malloc(strlen(path) + 8);
+    sprintf(tmp, "%s.tmp", path);
+    FILE *fp = fopen(tmp, "w");
+    if (!fp) {
+        wbf_unmap(&map);
+        free(tmp);
+        return -1;
+    }
+
+    const char *p = (const char *)map.data;
+    const char *end = p + map.size;
+    bool in_waveform = false;
+    bool format_done = false;
+    while (p < end) {
+        const char *eol = memchr(p, '\n', end - p);
+        eol = eol ? eol + 1 : end;
+        const char *line = p;
+        while ((line < eol) && ((*line == ' ') || (*line == '\t')))
+            line++;
+        bool blank = (line == eol) || (*line == '\n') || (*line == '\r');
+        char key[32];
+        get_key(line, eol, key, sizeof(key));
+        if (in_waveform && !format_done && (blank || (*line == '['))) {
+            // New key goes at the end of the [WAVEFORM] header
+            if (binary)
+                fprintf(fp, "FORMAT = LUT\n");
+            format_done = true;
+        }
+        if (*line == '[') {
+            in_waveform = (strncmp(line, "[WAVEFORM]", 10) == 0);
+        }
+        else if (in_waveform && (strcmp(key, "FORMAT") == 0)) {
+            if (binary)
+                fprintf(fp, "FORMAT = LUT\n");
+            format_done = true;
+            p = eol;
+            continue;
+        }
+        else if (in_waveform && (parse_index(key, "TB", "FILE") >= 0)) {
+            // Only the extension changes
+            const char *val_end = eol;
+            while ((val_end > line) && ((val_end[-1] == '\n') ||
+                    (val_end[-1] == '\r') || (val_end[-1] == ' ')))
+                val_end--;
+            const char *ext = val_end;
+            while ((ext > line) && (ext[-1] != '.') && (ext[-1] != '/'))
+                ext--;
+            if ((ext > line) && (ext[-1] == '.'))
+                val_end = ext - 1;
+            fprintf(fp, "%.*s.%s\n", (int)(val_end - p), p,
+                    binary ? "lut" : "csv");
+            p = eol;
+            continue;
+        }
+        fwrite(p, eol - p, 1, fp);
+        p = eol;
+    }
+    if (in_waveform && !format_done && binary)
+        fprintf(fp, "FORMAT = LUT\n");
+    wbf_unmap(&map);
+
+    bool ok = fclose(fp) == 0;
+    if (ok && (rename(tmp, path) != 0))
+        ok = false;
+    if (!ok)
+        unlink(tmp);
+    free(tmp);
+    return ok ? 0 : -1;
+}
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+static void print_usage(const char *name) {
+    fprintf(stderr, "Usage: %s [-c] input.iwf\n", name);
+    fprintf(stderr, "  Converts the tables to .lut and sets FORMAT = LUT\n");
+    fprintf(stderr, "  -c            Convert back to .csv instead\n");
+}
+
+int main(int argc, char *argv[]) {
+    static iwf_t iwf;
+    bool binary = true;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "c")) != -1) {
+        switch (opt) {
+        case 'c': binary = false; break;
+        default: print_usage(argv[0]); return 1;
+        }
+    }
+    if (optind != argc - 1) {
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    char *input_fn = argv[optind];
+    iwf.bpp = 4;
+    if (ini_parse(input_fn, iwf_handler, &iwf) != 0) {
+        fprintf(stderr, "Failed to load waveform descriptor %s\n", input_fn);
+        return 1;
+    }
+    if (((iwf.version != 1) && (iwf.version != 2)) || !iwf.prefix ||
+            (iwf.modes <= 0) || (iwf.modes > MAX_MODES) ||
+            (iwf.temps <= 0) || (iwf.temps > MAX_TEMPS) ||
+            (iwf.tables < 0) || (iwf.tables > MAX_TABLES)) {
+        fprintf(stderr, "%s is not a valid waveform descriptor\n", input_fn);
+        return 1;
+    }
+    if (iwf.binary == binary) {
+        printf("Tables are already in %s format\n", binary ? "LUT" : "CSV");
+        return 0;
+    }
+    int states = ((iwf.version == 2) && (iwf.bpp == 5)) ? 32 : 16;
+
+    char *dir = dirname(strdup(input_fn));
+    size_t max_file = 0;
+    for (int i = 0; i < MAX_TABLES; i++)
+        if (iwf.table_files[i] && (strlen(iwf.table_files[i]) > max_file))
+            max_file = strlen(iwf.table_files[i]);
+    size_t fn_len = strlen(dir) + strlen(iwf.prefix) + max_file + 32;
+    char *base = malloc(fn_len);
+    char *src = malloc(fn_len);
+    char *dst = malloc(fn_len);
+
+    uint64_t start = now_ns();
+    int count = 0;
+    for (int i = 0; i < MAX_TABLES; i++) {
+        if (iwf.version == 1) {
+            if ((i / MAX_TEMPS >= iwf.modes) || (i % MAX_TEMPS >= iwf.temps))
+                continue;
+        }
+        else if (i >= iwf.tables) {
+            break;
+        }
+        if (iwf.frame_counts[i] <= 0) {
+            fprintf(stderr, "No frame count for table %d\n", i);
+            return 1;
+        }
+        table_base(&iwf, dir, i, base);
+        sprintf(src, "%s.%s", base, iwf.binary ? "lut" : "csv");
+        sprintf(dst, "%s.%s", base, binary ? "lut" : "csv");
+        if (convert_table(src, dst, binary, states, iwf.frame_counts[i]) != 0)
+            return 1;
+        count++;
+    }
+    if (update_descriptor(input_fn, binary) != 0) {
+        fprintf(stderr, "Failed to update %s\n", input_fn);
+        return 1;
+    }
+    printf("%d tables converted to %s in %.1f ms\n", count,
+            binary ? "LUT" : "CSV", (now_ns() - start) / 1e6);
+
+    free(base);
+    free(src);
+    free(dst);
+    return 0;
+}
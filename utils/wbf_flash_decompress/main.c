@@ -27,27 +27,14 @@
 #include <assert.h>
 #include <inttypes.h>
 #include <ctype.h>
+#include "wbf.h"
 
-#define MAX_DECOMP_SIZE (0x100000)
-
-static uint32_t read_uint16_be(uint8_t *ptr) {
-    uint32_t b0 = (uint32_t)(*ptr++) << 8;
-    uint32_t b1 = (uint32_t)(*ptr++);
-    return b0 | b1;
-}
-
-static uint32_t read_uint16_le(uint8_t *ptr) {
-    uint32_t b0 = (uint32_t)(*ptr++);
-    uint32_t b1 = (uint32_t)(*ptr++) << 8;
-    return b0 | b1;
-}
-
-static uint32_t read_uint32_be(uint8_t *ptr) {
-    uint32_t b0 = (uint32_t)(*ptr++) << 24;
-    uint32_t b1 = (uint32_t)(*ptr++) << 16;
-    uint32_t b2 = (uint32_t)(*ptr++) << 8;
-    uint32_t b3 = (uint32_t)(*ptr++);
-    return b0 | b1 | b2 | b3;
+static void print_token(void *ctx, uint32_t pos, uint32_t offset, uint8_t len,
+        uint8_t byte) {
+    printf("Ptr %d, Offset %d, Len %d, Byte 0x%02x\n", pos, offset, len, byte);
+    if (len != 0) {
+        printf("Src: %d\n", pos - offset);
+    }
 }
 
 int main(int argc, char **argv) {
@@ -64,80 +51,63 @@ int main(int argc, char **argv) {
     char *wbf = argv[2];
 
     FILE * fp;
-    size_t file_size;
-    char * file_buffer;
-    size_t result;
-
-    fp = fopen(bin, "rb");
-    assert(fp);
-
-    // obtain file size:
-    fseek(fp, 0, SEEK_END);
-    file_size = ftell(fp);
-    fseek(fp, 0, SEEK_SET);
-
-    // allocate memory to contain the whole file:
-    file_buffer = (char*)malloc(sizeof(char) * file_size);
-    assert(file_buffer);
-
-    // copy the file into the buffer:
-    assert(fread(file_buffer, file_size, 1, fp) == 1);
-
-    fclose(fp);
+    wbf_map_t map;
+    int res = wbf_map_file(&map, bin);
+    if (res != WBF_OK) {
+        fprintf(stderr, "Failed to open %s: %s\n", bin, wbf_strerror(res));
+        return 1;
+    }
 
-    printf("File size: %zu bytes\n", file_size);
+    printf("File size: %zu bytes\n", map.size);
 
-    uint8_t *ptr = (uint8_t *)file_buffer;
-    uint32_t compressed_len = read_uint32_be(ptr);
-    ptr += 4;
-    uint32_t header_version = read_uint32_be(ptr);
+    wbf_flash_header_t hdr;
+    if (wbf_flash_header(map.data, map.size, &hdr) != WBF_OK) {
+        printf("Error: file size smaller than expected.\n");
+        return -1;
+    }
 
-    printf("Compressed length: %d bytes\n", compressed_len);
+    printf("Compressed length: %d bytes\n", hdr.compressed_len);
 
-    if ((compressed_len + 16) > file_size) {
+    if (((uint64_t)hdr.compressed_len + 16) > map.size) {
         printf("Error: file size smaller than expected.\n");
         return -1;
     }
-    else if ((compressed_len + 16) < file_size) {
+    else if ((hdr.compressed_len + 16) < map.size) {
         printf("Warning: file size larger than expected.\n");
     }
 
-    printf("Header version: %d\n", header_version);
+    printf("Header version: %d\n", hdr.version);
 
-    if (header_version != 1) {
+    if (hdr.version != 1) {
         printf("Unsupported file version\n");
         return -1;
     }
 
-    // Start decompress
-    ptr = (uint8_t *)file_buffer + 16; // skip header
-    static uint8_t decomp_buffer[MAX_DECOMP_SIZE];
-    uint32_t wrptr = 0;
-    uint8_t *ptr_end = ptr + compressed_len;
-    while (ptr < ptr_end) { 
-        uint32_t wrptr_snapshot = wrptr;
-        uint32_t offset = (uint32_t)read_uint16_le(ptr);
-        ptr += 2;
-        uint8_t len = *ptr++;
-        uint8_t byte = *ptr++;
-        printf("Ptr %d, Offset %d, Len %d, Byte 0x%02x\n", wrptr_snapshot, offset, len, byte);
-        if (len != 0) {
-            printf("Src: %d\n", wrptr_snapshot - offset);
-        }
-        for (int i = 0; i < len; i++) {
-            // len could be zero, in this case the loop doesn't execute
-            uint8_t rd = decomp_buffer[wrptr_snapshot - offset + i];
-            decomp_buffer[wrptr++] = rd;
-        }
-        decomp_buffer[wrptr++] = byte;
+    // Size the output first, then decompress
+    size_t size;
+    res = wbf_flash_size(map.data, map.size, &size);
+    uint8_t *decomp_buffer = NULL;
+    if (res == WBF_OK) {
+        decomp_buffer = malloc(size ? size : 1);
+        assert(decomp_buffer);
+        res = wbf_flash_decompress(map.data, map.size, decomp_buffer, size,
+                &size, print_token, NULL);
+    }
+    if (res != WBF_OK) {
+        printf("Error: %s\n", wbf_strerror(res));
+        return -1;
     }
 
-    printf("Decompressed size: %d bytes\n", wrptr);
+    printf("Decompressed size: %zu bytes\n", size);
 
     fp = fopen(wbf, "wb");
-    fwrite(decomp_buffer, wrptr, 1, fp);
+    assert(fp);
+    fwrite(decomp_buffer, size, 1, fp);
     fclose(fp);
     printf("Done\n");
 
+    free(decomp_buffer);
+    wbf_unmap(&map);
+
     return 0;
-}
\ No newline at end of file
+}
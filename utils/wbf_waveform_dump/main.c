@@ -32,281 +32,52 @@
 #include <assert.h>
 #include <inttypes.h>
 #include <ctype.h>
-
-struct waveform_data_header {
-  uint32_t checksum:32; // 0
-  uint32_t filesize:32; // 4
-  uint32_t serial:32; // 8 serial number
-  uint32_t run_type:8; // 12
-  uint32_t fpl_platform:8; // 13
-  uint32_t fpl_lot:16; // 14
-  uint32_t mode_version_or_adhesive_run_num:8; // 16
-  uint32_t waveform_version:8; // 17
-  uint32_t waveform_subversion:8; // 18
-  uint32_t waveform_type:8; // 19
-  uint32_t fpl_size:8; // 20 (aka panel_size)
-  uint32_t mfg_code:8; // 21 (aka amepd_part_number)
-  uint32_t waveform_tuning_bias_or_rev:8; // 22
-  uint32_t fpl_rate:8; // 23 (aka frame_rate)
-  uint32_t unknown0:8;
-  uint32_t vcom_shifted:8;
-  uint32_t unknown1:16;
-  uint32_t xwia:24; // address of extra waveform information
-  uint32_t cs1:8; // checksum 1
-  uint32_t wmta:24;
-  uint32_t fvsn:8;
-  uint32_t luts:8;
-  uint32_t mc:8; // mode count (length of mode table - 1)
-  uint32_t trc:8; // temperature range count (length of temperature table - 1)
-  uint32_t advanced_wfm_flags:8;
-  uint32_t eb:8;
-  uint32_t sb:8;
-  uint32_t reserved0_1:8;
-  uint32_t reserved0_2:8;
-  uint32_t reserved0_3:8;
-  uint32_t reserved0_4:8;
-  uint32_t reserved0_5:8;
-  uint32_t cs2:8; // checksum 2
-}__attribute__((packed));
-
-#define HEADER_SIZE sizeof(struct waveform_data_header)
-
-#define MODE_MAX 10
-
-// Mode version to mode string
-struct mode_name_lut_t {
-    uint8_t versions[2];
-    char *mode_strings[MODE_MAX];
-};
-
-// Partially derived from linux kernel drm_epd_helper.c
-// All GL series (GL GLR GLD) are marked as GL as the underlying wavetable seems to be identical
-// Thus it's impossible to identify the correct ordering
-// -R/ -D ghosting reduction is outside of the scope of this tool
-const struct mode_name_lut_t mode_name_lut[] = {
-    {
-        // Example: ED050SC3
-        .versions = {0x01},
-        .mode_strings = {"INIT", "DU", "GL8", "GC8"}
-    },
-    {
-        // Example: ED097TC1
-        .versions = {0x03},
-        .mode_strings = {"INIT", "DU", "GL16", "GL16", "A2"}
-    },
-    {
-        // Example: ET073TC1
-        .versions = {0x09},
-        .mode_strings = {"INIT", "DU", "GC16", "A2"}
-    },
-    {
-        // Untested
-        .versions = {0x12},
-        .mode_strings = {"INIT", "DU", "NULL", "GC16", "A2", "GL16", "GL16", "DU4"}
-    },
-    {
-        // Example: ES133UT1
-        .versions = {0x15},
-        .mode_strings = {"INIT", "DU", "GC16", "GL16", "A2", "DU4", "GC4"}
-    },
-    {
-        // Untested
-        .versions = {0x16},
-        .mode_strings = {"INIT", "DU", "GC16", "GL16", "GL16", "GC16", "A2"}
-    },
-    {
-        // Example: ES108FC1
-        .versions = {0x18, 0x20},
-        .mode_strings = {"INIT", "DU", "GC16", "GL16", "GL16", "GL16", "A2"}
-    },
-    {
-        // Example: ES103TC1
-        .versions = {0x19, 0x43},
-        .mode_strings = {"INIT", "DU", "GC16", "GL16", "GL16", "GL16", "A2", "DU4"}
-    },
-    {
-        // Untested
-        .versions = {0x23},
-        .mode_strings = {"INIT", "DU", "GC16", "GL16", "A2", "DU4"}
-    },
-    {
-        // Untested
-        .versions = {0x54},
-        .mode_strings = {"INIT", "DU", "GC16", "GL16", "GL16", "A2"}
-    },
-    {
-        // Example: ES120MC1
-        .versions = {0x48},
-        .mode_strings = {"INIT", "DU", "GC16", "GL16", "GL16", "NULL", "A2"}
-    }
-};
-#define MODE_NAME_LUTS  (sizeof(mode_name_lut) / sizeof(*mode_name_lut))
-
-#define MAX_TABLE_LENGTH    (1024*1024)
-
-static uint32_t read_pointer(uint8_t *ptr) {
-    uint32_t addr = ((uint32_t)ptr[2] << 16) | ((uint32_t)ptr[1] << 8) | ((uint32_t)ptr[0]);
-    uint8_t checksum = ptr[0] + ptr[1] + ptr[2];
-    if (checksum != ptr[3]) {
-        printf("Pointer checksum mismatch\n");
+#include <libgen.h>
+#include <unistd.h>
+#include "wbf.h"
+
+// A distinct table, the first offset it was found at
+typedef struct {
+    wbf_table_t view;
+    wbf_rle_info_t info;
+    uint8_t *decoded;
+    uint64_t hash;
+    int frames;
+    char name[WBF_STORE_NAME_MAX];
+} table_t;
+
+// Open addressing, key to table ID. Offsets are looked up first, so a table
+// shared by pointer is only decoded once, then the content hash catches the
+// same table stored again at another offset.
+typedef struct {
+    uint64_t key;
+    int id;
+} slot_t;
+
+static int slot_find(slot_t *slots, int size, uint64_t key, int *pos) {
+    int i = key & (size - 1);
+    while (slots[i].id >= 0) {
+        if (slots[i].key == key)
+            break;
+        i = (i + 1) & (size - 1);
     }
-    return addr;
-}
-
-static uint8_t read_uint4(uint8_t* src, size_t addr) {
-    uint8_t val = src[addr >> 1];
-    if (addr & 1)
-        val = (val >> 4) & 0xf;
-    else
-        val = val & 0xf;
-    return val;
-}
-
-
-void compute_crc_table(unsigned int* crc_table) {
-   unsigned c;
-   int n, k;
-   for (n = 0; n < 256; n++) {
-      c = (unsigned) n;
-      for (k = 0; k < 8; k++) {
-         if (c & 1) {
-            c = 0xedb88320L ^ (c >> 1);
-         }
-         else {
-            c = c >> 1;
-         }
-      }
-      crc_table[n] = c;
-   }
-}
-
-unsigned int update_crc(unsigned int* crc_table, unsigned crc,
-                           unsigned char *buf, int len) {
-
-  char b;
-  unsigned c = crc ^ 0xffffffff;
-  int i;
-  
-  for(i=0; i < len; i++) {
-    if(!buf) {
-      b = 0;
-    } else {
-      b = buf[i];
-    }
-    c = crc_table[(c ^ b) & 0xff] ^ (c >> 8);
-  }
-  
-  return c ^ 0xffffffff;
-}
-
-unsigned crc32(unsigned char *buf, int len) {
-  static unsigned int crc_table[256];
-  
-  compute_crc_table(crc_table);
-  
-  return update_crc(crc_table, 0, buf, len);
+    *pos = i;
+    return slots[i].id;
 }
 
-void dump_phases(FILE* fp, uint8_t* buffer, int bpp, int phases, int phase_per_byte, bool uni) {
-    int states;
-    int i, j, k, x, y;
-
-    states = (bpp == 4) ? 16 : 32;
-    uint8_t luts[phases][states][states];
-    uint8_t *ptr = buffer;
-
-    if (!uni) {
-        // 2D LUT
-        for (i = 0; i < phases; i ++) {
-            for (x = 0; x < states; x++) { // dst
-                for (y = 0; y < states; y+=phase_per_byte) { // src
-                    uint8_t val = *ptr++;
-                    if (phase_per_byte == 4) {
-                        luts[i][y+0][x] = (val >> 0) & 0x3;
-                        luts[i][y+1][x] = (val >> 2) & 0x3;
-                        luts[i][y+2][x] = (val >> 4) & 0x3;
-                        luts[i][y+3][x] = (val >> 6) & 0x3;
-                    }
-                    else if (phase_per_byte == 2) {
-                        luts[i][y+0][x] = (val >> 0) & 0xf;
-                        luts[i][y+1][x] = (val >> 4) & 0xf;
-                    }
-                }
-            }
-        }
-
-        for (i = 0; i < states; i++) {
-            for (j = 0; j < states; j++) {
-                fprintf(fp, "%d,%d,", i, j);
-                for (k = 0; k < phases; k++) {
-                    fprintf(fp, "%d,", luts[k][i][j]);
-                }
-                fprintf(fp, "\n");
-            }
-        }
-    }
-    else {
-        // 1D LUT
-        for (i = 0; i < phases; i ++) {
-            for (x = 0; x < states; x+=phase_per_byte) { // dst
-                uint8_t val = *ptr++;
-                luts[i][0][x+0] = (val >> 0) & 0xf;
-                luts[i][0][x+1] = (val >> 4) & 0xf;
-            }
-        }
-
-        for (i = 0; i < states; i++) {
-            fprintf(fp, "%d,", i);
-            for (k = 0; k < phases; k++) {
-                fprintf(fp, "%d,", luts[k][0][i]);
-            }
-            fprintf(fp, "\n");
-        }
-    }
-}
-
-int main(int argc, char **argv) {
-    fprintf(stderr, "Eink wbf waveform dumper\n");
-
-    if (argc != 3) {
-        fprintf(stderr, "Usage: wbf_wvfm_dump input_file output_prefix\n");
-        fprintf(stderr, "input_file: MXC EPDC firmware file, in .wbf format\n");
-        fprintf(stderr, "output_prefix: Prefix for output file name, without extension\n");
-        fprintf(stderr, "Example: wbf_wvfm_dump E060SCM.wbf e060scm\n");
+static int dump_file(const char *fw, const char *prefix, wbf_store_t *store,
+        bool binary) {
+    FILE * fp;
+    wbf_t wbf;
+    int res = wbf_open(&wbf, fw);
+    if (res != WBF_OK) {
+        fprintf(stderr, "Failed to open %s: %s\n", fw, wbf_strerror(res));
         return 1;
     }
 
-    char *fw = argv[1];
-    char *prefix = argv[2];
-
-    FILE * fp;
-    size_t file_size;
-    char * file_buffer;
-    size_t result;
-
-    fp = fopen(fw, "rb");
-    assert(fp);
-
-    // obtain file size:
-    fseek(fp, 0, SEEK_END);
-    file_size = ftell(fp);
-    fseek(fp, 0, SEEK_SET);
-
-    // allocate memory to contain the whole file:
-    file_buffer = (char*)malloc(sizeof(char) * file_size);
-    assert(file_buffer);
-
-    // copy the file into the buffer:
-    assert(fread(file_buffer, file_size, 1, fp) == 1);
+    const wbf_header_t *header = wbf.header;
 
-    fclose(fp);
-
-    /* the whole file is now loaded in the memory buffer. */
-
-    struct waveform_data_header *header;
-    header = (struct waveform_data_header *)file_buffer;
-
-    printf("File size: %zu bytes.\n", file_size);
+    printf("File size: %zu bytes.\n", wbf.map.size);
 
     printf("Reported size: %d bytes.\n", header->filesize);
     printf("Serial number: %d\n", header->serial);
@@ -324,32 +95,20 @@ int main(int argc, char **argv) {
     
     printf("Waveform type: %d\n", header->waveform_type);
 
-    printf("Number of modes: %d\n", header->mc + 1);
-    printf("Number of temperature ranges: %d\n", header->trc + 1);
+    printf("Number of modes: %d\n", wbf.modes);
+    printf("Number of temperature ranges: %d\n", wbf.temps);
 
-    int bpp = ((header->luts & 0xC) == 0x4) ? 5: (header->luts == 0x1d) ? 5 : 4;
+    int bpp = wbf.bpp;
     printf("BPP: %d (LUTS = 0x%02x)\n", bpp, header->luts);
-    bool mv = false;
-    bool uni = false;
     if (header->luts == 0x15) {
         printf("Looks like you've supplied a waveform for newer multi-voltage screens\n");
         printf("Expect the checksum for the header to fail.\n");
-        bpp = 5;
-        mv = true;
-    }
-    else if (header->luts == 0x1d) {
-        mv = true;
-        uni = true;
     }
 
     // Compare checksum
-    static unsigned int crc_table[256];
-    compute_crc_table(crc_table);
-    unsigned int crc;
-    if (header->filesize != 0) {
-        crc = update_crc(crc_table, 0, NULL, 4);
-        crc = update_crc(crc_table, crc, (unsigned char *)file_buffer + 4, header->filesize-4);
-
+    uint32_t crc;
+    res = wbf_crc(&wbf, &crc);
+    if (res == WBF_OK) {
         printf("Checksum: 0x%08x\n", crc);
         if (crc == header->checksum) {
             printf("Checksum match.\n");
@@ -357,64 +116,45 @@ int main(int argc, char **argv) {
             printf("Checksum mismatch! Expected: 0x%08x\n", header->checksum);
         }
     }
-    else {
+    else if (res == WBF_EINVAL) {
         printf("File size reported to be 0 in the header. Checksum check skipped.\n");
     }
-
-    // Try to find mode description
-    char **mode_string = NULL;
-    uint8_t mode_version = header->mode_version_or_adhesive_run_num;
-    for (int i = 0; i < MODE_NAME_LUTS; i++) {
-        if ((mode_name_lut[i].versions[0] == mode_version) ||
-                (mode_name_lut[i].versions[1] == mode_version)) {
-            mode_string = (char **)(mode_name_lut[i].mode_strings);
-        }
+    else {
+        printf("File size reported larger than the file. Checksum check skipped.\n");
     }
-    if (mode_string) {
+
+    if (wbf.mode_names) {
         printf("Known mode version, mode names available.\n");
     }
     else {
         printf("Unknown mode version, mode names won't be available.\n");
     }
 
-    // Right following the header is the temperature range table
-    uint8_t checksum = 0;
-
     int i, j;
-    int trt_entries; //  temperature range table
-
-    uint8_t *temp_range_bounds;
-    trt_entries = header->trc + 1;
+    int trt_entries = wbf.temps; //  temperature range table
+    const uint8_t *temp_range_bounds = wbf.temp_table;
 
     printf("Temperatures count: %d\n", trt_entries);
 
-    temp_range_bounds = (uint8_t*)malloc(trt_entries + 2);
-
-    memcpy(temp_range_bounds, file_buffer + HEADER_SIZE, trt_entries + 2);
-
     for (i = 0; i < trt_entries; i++) {
         printf("Temperature %d = %d°C\n", i, temp_range_bounds[i]);
-        checksum += temp_range_bounds[i];
     }
 
     printf("End bound: %d°C\n", temp_range_bounds[trt_entries]);
-    checksum +=  temp_range_bounds[trt_entries];
 
-    if (checksum != temp_range_bounds[trt_entries + 1]) {
+    if (!wbf.temp_checksum_ok) {
         printf("Temperature table checksum mismatch\n");
     }
 
-    char xwia_buffer[128];
-    uint8_t xwia_len = 0;
-    if (header->xwia != 0) {
+    // Escaped, up to 4 characters each
+    char xwia_buffer[256 * 4 + 1];
+    xwia_buffer[0] = '\0';
+    if (wbf.xwia) {
         printf("Extra waveform information present:\n");
-        uint8_t *ptr = (uint8_t *)file_buffer + header->xwia;
-        xwia_len = *ptr++;
-        checksum = xwia_len;
 
         j = 0;
-        for (i = 0; i < xwia_len; i++) {
-            char c = *ptr++;
+        for (i = 0; i < wbf.xwia_len; i++) {
+            char c = wbf.xwia[i];
             if (isprint(c)) {
                 xwia_buffer[j++] = c;
             }
@@ -424,134 +164,190 @@ int main(int argc, char **argv) {
                 xwia_buffer[j++] = (c / 16) + '0';
                 xwia_buffer[j++] = (c % 16) + '0';
             }
-            checksum += c;
         }
         xwia_buffer[j++] = '\0';
         printf("%s", xwia_buffer);
         printf("\n");
-        if (checksum != *ptr++) {
+        if (!wbf.xwia_checksum_ok) {
             printf("XWIA checksum mismatch\n");
         }
     }
 
-    int wv_data_offs; //  offset for waveform data
-    int waveform_buffer_size; // size for waveform data
-    int mode_count = header->mc + 1;
+    int mode_count = wbf.modes;
 
-    wv_data_offs = HEADER_SIZE + trt_entries + 2 + 1 + xwia_len + 1;
-    // This should yield the same result
-    if ((header->xwia) && (wv_data_offs != header->xwia + 1 + xwia_len + 1))
+    if (!wbf.data_offset_ok)
         printf("Warning: data offset calculation mismatch\n");
-    printf("Waveform data offset: %d\n", wv_data_offs);
-    
-    uint8_t *ptr = (uint8_t *)file_buffer + wv_data_offs;
-
-    uint32_t* wv_modes = malloc(sizeof(uint32_t) * mode_count);
+    printf("Waveform data offset: %d\n", wbf.data_offset);
 
     uint32_t addr;
     // get modes addr
     for (i = 0; i < mode_count; i++) {
-        addr = read_pointer(ptr);
+        res = wbf_mode_pointer(&wbf, i, &addr);
+        if (res == WBF_ECHECKSUM) {
+            printf("Pointer checksum mismatch\n");
+        }
         printf("wave #%d addr: %u\n", i, addr);
-        wv_modes[i] = addr;
-        ptr += 4;
     }
 
     // get modes temp addr
-    // Table offsets, ordered as first shown in the wbf, may not use up all space
-    uint32_t *table_offsets = malloc(sizeof(uint32_t) * mode_count * trt_entries + 1);
-    int *frame_counts = malloc(sizeof(uint32_t) * mode_count * trt_entries);
+    // Tables, ordered as first shown in the wbf, may not use up all space
+    int entries = mode_count * trt_entries;
+    table_t *tables_list = calloc(entries, sizeof(table_t));
     int tables = 0;
+    int offsets = 0;
     // Table index for each mode x temp
-    int *wv_modes_temps = malloc(sizeof(int) * mode_count * trt_entries);
+    int *wv_modes_temps = malloc(sizeof(int) * entries);
+    int slots_size = 16;
+    while (slots_size < entries * 2)
+        slots_size *= 2;
+    slot_t *offset_slots = malloc(sizeof(slot_t) * slots_size);
+    slot_t *hash_slots = malloc(sizeof(slot_t) * slots_size);
+    for (i = 0; i < slots_size; i++) {
+        offset_slots[i].id = -1;
+        hash_slots[i].id = -1;
+    }
+    uint32_t format = wbf_table_format(&wbf);
+    int ret = 1;
+
+    const char *dir = store ? wbf_store_dir(store) : NULL;
+    char* fn = malloc(strlen(prefix) + (dir ? strlen(dir) : 0) + 40);
+
+    const char *ext = binary ? "lut" : "csv";
+    wbf_lut_t lut = { .states = wbf_states(&wbf), .uni = wbf.uni,
+            .values = NULL };
+    size_t lut_size = 0;
+
+    wbf_iter_t iter;
+    wbf_table_t table;
+    wbf_iter_init(&iter, &wbf);
+    while (wbf_iter_next(&iter, &table, &res)) {
+        if (res == WBF_ECHECKSUM) {
+            printf("Pointer checksum mismatch\n");
+        }
+        else if (res != WBF_OK) {
+            fprintf(stderr, "Wave #%d, temp #%d: %s\n", table.mode, table.temp,
+                    wbf_strerror(res));
+            goto fail;
+        }
 
-    for (i = 0; i < mode_count; i++) {
-        ptr = (uint8_t *)file_buffer + wv_modes[i];
-        for (j = 0; j < trt_entries; j++) {
-            addr = read_pointer(ptr);
-
-            // Find the table ID correspond to the address
-            // Ideally this should be an hash table, but given the extremely small
-            // problem size here, linear search is more than good enough.
-            int id = -1;
-            for (int k = 0; k < tables; k++)
-                if (table_offsets[k] == addr) {
-                    id = k;
+        int offset_pos;
+        int id = slot_find(offset_slots, slots_size, table.offset, &offset_pos);
+        if (id == -1) {
+            // New offset, decode it and look for the same content
+            table_t *t = &tables_list[tables];
+            t->view = table;
+            res = wbf_table_scan(&table, &t->info);
+            if (res == WBF_OK) {
+                t->decoded = malloc(t->info.decoded_len ? t->info.decoded_len : 1);
+                assert(t->decoded);
+                res = wbf_table_decode(&table, t->decoded, t->info.decoded_len, NULL);
+            }
+            if (res != WBF_OK) {
+                fprintf(stderr, "Wave #%d, temp #%d: %s\n", table.mode,
+                        table.temp, wbf_strerror(res));
+                free(t->decoded);
+                t->decoded = NULL;
+                goto fail;
+            }
+            t->hash = wbf_hash64(t->decoded, t->info.decoded_len, format);
+            offsets++;
+
+            int pos = t->hash & (slots_size - 1);
+            while (hash_slots[pos].id >= 0) {
+                table_t *other = &tables_list[hash_slots[pos].id];
+                if ((other->hash == t->hash) &&
+                        (other->info.decoded_len == t->info.decoded_len) &&
+                        (memcmp(other->decoded, t->decoded,
+                        t->info.decoded_len) == 0)) {
+                    id = hash_slots[pos].id;
                     break;
                 }
+                pos = (pos + 1) & (slots_size - 1);
+            }
 
             if (id == -1) {
                 // New table
                 id = tables; // Assign ID
                 tables++;
-                table_offsets[id] = addr;
+                hash_slots[pos].key = t->hash;
+                hash_slots[pos].id = id;
             }
-
-            wv_modes_temps[i * trt_entries + j] = id;
-            printf("wave #%d, temp #%d: wavetable %d\n", i, j, id);
-            ptr += 4;
+            else {
+                free(t->decoded);
+                memset(t, 0, sizeof(table_t));
+            }
+            offset_slots[offset_pos].key = table.offset;
+            offset_slots[offset_pos].id = id;
         }
-    }
 
-    char* fn = malloc(strlen(prefix) + 14);
-
-    static uint8_t derle_buffer[MAX_TABLE_LENGTH];
+        wv_modes_temps[table.mode * trt_entries + table.temp] = id;
+        printf("wave #%d, temp #%d: wavetable %d\n", table.mode, table.temp, id);
+    }
+    if (offsets != tables) {
+        printf("%d tables found at different offsets, %d after merging "
+                "identical content\n", offsets, tables);
+    }
 
     for (i = 0; i < tables; i++) {
-        printf("Parsing table %d, addr %d (0x%06x)\n", i, table_offsets[i], table_offsets[i]);
-
-        ptr = (uint8_t *)file_buffer + table_offsets[i];
-        // Parse table
-        bool rle_mode = true;
-        uint32_t idx = 0;
-        uint8_t checksum = 0;
-        while(1) {
-            uint8_t chr = *ptr++;
-            checksum += chr;
-            if (chr == 0xfc) {
-                // Toggle RLE mode
-                rle_mode = !rle_mode;
-            }
-            else if (chr == 0xff) {
-                // End of block
-                break;
-            }
-            else if (!rle_mode) {
-                derle_buffer[idx++] = chr;
-            }
-            else {
-                uint8_t len = *ptr++;
-                checksum += len;
-                for (j = 0; j < (int)len + 1; j++) {
-                    derle_buffer[idx++] = chr;
-                }
+        table_t *t = &tables_list[i];
+        printf("Parsing table %d, addr %d (0x%06x)\n", i, t->view.offset, t->view.offset);
+        printf("Total %zu bytes. Checksum: 0x%02x\n", t->info.decoded_len, t->info.checksum);
+        if (!t->info.checksum_ok) {
+            printf("Checksum mismatch!\n");
+        }
+
+        int phases = wbf_table_frames(&wbf, t->info.decoded_len);
+        t->frames = phases;
+
+        if (store) {
+            // Only new tables are written out
+            bool added;
+            res = wbf_store_put(store, t->decoded, t->info.decoded_len,
+                    format, t->name, &added);
+            if (res != WBF_OK) {
+                fprintf(stderr, "Table %d: %s\n", i, wbf_strerror(res));
+                goto fail;
             }
+            printf("Stored as %s%s\n", t->name, added ? ", new" : "");
+            sprintf(fn, "%s/%s.%s", dir, t->name, ext);
+            // Stored by an earlier run, possibly in the other format
+            if (!added && (access(fn, F_OK) == 0))
+                continue;
         }
-        printf("Total %d bytes. Checksum: 0x%02x\n", idx, checksum);
-        if (*ptr++ != checksum) {
-            printf("Checksum mismatch!\n");
+        else {
+            sprintf(fn, "%s_TB%d.%s", prefix, i, ext);
         }
 
-        int phase_per_byte = mv ? 2 : 4;
-        int transitions = uni ? 32 : ((bpp == 3) ? (8 * 8) : (bpp == 4) ? (16 * 16) : (32 * 32));
-        int phases = idx * phase_per_byte / transitions;
-        frame_counts[i] = phases;
+        if (phases * wbf_frame_size(&wbf) > lut_size) {
+            lut_size = phases * wbf_frame_size(&wbf);
+            lut.values = realloc(lut.values, lut_size);
+            assert(lut.values);
+        }
+        wbf_table_unpack(&wbf, t->decoded, phases, lut.values);
+        lut.frames = phases;
 
         // Dump phases
-        sprintf(fn, "%s_TB%d.csv", prefix, i);
-        fp = fopen(fn, "w");
-        assert(fp);
-        size_t index = i * trt_entries + j;
-        dump_phases(fp, derle_buffer, bpp, phases, phase_per_byte, uni);
-        fclose(fp);
-        sprintf(fn, "%s_TB%d.bin", prefix, i);
-        fp = fopen(fn, "wb");
-        assert(fp);
-        fwrite(derle_buffer, idx, 1, fp);
-        fclose(fp);
+        if (binary)
+            res = wbf_lut_save(fn, &lut);
+        else
+            res = wbf_lut_save_csv(fn, &lut);
+        if (res != WBF_OK) {
+            fprintf(stderr, "Failed to write %s: %s\n", fn, wbf_strerror(res));
+            goto fail;
+        }
+        if (!store) {
+            sprintf(fn, "%s_TB%d.bin", prefix, i);
+            fp = fopen(fn, "wb");
+            assert(fp);
+            fwrite(t->decoded, t->info.decoded_len, 1, fp);
+            fclose(fp);
+        }
     }
 
-    sprintf(fn, "%s_desc.iwf", prefix);
+    if (store)
+        sprintf(fn, "%s/%s_desc.iwf", dir, prefix);
+    else
+        sprintf(fn, "%s_desc.iwf", prefix);
     fp = fopen(fn, "w");
     assert(fp);
     fprintf(fp, "[WAVEFORM]\n");
@@ -562,6 +358,8 @@ int main(int argc, char **argv) {
     fprintf(fp, "MODES = %d\n", mode_count);
     fprintf(fp, "TEMPS = %d\n", trt_entries);
     fprintf(fp, "TABLES = %d\n", tables);
+    if (binary)
+        fprintf(fp, "FORMAT = LUT\n");
     fprintf(fp, "\n");
     for (int i = 0; i < trt_entries; i++) {
         fprintf(fp, "T%dRANGE = %d\n", i, temp_range_bounds[i]);
@@ -569,13 +367,20 @@ int main(int argc, char **argv) {
     fprintf(fp, "TUPBOUND = %d\n", temp_range_bounds[trt_entries]);
     fprintf(fp, "\n");
     for (int i = 0; i < tables; i++) {
-        fprintf(fp, "TB%dFC = %d\n", i, frame_counts[i]);
+        fprintf(fp, "TB%dFC = %d\n", i, tables_list[i].frames);
     }
     fprintf(fp, "\n");
+    if (store) {
+        // Shared tables, relative to the descriptor
+        for (int i = 0; i < tables; i++) {
+            fprintf(fp, "TB%dFILE = %s.%s\n", i, tables_list[i].name, ext);
+        }
+        fprintf(fp, "\n");
+    }
     for (int i = 0; i < mode_count; i++) {
         fprintf(fp, "[MODE%d]\n", i);
-        if (mode_string) {
-            fprintf(fp, "NAME = %s\n", mode_string[i]);
+        if (wbf_mode_name(&wbf, i)) {
+            fprintf(fp, "NAME = %s\n", wbf_mode_name(&wbf, i));
         }
         for (int j = 0; j < trt_entries; j++) {
             fprintf(fp, "T%dTABLE = %d\n", j, wv_modes_temps[i * trt_entries + j]);
@@ -583,17 +388,98 @@ int main(int argc, char **argv) {
         fprintf(fp, "\n");
     }
     fclose(fp);
+    ret = 0;
 
-    printf("All done!\n");
-
+fail:
     free(fn);
-    free(temp_range_bounds);
-    free(table_offsets);
-    free(frame_counts);
-    free(wv_modes);
+    for (i = 0; i < tables; i++)
+        free(tables_list[i].decoded);
+    free(tables_list);
     free(wv_modes_temps);
+    free(offset_slots);
+    free(hash_slots);
+    wbf_lut_free(&lut);
+
+    wbf_close(&wbf);
+
+    return ret;
+}
+
+static void usage(void) {
+    fprintf(stderr, "Usage: wbf_wvfm_dump [-l] input_file output_prefix\n");
+    fprintf(stderr, "       wbf_wvfm_dump [-l] -s store_dir input_file...\n");
+    fprintf(stderr, "-l: Write tables in binary .lut format instead of .csv\n");
+    fprintf(stderr, "input_file: MXC EPDC firmware file, in .wbf format\n");
+    fprintf(stderr, "output_prefix: Prefix for output file name, without extension\n");
+    fprintf(stderr, "store_dir: Directory shared by all waveforms dumped into it. Each input is\n");
+    fprintf(stderr, "  described by <input name>_desc.iwf, tables are named after their content\n");
+    fprintf(stderr, "  and only written once.\n");
+    fprintf(stderr, "Example: wbf_wvfm_dump E060SCM.wbf e060scm\n");
+    fprintf(stderr, "         wbf_wvfm_dump -s waveforms *.wbf\n");
+}
+
+int main(int argc, char **argv) {
+    fprintf(stderr, "Eink wbf waveform dumper\n");
+
+    const char *store_dir = NULL;
+    bool binary = false;
+    int opt;
+    while ((opt = getopt(argc, argv, "ls:")) != -1) {
+        switch (opt) {
+        case 'l':
+            binary = true;
+            break;
+        case 's':
+            store_dir = optarg;
+            break;
+        default:
+            usage();
+            return 1;
+        }
+    }
+    int inputs = argc - optind;
+    if ((!store_dir && (inputs != 2)) || (store_dir && (inputs < 1))) {
+        usage();
+        return 1;
+    }
+
+    if (!store_dir) {
+        if (dump_file(argv[optind], argv[optind + 1], NULL, binary) != 0)
+            return 1;
+        printf("All done!\n");
+        return 0;
+    }
 
-    free(file_buffer);
+    wbf_store_t *store;
+    int res = wbf_store_open(&store, store_dir);
+    if (res != WBF_OK) {
+        fprintf(stderr, "Failed to open store %s: %s\n", store_dir, wbf_strerror(res));
+        return 1;
+    }
+    int failed = 0;
+    for (int i = optind; i < argc; i++) {
+        // Named after the input file, without the extension
+        char *name = strdup(basename(argv[i]));
+        char *ext = strrchr(name, '.');
+        if (ext && (ext != name))
+            *ext = '\0';
+        printf("%s:\n", argv[i]);
+        if (dump_file(argv[i], name, store, binary) != 0)
+            failed++;
+        free(name);
+    }
 
+    wbf_store_stats_t stats;
+    wbf_store_get_stats(store, &stats);
+    printf("%d files, %d failed. %"PRIu64" tables: %"PRIu64" new, %"PRIu64
+            " already stored (%"PRIu64" from earlier runs)\n", inputs, failed,
+            stats.lookups, stats.added, stats.hits_session + stats.hits_disk,
+            stats.hits_disk);
+    printf("%"PRIu64" bytes written, %"PRIu64" bytes shared\n",
+            stats.bytes_added, stats.bytes_reused);
+    wbf_store_close(store);
+    if (failed)
+        return 1;
+    printf("All done!\n");
     return 0;
-}
\ No newline at end of file
+}